@@ -74,6 +74,8 @@ public:
 
   void extendBy(const SbVec3f & pt);
   void extendBy(const SbBox3f & box);
+  void extendBy(const SbVec3f * points, const int num);
+  void extendBy(const SbVec3f * points, const int num, const SbMatrix & matrix);
   void transform(const SbMatrix & matrix);
   void makeEmpty(void);
   SbBool isEmpty(void) const { return maxpt[0] < minpt[0]; }
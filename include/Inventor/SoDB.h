@@ -103,6 +103,10 @@ public:
   static SbBool isNotifying(void);
   static void endNotify(void);
 
+  static void startBatchEdit(void);
+  static SbBool isBatchEditing(void);
+  static void endBatchEdit(void);
+
   typedef SbBool ProgressCallbackType(const SbName & itemid, float fraction,
                                       SbBool interruptible, void * userdata);
   static void addProgressCallback(ProgressCallbackType * func, void * userdata);
@@ -91,6 +91,9 @@ public:
   virtual float getIVVersion(void);
   virtual SbBool isBinary(void);
 
+  void setNumPrefetchThreads(const int numthreads);
+  int getNumPrefetchThreads(void) const;
+
   virtual SbBool get(char & c);
   virtual SbBool getASCIIBuffer(char & c);
   virtual SbBool getASCIIFile(char & c);
@@ -46,6 +46,7 @@ typedef void SoGLPreRenderCB(void * userdata, class SoGLRenderAction * action);
 typedef float SoGLSortedObjectOrderCB(void * userdata, SoGLRenderAction * action);
 
 class SoGLRenderActionP;
+class SbBox3f;
 
 class COIN_DLL_API SoGLRenderAction : public SoAction {
   typedef SoAction inherited;
@@ -65,7 +66,7 @@ public:
     // The remaining are Coin extensions to the common Inventor API
     SORTED_OBJECT_SORTED_TRIANGLE_ADD,
     SORTED_OBJECT_SORTED_TRIANGLE_BLEND,
-    NONE, SORTED_LAYERS_BLEND
+    NONE, SORTED_LAYERS_BLEND, WEIGHTED_BLEND
   };
 
   enum TransparentDelayedObjectRenderType {
@@ -135,6 +136,16 @@ public:
   SbBool isRenderingTranspPaths(void) const;
   SbBool isRenderingTranspBackfaces(void) const;
 
+  void setOcclusionCulling(const SbBool onoff);
+  SbBool isOcclusionCulling(void) const;
+  SbBool isOccluded(const SbBox3f & box);
+
+  void setRetainedRendering(const SbBool onoff);
+  SbBool isRetainedRendering(void) const;
+
+  void setInstancedRendering(const SbBool onoff);
+  SbBool isInstancedRendering(void) const;
+
 protected:
   friend class SoGLRenderActionP; // calls beginTraversal
   virtual void beginTraversal(SoNode * node);
@@ -73,6 +73,8 @@ public:
   SbBool isResetBefore(void) const;
   SoGetBoundingBoxAction::ResetType getWhatReset(void) const;
 
+  void setNumThreads(const int num);
+  int getNumThreads(void) const;
 
   void checkResetBefore(void);
   void checkResetAfter(void);
@@ -98,6 +100,7 @@ private:
   unsigned int flags;
 
 private:
+  friend class SoGetBoundingBoxActionP;
   SbLazyPimplPtr<SoGetBoundingBoxActionP> pimpl;
 
   SoGetBoundingBoxAction(const SoGetBoundingBoxAction & rhs);
@@ -58,10 +58,20 @@ public:
     ALL = (NORMAL|TEXCOORD|COLOR)
   };
 
+  enum Layout {
+    FULL_PRECISION,
+    COMPACT
+  };
+
+  void setLayout(const Layout layout);
+  Layout getLayout(void) const;
+
   virtual SbBool isValid(const SoState * state) const;
   void close(SoState * state);
 
   void renderTriangles(SoState * state, const int arrays = ALL) const;
+  void renderTrianglesInstanced(SoState * state, const int numinstances,
+                                const int arrays = ALL) const;
   void renderLines(SoState * state, const int arrays = ALL) const;
   void renderPoints(SoState * state, const int array = ALL) const;
 
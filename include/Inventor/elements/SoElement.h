@@ -69,6 +69,9 @@ public:
   virtual void print(FILE * file = stdout) const;
   virtual ~SoElement();
 
+  static void * operator new(size_t size);
+  static void operator delete(void * ptr);
+
 protected:
   SoElement(void);
   static int classStackIndex;
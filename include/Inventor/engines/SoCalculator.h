@@ -73,6 +73,7 @@ private:
   static void writefieldcb(const char *name, float *data, int comp, void *cbdata);
 
   void evaluateExpression(struct so_eval_node *node, const int fieldidx);
+  void evaluateProgram(const int maxnum);
   void findUsed(struct so_eval_node *node, char *inused, char *outused);
 
   SoCalculatorP * pimpl;
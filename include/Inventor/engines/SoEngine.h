@@ -66,6 +66,11 @@ public:
 
   virtual void writeInstance(SoOutput * out);
 
+  static void enableScheduling(const SbBool onoff);
+  static SbBool isSchedulingEnabled(void);
+  static void setNumSchedulingThreads(const int num);
+  static int getNumSchedulingThreads(void);
+  static int evaluateScheduled(void);
 
 protected:
   SoEngine(void);
@@ -65,6 +65,9 @@ public:
   void set1HSVValue(int idx, float h, float s, float v, float a);
   void set1HSVValue(int idx, const float hsva[4]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFColorRGBA
 
 #endif // !COIN_SOMFCOLORRGBA_H
@@ -48,6 +48,8 @@ public:
 
 private:
   virtual int getNumValuesPerLine(void) const;
+  virtual SbBool readBinaryValues(SoInput * in, int num);
+  virtual void writeBinaryValues(SoOutput * out) const;
 };
 
 #endif // !COIN_SOMFINT32_H
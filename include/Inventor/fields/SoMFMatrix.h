@@ -56,6 +56,9 @@ public:
 
                 const float a41, const float a42,
                 const float a43, const float a44);
+
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
 };
 
 #endif // !COIN_SOMFMATRIX_H
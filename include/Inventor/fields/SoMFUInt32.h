@@ -48,6 +48,7 @@ public:
 
 private:
   virtual int getNumValuesPerLine(void) const;
+  virtual void writeBinaryValues(SoOutput * out) const;
 };
 
 #endif // !COIN_SOMFUINT32_H
@@ -54,6 +54,9 @@ public:
   void setValue(double x, double y);
   void setValue(const double xy[2]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec2d
 
 #endif // !COIN_SOMFVEC2D_H
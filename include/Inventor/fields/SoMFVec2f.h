@@ -54,6 +54,9 @@ public:
   void setValue(float x, float y);
   void setValue(const float xy[2]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec2f
 
 #endif // !COIN_SOMFVEC2F_H
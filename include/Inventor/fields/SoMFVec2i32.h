@@ -54,6 +54,9 @@ public:
   void setValue(int32_t x, int32_t y);
   void setValue(const int32_t xy[2]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec2i32
 
 #endif // !COIN_SOMFVEC2I32_H
@@ -53,6 +53,9 @@ public:
   void setValue(double x, double y, double z);
   void setValue(const double xyz[3]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec3d
 
 #endif // !COIN_SOMFVEC3D_H
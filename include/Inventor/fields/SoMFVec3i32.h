@@ -53,6 +53,9 @@ public:
   void setValue(int32_t x, int32_t y, int32_t z);
   void setValue(const int32_t xyz[3]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec3i32
 
 #endif // !COIN_SOMFVEC3I32_H
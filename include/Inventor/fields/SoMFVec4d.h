@@ -54,6 +54,9 @@ public:
   void setValue(double x, double y, double z, double w);
   void setValue(const double xyzw[4]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec4d
 
 #endif // !COIN_SOMFVEC4D_H
@@ -54,6 +54,9 @@ public:
   void setValue(int32_t x, int32_t y, int32_t z, int32_t w);
   void setValue(const int32_t xyzw[4]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec4i32
 
 #endif // !COIN_SOMFVEC4I32_H
@@ -54,6 +54,9 @@ public:
   void setValue(uint32_t x, uint32_t y, uint32_t z, uint32_t w);
   void setValue(const uint32_t xyzw[4]);
 
+private:
+  virtual void writeBinaryValues(SoOutput * out) const;
+
 }; // SoMFVec4i32
 
 #endif // !COIN_SOMFVEC4UI32_H
@@ -72,6 +72,10 @@ protected:
   virtual void allocValues(int num);
 #endif // DOXYGEN_SKIP_THIS
 
+  SbBool shareValues(const SoMField & field);
+  void unshareValues(void);
+  SbBool releaseValues(void);
+
   virtual SoNotRec createNotRec(SoBase * container);
 
   void setChangedIndex(const int chgidx);
@@ -94,6 +98,9 @@ private:
 
   static SoType classTypeId;
   int changedIndex, numChangedIndices;
+
+  void detachValues(void);
+  void shareReadValues(void);
 };
 
 // inline methods
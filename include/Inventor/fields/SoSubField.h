@@ -263,7 +263,7 @@ public: \
   _valref_ operator=(_valref_ val) { this->setValue(val); return val; } \
   SbBool operator==(const _class_ & field) const; \
   SbBool operator!=(const _class_ & field) const { return !operator==(field); } \
-  _valtype_ * startEditing(void) { this->evaluate(); return this->values; } \
+  _valtype_ * startEditing(void) { this->evaluate(); this->unshareValues(); return this->values; } \
   void finishEditing(void) { this->valueChanged(); }
 
 #define SO_MFIELD_DERIVED_VALUE_HEADER(_class_, _valtype_, _valref_) \
@@ -329,6 +329,10 @@ PRIVATE_EQUALITY_SOURCE(_class_); \
 const _class_ & \
 _class_::operator=(const _class_ & field) \
 { \
+  /* Fields of the same type can share the values array, so */ \
+  /* copying is deferred until one of them is modified. */ \
+  if (this->shareValues(field)) return *this; \
+  \
   /* The allocValues() call is needed, as setValues() doesn't */ \
   /* necessarily make the field's getNum() size become the same */ \
   /* as the second argument (only if it expands on the old size). */ \
@@ -372,6 +376,7 @@ _class_::find(_valref_ value, SbBool addifnotfound) \
 void \
 _class_::setValues(const int start, const int numarg, const _valtype_ * newvals) \
 { \
+  this->unshareValues(); \
   if (start+numarg > this->maxNum) this->allocValues(start+numarg); \
   else if (start+numarg > this->num) this->num = start+numarg; \
  \
@@ -385,6 +390,7 @@ _class_::setValues(const int start, const int numarg, const _valtype_ * newvals)
 void \
 _class_::set1Value(const int idx, _valref_ value) \
 { \
+  this->unshareValues(); \
   if (idx+1 > this->maxNum) this->allocValues(idx+1); \
   else if (idx+1 > this->num) this->num = idx+1; \
   this->values[idx] = value; \
@@ -396,6 +402,7 @@ _class_::set1Value(const int idx, _valref_ value) \
 void \
 _class_::setValue(_valref_ value) \
 { \
+  this->unshareValues(); \
   this->allocValues(1); \
   this->values[0] = value; \
   this->setChangedIndex(0); \
@@ -426,6 +433,7 @@ _class_::deleteAllValues(void) \
 void \
 _class_::copyValue(int to, int from) \
 { \
+  this->unshareValues(); \
   this->values[to] = this->values[from]; \
 }
 
@@ -447,7 +455,7 @@ _class_::allocValues(int newnum) \
  \
   this->setChangedIndices(); \
   if (newnum == 0) { \
-    if (!this->userDataIsUsed) delete[] this->values; /* don't fetch pointer through valuesPtr() (avoids void* cast) */ \
+    if (this->releaseValues()) delete[] this->values; /* don't fetch pointer through valuesPtr() (avoids void* cast) */ \
     this->setValuesPtr(NULL); \
     this->maxNum = 0; \
     this->userDataIsUsed = FALSE; \
@@ -472,7 +480,7 @@ _class_::allocValues(int newnum) \
         for (i=0; i < SbMin(this->num, newnum); i++) \
           newblock[i] = this->values[i]; \
  \
-        delete[] this->values; /* don't fetch pointer through valuesPtr() (avoids void* cast) */ \
+        if (this->releaseValues()) delete[] this->values; /* don't fetch pointer through valuesPtr() (avoids void* cast) */ \
         this->setValuesPtr(newblock); \
         this->userDataIsUsed = FALSE; \
       } \
@@ -485,7 +493,8 @@ _class_::allocValues(int newnum) \
   } \
  \
   this->num = newnum; \
-}
+} \
+
 
 
 
@@ -53,6 +53,8 @@ public:
   void addMethod(const SoType node, const SoActionMethod method);
   void setUp(void);
 
+  const SoActionMethod * getDispatchTable(int & numentries) const;
+
 private:
   class SoActionMethodListP * pimpl;
 };
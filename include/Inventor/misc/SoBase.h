@@ -130,6 +130,7 @@ private:
 
   class PImpl;
   friend class PImpl; // MSVC6
+  friend class SoDBP; // sends notifications deferred by batch edits
 };
 
 // support for boost::intrusive_ptr<SoBase>
@@ -96,4 +96,6 @@ private:
 #define SO_GL_NON_POWER_OF_TWO_TEXTURES "COIN_non_power_of_two_textures"
 #define SO_GL_GENERATE_MIPMAP       "COIN_generate_mipmap"
 #define SO_GL_GLSL_CLIP_VERTEX_HW   "COIN_GLSL_clip_vertex_hw"
+#define SO_GL_WEIGHTED_BLEND        "COIN_weighted_blend"
+#define SO_GL_INSTANCED_RENDERING   "COIN_instanced_rendering"
 #endif // SOGLDATABASE_H
@@ -92,6 +92,7 @@ protected:
   SbBool shouldPrimitiveCount(SoGetPrimitiveCountAction * action);
 
   SbBool shouldRayPick(SoRayPickAction * const action);
+  void rayPickBVH(SoRayPickAction * action);
   void computeObjectSpaceRay(SoRayPickAction * const action);
   void computeObjectSpaceRay(SoRayPickAction * const action,
                              const SbMatrix & matrix);
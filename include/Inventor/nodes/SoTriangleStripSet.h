@@ -50,6 +50,7 @@ public:
 
   virtual void GLRender(SoGLRenderAction * action);
   virtual void getPrimitiveCount(SoGetPrimitiveCountAction * action);
+  virtual void rayPick(SoRayPickAction * action);
   virtual SbBool generateDefaultNormals(SoState * state, SoNormalBundle * nb);
 
 protected:
@@ -348,6 +348,18 @@
 #define GL_BGR 0x80E0
 #endif /* GL_BGR */
 
+/* ARB_multisample */
+
+#ifndef GL_SAMPLE_BUFFERS_ARB
+#define GL_SAMPLE_BUFFERS_ARB 0x80A8
+#endif /* GL_SAMPLE_BUFFERS_ARB */
+
+/* ARB_draw_buffers */
+
+#ifndef GL_MAX_DRAW_BUFFERS_ARB
+#define GL_MAX_DRAW_BUFFERS_ARB 0x8824
+#endif /* GL_MAX_DRAW_BUFFERS_ARB */
+
 /* Floating point texture formats (ARB_texture_float) */
 
 #ifndef GL_RGBA32F_ARB
@@ -386,6 +398,9 @@
 #ifndef GL_LUMINANCE_ALPHA16F_ARB
 #define GL_LUMINANCE_ALPHA16F_ARB 0x881F
 #endif /* GL_LUMINANCE_ALPHA16F_ARB */
+#ifndef GL_HALF_FLOAT_ARB
+#define GL_HALF_FLOAT_ARB 0x140B
+#endif /* GL_HALF_FLOAT_ARB */
 
 #ifndef GL_RGBA16_EXT
 #define GL_RGBA16_EXT 0x805B
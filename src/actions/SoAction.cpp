@@ -344,6 +344,8 @@ SoAction::SoAction(void)
   PRIVATE(this)->applieddata.node = NULL;
   PRIVATE(this)->terminated = FALSE;
   PRIVATE(this)->prevenabledelementscounter = 0;
+  PRIVATE(this)->dispatch = NULL;
+  PRIVATE(this)->numdispatch = 0;
 
   this->currentpath.ref(); // to avoid having a zero refcount instance
 }
@@ -473,6 +475,8 @@ SoAction::apply(SoNode * root)
   // the SoAction subclass.
   assert(this->traversalMethods);
   this->traversalMethods->setUp();
+  PRIVATE(this)->dispatch =
+    this->traversalMethods->getDispatchTable(PRIVATE(this)->numdispatch);
 
   PRIVATE(this)->terminated = FALSE;
 
@@ -627,6 +631,8 @@ SoAction::apply(SoPath * path)
   // the SoAction subclass.
   assert(this->traversalMethods);
   this->traversalMethods->setUp();
+  PRIVATE(this)->dispatch =
+    this->traversalMethods->getDispatchTable(PRIVATE(this)->numdispatch);
 
   PRIVATE(this)->terminated = FALSE;
 
@@ -684,6 +690,8 @@ SoAction::apply(const SoPathList & pathlist, SbBool obeysrules)
   // the SoAction subclass.
   assert(this->traversalMethods);
   this->traversalMethods->setUp();
+  PRIVATE(this)->dispatch =
+    this->traversalMethods->getDispatchTable(PRIVATE(this)->numdispatch);
   if (pathlist.getLength() == 0) {
     SoDB::readunlock();
     return;
@@ -939,10 +947,20 @@ SoAction::getPathCode(int & numindices, const int * & indices)
 void
 SoAction::traverse(SoNode * const node)
 {
-  SoType t = node->getTypeId();
+  const SoType t = node->getTypeId();
+  const int key = t.getKey();
+  SoActionMethod func =
+    key < PRIVATE(this)->numdispatch ? PRIVATE(this)->dispatch[key] : NULL;
+  if (func == NULL) {
+    // not applied yet, or a node type created after apply()
+    int idx = SoNode::getActionMethodIndex(t);
+    func = (*this->traversalMethods)[idx];
+  }
 
-  int idx = SoNode::getActionMethodIndex(t);
-  SoActionMethod func = (*this->traversalMethods)[idx];
+  if (!SoProfiler::isEnabled()) {
+    func(this, node);
+    return;
+  }
 
   SoNodeProfiling profiling;
   profiling.preTraversal(this);
@@ -69,6 +69,10 @@ public:
   SbList <SbList<int> *> pathcodearray;
   int prevenabledelementscounter;
 
+  // the dispatch table of the traversal methods, from the last apply()
+  const SoActionMethod * dispatch;
+  int numdispatch;
+
   static SoNode * getProfilerOverlay(void);
   static SoProfilerStats * getProfilerStatsNode(void);
 }; // SoActionP
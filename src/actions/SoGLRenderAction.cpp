@@ -75,10 +75,12 @@
 #include <Inventor/SbColor.h>
 #include <Inventor/SbPlane.h>
 #include <Inventor/SoFullPath.h>
+#include <Inventor/actions/SoCallbackAction.h>
 #include <Inventor/actions/SoGetBoundingBoxAction.h>
 #include <Inventor/actions/SoSearchAction.h>
 #include <Inventor/caches/SoBoundingBoxCache.h>
 #include <Inventor/elements/SoCacheElement.h>
+#include <Inventor/elements/SoClipPlaneElement.h>
 #include <Inventor/elements/SoDecimationPercentageElement.h>
 #include <Inventor/elements/SoDecimationTypeElement.h>
 #include <Inventor/elements/SoGLCacheContextElement.h>
@@ -89,6 +91,7 @@
 #include <Inventor/elements/SoGLViewportRegionElement.h>
 #include <Inventor/elements/SoLazyElement.h>
 #include <Inventor/elements/SoModelMatrixElement.h>
+#include <Inventor/elements/SoMultiTextureImageElement.h>
 #include <Inventor/elements/SoOverrideElement.h>
 #include <Inventor/elements/SoProjectionMatrixElement.h>
 #include <Inventor/elements/SoShapeHintsElement.h>
@@ -102,14 +105,23 @@
 #include <Inventor/errors/SoDebugError.h>
 #include <Inventor/lists/SoCallbackList.h>
 #include <Inventor/lists/SoEnabledElementsList.h>
+#include <Inventor/lists/SoNodeList.h>
 #include <Inventor/lists/SoPathList.h>
+#include <Inventor/misc/SoChildList.h>
 #include <Inventor/misc/SoState.h>
 #include <Inventor/misc/SoGLDriverDatabase.h>
+#include <Inventor/nodes/SoCamera.h>
 #include <Inventor/nodes/SoGroup.h>
 #include <Inventor/nodes/SoNode.h>
 #include <Inventor/nodes/SoSeparator.h>
 #include <Inventor/nodes/SoShape.h>
 #include <Inventor/nodes/SoShapeHints.h>
+#include <Inventor/nodes/SoSwitch.h>
+#include <Inventor/nodes/SoTransformSeparator.h>
+#include <Inventor/nodes/SoDrawStyle.h>
+#include <Inventor/nodes/SoImage.h>
+#include <Inventor/nodes/SoText2.h>
+#include <Inventor/SoPrimitiveVertex.h>
 #include <Inventor/sensors/SoAlarmSensor.h>
 #include <Inventor/sensors/SoNodeSensor.h>
 #include <Inventor/C/tidbits.h>
@@ -124,7 +136,12 @@
 #include "actions/SoSubActionP.h"
 #include "glue/glp.h"
 #include "glue/simage_wrapper.h"
+#include "rendering/SoDepthSorter.h"
 #include "rendering/SoGL.h"
+#include "rendering/SoGLInstancer.h"
+#include "rendering/SoGLRenderQueue.h"
+#include "rendering/SoGLWeightedBlend.h"
+#include "rendering/SoOcclusionBuffer.h"
 
 #include <Inventor/annex/Profiler/nodes/SoProfilerStats.h>
 #include "profiler/SoProfilerP.h"
@@ -185,6 +202,11 @@
   careful and test your application on a wide variety of runtime
   systems when using SoGLRenderAction::SORTED_LAYERS_BLEND.)
 
+  For scenes with many transparent objects, like semi-transparent CAD
+  assemblies, SoGLRenderAction::WEIGHTED_BLEND renders all of them in
+  a single pass without sorting, at the cost of approximating the
+  blending order.
+
   \sa SoTransparencyType
 */
 
@@ -416,6 +438,43 @@
   \since TGS Inventor 4.0
 */
 
+/*!
+  \var SoGLRenderAction::TransparencyType SoGLRenderAction::WEIGHTED_BLEND
+
+  This transparency type is a Coin extension versus the original SGI
+  Open Inventor API.
+
+  Transparent objects are rendered in a single pass after the opaque
+  objects, without sorting, using weighted blended order independent
+  transparency. The colors of all transparent surfaces covering a
+  pixel are accumulated in floating point buffers, weighted by their
+  opacity and distance from the camera, and the weighted average is
+  blended on top of the opaque objects at the end of the frame. The
+  result is not exact, as surfaces are not ordered, but it is smooth
+  and stable for any number of intersecting transparent objects, and
+  much faster than the sorted modes when there are many of them.
+
+  Like SoGLRenderAction::SORTED_LAYERS_BLEND, this mode overrides the
+  SoTransparencyType nodes in the scene graph.
+
+  Transparent shapes are drawn with a fragment shader that replaces
+  the fixed function texturing and fog. Only the 2D texture in the
+  first texture unit is applied, modulating the lit color. Shapes with
+  their own shader programs are not handled correctly.
+
+  The OpenGL context must support GLSL fragment shaders, framebuffer
+  objects with two floating point color buffers, and depth
+  textures. If it does not, or if the framebuffer rendered to is
+  multisampled, SoGLRenderAction::SORTED_OBJECT_BLEND will be used as
+  the transparency type instead.
+
+  The method is described in "Weighted Blended Order-Independent
+  Transparency" by Morgan McGuire and Louis Bavoil, Journal of
+  Computer Graphics Techniques, 2013.
+
+  \since Coin 4.1
+*/
+
 // FIXME:
 //  todo: - Add debug printout info concerning chosen blend method.
 //        - Add GL_[NV/HP]_occlusion_test support making the number of passes adaptive.
@@ -560,6 +619,8 @@ public:
   SoPathList transpobjpaths;
   SoPathList sorttranspobjpaths;
   SbList<float> sorttranspobjdistances;
+  SbPList sorttranspobjscratch;
+  SoDepthSorter depthsorter;
   SoGLRenderAction::TransparentDelayedObjectRenderType transpdelayedrendertype;
   SbBool renderingtranspbackfaces;
 
@@ -589,10 +650,38 @@ public:
   int sortedlayersblendcounter;
   SbBool usenvidiaregistercombiners;
 
+  boost::scoped_ptr<SoGLWeightedBlend> weightedblend;
+  SbBool weightedblendactive;
+
   SoGLRenderAction::SortedObjectOrderStrategy sortedobjectstrategy;
   SoGLSortedObjectOrderCB * sortedobjectcb;
   void * sortedobjectclosure;
 
+  SbBool retainedrendering;
+  SbBool instancedrendering;
+
+  // occlusion culling
+  SbBool occlusionculling;
+  boost::scoped_ptr<SoOcclusionBuffer> occlusionbuffer;
+  SbBool occlusionbufferready;
+  SbList<SbVec3f> occluders; // world space triangles
+  SbList<SbUniqueId> occluderkey;
+  SoNodeList occluderpathnodes; // groups on the paths to the cameras
+  SoNode * occludercamera;
+  int occludershapestart;
+  float occluderminsize;
+  void updateOccluders(SoNode * root);
+  void findOccluderCameras(SoNode * root);
+  void getOccluderKey(SoNode * node, SbList<SbUniqueId> & key) const;
+  static SoCallbackAction::Response occluderPreCB(void * closure, SoCallbackAction * action,
+                                                  const SoNode * node);
+  static SoCallbackAction::Response occluderPostCB(void * closure, SoCallbackAction * action,
+                                                   const SoNode * node);
+  static void occluderTriangleCB(void * closure, SoCallbackAction * action,
+                                 const SoPrimitiveVertex * v1,
+                                 const SoPrimitiveVertex * v2,
+                                 const SoPrimitiveVertex * v3);
+
   void setupSortedLayersBlendTextures(const SoState * state);
   void doSortedLayersBlendRendering(const SoState * state, SoNode * node);
   void initSortedLayersBlendRendering(const SoState * state);
@@ -632,6 +721,18 @@ public:
 SO_ACTION_SOURCE(SoGLRenderAction);
 
 static int COIN_GLBBOX = 0;
+static int COIN_OCCLUSION_CULLING = 0;
+static int COIN_OCCLUSION_CULLING_THREADS = 1;
+static int COIN_RETAINED_RENDERING = 0;
+static int COIN_INSTANCED_RENDERING = 0;
+
+// Occluders are shapes with a bounding box diagonal at least this
+// fraction of the scene's, and with no more than the given number of
+// triangles. The total number of occluder triangles is also limited.
+static const float OCCLUDER_MIN_SIZE = 0.1f;
+static const int OCCLUDER_MAX_SHAPE_TRIANGLES = 1024;
+static const int OCCLUDER_MAX_TRIANGLES = 65536;
+static const int OCCLUSION_BUFFER_WIDTH = 256;
 
 // *************************************************************************
 
@@ -662,6 +763,25 @@ SoGLRenderAction::initClass(void)
   else {
     COIN_GLBBOX = 0;
   }
+
+  env = coin_getenv("COIN_OCCLUSION_CULLING");
+  COIN_OCCLUSION_CULLING = env ? atoi(env) : 0;
+  env = coin_getenv("COIN_OCCLUSION_CULLING_THREADS");
+  if (env) {
+    const int num = atoi(env);
+    COIN_OCCLUSION_CULLING_THREADS = (num > 0) ? num : coin_num_processors();
+  }
+  else {
+    COIN_OCCLUSION_CULLING_THREADS = 1;
+  }
+
+  env = coin_getenv("COIN_RETAINED_RENDERING");
+  COIN_RETAINED_RENDERING = env ? atoi(env) : 0;
+  env = coin_getenv("COIN_INSTANCED_RENDERING");
+  COIN_INSTANCED_RENDERING = env ? atoi(env) : 0;
+
+  SoGLRenderQueue::initClass();
+  SoGLInstancer::initClass();
 }
 
 // *************************************************************************
@@ -729,6 +849,7 @@ SoGLRenderAction::SoGLRenderAction(const SbViewportRegion & viewportregion)
   PRIVATE(this)->viewportwidth = 0;
   PRIVATE(this)->sortedlayersblendinitialized = FALSE;
   PRIVATE(this)->sortedlayersblendcounter = 0;
+  PRIVATE(this)->weightedblendactive = FALSE;
   PRIVATE(this)->usenvidiaregistercombiners = FALSE;
   PRIVATE(this)->cachedprofilingsg = NULL;
   PRIVATE(this)->transpobjdepthwrite = FALSE;
@@ -738,6 +859,14 @@ SoGLRenderAction::SoGLRenderAction(const SbViewportRegion & viewportregion)
   PRIVATE(this)->sortedobjectstrategy = BBOX_CENTER;
   PRIVATE(this)->sortedobjectcb = NULL;
   PRIVATE(this)->sortedobjectclosure = NULL;
+
+  PRIVATE(this)->retainedrendering = COIN_RETAINED_RENDERING > 0;
+  PRIVATE(this)->instancedrendering = COIN_INSTANCED_RENDERING > 0;
+  PRIVATE(this)->occlusionculling = COIN_OCCLUSION_CULLING > 0;
+  PRIVATE(this)->occlusionbufferready = FALSE;
+  PRIVATE(this)->occludercamera = NULL;
+  PRIVATE(this)->occludershapestart = 0;
+  PRIVATE(this)->occluderminsize = 0.0f;
 }
 
 /*!
@@ -1073,6 +1202,9 @@ SoGLRenderAction::beginTraversal(SoNode * node)
   if (COIN_GLBBOX) {
     PRIVATE(this)->bboxaction->apply(node);
   }
+  if (PRIVATE(this)->occlusionculling) {
+    PRIVATE(this)->updateOccluders(node);
+  }
   int err_before_init = GL_NO_ERROR;
 
   if (sogl_glerror_debugging()) {
@@ -1237,6 +1369,27 @@ SoGLRenderAction::handleTransparency(SbBool istransparent)
     return FALSE;
   }
 
+  if (PRIVATE(this)->transparencytype == WEIGHTED_BLEND && istransparent) {
+    if (PRIVATE(this)->transparencyrender && PRIVATE(this)->weightedblendactive) {
+      SoLazyElement::enableBlending(thestate, GL_ONE, GL_ONE);
+      PRIVATE(this)->weightedblend->setTextured(
+        SoMultiTextureEnabledElement::getMode(thestate, 0) ==
+        SoMultiTextureEnabledElement::TEXTURE2D);
+      return FALSE;
+    }
+    // plain blending if the weighted blend buffers could not be set up
+    if (PRIVATE(this)->transparencyrender || PRIVATE(this)->delayedpathrender) {
+      SoLazyElement::enableBlending(thestate, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      return FALSE;
+    }
+    PRIVATE(this)->addTransPath(this->getCurPath()->copy());
+    SoCacheElement::setInvalid(TRUE);
+    if (thestate->isCacheOpen()) {
+      SoCacheElement::invalidate(thestate);
+    }
+    return TRUE; // delay render
+  }
+
 
   // check common cases first
   if (!istransparent || transptype == SoGLRenderAction::NONE || transptype == SoGLRenderAction::SCREEN_DOOR) {
@@ -1479,7 +1632,9 @@ SoGLRenderAction::invalidateState(void)
   PRIVATE(this)->needglinit = TRUE;
 }
 
-// Sort paths with transparent objects before rendering.
+// Sort paths with transparent objects before rendering. The depth
+// sorter starts from the order of the previous frame, which is close
+// to right when the camera has moved only a little.
 void
 SoGLRenderActionP::doPathSort(void)
 {
@@ -1488,26 +1643,21 @@ SoGLRenderActionP::doPathSort(void)
   SbPList * plist = &this->sorttranspobjpaths;
   float * darray = const_cast<float *>(this->sorttranspobjdistances.getArrayPtr());
 
-  int i, j, distance, n = this->sorttranspobjdistances.getLength();
-  void * ptmp;
-  float dtmp;
-
-  // shell sort algorithm (O(nlog(n))
-  for (distance = 1; distance <= n/9; distance = 3*distance + 1) ;
-  for (; distance > 0; distance /= 3) {
-    for (i = distance; i < n; i++) {
-      dtmp = darray[i];
-      ptmp = plist->get(i);
-      j = i;
-      while (j >= distance && darray[j-distance] < dtmp) {
-        darray[j] = darray[j-distance];
-        plist->set(j, plist->get(j-distance));
-        j -= distance;
-      }
-      darray[j] = dtmp;
-      plist->set(j, ptmp);
-    }
+  const int n = this->sorttranspobjdistances.getLength();
+  if (n < 2) return;
+  this->depthsorter.sort(darray, n);
+  const int * order = this->depthsorter.getOrder();
+
+  SbPList & scratch = this->sorttranspobjscratch;
+  scratch.truncate(0);
+  int i;
+  for (i = 0; i < n; i++) {
+    scratch.append(plist->get(i));
   }
+  for (i = 0; i < n; i++) {
+    plist->set(i, scratch[order[i]]);
+  }
+  scratch.truncate(0);
 }
 
 /*!
@@ -1580,9 +1730,375 @@ SoGLRenderAction::setSortedObjectOrderStrategy(const SortedObjectOrderStrategy s
   PRIVATE(this)->sortedobjectclosure = closure;
 }
 
+/*!
+  Enables or disables occlusion culling. Default is off, unless the
+  environment variable COIN_OCCLUSION_CULLING is set to 1.
+
+  With occlusion culling, large opaque shapes in the scene graph are
+  rasterized into a low resolution depth buffer on the CPU before each
+  frame, and SoSeparator nodes with a bounding box that is completely
+  hidden behind them are not rendered. Like view frustum culling, this
+  depends on the bounding box caches of the separators, which are
+  filled in when the occluders are collected.
+
+  The occluders are the shapes with a bounding box diagonal of at
+  least a tenth of the scene's, and with at most 1024 triangles, and
+  which are not transparent, clipped, drawn as lines or points, or
+  textured with a texture with an alpha channel. They are collected
+  again whenever the scene graph changes, except when only the
+  cameras change. Only shapes seen through the first camera of the
+  scene graph are tested, so a subgraph with its own camera, like a
+  heads-up display, or an SoAnnotation node is never culled. The
+  environment variable COIN_OCCLUSION_CULLING_THREADS sets the number
+  of threads used for rasterizing them.
+
+  \since Coin 4.1
+
+  \sa isOccluded()
+*/
+void
+SoGLRenderAction::setOcclusionCulling(const SbBool onoff)
+{
+  PRIVATE(this)->occlusionculling = onoff;
+  if (!onoff) {
+    PRIVATE(this)->occluders.truncate(0);
+    PRIVATE(this)->occluderkey.truncate(0);
+    PRIVATE(this)->occluderpathnodes.truncate(0);
+    PRIVATE(this)->occludercamera = NULL;
+  }
+}
+
+/*!
+  Returns whether occlusion culling is enabled.
+
+  \since Coin 4.1
+
+  \sa setOcclusionCulling()
+*/
+SbBool
+SoGLRenderAction::isOcclusionCulling(void) const
+{
+  return PRIVATE(this)->occlusionculling;
+}
+
+/*!
+  Returns \c TRUE if \a box, given in the current object space, is
+  completely hidden behind the occluders of the scene graph being
+  rendered. Always returns \c FALSE when occlusion culling is
+  disabled, while delayed paths are rendered, and for other cameras
+  than the first one in the scene graph. This is meant to be called by nodes during traversal.
+
+  \since Coin 4.1
+
+  \sa setOcclusionCulling()
+*/
+SbBool
+SoGLRenderAction::isOccluded(const SbBox3f & box)
+{
+  if (!PRIVATE(this)->occlusionculling ||
+      PRIVATE(this)->occluders.getLength() == 0) return FALSE;
+  // annotations are drawn on top of the occluders
+  if (this->isRenderingDelayedPaths()) return FALSE;
+
+  SoState * state = this->getState();
+  // the occluders only hide what is seen through the camera they were
+  // collected for, not heads-up displays with their own camera
+  if (PRIVATE(this)->occludercamera) {
+    const SoReplacedElement * elem = coin_assert_cast<const SoReplacedElement *>
+      (state->getConstElement(SoViewingMatrixElement::getClassStackIndex()));
+    if (elem->getNodeId() != PRIVATE(this)->occludercamera->getNodeId()) return FALSE;
+  }
+  SbMatrix matrix = SoViewingMatrixElement::get(state);
+  matrix.multRight(SoProjectionMatrixElement::get(state));
+
+  // rasterize the occluders the first time they are needed for a
+  // camera, which is usually once per frame
+  SoOcclusionBuffer * buffer = PRIVATE(this)->occlusionbuffer.get();
+  if (!PRIVATE(this)->occlusionbufferready || matrix != buffer->getMatrix()) {
+    const SbVec2s size = SoViewportRegionElement::get(state).getViewportSizePixels();
+    const int height = (size[0] > 0) ?
+      SbClamp(OCCLUSION_BUFFER_WIDTH * size[1] / size[0], 16, OCCLUSION_BUFFER_WIDTH) :
+      OCCLUSION_BUFFER_WIDTH;
+    if (buffer->getWidth() != OCCLUSION_BUFFER_WIDTH || buffer->getHeight() != height) {
+      buffer->setSize(OCCLUSION_BUFFER_WIDTH, height);
+    }
+    buffer->setMatrix(matrix);
+    buffer->addTriangles(PRIVATE(this)->occluders.getArrayPtr(),
+                         PRIVATE(this)->occluders.getLength() / 3);
+    PRIVATE(this)->occlusionbufferready = TRUE;
+  }
+  return buffer->isOccluded(box, SoModelMatrixElement::get(state));
+}
+
+/*!
+  Enables or disables retained rendering. Default is off, unless the
+  environment variable COIN_RETAINED_RENDERING is set to 1.
+
+  In retained mode, an SoSeparator being rendered records the shapes
+  below each of its child separators as draw items, with the vertex
+  arrays, model matrix and material of each shape. The next time it
+  is rendered, the unchanged children are not traversed. Their draw
+  items are collected instead, and drawn sorted to minimize the number
+  of OpenGL state changes when the separator reaches a child which is
+  not a separator, before that child is traversed. They are also
+  drawn at the end of the frame. This keeps the draw items in order
+  with nodes like lights, cameras, SoDepthBuffer and SoPolygonOffset,
+  and with the shapes which are rendered normally, just like without
+  retained rendering. When a child changes, only the draw items of
+  that child are recorded again. Children of separators with many
+  children are recorded separately, so that edits in a large, flat
+  scene graph are cheap.
+
+  This is a replacement for render caching of static scenes with many
+  shapes. It only applies to opaque, untextured, filled shapes
+  without shaders, and not with the SORTED_LAYERS_BLEND transparency
+  type or smoothing. Children with other shapes, or with lights or
+  clip planes of their own, are traversed every frame, just like when
+  retained rendering is off.
+
+  \since Coin 4.1
+*/
+void
+SoGLRenderAction::setRetainedRendering(const SbBool onoff)
+{
+  PRIVATE(this)->retainedrendering = onoff;
+}
+
+/*!
+  Returns whether retained rendering is enabled.
+
+  \since Coin 4.1
+
+  \sa setRetainedRendering()
+*/
+SbBool
+SoGLRenderAction::isRetainedRendering(void) const
+{
+  return PRIVATE(this)->retainedrendering;
+}
+
+/*!
+  Enables or disables instanced rendering. Default is off, unless the
+  environment variable COIN_INSTANCED_RENDERING is set to 1.
+
+  When enabled, the children of an SoMultipleCopy or SoArray are
+  traversed once, and the shapes found are drawn for all the copies
+  with one instanced draw call per shape, with the matrix of each
+  copy taken from a vertex buffer. Much like retained rendering, the
+  shapes are recorded again only when the node, its children or the
+  state they depend on change.
+
+  It only applies to the same shapes as retained rendering: opaque,
+  untextured, filled shapes without shaders. Lighting is done in a
+  vertex shader which follows the fixed function pipeline. Copies
+  with other shapes, children which select what to render with
+  SoSwitch::SO_SWITCH_INHERIT, and copies rendered with active clip
+  planes, shaders or retained rendering are traversed once per copy
+  just like when instanced rendering is off. Instanced rendering also
+  needs vertex buffer objects, vertex shaders, and
+  GL_ARB_draw_instanced and GL_ARB_instanced_arrays or OpenGL 3.3.
+
+  \since Coin 4.1
+
+  \sa setRetainedRendering()
+*/
+void
+SoGLRenderAction::setInstancedRendering(const SbBool onoff)
+{
+  PRIVATE(this)->instancedrendering = onoff;
+}
+
+/*!
+  Returns whether instanced rendering is enabled.
+
+  \since Coin 4.1
+
+  \sa setInstancedRendering()
+*/
+SbBool
+SoGLRenderAction::isInstancedRendering(void) const
+{
+  return PRIVATE(this)->instancedrendering;
+}
+
 // *************************************************************************
 // methods in SoGLRenderActionP
 
+// Collects the occluder triangles of the scene graph if its content
+// has changed since the last time, and makes the occlusion buffer be
+// rasterized again for the new frame. Moving the cameras changes the
+// node id of the root, so the cameras are left out of the comparison.
+void
+SoGLRenderActionP::updateOccluders(SoNode * root)
+{
+  this->occlusionbufferready = FALSE;
+  if (!this->occlusionbuffer) {
+    this->occlusionbuffer.reset(new SoOcclusionBuffer);
+    this->occlusionbuffer->setNumThreads(COIN_OCCLUSION_CULLING_THREADS);
+  }
+  if (this->occluderkey.getLength() > 0) {
+    SbList<SbUniqueId> key;
+    this->getOccluderKey(root, key);
+    if (key == this->occluderkey) return;
+  }
+  this->findOccluderCameras(root);
+  this->occluderkey.truncate(0);
+  this->getOccluderKey(root, this->occluderkey);
+  this->occluders.truncate(0);
+
+  // this also fills in the bounding box caches used for culling
+  this->bboxaction->apply(root);
+  const SbBox3f & scenebox = this->bboxaction->getBoundingBox();
+  if (scenebox.isEmpty()) return;
+  this->occluderminsize = OCCLUDER_MIN_SIZE * (scenebox.getMax() - scenebox.getMin()).length();
+
+  SoCallbackAction cbaction(this->viewport);
+  cbaction.addPreCallback(SoShape::getClassTypeId(), SoGLRenderActionP::occluderPreCB, this);
+  cbaction.addPostCallback(SoShape::getClassTypeId(), SoGLRenderActionP::occluderPostCB, this);
+  cbaction.addTriangleCallback(SoShape::getClassTypeId(), SoGLRenderActionP::occluderTriangleCB, this);
+  cbaction.apply(root);
+}
+
+// Finds the cameras of the scene graph, and the plain grouping nodes
+// on the paths to them which getOccluderKey() looks into. The first
+// camera is the one the occluders are tested with.
+void
+SoGLRenderActionP::findOccluderCameras(SoNode * root)
+{
+  this->occluderpathnodes.truncate(0);
+  this->occludercamera = NULL;
+
+  SoSearchAction sa;
+  sa.setType(SoCamera::getClassTypeId());
+  sa.setInterest(SoSearchAction::ALL);
+  sa.apply(root);
+  const SoPathList & paths = sa.getPaths();
+  for (int i = 0; i < paths.getLength(); i++) {
+    const SoFullPath * path = reclassify_cast<const SoFullPath *>(paths[i]);
+    SoNode * camera = path->getTail();
+    if (i == 0) {
+      // keeps the camera referenced
+      this->occludercamera = camera;
+      this->occluderpathnodes.append(camera);
+    }
+    int j;
+    for (j = 0; j < path->getLength() - 1; j++) {
+      SoNode * node = path->getNode(j);
+      const SoType type = node->getTypeId();
+      // other groups may change which children are traversed on their own
+      if (type != SoGroup::getClassTypeId() &&
+          type != SoSeparator::getClassTypeId() &&
+          type != SoTransformSeparator::getClassTypeId() &&
+          type != SoSwitch::getClassTypeId()) break;
+      if (this->occluderpathnodes.find(node) < 0) this->occluderpathnodes.append(node);
+    }
+    if (j == path->getLength() - 1 && this->occluderpathnodes.find(camera) < 0) {
+      this->occluderpathnodes.append(camera);
+    }
+  }
+  sa.reset();
+}
+
+// Appends a key for the content of the subgraph below node to key,
+// which does not change when the cameras found by
+// findOccluderCameras() are modified. It holds the node ids of the
+// other nodes, and the number of children of the groups on the paths
+// to the cameras, which are marked with ids no node gets, so that two
+// keys are only equal for the same content.
+void
+SoGLRenderActionP::getOccluderKey(SoNode * node, SbList<SbUniqueId> & key) const
+{
+  static const SbUniqueId GROUP = ~SbUniqueId(0);
+  static const SbUniqueId CAMERA = ~SbUniqueId(0) - 1;
+
+  SoChildList * children = node->getChildren();
+  if (this->occluderpathnodes.find(node) < 0) {
+    key.append(node->getNodeId());
+  }
+  else if (node->isOfType(SoCamera::getClassTypeId())) {
+    key.append(CAMERA);
+  }
+  else if (!children) {
+    key.append(node->getNodeId());
+  }
+  else {
+    key.append(GROUP);
+    key.append(children->getLength());
+    if (node->isOfType(SoSwitch::getClassTypeId())) {
+      key.append(SbUniqueId(coin_assert_cast<SoSwitch *>(node)->whichChild.getValue()));
+    }
+    for (int i = 0; i < children->getLength(); i++) {
+      this->getOccluderKey((*children)[i], key);
+    }
+  }
+}
+
+SoCallbackAction::Response
+SoGLRenderActionP::occluderPreCB(void * closure, SoCallbackAction * action,
+                                 const SoNode * node)
+{
+  SoGLRenderActionP * thisp = static_cast<SoGLRenderActionP *>(closure);
+  // bitmaps and images may have transparent pixels
+  if (node->isOfType(SoText2::getClassTypeId()) ||
+      node->isOfType(SoImage::getClassTypeId()) ||
+      action->getDrawStyle() != SoDrawStyle::FILLED) {
+    return SoCallbackAction::PRUNE;
+  }
+  SoState * state = action->getState();
+  for (int i = 0; i < SoLazyElement::getInstance(state)->getNumTransparencies(); i++) {
+    if (SoLazyElement::getTransparency(state, i) > 0.0f) return SoCallbackAction::PRUNE;
+  }
+  // textures with alpha and clip planes let parts of the shape be
+  // seen through
+  if (SoMultiTextureImageElement::containsTransparency(state) ||
+      SoClipPlaneElement::getInstance(state)->getNum() > 0) {
+    return SoCallbackAction::PRUNE;
+  }
+
+  SbBox3f box;
+  SbVec3f center;
+  const_cast<SoShape *>(coin_assert_cast<const SoShape *>(node))->computeBBox(action, box, center);
+  if (box.isEmpty()) return SoCallbackAction::PRUNE;
+  box.transform(action->getModelMatrix());
+  if ((box.getMax() - box.getMin()).length() < thisp->occluderminsize) {
+    return SoCallbackAction::PRUNE;
+  }
+  thisp->occludershapestart = thisp->occluders.getLength();
+  return SoCallbackAction::CONTINUE;
+}
+
+SoCallbackAction::Response
+SoGLRenderActionP::occluderPostCB(void * closure, SoCallbackAction * COIN_UNUSED_ARG(action),
+                                  const SoNode * COIN_UNUSED_ARG(node))
+{
+  SoGLRenderActionP * thisp = static_cast<SoGLRenderActionP *>(closure);
+  // too detailed shapes are not worth rasterizing
+  if (thisp->occluders.getLength() - thisp->occludershapestart >
+      3 * OCCLUDER_MAX_SHAPE_TRIANGLES) {
+    thisp->occluders.truncate(thisp->occludershapestart);
+  }
+  thisp->occludershapestart = thisp->occluders.getLength();
+  return SoCallbackAction::CONTINUE;
+}
+
+void
+SoGLRenderActionP::occluderTriangleCB(void * closure, SoCallbackAction * action,
+                                      const SoPrimitiveVertex * v1,
+                                      const SoPrimitiveVertex * v2,
+                                      const SoPrimitiveVertex * v3)
+{
+  SoGLRenderActionP * thisp = static_cast<SoGLRenderActionP *>(closure);
+  if (thisp->occluders.getLength() >= 3 * OCCLUDER_MAX_TRIANGLES) return;
+  const SbMatrix & matrix = action->getModelMatrix();
+  const SoPrimitiveVertex * v[3] = { v1, v2, v3 };
+  for (int i = 0; i < 3; i++) {
+    SbVec3f p;
+    matrix.multVecMatrix(v[i]->getPoint(), p);
+    thisp->occluders.append(p);
+  }
+}
+
+
 // Private function to save transparent paths that need to be sorted.
 // The transparent paths that don't need to be sorted are rendered
 // after the sorted ones.
@@ -1603,22 +2119,13 @@ SoGLRenderActionP::addSortTransPath(SoPath * path)
   SoNode * tail = reclassify_cast<SoFullPath *>(path)->getTail();
   float dist;
   SbBox3f bbox;
-  // test if we can find the bbox using SoShape::getBoundingBoxCache()
-  // or SoShape::computeBBox. This is the common case, and quite a lot
-  // faster than using an SoGetBoundingBoxAction.
+  // shapes keep their bbox between frames in the depth sorter. This
+  // is the common case, and quite a lot faster than using an
+  // SoGetBoundingBoxAction.
   if (tail->isOfType(SoShape::getClassTypeId())) { // common case
     SoShape * tailshape = coin_assert_cast<SoShape *>(tail);
-    const SoBoundingBoxCache * bboxcache = tailshape->getBoundingBoxCache();
     SbVec3f center;
-
-    if (bboxcache && bboxcache->isValid(state)) {
-      bbox = bboxcache->getProjectedBox();
-      if (bboxcache->isCenterSet()) center = bboxcache->getCenter();
-      else center = bbox.getCenter();
-    }
-    else {
-      tailshape->computeBBox(action, bbox, center);
-    }
+    this->depthsorter.getBBox(action, tailshape, bbox, center);
     SoModelMatrixElement::get(state).multVecMatrix(center, center);
     dist = -SoViewVolumeElement::get(state).getPlane(0.0f).getDistance(center);
   }
@@ -1707,7 +2214,8 @@ SoGLRenderActionP::render(SoNode * node)
   SoLazyElement::setTransparencyType(state,
                                      static_cast<int32_t>(this->transparencytype));
 
-  if (this->transparencytype == SoGLRenderAction::SORTED_LAYERS_BLEND) {
+  if (this->transparencytype == SoGLRenderAction::SORTED_LAYERS_BLEND ||
+      this->transparencytype == SoGLRenderAction::WEIGHTED_BLEND) {
     SoOverrideElement::setTransparencyTypeOverride(state, node, TRUE);
   }
 
@@ -1826,6 +2334,7 @@ SoGLRenderActionP::renderSingle(SoNode * node)
   this->transpobjpaths.truncate(0);
   this->sorttranspobjdistances.truncate(0);
   this->delayedpaths.truncate(0);
+  this->depthsorter.beginFrame();
 
   // Do order independent transparency rendering
   if (this->transparencytype == SoGLRenderAction::SORTED_LAYERS_BLEND) {
@@ -1858,16 +2367,48 @@ SoGLRenderActionP::renderSingle(SoNode * node)
     return;
   }
 
+  if (this->transparencytype == SoGLRenderAction::WEIGHTED_BLEND &&
+      !SoGLDriverDatabase::isSupported(sogl_glue_instance(state), SO_GL_WEIGHTED_BLEND)) {
+    SoDebugError::postWarning("renderSingle", "Weighted blend cannot be enabled "
+                              "due to missing OpenGL extensions. Rendering using "
+                              "SORTED_OBJECT_BLEND instead.");
+    this->transparencytype = SoGLRenderAction::SORTED_OBJECT_BLEND;
+    render(node); // Render again using the fallback transparency type.
+    return;
+  }
+
+  if (this->transparencytype == SoGLRenderAction::WEIGHTED_BLEND) {
+    // the depth buffer of the opaque objects can not be copied into a
+    // texture from a multisampled framebuffer
+    GLint samplebuffers = 0;
+    glGetIntegerv(GL_SAMPLE_BUFFERS_ARB, &samplebuffers);
+    if (samplebuffers > 0) {
+      this->transparencytype = SoGLRenderAction::SORTED_OBJECT_BLEND;
+      render(node);
+      this->transparencytype = SoGLRenderAction::WEIGHTED_BLEND;
+      return;
+    }
+  }
+
   this->action->beginTraversal(node);
 
   if ((this->transpobjpaths.getLength() || this->sorttranspobjpaths.getLength()) &&
       !this->action->hasTerminated()) {
 
     this->transparencyrender = TRUE;
+
+    // weighted blend renders all transparent objects in one pass into
+    // separate buffers, which are blended onto the opaque objects
+    // afterwards
+    if (this->transparencytype == SoGLRenderAction::WEIGHTED_BLEND) {
+      if (!this->weightedblend) this->weightedblend.reset(new SoGLWeightedBlend);
+      this->weightedblendactive = this->weightedblend->begin(state);
+    }
+
     // disable writing into the z-buffer when rendering transparent
     // objects
-
-    if (!this->transpobjdepthwrite) {
+    const SbBool depthwrite = this->transpobjdepthwrite && !this->weightedblendactive;
+    if (!depthwrite) {
       SoDepthBufferElement::set(state, TRUE, FALSE,
                                 SoDepthBufferElement::LEQUAL,
                                 SbVec2f(0.0f, 1.0f));
@@ -1880,7 +2421,8 @@ SoGLRenderActionP::renderSingle(SoNode * node)
     default:
       break;
     case SoGLRenderAction::NONSOLID_SEPARATE_BACKFACE_PASS:
-      numtransppasses = 2;
+      // the order does not matter for weighted blend
+      if (!this->weightedblendactive) numtransppasses = 2;
       break;
     }
 
@@ -1922,8 +2464,12 @@ SoGLRenderActionP::renderSingle(SoNode * node)
       // Render all transparent paths that should not be sorted
       this->action->apply(this->transpobjpaths, TRUE);
     }
+    if (this->weightedblendactive) {
+      this->weightedblend->end(state);
+      this->weightedblendactive = FALSE;
+    }
     // enable writing again. FIXME: consider if it is OK to push/pop state instead
-    if (!this->transpobjdepthwrite) {
+    if (!depthwrite) {
       SoDepthBufferElement::set(state, TRUE, TRUE,
                                 SoDepthBufferElement::LEQUAL,
                                 SbVec2f(0.0f, 1.0f));
@@ -1942,7 +2488,7 @@ SoGLRenderActionP::renderSingle(SoNode * node)
   this->transpobjpaths.truncate(0);
   this->sorttranspobjdistances.truncate(0);
   this->delayedpaths.truncate(0);
-
+  this->depthsorter.endFrame();
 }
 
 void
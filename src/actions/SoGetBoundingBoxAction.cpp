@@ -76,6 +76,12 @@
   use the getXfBoundingBox() method after having applied the
   SoGetBoundingBoxAction.
 
+  For large scene graphs with cold caches (for instance right after
+  loading a big model), the action can be told to fill in the
+  bounding box caches of independent SoSeparator subgraphs on several
+  threads before the ordinary traversal, see setNumThreads(). The
+  result is identical to a single-threaded traversal.
+
   \sa SoSeparator::boundingBoxCaching
 */
 
@@ -88,13 +94,34 @@
 #include <Inventor/lists/SoEnabledElementsList.h>
 #include <Inventor/misc/SoState.h>
 #include <Inventor/nodes/SoNode.h>
+#include <Inventor/nodes/SoCallback.h>
+#include <Inventor/nodes/SoFile.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoSurroundScale.h>
+#include <Inventor/nodes/SoWWWInline.h>
+#include <Inventor/VRMLnodes/SoVRMLInline.h>
+#include <Inventor/fields/SoField.h>
+#include <Inventor/fields/SoFieldData.h>
+#include <Inventor/misc/SoChildList.h>
+#include <Inventor/lists/SbList.h>
+#include <Inventor/C/tidbits.h>
 
 #if COIN_DEBUG
 #include <Inventor/errors/SoDebugError.h>
 #endif // COIN_DEBUG
 
 #include "actions/SoSubActionP.h"
+#include "misc/SbHash.h"
 #include "SbBasicP.h"
+#include "tidbitsp.h"
+
+#ifdef HAVE_THREADS
+#include <Inventor/C/threads/mutex.h>
+#include <Inventor/C/threads/thread.h>
+#include <Inventor/C/threads/wpool.h>
+#endif // HAVE_THREADS
+
+#include <cstdlib>
 
 // FIXME: kristian investigated the assumed bug-cases listed below,
 // and found that it is fundamentally impossible making a perfect fit
@@ -218,10 +245,46 @@
   \COININTERNAL
 */
 
+// A separator which gets its bounding box cache filled in ahead of
+// the traversal. The child indices lead from the root of the
+// traversal down to the separator.
+struct sogetbbox_task {
+  SoNode * node;
+  SbList<int> indices;
+};
+
 class SoGetBoundingBoxActionP {
 public:
+  SoGetBoundingBoxActionP(void);
+  ~SoGetBoundingBoxActionP();
+
+  static SbBool isPlainGroup(const SoNode * node);
+  static SbBool hasConnections(const SoNode * node);
+  static SbBool collectTasks(SoNode * group, const SbList<int> & indices,
+                             SbList<sogetbbox_task *> & tasks);
+  static SbBool isTaskSafe(const SoNode * node);
+  static void runJobs(void * closure);
+
+  void fillCaches(const SbViewportRegion & vp, SoNode * root);
+  void replayPath(SoGetBoundingBoxAction * action);
+  void replayState(SoGetBoundingBoxAction * action, SoNode * node);
+
+  int numthreads;
+  // the scene graph the caches were last filled in for
+  SbUniqueId filledid;
+  SbViewportRegion filledvp;
+  // only set for the actions doing the work in fillCaches()
+  SoNode * root;
+  const sogetbbox_task * task;
+
+#ifdef HAVE_THREADS
+  cc_wpool * pool;
+#endif // HAVE_THREADS
+  SbList<SoGetBoundingBoxAction *> workeractions;
 };
 
+#define PRIVATE(obj) obj->pimpl
+
 SO_ACTION_SOURCE(SoGetBoundingBoxAction);
 
 
@@ -590,6 +653,61 @@ SoGetBoundingBoxAction::resetCenter(void)
   this->center.setValue(0.0f, 0.0f, 0.0f);
 }
 
+/*!
+  Sets the number of threads used for filling in the bounding box
+  caches of SoSeparator nodes when the action is applied to a node.
+  Pass 0 to use one thread per processor. The default is 1, which
+  means that all work is done by the thread calling apply(), unless
+  the environment variable COIN_BOUNDING_BOX_THREADS is set.
+
+  With more than one thread, independent SoSeparator subgraphs get
+  their caches filled in concurrently, each with its own traversal
+  state, before the ordinary traversal picks up the cached
+  results. This only pays off when the caches are cold, and the
+  calculated bounding box and center point are the same as for a
+  single thread.
+
+  Traversing the scene graph from several threads at once is only
+  safe when Coin is built with COIN_THREADSAFE. In other builds, all
+  work is done by the thread calling apply(), whatever the number of
+  threads is set to.
+
+  Subgraphs which can not safely be traversed from other threads,
+  like those containing SoCallback, SoSurroundScale or inline nodes,
+  or nodes with connected fields, are left to the ordinary
+  traversal. The same goes for applying the action to paths, and
+  for camera space or reset path calculations.
+
+  \since Coin 4.1
+
+  \sa getNumThreads()
+*/
+void
+SoGetBoundingBoxAction::setNumThreads(const int num)
+{
+  PRIVATE(this)->numthreads = (num > 0) ? num : coin_num_processors();
+}
+
+/*!
+  Returns the number of threads used for filling in bounding box
+  caches. This is always 1 when Coin is not built with
+  COIN_THREADSAFE, whatever the number set with setNumThreads().
+
+  \since Coin 4.1
+
+  \sa setNumThreads()
+*/
+int
+SoGetBoundingBoxAction::getNumThreads(void) const
+{
+#if defined(HAVE_THREADS) && defined(COIN_THREADSAFE)
+  if (cc_thread_implementation() != CC_NO_THREADS) {
+    return PRIVATE(this)->numthreads;
+  }
+#endif // HAVE_THREADS && COIN_THREADSAFE
+  return 1;
+}
+
 // Documented in superclass. Overridden to reset center point and
 // bounding box before traversal starts.
 void
@@ -599,5 +717,475 @@ SoGetBoundingBoxAction::beginTraversal(SoNode * node)
   this->bbox.makeEmpty();
 
   SoViewportRegionElement::set(this->getState(), this->vpregion);
+
+  if (PRIVATE(this)->task) {
+    // Filling in the cache of a single separator from
+    // SoGetBoundingBoxActionP::fillCaches(). The state is set up as
+    // it will be when the ordinary traversal reaches the separator,
+    // so the cache will be found valid then.
+    SoState * state = this->getState();
+    state->push();
+    PRIVATE(this)->replayPath(this);
+    inherited::beginTraversal(node);
+    state->pop();
+    this->resetCenter();
+    return;
+  }
+
+  if (PRIVATE(this)->numthreads > 1 &&
+      this->getWhatAppliedTo() == SoAction::NODE &&
+      !this->isInCameraSpace() && !this->isResetPath()) {
+    PRIVATE(this)->fillCaches(this->vpregion, node);
+  }
   inherited::beginTraversal(node);
 }
+
+// *************************************************************************
+
+SoGetBoundingBoxActionP::SoGetBoundingBoxActionP(void)
+{
+  this->numthreads = 1;
+  const char * env = coin_getenv("COIN_BOUNDING_BOX_THREADS");
+  if (env) {
+    const int num = atoi(env);
+    this->numthreads = (num > 0) ? num : coin_num_processors();
+  }
+  this->filledid = 0;
+  this->root = NULL;
+  this->task = NULL;
+#ifdef HAVE_THREADS
+  this->pool = NULL;
+#endif // HAVE_THREADS
+}
+
+SoGetBoundingBoxActionP::~SoGetBoundingBoxActionP()
+{
+  for (int i = 0; i < this->workeractions.getLength(); i++) {
+    delete this->workeractions[i];
+  }
+#ifdef HAVE_THREADS
+  if (this->pool) { cc_wpool_destruct(this->pool); }
+#endif // HAVE_THREADS
+}
+
+// Groups which are traversed without pushing the state, and which
+// can be descended into when looking for separators.
+SbBool
+SoGetBoundingBoxActionP::isPlainGroup(const SoNode * node)
+{
+  const SoType type = node->getTypeId();
+  return type == SoGroup::getClassTypeId() || type == SoFile::getClassTypeId();
+}
+
+SbBool
+SoGetBoundingBoxActionP::hasConnections(const SoNode * node)
+{
+  // getFieldData() is protected in SoNode
+  const SoFieldContainer * container = node;
+  const SoFieldData * fielddata = container->getFieldData();
+  if (fielddata == NULL) return FALSE;
+  for (int i = 0; i < fielddata->getNumFields(); i++) {
+    if (fielddata->getField(node, i)->isConnected()) return TRUE;
+  }
+  return FALSE;
+}
+
+// Whether a node may be traversed by several threads at once. Nodes
+// with connected fields are excluded, as evaluating them touches the
+// engines and nodes at the other end of the connections.
+SbBool
+SoGetBoundingBoxActionP::isTaskSafe(const SoNode * node)
+{
+  return
+    !node->isOfType(SoCallback::getClassTypeId()) &&
+    !node->isOfType(SoSurroundScale::getClassTypeId()) &&
+    !node->isOfType(SoWWWInline::getClassTypeId()) &&
+    !node->isOfType(SoVRMLInline::getClassTypeId()) &&
+    !SoGetBoundingBoxActionP::hasConnections(node);
+}
+
+// Collects the separators below \a group, in traversal order. Stops
+// and returns FALSE at the first node which affects the state in a
+// way that can not be replayed by replayState().
+SbBool
+SoGetBoundingBoxActionP::collectTasks(SoNode * group,
+                                      const SbList<int> & indices,
+                                      SbList<sogetbbox_task *> & tasks)
+{
+  const SoChildList * children = group->getChildren();
+  for (int i = 0; i < children->getLength(); i++) {
+    SoNode * child = (*children)[i];
+    SbList<int> childindices(indices);
+    childindices.append(i);
+
+    if (child->isOfType(SoSeparator::getClassTypeId())) {
+      sogetbbox_task * task = new sogetbbox_task;
+      task->node = child;
+      task->indices = childindices;
+      tasks.append(task);
+    }
+    else if (SoGetBoundingBoxActionP::isPlainGroup(child)) {
+      if (!SoGetBoundingBoxActionP::collectTasks(child, childindices, tasks)) {
+        return FALSE;
+      }
+    }
+    else if (child->affectsState() &&
+             (child->getChildren() != NULL ||
+              !SoGetBoundingBoxActionP::isTaskSafe(child))) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+// Sets up the state of \a action like it is when the ordinary
+// traversal reaches the separator of the current task.
+void
+SoGetBoundingBoxActionP::replayPath(SoGetBoundingBoxAction * action)
+{
+  SoNode * node = this->root;
+  for (int level = 0; level < this->task->indices.getLength(); level++) {
+    const SoChildList * children = node->getChildren();
+    const int idx = this->task->indices[level];
+    for (int i = 0; i < idx; i++) {
+      this->replayState(action, (*children)[i]);
+    }
+    node = (*children)[idx];
+  }
+  assert(node == this->task->node);
+}
+
+void
+SoGetBoundingBoxActionP::replayState(SoGetBoundingBoxAction * action, SoNode * node)
+{
+  if (SoGetBoundingBoxActionP::isPlainGroup(node)) {
+    const SoChildList * children = node->getChildren();
+    for (int i = 0; i < children->getLength(); i++) {
+      this->replayState(action, (*children)[i]);
+    }
+  }
+  else if (node->affectsState()) {
+    // only state changing nodes accepted by collectTasks() get here,
+    // and their bounding box contribution is thrown away with the
+    // state
+    action->traverse(node);
+  }
+}
+
+// Shared state for the threads filling in caches. A job is a range
+// of tasks which must be done by the same thread, as they share
+// nodes. Jobs are handed out in index order.
+struct sogetbbox_jobs {
+  const SbList<sogetbbox_task *> * tasks;
+  const SbList<int> * jobstart;
+  int next;
+#ifdef HAVE_THREADS
+  cc_mutex * mutex;
+#endif // HAVE_THREADS
+};
+
+struct sogetbbox_worker {
+  sogetbbox_jobs * jobs;
+  SoGetBoundingBoxAction * action;
+};
+
+void
+SoGetBoundingBoxActionP::runJobs(void * closure)
+{
+  sogetbbox_worker * worker = static_cast<sogetbbox_worker *>(closure);
+  sogetbbox_jobs * jobs = worker->jobs;
+  const int numjobs = jobs->jobstart->getLength() - 1;
+  for (;;) {
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_lock(jobs->mutex); }
+#endif // HAVE_THREADS
+    const int idx = jobs->next++;
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_unlock(jobs->mutex); }
+#endif // HAVE_THREADS
+    if (idx >= numjobs) { return; }
+    for (int i = (*jobs->jobstart)[idx]; i < (*jobs->jobstart)[idx+1]; i++) {
+      const sogetbbox_task * task = (*jobs->tasks)[i];
+      PRIVATE(worker->action)->task = task;
+      worker->action->apply(task->node);
+    }
+    PRIVATE(worker->action)->task = NULL;
+  }
+}
+
+static int
+sogetbbox_find(SbList<int> & parent, int idx)
+{
+  while (parent[idx] != idx) {
+    parent[idx] = parent[parent[idx]];
+    idx = parent[idx];
+  }
+  return idx;
+}
+
+// Fills in the bounding box caches of the separators below \a root,
+// distributed over the worker pool and the calling thread.
+void
+SoGetBoundingBoxActionP::fillCaches(const SbViewportRegion & vp, SoNode * rootnode)
+{
+  // without COIN_THREADSAFE, node locks are no-ops and cache
+  // invalidation is tracked in a single global, so the scene graph
+  // can not be traversed from several threads at once
+#if defined(HAVE_THREADS) && defined(COIN_THREADSAFE)
+  if (cc_thread_implementation() == CC_NO_THREADS) return;
+  if (!SoGetBoundingBoxActionP::isPlainGroup(rootnode) &&
+      rootnode->getTypeId() != SoSeparator::getClassTypeId()) return;
+  // nothing has changed below the root since last time, so the
+  // caches are still valid
+  if (rootnode->getNodeId() == this->filledid && vp == this->filledvp) return;
+  this->filledid = rootnode->getNodeId();
+  this->filledvp = vp;
+
+  SbList<sogetbbox_task *> tasks;
+  (void) SoGetBoundingBoxActionP::collectTasks(rootnode, SbList<int>(), tasks);
+
+  // split separators into their children until there are enough
+  // tasks to keep the threads busy
+  SbBool split = TRUE;
+  while (split && tasks.getLength() < 4 * this->numthreads) {
+    split = FALSE;
+    SbList<sogetbbox_task *> splittasks;
+    for (int i = 0; i < tasks.getLength(); i++) {
+      sogetbbox_task * task = tasks[i];
+      SbList<sogetbbox_task *> subtasks;
+      if (task->node->getTypeId() == SoSeparator::getClassTypeId() &&
+          SoGetBoundingBoxActionP::collectTasks(task->node, task->indices, subtasks) &&
+          subtasks.getLength() > 0) {
+        for (int j = 0; j < subtasks.getLength(); j++) {
+          splittasks.append(subtasks[j]);
+        }
+        delete task;
+        split = TRUE;
+      }
+      else {
+        for (int j = 0; j < subtasks.getLength(); j++) { delete subtasks[j]; }
+        splittasks.append(task);
+      }
+    }
+    tasks = splittasks;
+  }
+
+  // Tasks sharing nodes must be done by the same thread, so they are
+  // merged into one job. Tasks with nodes which are unsafe to
+  // traverse concurrently are dropped.
+  const int numtasks = tasks.getLength();
+  SbList<int> parent;
+  SbList<SbBool> safe;
+  SbHash<const SoNode *, int> owner;
+  for (int i = 0; i < numtasks; i++) {
+    parent.append(i);
+    safe.append(TRUE);
+  }
+  for (int i = 0; i < numtasks; i++) {
+    SbList<SoNode *> stack;
+    stack.push(tasks[i]->node);
+    while (stack.getLength() > 0) {
+      SoNode * node = stack.pop();
+      int other;
+      if (owner.get(node, other)) {
+        const int a = sogetbbox_find(parent, i);
+        const int b = sogetbbox_find(parent, other);
+        if (a != b) { parent[SbMax(a, b)] = SbMin(a, b); }
+        continue;
+      }
+      (void) owner.put(node, i);
+      if (!SoGetBoundingBoxActionP::isTaskSafe(node)) { safe[i] = FALSE; }
+      const SoChildList * children = node->getChildren();
+      if (children) {
+        for (int j = children->getLength() - 1; j >= 0; j--) {
+          stack.push((*children)[j]);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < numtasks; i++) {
+    if (!safe[i]) { safe[sogetbbox_find(parent, i)] = FALSE; }
+  }
+
+  // order the tasks by job, keeping the traversal order within each job
+  SbList<int> jobof;
+  SbList<int> jobstart;
+  for (int i = 0; i < numtasks; i++) {
+    const SbBool isjob = parent[i] == i && safe[i];
+    jobof.append(isjob ? jobstart.getLength() : -1);
+    if (isjob) { jobstart.append(0); }
+  }
+  jobstart.append(0);
+  for (int i = 0; i < numtasks; i++) {
+    const int job = jobof[sogetbbox_find(parent, i)];
+    if (job >= 0) { jobstart[job+1]++; }
+  }
+  for (int i = 1; i < jobstart.getLength(); i++) {
+    jobstart[i] += jobstart[i-1];
+  }
+  SbList<int> fillpos(jobstart);
+  SbList<sogetbbox_task *> jobtasks;
+  for (int i = 0; i < jobstart[jobstart.getLength()-1]; i++) {
+    jobtasks.append(NULL);
+  }
+  for (int i = 0; i < numtasks; i++) {
+    const int job = jobof[sogetbbox_find(parent, i)];
+    if (job >= 0) { jobtasks[fillpos[job]++] = tasks[i]; }
+  }
+  const int numjobs = jobstart.getLength() - 1;
+
+  // the calling thread takes part in the work
+  const int numworkers = SbMin(this->numthreads, numjobs) - 1;
+  if (numworkers > 0) {
+    if (this->pool == NULL) {
+      this->pool = cc_wpool_construct(numworkers);
+    }
+    else if (cc_wpool_get_num_workers(this->pool) < numworkers) {
+      cc_wpool_set_num_workers(this->pool, numworkers);
+    }
+    // actions and their states are created up front, in this thread
+    while (this->workeractions.getLength() < numworkers + 1) {
+      SoGetBoundingBoxAction * action = new SoGetBoundingBoxAction(vp);
+      action->setNumThreads(1);
+      this->workeractions.append(action);
+    }
+
+    sogetbbox_jobs jobs;
+    jobs.tasks = &jobtasks;
+    jobs.jobstart = &jobstart;
+    jobs.next = 0;
+    jobs.mutex = cc_mutex_construct();
+
+    SbList<sogetbbox_worker> workers;
+    for (int i = 0; i <= numworkers; i++) {
+      SoGetBoundingBoxAction * action = this->workeractions[i];
+      action->setViewportRegion(vp);
+      (void) action->getState();
+      PRIVATE(action)->root = rootnode;
+      sogetbbox_worker worker;
+      worker.jobs = &jobs;
+      worker.action = action;
+      workers.append(worker);
+    }
+
+    cc_wpool_begin(this->pool, numworkers);
+    for (int i = 0; i < numworkers; i++) {
+      cc_wpool_start_worker(this->pool, SoGetBoundingBoxActionP::runJobs, &workers[i+1]);
+    }
+    cc_wpool_end(this->pool);
+
+    SoGetBoundingBoxActionP::runJobs(&workers[0]);
+    cc_wpool_wait_all(this->pool);
+    cc_mutex_destruct(jobs.mutex);
+
+    for (int i = 0; i <= numworkers; i++) {
+      PRIVATE(this->workeractions[i])->root = NULL;
+    }
+  }
+
+  for (int i = 0; i < numtasks; i++) { delete tasks[i]; }
+#endif // HAVE_THREADS && COIN_THREADSAFE
+}
+
+#undef PRIVATE
+
+#ifdef COIN_TEST_SUITE
+
+#include <config.h> // HAVE_THREADS and COIN_THREADSAFE
+#include <Inventor/nodes/SoCallback.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoGroup.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoSphere.h>
+#include <Inventor/nodes/SoTransform.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static SoSeparator *
+sogetbbox_test_graph(void)
+{
+  SoSeparator * shared = new SoSeparator;
+  SoTranslation * sharedt = new SoTranslation;
+  sharedt->translation = SbVec3f(0.0f, 0.0f, 3.0f);
+  shared->addChild(sharedt);
+  shared->addChild(new SoSphere);
+
+  SoSeparator * root = new SoSeparator;
+  for (int i = 0; i < 6; i++) {
+    SoTransform * t = new SoTransform;
+    t->translation = SbVec3f(float(i), 0.0f, 0.0f);
+    t->rotation = SbRotation(SbVec3f(0.0f, 1.0f, 1.0f), 0.3f * i);
+    root->addChild(t);
+    SoGroup * group = new SoGroup;
+    root->addChild(group);
+    for (int j = 0; j < 4; j++) {
+      SoSeparator * sep = new SoSeparator;
+      SoTranslation * st = new SoTranslation;
+      st->translation = SbVec3f(0.0f, float(j), 0.0f);
+      sep->addChild(st);
+      sep->addChild(new SoCube);
+      if (j == i % 4) { sep->addChild(shared); }
+      if (i == 3 && j == 2) { sep->addChild(new SoCallback); }
+      group->addChild(sep);
+    }
+  }
+  return root;
+}
+
+static SbBool
+sogetbbox_test_same(SoGetBoundingBoxAction & a1, SoGetBoundingBoxAction & a2)
+{
+  const SbXfBox3f & b1 = a1.getXfBoundingBox();
+  const SbXfBox3f & b2 = a2.getXfBoundingBox();
+  return
+    b1.SbBox3f::getMin() == b2.SbBox3f::getMin() &&
+    b1.SbBox3f::getMax() == b2.SbBox3f::getMax() &&
+    b1.getTransform() == b2.getTransform() &&
+    a1.getCenter() == a2.getCenter();
+}
+
+BOOST_AUTO_TEST_CASE(parallelCacheFilling)
+{
+  SoSeparator * root1 = sogetbbox_test_graph();
+  root1->ref();
+  SoSeparator * root2 = sogetbbox_test_graph();
+  root2->ref();
+
+  SbViewportRegion vp(640, 480);
+  SoGetBoundingBoxAction serial(vp);
+  serial.setNumThreads(1);
+  SoGetBoundingBoxAction parallel(vp);
+  parallel.setNumThreads(4);
+#if defined(HAVE_THREADS) && defined(COIN_THREADSAFE)
+  BOOST_CHECK_EQUAL(parallel.getNumThreads(), 4);
+#else // !(HAVE_THREADS && COIN_THREADSAFE)
+  // the caches are filled in by the calling thread in this build, so
+  // this only checks the sequential fallback
+  BOOST_CHECK_EQUAL(parallel.getNumThreads(), 1);
+#endif // !(HAVE_THREADS && COIN_THREADSAFE)
+
+  serial.apply(root1);
+  parallel.apply(root2);
+  BOOST_CHECK_MESSAGE(!serial.getXfBoundingBox().isEmpty(), "bounding box should not be empty");
+  BOOST_CHECK_MESSAGE(sogetbbox_test_same(serial, parallel),
+                      "threaded calculation should give the same result");
+
+  // the caches filled in by the threads should give the same result
+  serial.apply(root2);
+  BOOST_CHECK_MESSAGE(sogetbbox_test_same(serial, parallel),
+                      "cached result should be the same");
+
+  // change something deep down and check again
+  SoTranslation * t1 = static_cast<SoTranslation *>(static_cast<SoSeparator *>(static_cast<SoGroup *>(root1->getChild(3))->getChild(2))->getChild(0));
+  SoTranslation * t2 = static_cast<SoTranslation *>(static_cast<SoSeparator *>(static_cast<SoGroup *>(root2->getChild(3))->getChild(2))->getChild(0));
+  t1->translation = SbVec3f(5.0f, 10.0f, 0.0f);
+  t2->translation = SbVec3f(5.0f, 10.0f, 0.0f);
+  serial.apply(root1);
+  parallel.apply(root2);
+  BOOST_CHECK_MESSAGE(sogetbbox_test_same(serial, parallel),
+                      "threaded calculation should give the same result after a change");
+
+  root1->unref();
+  root2->unref();
+}
+
+#endif // COIN_TEST_SUITE
@@ -56,6 +56,8 @@
 #include <Inventor/errors/SoDebugError.h>
 #endif // COIN_DEBUG
 
+#include "base/SbVec3fBatch.h"
+
 /*!
   \fn SbBox3f::SbBox3f(void)
   The default constructor makes an empty box.
@@ -268,6 +270,41 @@ SbBox3f::extendBy(const SbBox3f & box)
   }
 }
 
+/*!
+  Extend the boundaries of the box by the \a num points in the \a points
+  array. This gives the same result as calling extendBy() for each
+  point, but is faster for large arrays.
+
+  \since Coin 4.1
+ */
+void
+SbBox3f::extendBy(const SbVec3f * points, const int num)
+{
+  if (num <= 0) { return; }
+
+  SbVec3f min, max;
+  SbVec3fBatch::getBounds(points, num, min, max);
+  this->extendBy(SbBox3f(min, max));
+}
+
+/*!
+  Extend the boundaries of the box by the \a num points in the \a points
+  array, after transforming them with \a matrix. This gives the same
+  result as calling SbMatrix::multVecMatrix() and extendBy() for each
+  point, without storing the transformed points.
+
+  \since Coin 4.1
+ */
+void
+SbBox3f::extendBy(const SbVec3f * points, const int num, const SbMatrix & matrix)
+{
+  if (num <= 0) { return; }
+
+  SbVec3f min, max;
+  SbVec3fBatch::getBounds(matrix, points, num, min, max);
+  this->extendBy(SbBox3f(min, max));
+}
+
 /*!
   Check if the given point lies within the boundaries of this box.
  */
@@ -133,6 +133,7 @@
 #endif // COIN_DEBUG
 
 #include "coindefs.h" // COIN_STUB()
+#include "base/SbVec3fBatch.h"
 
 #ifndef COIN_WORKAROUND_NO_USING_STD_FUNCS
 using std::memmove;
@@ -1497,6 +1498,23 @@ SbMatrix::multVecMatrix(const SbVec4f & src, SbVec4f & dst) const
   dst[3] = (s[0]*t0[3] + s[1]*t1[3] + s[2]*t2[3] + s[3]*t3[3]);
 }
 
+/*!
+  \overload
+
+  Multiplies \a num vectors from \a src with the matrix and stores the
+  results in \a dst. The results are the same as when calling
+  multVecMatrix() for each vector, but faster for large arrays, as
+  the vectors are processed with the SIMD instructions of the CPU
+  where available. \a src and \a dst can be the same array.
+
+  \since Coin 4.1
+*/
+void
+SbMatrix::multVecMatrix(const SbVec3f * src, SbVec3f * dst, const int num) const
+{
+  SbVec3fBatch::multVecMatrix(*this, src, dst, num);
+}
+
 /*!
   Multiplies \a src by the matrix. \a src is assumed to be a direction
   vector, and the translation components of the matrix are therefore
@@ -1525,6 +1543,21 @@ SbMatrix::multDirMatrix(const SbVec3f & src, SbVec3f & dst) const
   dst[2] = s[0]*t0[2] + s[1]*t1[2] + s[2]*t2[2];
 }
 
+/*!
+  \overload
+
+  Multiplies \a num direction vectors from \a src with the matrix and
+  stores the results in \a dst. See the array version of
+  multVecMatrix() for more information.
+
+  \since Coin 4.1
+*/
+void
+SbMatrix::multDirMatrix(const SbVec3f * src, SbVec3f * dst, const int num) const
+{
+  SbVec3fBatch::multDirMatrix(*this, src, dst, num);
+}
+
 /*!
   Multiplies line point with the full matrix and multiplies the
   line direction with the matrix without the translation components.
@@ -2053,6 +2086,10 @@ SbMatrixP::decomp_affine(SbMatrixP::HMatrix A, SbMatrixP::AffineParts * parts)
 
 #ifdef COIN_TEST_SUITE
 #include <Inventor/SbDPMatrix.h>
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbRotation.h>
+#include <cstdlib>
+#include <cstring>
 
 BOOST_AUTO_TEST_CASE(constructFromSbDPMatrix) {
   SbMatrixd a(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
@@ -2063,4 +2100,66 @@ BOOST_AUTO_TEST_CASE(constructFromSbDPMatrix) {
   BOOST_CHECK_MESSAGE(b == d,
                       "Equality comparison failed!");
 }
+
+BOOST_AUTO_TEST_CASE(multVecArrays) {
+  const int NUM = 37;
+  SbVec3f points[NUM];
+  srand(42);
+  for (int i = 0; i < NUM; i++) {
+    for (int j = 0; j < 3; j++) {
+      points[i][j] = float(rand() % 2000) * 0.01f - 10.0f;
+    }
+  }
+  SbMatrix affine;
+  affine.setTransform(SbVec3f(1.0f, -2.0f, 3.5f),
+                      SbRotation(SbVec3f(1.0f, 1.0f, 0.0f), 0.7f),
+                      SbVec3f(2.0f, 0.5f, 1.5f));
+  SbMatrix projective = affine;
+  projective[0][3] = 0.01f;
+  projective[2][3] = -0.02f;
+  projective[3][3] = 1.5f;
+  const SbMatrix * matrices[] = { &affine, &projective };
+
+  for (int m = 0; m < 2; m++) {
+    const SbMatrix & matrix = *matrices[m];
+    // all array lengths up to NUM, to test the ends of the SIMD loops
+    for (int n = 1; n <= NUM; n++) {
+      SbVec3f pts[NUM], dirs[NUM];
+      matrix.multVecMatrix(points, pts, n);
+      matrix.multDirMatrix(points, dirs, n);
+      SbBox3f box, xfbox;
+      box.extendBy(points, n);
+      xfbox.extendBy(points, n, matrix);
+
+      SbBox3f expectedbox, expectedxfbox;
+      SbBool ok = TRUE;
+      for (int i = 0; i < n; i++) {
+        SbVec3f pt, dir;
+        matrix.multVecMatrix(points[i], pt);
+        matrix.multDirMatrix(points[i], dir);
+        if (pt != pts[i] || dir != dirs[i]) ok = FALSE;
+        expectedbox.extendBy(points[i]);
+        expectedxfbox.extendBy(pt);
+      }
+      BOOST_CHECK_MESSAGE(ok, "Transformed arrays differ from single vectors");
+      BOOST_CHECK_MESSAGE(box.getMin() == expectedbox.getMin() &&
+                          box.getMax() == expectedbox.getMax(),
+                          "Array bounding box differs");
+      BOOST_CHECK_MESSAGE(xfbox.getMin() == expectedxfbox.getMin() &&
+                          xfbox.getMax() == expectedxfbox.getMax(),
+                          "Transformed array bounding box differs");
+    }
+
+    SbVec3f inplace[NUM];
+    memcpy(inplace, points, sizeof(points));
+    matrix.multVecMatrix(inplace, inplace, NUM);
+    SbBool ok = TRUE;
+    for (int i = 0; i < NUM; i++) {
+      SbVec3f pt;
+      matrix.multVecMatrix(points[i], pt);
+      if (pt != inplace[i]) ok = FALSE;
+    }
+    BOOST_CHECK_MESSAGE(ok, "In place transform differs");
+  }
+}
 #endif //COIN_TEST_SUITE
@@ -376,3 +376,35 @@ SbName::empty(void) // static
   }
   return *emptyname;
 }
+
+#ifdef COIN_TEST_SUITE
+#include <Inventor/SbName.h>
+#include <Inventor/SbString.h>
+
+BOOST_AUTO_TEST_CASE(internManyNames)
+{
+  // enough names to make the name table grow several times
+  const int numnames = 50000;
+  const char ** addresses = new const char *[numnames];
+  for (int i = 0; i < numnames; i++) {
+    SbString str;
+    str.sprintf("internManyNames_%d", i);
+    addresses[i] = SbName(str).getString();
+  }
+  int mismatches = 0;
+  for (int i = 0; i < numnames; i++) {
+    SbString str;
+    str.sprintf("internManyNames_%d", i);
+    const SbName name(str);
+    if (name.getString() != addresses[i] || str != name.getString()) {
+      mismatches++;
+    }
+  }
+  delete[] addresses;
+  BOOST_CHECK_MESSAGE(mismatches == 0,
+                      "names did not keep their addresses when the table grew");
+  BOOST_CHECK_MESSAGE(SbName("").getString() == SbName::empty().getString(),
+                      "empty name not unique");
+}
+
+#endif // COIN_TEST_SUITE
@@ -0,0 +1,362 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SbTriangleBVH SbTriangleBVH.h
+  \brief The SbTriangleBVH class is a bounding volume hierarchy over a set of triangles.
+
+  \ingroup coin_base
+
+  Triangles are added with addTriangle(), and the hierarchy is created
+  by calling build(). Triangles are identified by the order they were
+  added in. The search functions will invoke a callback for every
+  triangle found in a leaf node overlapping the search primitive, so
+  the caller must still do the exact triangle test.
+
+  The tree is a binary tree stored depth first in a single array,
+  split at the median centroid of the longest axis. Each leaf holds
+  at most a few triangles.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "base/SbTriangleBVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+#include <Inventor/SbLine.h>
+
+// *************************************************************************
+
+// maximum number of triangles in a leaf node
+static const int SBTRIANGLEBVH_LEAF_SIZE = 4;
+
+namespace {
+
+class sbtrianglebvh_centroid_less {
+public:
+  sbtrianglebvh_centroid_less(const std::vector<SbVec3f> & c, const int a)
+    : centroids(c), axis(a) { }
+  bool operator()(const int t0, const int t1) const {
+    return this->centroids[t0][this->axis] < this->centroids[t1][this->axis];
+  }
+private:
+  const std::vector<SbVec3f> & centroids;
+  int axis;
+};
+
+} // anonymous namespace
+
+// *************************************************************************
+
+/*!
+  Constructor. Creates an empty hierarchy.
+*/
+SbTriangleBVH::SbTriangleBVH(void)
+{
+}
+
+/*!
+  Destructor.
+*/
+SbTriangleBVH::~SbTriangleBVH(void)
+{
+}
+
+/*!
+  Adds a triangle. The triangle index is the number of triangles
+  added before this one. build() must be called before searching.
+*/
+void
+SbTriangleBVH::addTriangle(const SbVec3f & v0, const SbVec3f & v1, const SbVec3f & v2)
+{
+  this->vertices.push_back(v0);
+  this->vertices.push_back(v1);
+  this->vertices.push_back(v2);
+}
+
+/*!
+  Builds the hierarchy from the triangles added so far.
+*/
+void
+SbTriangleBVH::build(void)
+{
+  const int numtri = this->getNumTriangles();
+  this->nodes.clear();
+  this->order.resize(numtri);
+  this->bbox.makeEmpty();
+  if (numtri == 0) return;
+
+  std::vector<SbVec3f> centroids(numtri);
+  for (int i = 0; i < numtri; i++) {
+    const SbVec3f * v = &this->vertices[i*3];
+    centroids[i] = (v[0] + v[1] + v[2]) / 3.0f;
+    this->order[i] = i;
+  }
+  // a balanced binary tree with small leaves needs less than this
+  this->nodes.reserve(2 * (numtri / SBTRIANGLEBVH_LEAF_SIZE + 1));
+  (void) this->buildRecursive(0, numtri, centroids);
+
+  const Node & root = this->nodes[0];
+  this->bbox.setBounds(root.bmin[0], root.bmin[1], root.bmin[2],
+                       root.bmax[0], root.bmax[1], root.bmax[2]);
+}
+
+/*!
+  Removes all triangles and nodes.
+*/
+void
+SbTriangleBVH::clear(void)
+{
+  std::vector<SbVec3f>().swap(this->vertices);
+  std::vector<int>().swap(this->order);
+  std::vector<Node>().swap(this->nodes);
+  this->bbox.makeEmpty();
+}
+
+/*!
+  Returns the number of triangles added.
+*/
+int
+SbTriangleBVH::getNumTriangles(void) const
+{
+  return static_cast<int>(this->vertices.size() / 3);
+}
+
+/*!
+  Returns the vertices of triangle number \a triangle.
+*/
+void
+SbTriangleBVH::getTriangle(const int triangle,
+                           SbVec3f & v0, SbVec3f & v1, SbVec3f & v2) const
+{
+  assert(triangle >= 0 && triangle < this->getNumTriangles());
+  const SbVec3f * v = &this->vertices[triangle*3];
+  v0 = v[0];
+  v1 = v[1];
+  v2 = v[2];
+}
+
+/*!
+  Returns the bounding box of triangle number \a triangle.
+*/
+SbBox3f
+SbTriangleBVH::getTriangleBox(const int triangle) const
+{
+  assert(triangle >= 0 && triangle < this->getNumTriangles());
+  const SbVec3f * v = &this->vertices[triangle*3];
+  SbBox3f box(v[0], v[0]);
+  box.extendBy(v[1]);
+  box.extendBy(v[2]);
+  return box;
+}
+
+/*!
+  Returns the bounding box of all triangles. Only valid after build()
+  has been called.
+*/
+const SbBox3f &
+SbTriangleBVH::getBoundingBox(void) const
+{
+  return this->bbox;
+}
+
+/*!
+  Returns the number of nodes in the hierarchy.
+*/
+int
+SbTriangleBVH::getNumNodes(void) const
+{
+  return static_cast<int>(this->nodes.size());
+}
+
+// Creates the node for triangles [start, end) in the order array and
+// returns its index.
+int
+SbTriangleBVH::buildRecursive(const int start, const int end,
+                              const std::vector<SbVec3f> & centroids)
+{
+  const int nodeidx = static_cast<int>(this->nodes.size());
+  this->nodes.push_back(Node());
+
+  SbBox3f box, cbox;
+  box.makeEmpty();
+  cbox.makeEmpty();
+  for (int i = start; i < end; i++) {
+    const int t = this->order[i];
+    const SbVec3f * v = &this->vertices[t*3];
+    box.extendBy(v[0]);
+    box.extendBy(v[1]);
+    box.extendBy(v[2]);
+    cbox.extendBy(centroids[t]);
+  }
+
+  Node & node = this->nodes[nodeidx];
+  box.getBounds(node.bmin[0], node.bmin[1], node.bmin[2],
+                node.bmax[0], node.bmax[1], node.bmax[2]);
+
+  float dx, dy, dz;
+  cbox.getSize(dx, dy, dz);
+  int axis = 0;
+  if (dy > dx) axis = 1;
+  if (dz > SbMax(dx, dy)) axis = 2;
+
+  // all centroids in the same spot can't be split further
+  if ((end - start) <= SBTRIANGLEBVH_LEAF_SIZE || cbox.getMax()[axis] <= cbox.getMin()[axis]) {
+    node.offset = start;
+    node.count = end - start;
+    return nodeidx;
+  }
+
+  const int mid = start + (end - start) / 2;
+  std::nth_element(this->order.begin() + start,
+                   this->order.begin() + mid,
+                   this->order.begin() + end,
+                   sbtrianglebvh_centroid_less(centroids, axis));
+
+  (void) this->buildRecursive(start, mid, centroids);
+  const int second = this->buildRecursive(mid, end, centroids);
+  // don't use the node reference here, the node array might have
+  // been reallocated
+  this->nodes[nodeidx].offset = second;
+  this->nodes[nodeidx].count = 0;
+  return nodeidx;
+}
+
+// *************************************************************************
+
+/*!
+  Invokes \a cb for all triangles in leaf nodes intersected by \a
+  line. The line is treated as infinite in both directions.
+*/
+void
+SbTriangleBVH::findTriangles(const SbLine & line,
+                             TriangleCB * cb, void * closure) const
+{
+  if (this->nodes.empty()) return;
+
+  const SbVec3f & pos = line.getPosition();
+  const SbVec3f & dir = line.getDirection();
+
+  // nodes are padded a bit so that the triangles on the boundary of
+  // a flat node are found even with floating point inaccuracies in
+  // the slab test
+  float sx, sy, sz;
+  this->bbox.getSize(sx, sy, sz);
+  const float pad = SbMax(SbMax(sx, sy), sz) * 1.0e-5f + FLT_MIN;
+
+  float invdir[3];
+  for (int i = 0; i < 3; i++) {
+    invdir[i] = (dir[i] != 0.0f) ? 1.0f / dir[i] : FLT_MAX;
+  }
+
+  int stack[64];
+  int stacksize = 0;
+  stack[stacksize++] = 0;
+
+  while (stacksize) {
+    const int nodeidx = stack[--stacksize];
+    const Node & node = this->nodes[nodeidx];
+
+    float tmin = -FLT_MAX;
+    float tmax = FLT_MAX;
+    SbBool hit = TRUE;
+    for (int i = 0; i < 3 && hit; i++) {
+      const float lo = node.bmin[i] - pad;
+      const float hi = node.bmax[i] + pad;
+      if (dir[i] == 0.0f) {
+        if (pos[i] < lo || pos[i] > hi) hit = FALSE;
+      }
+      else {
+        float t0 = (lo - pos[i]) * invdir[i];
+        float t1 = (hi - pos[i]) * invdir[i];
+        if (t0 > t1) { const float tmp = t0; t0 = t1; t1 = tmp; }
+        if (t0 > tmin) tmin = t0;
+        if (t1 < tmax) tmax = t1;
+        if (tmin > tmax) hit = FALSE;
+      }
+    }
+    if (!hit) continue;
+
+    if (node.count) {
+      for (int i = 0; i < node.count; i++) {
+        cb(closure, this->order[node.offset + i]);
+      }
+    }
+    else {
+      assert(stacksize + 2 <= 64);
+      stack[stacksize++] = node.offset;
+      stack[stacksize++] = nodeidx + 1;
+    }
+  }
+}
+
+/*!
+  Invokes \a cb for all triangles in leaf nodes intersecting \a box.
+*/
+void
+SbTriangleBVH::findTriangles(const SbBox3f & box,
+                             TriangleCB * cb, void * closure) const
+{
+  if (this->nodes.empty() || box.isEmpty()) return;
+
+  const SbVec3f & bmin = box.getMin();
+  const SbVec3f & bmax = box.getMax();
+
+  int stack[64];
+  int stacksize = 0;
+  stack[stacksize++] = 0;
+
+  while (stacksize) {
+    const int nodeidx = stack[--stacksize];
+    const Node & node = this->nodes[nodeidx];
+
+    if (bmin[0] > node.bmax[0] || bmax[0] < node.bmin[0] ||
+        bmin[1] > node.bmax[1] || bmax[1] < node.bmin[1] ||
+        bmin[2] > node.bmax[2] || bmax[2] < node.bmin[2]) continue;
+
+    if (node.count) {
+      for (int i = 0; i < node.count; i++) {
+        cb(closure, this->order[node.offset + i]);
+      }
+    }
+    else {
+      assert(stacksize + 2 <= 64);
+      stack[stacksize++] = node.offset;
+      stack[stacksize++] = nodeidx + 1;
+    }
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef COIN_SBTRIANGLEBVH_H
+#define COIN_SBTRIANGLEBVH_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* ! COIN_INTERNAL */
+
+// *************************************************************************
+
+#include <vector>
+
+#include <Inventor/SbVec3f.h>
+#include <Inventor/SbBox3f.h>
+
+class SbLine;
+
+// *************************************************************************
+
+class SbTriangleBVH {
+public:
+  typedef void TriangleCB(void * closure, const int triangle);
+
+  SbTriangleBVH(void);
+  ~SbTriangleBVH(void);
+
+  void addTriangle(const SbVec3f & v0, const SbVec3f & v1, const SbVec3f & v2);
+  void build(void);
+  void clear(void);
+
+  int getNumTriangles(void) const;
+  void getTriangle(const int triangle,
+                   SbVec3f & v0, SbVec3f & v1, SbVec3f & v2) const;
+  SbBox3f getTriangleBox(const int triangle) const;
+  const SbBox3f & getBoundingBox(void) const;
+  int getNumNodes(void) const;
+
+  void findTriangles(const SbLine & line,
+                     TriangleCB * cb, void * closure) const;
+  void findTriangles(const SbBox3f & box,
+                     TriangleCB * cb, void * closure) const;
+
+private:
+  struct Node {
+    float bmin[3];
+    float bmax[3];
+    // for leaves, the first entry in the triangle order array. For
+    // inner nodes, the index of the second child. The first child
+    // always follows its parent.
+    int offset;
+    // number of triangles in leaf, 0 for inner nodes
+    int count;
+  };
+
+  int buildRecursive(const int start, const int end,
+                     const std::vector<SbVec3f> & centroids);
+
+  std::vector<SbVec3f> vertices;
+  std::vector<int> order;
+  std::vector<Node> nodes;
+  SbBox3f bbox;
+};
+
+#endif // !COIN_SBTRIANGLEBVH_H
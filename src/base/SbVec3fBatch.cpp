@@ -0,0 +1,550 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SbVec3fBatch SbVec3fBatch.h
+  \brief The SbVec3fBatch class transforms and bounds arrays of SbVec3f.
+
+  \ingroup coin_base
+
+  This is the implementation behind the array versions of
+  SbMatrix::multVecMatrix(), SbMatrix::multDirMatrix() and
+  SbBox3f::extendBy(), and it is also used directly for the bounding
+  box calculations of the vertex based shapes.
+
+  Which kernel to use is decided the first time one of the functions
+  is called. On x86 CPUs with AVX support, two points are processed
+  per 256-bit register. With SSE2, one point is processed per 128-bit
+  register. On other CPUs, plain loops are used.
+
+  All kernels do the same floating point operations in the same order
+  as the single vector functions in SbMatrix, so for finite input the
+  results are identical no matter which kernel is used. The
+  environment variable COIN_SIMD_KERNEL can be set to "scalar" or
+  "sse2" to avoid using the faster kernels.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "base/SbVec3fBatch.h"
+
+#include <cstring>
+
+#include <Inventor/SbMatrix.h>
+#include <Inventor/C/tidbits.h>
+
+#if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SBVEC3FBATCH_X86 1
+#define SBVEC3FBATCH_TARGET(ext) __attribute__((target(ext)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SBVEC3FBATCH_X86 1
+#define SBVEC3FBATCH_TARGET(ext)
+#include <intrin.h>
+#endif
+
+#ifdef SBVEC3FBATCH_X86
+#include <immintrin.h>
+#endif // SBVEC3FBATCH_X86
+
+// *************************************************************************
+
+namespace {
+
+const float identitymatrix[4][4] = {
+  { 1.0f, 0.0f, 0.0f, 0.0f },
+  { 0.0f, 1.0f, 0.0f, 0.0f },
+  { 0.0f, 0.0f, 1.0f, 0.0f },
+  { 0.0f, 0.0f, 0.0f, 1.0f }
+};
+
+int currentkernel = -1;
+
+// The W component is always 1 for affine matrices, and then the
+// division in SbMatrix::multVecMatrix() can be skipped without
+// changing the result.
+SbBool
+is_projective(const float m[4][4])
+{
+  return
+    m[0][3] != 0.0f || m[1][3] != 0.0f ||
+    m[2][3] != 0.0f || m[3][3] != 1.0f;
+}
+
+// *************************************************************************
+
+void
+multvec_scalar(const float m[4][4], const float * src, float * dst,
+               const int num, const SbBool projective)
+{
+  for (int i = 0; i < num; i++, src += 3, dst += 3) {
+    const float x = src[0], y = src[1], z = src[2];
+    const float W = projective ?
+      x*m[0][3] + y*m[1][3] + z*m[2][3] + m[3][3] : 1.0f;
+    dst[0] = (x*m[0][0] + y*m[1][0] + z*m[2][0] + m[3][0])/W;
+    dst[1] = (x*m[0][1] + y*m[1][1] + z*m[2][1] + m[3][1])/W;
+    dst[2] = (x*m[0][2] + y*m[1][2] + z*m[2][2] + m[3][2])/W;
+  }
+}
+
+void
+multdir_scalar(const float m[4][4], const float * src, float * dst,
+               const int num)
+{
+  for (int i = 0; i < num; i++, src += 3, dst += 3) {
+    const float x = src[0], y = src[1], z = src[2];
+    dst[0] = x*m[0][0] + y*m[1][0] + z*m[2][0];
+    dst[1] = x*m[0][1] + y*m[1][1] + z*m[2][1];
+    dst[2] = x*m[0][2] + y*m[1][2] + z*m[2][2];
+  }
+}
+
+void
+extend_scalar(float * mn, float * mx, const float * p)
+{
+  for (int c = 0; c < 3; c++) {
+    if (p[c] < mn[c]) mn[c] = p[c];
+    if (p[c] > mx[c]) mx[c] = p[c];
+  }
+}
+
+// min, max and sum must be initialized by the caller
+void
+bounds_scalar(const float * src, const int num,
+              float * mn, float * mx, float * sum)
+{
+  for (int i = 0; i < num; i++, src += 3) {
+    extend_scalar(mn, mx, src);
+    if (sum) {
+      sum[0] += src[0];
+      sum[1] += src[1];
+      sum[2] += src[2];
+    }
+  }
+}
+
+void
+xfbounds_scalar(const float m[4][4], const float * src, const int num,
+                float * mn, float * mx, const SbBool projective)
+{
+  float p[3];
+  for (int i = 0; i < num; i++, src += 3) {
+    multvec_scalar(m, src, p, 1, projective);
+    extend_scalar(mn, mx, p);
+  }
+}
+
+// *************************************************************************
+
+#ifdef SBVEC3FBATCH_X86
+
+// Loading four floats from a point reads the first coordinate of the
+// next point, so the last point in an array must be loaded
+// separately. The fourth component is never used.
+
+SBVEC3FBATCH_TARGET("sse2") inline __m128
+load_sse2(const float * src, const SbBool last)
+{
+  return last ? _mm_setr_ps(src[0], src[1], src[2], 0.0f) : _mm_loadu_ps(src);
+}
+
+SBVEC3FBATCH_TARGET("sse2") inline void
+store_sse2(float * dst, const __m128 v)
+{
+  _mm_storel_pi(reinterpret_cast<__m64 *>(dst), v);
+  _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+}
+
+// p * M, computed in the same order as in SbMatrix::multVecMatrix()
+SBVEC3FBATCH_TARGET("sse2") inline __m128
+transform_sse2(const __m128 p, const __m128 * rows, const SbBool projective)
+{
+  __m128 r = _mm_mul_ps(_mm_shuffle_ps(p, p, 0x00), rows[0]);
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0x55), rows[1]));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0xaa), rows[2]));
+  r = _mm_add_ps(r, rows[3]);
+  if (projective) { r = _mm_div_ps(r, _mm_shuffle_ps(r, r, 0xff)); }
+  return r;
+}
+
+SBVEC3FBATCH_TARGET("sse2") void
+multvec_sse2(const float m[4][4], const float * src, float * dst,
+             const int num, const SbBool projective)
+{
+  __m128 rows[4];
+  for (int i = 0; i < 4; i++) { rows[i] = _mm_loadu_ps(m[i]); }
+
+  for (int i = 0; i < num; i++, src += 3, dst += 3) {
+    store_sse2(dst, transform_sse2(load_sse2(src, i == num-1), rows, projective));
+  }
+}
+
+SBVEC3FBATCH_TARGET("sse2") void
+multdir_sse2(const float m[4][4], const float * src, float * dst,
+             const int num)
+{
+  const __m128 r0 = _mm_loadu_ps(m[0]);
+  const __m128 r1 = _mm_loadu_ps(m[1]);
+  const __m128 r2 = _mm_loadu_ps(m[2]);
+
+  for (int i = 0; i < num; i++, src += 3, dst += 3) {
+    const __m128 p = load_sse2(src, i == num-1);
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(p, p, 0x00), r0);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0x55), r1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0xaa), r2));
+    store_sse2(dst, r);
+  }
+}
+
+SBVEC3FBATCH_TARGET("sse2") void
+bounds_sse2(const float * src, const int num,
+            float * mn, float * mx, float * sum)
+{
+  __m128 vmin = _mm_setr_ps(mn[0], mn[1], mn[2], 0.0f);
+  __m128 vmax = _mm_setr_ps(mx[0], mx[1], mx[2], 0.0f);
+  __m128 vsum = sum ? _mm_setr_ps(sum[0], sum[1], sum[2], 0.0f) : _mm_setzero_ps();
+
+  for (int i = 0; i < num; i++, src += 3) {
+    const __m128 p = load_sse2(src, i == num-1);
+    vmin = _mm_min_ps(vmin, p);
+    vmax = _mm_max_ps(vmax, p);
+    if (sum) { vsum = _mm_add_ps(vsum, p); }
+  }
+  store_sse2(mn, vmin);
+  store_sse2(mx, vmax);
+  if (sum) { store_sse2(sum, vsum); }
+}
+
+SBVEC3FBATCH_TARGET("sse2") void
+xfbounds_sse2(const float m[4][4], const float * src, const int num,
+              float * mn, float * mx, const SbBool projective)
+{
+  __m128 rows[4];
+  for (int i = 0; i < 4; i++) { rows[i] = _mm_loadu_ps(m[i]); }
+  __m128 vmin = _mm_setr_ps(mn[0], mn[1], mn[2], 0.0f);
+  __m128 vmax = _mm_setr_ps(mx[0], mx[1], mx[2], 0.0f);
+
+  for (int i = 0; i < num; i++, src += 3) {
+    const __m128 r = transform_sse2(load_sse2(src, i == num-1), rows, projective);
+    vmin = _mm_min_ps(vmin, r);
+    vmax = _mm_max_ps(vmax, r);
+  }
+  store_sse2(mn, vmin);
+  store_sse2(mx, vmax);
+}
+
+// *************************************************************************
+
+// The AVX kernels handle two points per iteration, with one point in
+// each 128-bit half of the registers. The last one or two points are
+// left for the SSE2 kernels, as the second load of an iteration reads
+// the first coordinate of the point after the pair.
+
+SBVEC3FBATCH_TARGET("avx") inline __m256
+load_avx(const float * src)
+{
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src)),
+                              _mm_loadu_ps(src + 3), 1);
+}
+
+SBVEC3FBATCH_TARGET("avx") inline __m256
+transform_avx(const __m256 p, const __m256 * rows, const SbBool projective)
+{
+  __m256 r = _mm256_mul_ps(_mm256_permute_ps(p, 0x00), rows[0]);
+  r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(p, 0x55), rows[1]));
+  r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(p, 0xaa), rows[2]));
+  r = _mm256_add_ps(r, rows[3]);
+  if (projective) { r = _mm256_div_ps(r, _mm256_permute_ps(r, 0xff)); }
+  return r;
+}
+
+SBVEC3FBATCH_TARGET("avx") void
+multvec_avx(const float m[4][4], const float * src, float * dst,
+            const int num, const SbBool projective)
+{
+  __m256 rows[4];
+  for (int i = 0; i < 4; i++) { rows[i] = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m[i])); }
+
+  int i = 0;
+  for (; i + 2 < num; i += 2, src += 6, dst += 6) {
+    const __m256 r = transform_avx(load_avx(src), rows, projective);
+    store_sse2(dst, _mm256_castps256_ps128(r));
+    store_sse2(dst + 3, _mm256_extractf128_ps(r, 1));
+  }
+  multvec_sse2(m, src, dst, num - i, projective);
+}
+
+SBVEC3FBATCH_TARGET("avx") void
+multdir_avx(const float m[4][4], const float * src, float * dst,
+            const int num)
+{
+  const __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m[0]));
+  const __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m[1]));
+  const __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m[2]));
+
+  int i = 0;
+  for (; i + 2 < num; i += 2, src += 6, dst += 6) {
+    const __m256 p = load_avx(src);
+    __m256 r = _mm256_mul_ps(_mm256_permute_ps(p, 0x00), r0);
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(p, 0x55), r1));
+    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(p, 0xaa), r2));
+    store_sse2(dst, _mm256_castps256_ps128(r));
+    store_sse2(dst + 3, _mm256_extractf128_ps(r, 1));
+  }
+  multdir_sse2(m, src, dst, num - i);
+}
+
+SBVEC3FBATCH_TARGET("avx") void
+bounds_avx(const float * src, const int num,
+           float * mn, float * mx, float * sum)
+{
+  __m256 vmin = _mm256_castps128_ps256(_mm_setr_ps(mn[0], mn[1], mn[2], 0.0f));
+  vmin = _mm256_insertf128_ps(vmin, _mm256_castps256_ps128(vmin), 1);
+  __m256 vmax = _mm256_castps128_ps256(_mm_setr_ps(mx[0], mx[1], mx[2], 0.0f));
+  vmax = _mm256_insertf128_ps(vmax, _mm256_castps256_ps128(vmax), 1);
+  // the sum is accumulated one point at a time, to add in the same
+  // order as the other kernels
+  __m128 vsum = sum ? _mm_setr_ps(sum[0], sum[1], sum[2], 0.0f) : _mm_setzero_ps();
+
+  int i = 0;
+  for (; i + 2 < num; i += 2, src += 6) {
+    const __m256 p = load_avx(src);
+    vmin = _mm256_min_ps(vmin, p);
+    vmax = _mm256_max_ps(vmax, p);
+    if (sum) {
+      vsum = _mm_add_ps(vsum, _mm256_castps256_ps128(p));
+      vsum = _mm_add_ps(vsum, _mm256_extractf128_ps(p, 1));
+    }
+  }
+  store_sse2(mn, _mm_min_ps(_mm256_castps256_ps128(vmin), _mm256_extractf128_ps(vmin, 1)));
+  store_sse2(mx, _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1)));
+  if (sum) { store_sse2(sum, vsum); }
+  bounds_sse2(src, num - i, mn, mx, sum);
+}
+
+SBVEC3FBATCH_TARGET("avx") void
+xfbounds_avx(const float m[4][4], const float * src, const int num,
+             float * mn, float * mx, const SbBool projective)
+{
+  __m256 rows[4];
+  for (int i = 0; i < 4; i++) { rows[i] = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(m[i])); }
+  __m256 vmin = _mm256_castps128_ps256(_mm_setr_ps(mn[0], mn[1], mn[2], 0.0f));
+  vmin = _mm256_insertf128_ps(vmin, _mm256_castps256_ps128(vmin), 1);
+  __m256 vmax = _mm256_castps128_ps256(_mm_setr_ps(mx[0], mx[1], mx[2], 0.0f));
+  vmax = _mm256_insertf128_ps(vmax, _mm256_castps256_ps128(vmax), 1);
+
+  int i = 0;
+  for (; i + 2 < num; i += 2, src += 6) {
+    const __m256 r = transform_avx(load_avx(src), rows, projective);
+    vmin = _mm256_min_ps(vmin, r);
+    vmax = _mm256_max_ps(vmax, r);
+  }
+  store_sse2(mn, _mm_min_ps(_mm256_castps256_ps128(vmin), _mm256_extractf128_ps(vmin, 1)));
+  store_sse2(mx, _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1)));
+  xfbounds_sse2(m, src, num - i, mn, mx, projective);
+}
+
+#endif // SBVEC3FBATCH_X86
+
+} // anonymous namespace
+
+// *************************************************************************
+
+/*!
+  Returns the kernel used by the other functions. The first call
+  decides the kernel from getBestKernel() and the COIN_SIMD_KERNEL
+  environment variable.
+*/
+SbVec3fBatch::Kernel
+SbVec3fBatch::getKernel(void)
+{
+  if (currentkernel < 0) {
+    Kernel kernel = SbVec3fBatch::getBestKernel();
+    const char * env = coin_getenv("COIN_SIMD_KERNEL");
+    if (env) {
+      if (strcmp(env, "scalar") == 0) { kernel = SCALAR; }
+      else if (strcmp(env, "sse2") == 0 && kernel > SSE2) { kernel = SSE2; }
+    }
+    currentkernel = kernel;
+  }
+  return static_cast<Kernel>(currentkernel);
+}
+
+/*!
+  Returns the fastest kernel supported by the CPU.
+*/
+SbVec3fBatch::Kernel
+SbVec3fBatch::getBestKernel(void)
+{
+#if defined(SBVEC3FBATCH_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  // the OS must also save the YMM registers on context switches
+  if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) { return AVX; }
+  if (info[3] & (1 << 26)) { return SSE2; }
+#elif defined(SBVEC3FBATCH_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx")) { return AVX; }
+  if (__builtin_cpu_supports("sse2")) { return SSE2; }
+#endif // SBVEC3FBATCH_X86
+  return SCALAR;
+}
+
+/*!
+  Sets the kernel to use. Kernels not supported by the CPU are
+  replaced by the best supported one. Used for testing.
+*/
+void
+SbVec3fBatch::setKernel(const Kernel kernel)
+{
+  const Kernel best = SbVec3fBatch::getBestKernel();
+  currentkernel = (kernel > best) ? best : kernel;
+}
+
+/*!
+  Transforms \a num points from \a src with SbMatrix::multVecMatrix()
+  and stores them in \a dst. \a src and \a dst can be the same array.
+*/
+void
+SbVec3fBatch::multVecMatrix(const SbMatrix & matrix,
+                            const SbVec3f * src, SbVec3f * dst, const int num)
+{
+  if (num <= 0) return;
+  const SbMat & m = matrix.getValue();
+  if (memcmp(m, identitymatrix, sizeof(identitymatrix)) == 0) {
+    if (src != dst) { memmove(dst, src, num * sizeof(SbVec3f)); }
+    return;
+  }
+  const SbBool projective = is_projective(m);
+  const float * s = src[0].getValue();
+  float * d = const_cast<float *>(dst[0].getValue());
+
+  switch (SbVec3fBatch::getKernel()) {
+#ifdef SBVEC3FBATCH_X86
+  case AVX: multvec_avx(m, s, d, num, projective); break;
+  case SSE2: multvec_sse2(m, s, d, num, projective); break;
+#endif // SBVEC3FBATCH_X86
+  default: multvec_scalar(m, s, d, num, projective); break;
+  }
+}
+
+/*!
+  Transforms \a num direction vectors from \a src with
+  SbMatrix::multDirMatrix() and stores them in \a dst. \a src and \a
+  dst can be the same array.
+*/
+void
+SbVec3fBatch::multDirMatrix(const SbMatrix & matrix,
+                            const SbVec3f * src, SbVec3f * dst, const int num)
+{
+  if (num <= 0) return;
+  const SbMat & m = matrix.getValue();
+  if (memcmp(m, identitymatrix, sizeof(identitymatrix)) == 0) {
+    if (src != dst) { memmove(dst, src, num * sizeof(SbVec3f)); }
+    return;
+  }
+  const float * s = src[0].getValue();
+  float * d = const_cast<float *>(dst[0].getValue());
+
+  switch (SbVec3fBatch::getKernel()) {
+#ifdef SBVEC3FBATCH_X86
+  case AVX: multdir_avx(m, s, d, num); break;
+  case SSE2: multdir_sse2(m, s, d, num); break;
+#endif // SBVEC3FBATCH_X86
+  default: multdir_scalar(m, s, d, num); break;
+  }
+}
+
+/*!
+  Calculates the bounds of \a num points. If \a sum is not \c NULL,
+  the sum of the points is also calculated. Nothing is changed if \a
+  num is zero.
+*/
+void
+SbVec3fBatch::getBounds(const SbVec3f * points, const int num,
+                        SbVec3f & min, SbVec3f & max, SbVec3f * sum)
+{
+  if (num <= 0) return;
+  const float * s = points[0].getValue();
+  float mn[3] = { s[0], s[1], s[2] };
+  float mx[3] = { s[0], s[1], s[2] };
+  float acc[3] = { 0.0f, 0.0f, 0.0f };
+  float * accptr = sum ? acc : NULL;
+
+  switch (SbVec3fBatch::getKernel()) {
+#ifdef SBVEC3FBATCH_X86
+  case AVX: bounds_avx(s, num, mn, mx, accptr); break;
+  case SSE2: bounds_sse2(s, num, mn, mx, accptr); break;
+#endif // SBVEC3FBATCH_X86
+  default: bounds_scalar(s, num, mn, mx, accptr); break;
+  }
+  min.setValue(mn);
+  max.setValue(mx);
+  if (sum) { sum->setValue(acc); }
+}
+
+/*!
+  Calculates the bounds of \a num points after transforming them
+  with \a matrix. Nothing is changed if \a num is zero.
+*/
+void
+SbVec3fBatch::getBounds(const SbMatrix & matrix,
+                        const SbVec3f * points, const int num,
+                        SbVec3f & min, SbVec3f & max)
+{
+  if (num <= 0) return;
+  const SbMat & m = matrix.getValue();
+  if (memcmp(m, identitymatrix, sizeof(identitymatrix)) == 0) {
+    SbVec3fBatch::getBounds(points, num, min, max, NULL);
+    return;
+  }
+  const SbBool projective = is_projective(m);
+  const float * s = points[0].getValue();
+  float first[3];
+  multvec_scalar(m, s, first, 1, projective);
+  float mn[3] = { first[0], first[1], first[2] };
+  float mx[3] = { first[0], first[1], first[2] };
+
+  switch (SbVec3fBatch::getKernel()) {
+#ifdef SBVEC3FBATCH_X86
+  case AVX: xfbounds_avx(m, s, num, mn, mx, projective); break;
+  case SSE2: xfbounds_sse2(m, s, num, mn, mx, projective); break;
+#endif // SBVEC3FBATCH_X86
+  default: xfbounds_scalar(m, s, num, mn, mx, projective); break;
+  }
+  min.setValue(mn);
+  max.setValue(mx);
+}
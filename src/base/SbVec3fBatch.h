@@ -0,0 +1,72 @@
+#ifndef COIN_SBVEC3FBATCH_H
+#define COIN_SBVEC3FBATCH_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* ! COIN_INTERNAL */
+
+// *************************************************************************
+
+#include <Inventor/SbVec3f.h>
+
+class SbMatrix;
+
+// *************************************************************************
+
+class SbVec3fBatch {
+public:
+  enum Kernel {
+    SCALAR = 0,
+    SSE2,
+    AVX
+  };
+
+  static Kernel getKernel(void);
+  static Kernel getBestKernel(void);
+  static void setKernel(const Kernel kernel);
+
+  static void multVecMatrix(const SbMatrix & matrix,
+                            const SbVec3f * src, SbVec3f * dst, const int num);
+  static void multDirMatrix(const SbMatrix & matrix,
+                            const SbVec3f * src, SbVec3f * dst, const int num);
+
+  static void getBounds(const SbVec3f * points, const int num,
+                        SbVec3f & min, SbVec3f & max, SbVec3f * sum = NULL);
+  static void getBounds(const SbMatrix & matrix,
+                        const SbVec3f * points, const int num,
+                        SbVec3f & min, SbVec3f & max);
+};
+
+#endif // !COIN_SBVEC3FBATCH_H
@@ -64,6 +64,8 @@
 #include "SbTesselator.cpp"
 #include "SbGLUTessellator.cpp"
 #include "SbTime.cpp"
+#include "SbTriangleBVH.cpp"
+#include "SbVec3fBatch.cpp"
 #include "SbByteBuffer.cpp"
 
 #include "SbVec2b.cpp"
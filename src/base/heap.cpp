@@ -278,7 +278,16 @@ cc_heap_remove(cc_heap * h, void * o)
 
   h->array[i] = h->array[--h->elements];
   cc_dict_put(h->hash, reinterpret_cast<uintptr_t>(h->array[i]), reinterpret_cast<void *>(i));
-  heap_heapify_down(h, i);
+  /* the element moved into the hole may belong above it as well as
+     below it */
+  if (i < h->elements) {
+    if (i > 0 && h->compare(h->array[i], h->array[HEAP_PARENT(i)]) > 0) {
+      heap_heapify_up(h, i);
+    }
+    else {
+      heap_heapify_down(h, i);
+    }
+  }
 
   cc_dict_remove(h->hash, reinterpret_cast<uintptr_t>(o));
 
@@ -475,4 +484,23 @@ BOOST_AUTO_TEST_CASE(heap_update) {
   BOOST_CHECK_MESSAGE(str == result,
     std::string("Mismatch between ") + result.getString() + " and control string " + str.getString());
 }
+BOOST_AUTO_TEST_CASE(heap_remove_moves_up) {
+  // removing 11 moves the last element, 4, into a subtree where it
+  // has to go up past 10
+  mock_up::wrapped_value val[] = {1, 10, 2, 11, 12, 3, 4};
+  cc_heap* heap = cc_heap_construct(256, reinterpret_cast<cc_heap_compare_cb*>(mock_up::min_heap_compare_cb), TRUE);
+  for (int i = 0, n = sizeof(val) / sizeof(val[0]); i < n; ++i)
+    cc_heap_add(heap, &val[i]);
+  cc_heap_remove(heap, &val[3]);
+  SbString result;
+  while (!cc_heap_empty(heap)) {
+    mock_up::heap_print_cb(cc_heap_extract_top(heap), result);
+    result += ' ';
+  }
+  cc_heap_destruct(heap);
+  heap = NULL;
+  SbString str("1 2 3 4 10 12 ");
+  BOOST_CHECK_MESSAGE(str == result,
+    std::string("Mismatch between ") + result.getString() + " and control string " + str.getString());
+}
 #endif //COIN_TEST_SUITE
@@ -36,37 +36,49 @@
 #include <cassert>
 #include <cstring>
 
+#include <Inventor/C/errors/debugerror.h>
+
 #include "threads/threadsutilp.h"
 #include "tidbitsp.h"
 #include "coindefs.h"
 
 #ifndef COIN_WORKAROUND_NO_USING_STD_FUNCS
 using std::malloc;
+using std::calloc;
 using std::free;
 using std::strcpy;
 using std::strlen;
 using std::strcmp;
+using std::memset;
 #endif // !COIN_WORKAROUND_NO_USING_STD_FUNCS
 
 /* ************************************************************************* */
 
 /*
-  Implementation note: we cannot use the cc_dict ADT to simplify this
-  implementation, as cc_dict requires all keys in the hash to be
-  unique. That is not necessarily true for a set of strings, as two
-  strings can map to the same key (even though the probability is low
-  (with a good hash routine)).
-
-  So it is indeed necessary to use our own string hash, where equality
-  is tested for with first hash value and then string compare.
-
-  mortene.
+  Implementation note: the name table is an open addressing hash
+  table with linear probing, where each slot holds the permanent
+  address of a string, or NULL. The hash value of each string is
+  stored in the 4 bytes right in front of the string in the memory
+  chunk, so a slot is only a single pointer, and the hash values can
+  be compared before doing any string compares.
+
+  Lookups of strings which are already in the table do not take any
+  lock. This is possible since a slot never changes once it has been
+  set, and since the table is never resized in place: when it gets
+  too full, a new table twice the size is built and published, while
+  the old one is left alone for any thread which might still be
+  probing it. Replaced tables are kept until the name map is cleaned
+  up, which costs less memory than the current table.
+
+  A lookup which misses in a table which has just been replaced takes
+  the lock and looks again in the current table before adding the
+  string, so strings are never added twice.
 */
 
 /* ************************************************************************* */
 
 #define CHUNK_SIZE (65536-32)
-static const unsigned int NAME_TABLE_SIZE = 1999;
+static const unsigned int NAME_TABLE_INITIAL_SIZE = 2048;
 
 struct NamemapMemChunk {
   char mem[CHUNK_SIZE];
@@ -75,15 +87,71 @@ struct NamemapMemChunk {
   struct NamemapMemChunk * next;
 };
 
-struct NamemapBucketEntry {
-  unsigned long hashvalue;
-  const char * str;
-  struct NamemapBucketEntry * next;
+struct NamemapTable {
+  unsigned int size; /* always a power of two */
+  const char ** slots;
+  struct NamemapTable * replaced;
 };
 
 static void * access_mutex = NULL;
-static struct NamemapBucketEntry ** nametable = NULL;
+static struct NamemapTable * nametable = NULL;
 static struct NamemapMemChunk * headchunk = NULL;
+static unsigned int numnames = 0;
+static unsigned int numchunks = 0;
+
+#define NAMEMAP_STORED_HASH(_str_) (reinterpret_cast<const uint32_t *>(_str_)[-1])
+
+/* ************************************************************************* */
+
+/* FNV-1a, with a final mix so the low bits used for the slot index
+   depend on all the characters. */
+static uint32_t
+namemap_hash(const char * str)
+{
+  uint32_t h = 2166136261u;
+  for (const unsigned char * p = reinterpret_cast<const unsigned char *>(str); *p; p++) {
+    h = (h ^ *p) * 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+static const char *
+namemap_lookup(const struct NamemapTable * table, const char * str, uint32_t h)
+{
+  const unsigned int mask = table->size - 1;
+  unsigned int i = h & mask;
+  for (;;) {
+    const char * s = CC_ATOMIC_LOAD_ACQUIRE(&table->slots[i]);
+    if (s == NULL) { return NULL; }
+    if (NAMEMAP_STORED_HASH(s) == h && strcmp(s, str) == 0) { return s; }
+    i = (i + 1) & mask;
+  }
+}
+
+static void
+namemap_insert(struct NamemapTable * table, const char * str, uint32_t h)
+{
+  const unsigned int mask = table->size - 1;
+  unsigned int i = h & mask;
+  while (table->slots[i] != NULL) { i = (i + 1) & mask; }
+  CC_ATOMIC_STORE_RELEASE(&table->slots[i], str);
+}
+
+static struct NamemapTable *
+namemap_create_table(unsigned int size)
+{
+  struct NamemapTable * table = static_cast<struct NamemapTable *>(
+    malloc(sizeof(struct NamemapTable)));
+  table->size = size;
+  table->slots = static_cast<const char **>(calloc(size, sizeof(const char *)));
+  table->replaced = NULL;
+  return table;
+}
 
 /* ************************************************************************* */
 
@@ -93,7 +161,8 @@ extern "C" {
 static void
 namemap_cleanup(void)
 {
-  unsigned int i;
+  const char * env = coin_getenv("COIN_DEBUG_NAMEMAP");
+  if (env && atoi(env) > 0) { cc_namemap_print_stat(); }
 
   struct NamemapMemChunk * chunkptr = headchunk;
   while (chunkptr) {
@@ -101,17 +170,18 @@ namemap_cleanup(void)
     free(chunkptr);
     chunkptr = next;
   }
-  
-  for (i = 0; i < NAME_TABLE_SIZE; i++) {
-    struct NamemapBucketEntry * entry = nametable[i];
-    while (entry) {
-      struct NamemapBucketEntry * next = entry->next;
-      free(entry);
-      entry = next;
-    }
+  headchunk = NULL;
+
+  struct NamemapTable * table = nametable;
+  while (table) {
+    struct NamemapTable * next = table->replaced;
+    free(table->slots);
+    free(table);
+    table = next;
   }
-  free(nametable);
-  nametable = static_cast<struct NamemapBucketEntry **>(NULL);
+  nametable = static_cast<struct NamemapTable *>(NULL);
+  numnames = 0;
+  numchunks = 0;
 
   CC_MUTEX_DESTRUCT(access_mutex);
 }
@@ -122,26 +192,42 @@ namemap_cleanup(void)
 static void
 namemap_init(void)
 {
-  unsigned int i;
-
-  nametable = static_cast<struct NamemapBucketEntry **>(
-    malloc(sizeof(struct NamemapBucketEntry *) * NAME_TABLE_SIZE));
-  for (i = 0; i < NAME_TABLE_SIZE; i++) { nametable[i] = NULL; }
-
+  nametable = namemap_create_table(NAME_TABLE_INITIAL_SIZE);
   headchunk = NULL;
+  numnames = 0;
+  numchunks = 0;
 
   coin_atexit(static_cast<coin_atexit_f *>(namemap_cleanup), CC_ATEXIT_SBNAME);
 }
 
+/* Replaces the name table with one twice the size. Must be called
+   with the lock held. */
+static struct NamemapTable *
+namemap_grow(void)
+{
+  struct NamemapTable * old = nametable;
+  struct NamemapTable * table = namemap_create_table(old->size * 2);
+  for (unsigned int i = 0; i < old->size; i++) {
+    const char * s = old->slots[i];
+    if (s) { namemap_insert(table, s, NAMEMAP_STORED_HASH(s)); }
+  }
+  table->replaced = old;
+  CC_ATOMIC_STORE_RELEASE(&nametable, table);
+  return table;
+}
+
 static const char *
-find_string_address(const char * s)
+find_string_address(const char * s, uint32_t h)
 {
+  /* room for the hash value in front, and padding to keep the next
+     hash value aligned */
   size_t len = strlen(s) + 1;
+  const size_t size = (sizeof(uint32_t) + len + 3) & ~static_cast<size_t>(3);
 
   /* FIXME: this is an unacceptable limitation. 20030608 mortene. */
-  assert(len < CHUNK_SIZE);
+  assert(size < CHUNK_SIZE);
 
-  if (headchunk == NULL || headchunk->bytesleft < len) {
+  if (headchunk == NULL || headchunk->bytesleft < size) {
     struct NamemapMemChunk * newchunk = static_cast<struct NamemapMemChunk *>(
       malloc(sizeof(struct NamemapMemChunk))
       );
@@ -151,49 +237,53 @@ find_string_address(const char * s)
     newchunk->next = headchunk;
 
     headchunk = newchunk;
+    numchunks++;
   }
 
-  (void)strcpy(headchunk->curbyte, s);
-  s = headchunk->curbyte;
+  *reinterpret_cast<uint32_t *>(headchunk->curbyte) = h;
+  char * str = headchunk->curbyte + sizeof(uint32_t);
+  (void)strcpy(str, s);
 
-  headchunk->curbyte += len;
-  headchunk->bytesleft -= len;
+  headchunk->curbyte += size;
+  headchunk->bytesleft -= size;
 
-  return s;
+  return str;
 }
 
 static const char *
 namemap_find_or_add_string(const char * str, SbBool addifnotfound)
 {
-  unsigned long h, i;
-  struct NamemapBucketEntry * entry;
+  const uint32_t h = namemap_hash(str);
+
+  /* the common case of looking up an existing string, without
+     locking */
+  const struct NamemapTable * table = CC_ATOMIC_LOAD_ACQUIRE(&nametable);
+  if (table) {
+    const char * found = namemap_lookup(table, str, h);
+    if (found || !addifnotfound) { return found; }
+  }
+  else if (!addifnotfound) {
+    return NULL;
+  }
 
   if (access_mutex == NULL) { CC_MUTEX_CONSTRUCT(access_mutex); }
   CC_MUTEX_LOCK(access_mutex);
 
   if (nametable == NULL) { namemap_init(); }
-  assert(nametable != static_cast<struct NamemapBucketEntry **>(NULL) && "name hash dead");
-
-  h = cc_string_hash_text(str);
-  i = h % NAME_TABLE_SIZE;
-  entry = nametable[i];
-
-  while (entry != NULL) {
-    if (entry->hashvalue == h && strcmp(entry->str, str) == 0) { break; }
-    entry = entry->next;
-  }
-
-  if ((entry == NULL) && addifnotfound) {
-    entry = static_cast<struct NamemapBucketEntry *>(malloc(sizeof(struct NamemapBucketEntry)));
-    entry->str = find_string_address(str);
-    entry->hashvalue = h;
-    entry->next = nametable[i];
-
-    nametable[i] = entry;
+  assert(nametable != static_cast<struct NamemapTable *>(NULL) && "name hash dead");
+
+  const char * s = namemap_lookup(nametable, str, h);
+  if (s == NULL) {
+    struct NamemapTable * current = nametable;
+    /* keep the table at most 3/4 full */
+    if ((numnames + 1) * 4 > current->size * 3) { current = namemap_grow(); }
+    s = find_string_address(str, h);
+    namemap_insert(current, s, h);
+    numnames++;
   }
 
   CC_MUTEX_UNLOCK(access_mutex);
-  return entry ? entry->str : NULL;
+  return s;
 }
 
 /* ************************************************************************* */
@@ -221,4 +311,63 @@ cc_namemap_peek_string(const char * str)
   return namemap_find_or_add_string(str, FALSE);
 }
 
+/*!
+  Fills in \a stats with the number of strings in the name hash, its
+  memory usage, and how many slots lookups of the strings have to
+  probe.
+*/
+void
+cc_namemap_get_stats(cc_namemap_stats * stats)
+{
+  (void)memset(stats, 0, sizeof(cc_namemap_stats));
+
+  if (access_mutex == NULL) { CC_MUTEX_CONSTRUCT(access_mutex); }
+  CC_MUTEX_LOCK(access_mutex);
+
+  if (nametable) {
+    const unsigned int mask = nametable->size - 1;
+    double probes = 0.0;
+    for (unsigned int i = 0; i < nametable->size; i++) {
+      const char * s = nametable->slots[i];
+      if (s == NULL) { continue; }
+      const unsigned int probelength =
+        ((i - NAMEMAP_STORED_HASH(s)) & mask) + 1;
+      probes += probelength;
+      if (probelength > stats->maxprobelength) {
+        stats->maxprobelength = probelength;
+      }
+    }
+    for (const struct NamemapTable * table = nametable; table; table = table->replaced) {
+      stats->tablebytes += sizeof(struct NamemapTable) + table->size * sizeof(const char *);
+    }
+    stats->numnames = numnames;
+    stats->tablesize = nametable->size;
+    stats->avgprobelength = numnames ? static_cast<float>(probes / numnames) : 0.0f;
+    stats->stringbytes = numchunks * sizeof(struct NamemapMemChunk);
+  }
+
+  CC_MUTEX_UNLOCK(access_mutex);
+}
+
+/*!
+  For debugging only. Prints information about the name hash with
+  cc_debugerror.
+*/
+void
+cc_namemap_print_stat(void)
+{
+  cc_namemap_stats stats;
+  cc_namemap_get_stats(&stats);
+  cc_debugerror_postinfo("cc_namemap_print_stat",
+                         "%u names in %u slots (%.1f%% full), "
+                         "avg probe length: %.2f, max probe length: %u, "
+                         "string memory: %lu kB, table memory: %lu kB",
+                         stats.numnames, stats.tablesize,
+                         stats.tablesize ? 100.0 * stats.numnames / stats.tablesize : 0.0,
+                         stats.avgprobelength, stats.maxprobelength,
+                         static_cast<unsigned long>(stats.stringbytes / 1024),
+                         static_cast<unsigned long>(stats.tablebytes / 1024));
+}
+
+#undef NAMEMAP_STORED_HASH
 #undef CHUNK_SIZE
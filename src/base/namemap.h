@@ -51,9 +51,21 @@ extern "C" {
 
 /* ********************************************************************** */
 
+  typedef struct {
+    unsigned int numnames;
+    unsigned int tablesize;
+    float avgprobelength;
+    unsigned int maxprobelength;
+    size_t stringbytes;
+    size_t tablebytes;
+  } cc_namemap_stats;
+
   const char * cc_namemap_get_address(const char * str);
   const char * cc_namemap_peek_string(const char * str);
 
+  void cc_namemap_get_stats(cc_namemap_stats * stats);
+  void cc_namemap_print_stat(void);
+
 /* ********************************************************************** */
 
 #ifdef __cplusplus
@@ -41,6 +41,9 @@
 
   \ingroup coin_caches
 
+  The cache can store its arrays in a compact layout, see
+  setLayout(), to save memory and upload time for large shapes.
+
   \since Coin 3.0
 */
 
@@ -48,6 +51,8 @@
 
 #include <Inventor/caches/SoPrimitiveVertexCache.h>
 
+#include <cfloat>
+#include <cmath>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
@@ -187,8 +192,26 @@ public:
   SoGLLazyElement::GLState prestate;
   SoGLLazyElement::GLState poststate;
 
+  // the compact layout, see SoPrimitiveVertexCache::setLayout()
+  SoPrimitiveVertexCache::Layout layout;
+  SbBool compact;
+  int numvertices;
+  SbVec3f qcenter;
+  float qscale;
+  SbList <int16_t> cvertexlist;
+  SbList <int16_t> cnormallist;
+  SbList <uint16_t> ctexcoordlist;
+  SbList <int8_t> glnormallist;
+
   void addVertex(const Vertex & v);
 
+  void compactArrays(void);
+  SbVec3f getVertex(const int idx) const;
+  const SbVec3f * getVertices(void);
+  const SbVec3f * getNormals(void);
+  const SbVec4f * getTexCoords(void);
+  const int8_t * getGLNormals(void);
+
   void renderImmediate(const cc_glglue * glue,
                        const GLint * indices,
                        const int numindices,
@@ -239,6 +262,98 @@ namespace {
     }
     return FALSE;
   }
+
+  SbBool use_compact_layout(void) {
+    static int compactlayout = -1;
+    if (compactlayout < 0) {
+      const char * env = coin_getenv("COIN_COMPACT_VERTEX_CACHE");
+      compactlayout = (env && atoi(env) > 0) ? 1 : 0;
+    }
+    return compactlayout;
+  }
+
+  // IEEE 754 half precision conversion, rounding to nearest even
+  uint16_t float_to_half(const float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    const uint32_t absx = x & 0x7fffffff;
+
+    if (absx >= 0x7f800000) { // infinity or NaN
+      return sign | 0x7c00 | ((absx > 0x7f800000) ? 0x200 : 0);
+    }
+    if (absx >= 0x477ff000) { // rounds to infinity
+      return sign | 0x7c00;
+    }
+    if (absx < 0x38800000) { // subnormal half, or zero
+      if (absx <= 0x33000000) return sign;
+      const uint32_t shift = 126 - (absx >> 23);
+      const uint32_t m = (absx & 0x7fffff) | 0x800000;
+      uint32_t h = m >> shift;
+      const uint32_t rem = m & ((1u << shift) - 1);
+      const uint32_t halfway = 1u << (shift - 1);
+      if (rem > halfway || (rem == halfway && (h & 1))) h++;
+      return sign | static_cast<uint16_t>(h);
+    }
+    uint32_t h = (absx - 0x38000000) >> 13;
+    const uint32_t rem = absx & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+    return sign | static_cast<uint16_t>(h);
+  }
+
+  float half_to_float(const uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t e = (h >> 10) & 0x1f;
+    const uint32_t m = h & 0x3ff;
+    uint32_t x;
+    if (e == 0) {
+      const float f = float(m) * (1.0f / 16777216.0f);
+      return sign ? -f : f;
+    }
+    else if (e == 31) {
+      x = sign | 0x7f800000 | (m << 13);
+    }
+    else {
+      x = sign | ((e + 112) << 23) | (m << 13);
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+  }
+
+  // octahedral normal encoding, two signed 16-bit components
+  void encode_normal(const SbVec3f & n, int16_t * out) {
+    const float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (!(l1 > 0.0f && l1 <= FLT_MAX)) {
+      out[0] = out[1] = 0;
+      return;
+    }
+    float x = n[0] / l1;
+    float y = n[1] / l1;
+    if (n[2] < 0.0f) {
+      const float tx = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+      const float ty = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+      x = tx;
+      y = ty;
+    }
+    out[0] = static_cast<int16_t>(floorf(SbClamp(x, -1.0f, 1.0f) * 32767.0f + 0.5f));
+    out[1] = static_cast<int16_t>(floorf(SbClamp(y, -1.0f, 1.0f) * 32767.0f + 0.5f));
+  }
+
+  SbVec3f decode_normal(const int16_t * in) {
+    float x = SbMax(float(in[0]) / 32767.0f, -1.0f);
+    float y = SbMax(float(in[1]) / 32767.0f, -1.0f);
+    const float z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f) {
+      const float tx = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+      const float ty = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+      x = tx;
+      y = ty;
+    }
+    SbVec3f n(x, y, z);
+    n.normalize();
+    return n;
+  }
 };
 
 // *************************************************************************
@@ -274,6 +389,11 @@ SoPrimitiveVertexCache::SoPrimitiveVertexCache(SoState * state)
   // set up variables to test if we need to supply color per vertex
   PRIVATE(this)->colorpervertex = FALSE;
 
+  PRIVATE(this)->layout = use_compact_layout() ? COMPACT : FULL_PRECISION;
+  PRIVATE(this)->compact = FALSE;
+  PRIVATE(this)->numvertices = 0;
+  PRIVATE(this)->qscale = 1.0f;
+
   // just store diffuse color with index 0
   uint32_t col;
   if (PRIVATE(this)->packedptr) {
@@ -344,10 +464,66 @@ SoPrimitiveVertexCache::close(SoState * state)
     SoGLLazyElement::endCaching(state);
   }
   this->fit();
+  if (PRIVATE(this)->layout == COMPACT) {
+    PRIVATE(this)->compactArrays();
+  }
+}
+
+/*!
+  Sets the layout used for storing the vertex data once the cache is
+  closed. Must be called before close() to have any effect.
+
+  With the \c COMPACT layout, coordinates are stored as 16-bit
+  integers relative to the bounding box of the shape, normals are
+  octahedron encoded in two 16-bit integers and texture coordinates
+  for the first unit as half floats. This roughly halves the size of
+  the vertex data, both in memory and in the buffer objects uploaded
+  to OpenGL, at the cost of some precision. The array access methods
+  still return the data in full precision, decoded from the compact
+  arrays the first time they are called. The decoded arrays are
+  released when the buffer objects are set up for rendering, so the
+  pointers returned are only valid until the cache is rendered next.
+
+  The default is \c FULL_PRECISION, unless the environment variable
+  COIN_COMPACT_VERTEX_CACHE is set to 1.
+
+  \since Coin 4.1
+*/
+void
+SoPrimitiveVertexCache::setLayout(const Layout layout)
+{
+  PRIVATE(this)->layout = layout;
+}
+
+/*!
+  Returns the layout used for storing the vertex data.
+
+  \since Coin 4.1
+*/
+SoPrimitiveVertexCache::Layout
+SoPrimitiveVertexCache::getLayout(void) const
+{
+  return PRIVATE(this)->layout;
 }
 
 void
 SoPrimitiveVertexCache::renderTriangles(SoState * state, const int arrays) const
+{
+  this->renderTrianglesInstanced(state, 1, arrays);
+}
+
+/*!
+  Renders the triangles \a numinstances times with one instanced draw
+  call. Unless \a numinstances is 1, the driver must support
+  SO_GL_INSTANCED_RENDERING, and the caller must have set up a vertex
+  shader which places each instance, usually from a vertex attribute
+  array with a divisor of 1.
+
+  \since Coin 4.1
+*/
+void
+SoPrimitiveVertexCache::renderTrianglesInstanced(SoState * state, const int numinstances,
+                                                 const int arrays) const
 {
   int lastenabled = -1;
   const int n = this->getNumTriangleIndices();
@@ -366,7 +542,7 @@ SoPrimitiveVertexCache::renderTriangles(SoState * state, const int arrays) const
 
   SbBool renderasvbo =
     PRIVATE(this)->vertexvbo ||
-    SoGLVBOElement::shouldCreateVBO(state, PRIVATE(this)->vertexlist.getLength());
+    SoGLVBOElement::shouldCreateVBO(state, this->getNumVertices());
 
   if (renderasvbo) {
     if (!SoGLDriverDatabase::isSupported(glue, SO_GL_VBO_IN_DISPLAYLIST)) {
@@ -378,16 +554,17 @@ SoPrimitiveVertexCache::renderTriangles(SoState * state, const int arrays) const
     SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
 
     thisp->enableVBOs(glue, contextid, color, normal, texture, enabled, lastenabled);
-    PRIVATE(this)->triangleindexer->render(glue, TRUE, contextid);
+    PRIVATE(this)->triangleindexer->render(glue, TRUE, contextid, numinstances);
     thisp->disableVBOs(glue, color, normal, texture, enabled, lastenabled);
   }
   else if (SoGLDriverDatabase::isSupported(glue, SO_GL_VERTEX_ARRAY)) {
     SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
     thisp->enableArrays(glue, color, normal, texture, enabled, lastenabled);
-    PRIVATE(this)->triangleindexer->render(glue, FALSE, contextid);
+    PRIVATE(this)->triangleindexer->render(glue, FALSE, contextid, numinstances);
     thisp->disableArrays(glue, color, normal, texture, enabled, lastenabled);
   }
   else {
+    assert(numinstances == 1 && "instanced rendering needs vertex arrays");
     // fall back to immediate mode rendering
     SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
     glBegin(GL_TRIANGLES);
@@ -731,25 +908,29 @@ SoPrimitiveVertexCache::addPoint(const SoPrimitiveVertex * v0)
 int
 SoPrimitiveVertexCache::getNumVertices(void) const
 {
+  if (PRIVATE(this)->compact) return PRIVATE(this)->numvertices;
   return PRIVATE(this)->vertexlist.getLength();
 }
 
 const SbVec3f *
 SoPrimitiveVertexCache::getVertexArray(void) const
 {
-  return PRIVATE(this)->vertexlist.getArrayPtr();
+  SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
+  return thisp->getVertices();
 }
 
 const SbVec3f *
 SoPrimitiveVertexCache::getNormalArray(void) const
 {
-  return PRIVATE(this)->normallist.getArrayPtr();
+  SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
+  return thisp->getNormals();
 }
 
 const SbVec4f *
 SoPrimitiveVertexCache::getTexCoordArray(void) const
 {
-  return PRIVATE(this)->texcoordlist.getArrayPtr();
+  SoPrimitiveVertexCacheP * thisp = const_cast<SoPrimitiveVertexCacheP *>(&PRIVATE(this).get());
+  return thisp->getTexCoords();
 }
 
 const SbVec2f *
@@ -842,7 +1023,7 @@ SoPrimitiveVertexCache::fit(void)
 void
 SoPrimitiveVertexCache::depthSortTriangles(SoState * state)
 {
-  int numv = PRIVATE(this)->vertexlist.getLength();
+  int numv = this->getNumVertices();
   int numtri = this->getNumTriangleIndices() / 3;
   if (numv == 0 || numtri == 0) return;
 
@@ -857,13 +1038,12 @@ SoPrimitiveVertexCache::depthSortTriangles(SoState * state)
     }
     PRIVATE(this)->prevsortplane = sortplane;
     float * darray = PRIVATE(this)->deptharray;
-    const SbVec3f * vptr = PRIVATE(this)->vertexlist.getArrayPtr();
     GLint * iptr = PRIVATE(this)->triangleindexer->getWriteableIndices();
     int i,j;
     for (i = 0; i < numtri; i++) {
       float acc = 0.0;
       for (j = 0; j < 3; j++) {
-        acc += sortplane.getDistance(vptr[iptr[i*3+j]]);
+        acc += sortplane.getDistance(PRIVATE(this)->getVertex(iptr[i*3+j]));
       }
       darray[i] = acc / 3.0f;
     }
@@ -940,6 +1120,135 @@ SoPrimitiveVertexCacheP::addVertex(const Vertex & v)
   }
 }
 
+// Replaces the coordinate, normal and texture coordinate lists with
+// their compact counterparts.
+void
+SoPrimitiveVertexCacheP::compactArrays(void)
+{
+  const int n = this->vertexlist.getLength();
+  if (this->compact || n == 0) return;
+
+  const SbVec3f * vptr = this->vertexlist.getArrayPtr();
+  SbVec3f bmin = vptr[0];
+  SbVec3f bmax = vptr[0];
+  for (int i = 0; i < n; i++) {
+    for (int c = 0; c < 3; c++) {
+      // keep the full precision layout for non-finite coordinates
+      if (!(fabsf(vptr[i][c]) <= FLT_MAX)) return;
+      bmin[c] = SbMin(bmin[c], vptr[i][c]);
+      bmax[c] = SbMax(bmax[c], vptr[i][c]);
+    }
+  }
+  // The same scale is used for all axes, so that the matrix applied
+  // when rendering does not change the direction of the normals.
+  this->qcenter = (bmin + bmax) * 0.5f;
+  const SbVec3f halfsize = (bmax - bmin) * 0.5f;
+  const float maxhalfsize = SbMax(halfsize[0], SbMax(halfsize[1], halfsize[2]));
+  this->qscale = (maxhalfsize > 0.0f) ? maxhalfsize / 32767.0f : 1.0f;
+
+  for (int i = 0; i < n; i++) {
+    for (int c = 0; c < 3; c++) {
+      const float q = floorf((vptr[i][c] - this->qcenter[c]) / this->qscale + 0.5f);
+      this->cvertexlist.append(static_cast<int16_t>(SbClamp(q, -32767.0f, 32767.0f)));
+    }
+    this->cvertexlist.append(1);
+  }
+  const SbVec3f * nptr = this->normallist.getArrayPtr();
+  for (int i = 0; i < n; i++) {
+    int16_t oct[2];
+    encode_normal(nptr[i], oct);
+    this->cnormallist.append(oct[0]);
+    this->cnormallist.append(oct[1]);
+  }
+  const SbVec4f * tptr = this->texcoordlist.getArrayPtr();
+  for (int i = 0; i < n; i++) {
+    for (int c = 0; c < 4; c++) {
+      this->ctexcoordlist.append(float_to_half(tptr[i][c]));
+    }
+  }
+
+  this->numvertices = n;
+  this->compact = TRUE;
+  this->vertexlist.truncate(0, TRUE);
+  this->normallist.truncate(0, TRUE);
+  this->texcoordlist.truncate(0, TRUE);
+}
+
+SbVec3f
+SoPrimitiveVertexCacheP::getVertex(const int idx) const
+{
+  if (!this->compact) return this->vertexlist[idx];
+  const int16_t * q = this->cvertexlist.getArrayPtr(idx * 4);
+  return SbVec3f(this->qcenter[0] + float(q[0]) * this->qscale,
+                 this->qcenter[1] + float(q[1]) * this->qscale,
+                 this->qcenter[2] + float(q[2]) * this->qscale);
+}
+
+// The get*() functions below decode the compact arrays the first time
+// they are called.
+
+const SbVec3f *
+SoPrimitiveVertexCacheP::getVertices(void)
+{
+  if (this->compact && this->vertexlist.getLength() < this->numvertices) {
+    for (int i = 0; i < this->numvertices; i++) {
+      this->vertexlist.append(this->getVertex(i));
+    }
+  }
+  return this->vertexlist.getArrayPtr();
+}
+
+const SbVec3f *
+SoPrimitiveVertexCacheP::getNormals(void)
+{
+  if (this->compact && this->normallist.getLength() < this->numvertices) {
+    for (int i = 0; i < this->numvertices; i++) {
+      this->normallist.append(decode_normal(this->cnormallist.getArrayPtr(i * 2)));
+    }
+  }
+  return this->normallist.getArrayPtr();
+}
+
+const SbVec4f *
+SoPrimitiveVertexCacheP::getTexCoords(void)
+{
+  if (this->compact && this->texcoordlist.getLength() < this->numvertices) {
+    for (int i = 0; i < this->numvertices; i++) {
+      const uint16_t * h = this->ctexcoordlist.getArrayPtr(i * 4);
+      this->texcoordlist.append(SbVec4f(half_to_float(h[0]), half_to_float(h[1]),
+                                        half_to_float(h[2]), half_to_float(h[3])));
+    }
+  }
+  return this->texcoordlist.getArrayPtr();
+}
+
+// OpenGL can not decode octahedron encoded normals without a shader,
+// so the normals are handed over as signed bytes (padded to four),
+// which takes the same amount of space.
+const int8_t *
+SoPrimitiveVertexCacheP::getGLNormals(void)
+{
+  assert(this->compact);
+  if (this->glnormallist.getLength() < this->numvertices * 4) {
+    for (int i = 0; i < this->numvertices; i++) {
+      const SbVec3f n = decode_normal(this->cnormallist.getArrayPtr(i * 2));
+      for (int c = 0; c < 3; c++) {
+        this->glnormallist.append(static_cast<int8_t>(floorf(n[c] * 127.0f + 0.5f)));
+      }
+      this->glnormallist.append(0);
+    }
+  }
+  return this->glnormallist.getArrayPtr();
+}
+
+static SbBool
+pvcache_half_float_vertex(const cc_glglue * glue)
+{
+  return
+    cc_glglue_glversion_matches_at_least(glue, 3, 0, 0) ||
+    cc_glglue_glext_supported(glue, "GL_ARB_half_float_vertex");
+}
+
 void
 SoPrimitiveVertexCacheP::enableArrays(const cc_glglue * glue,
                                       const SbBool color, const SbBool normal,
@@ -954,8 +1263,14 @@ SoPrimitiveVertexCacheP::enableArrays(const cc_glglue * glue,
   }
 
   if (texture) {
-    cc_glglue_glTexCoordPointer(glue, 4, GL_FLOAT, 0,
-                                reinterpret_cast<const GLvoid *>(this->texcoordlist.getArrayPtr()));
+    if (this->compact && pvcache_half_float_vertex(glue)) {
+      cc_glglue_glTexCoordPointer(glue, 4, GL_HALF_FLOAT_ARB, 0,
+                                  reinterpret_cast<const GLvoid *>(this->ctexcoordlist.getArrayPtr()));
+    }
+    else {
+      cc_glglue_glTexCoordPointer(glue, 4, GL_FLOAT, 0,
+                                  reinterpret_cast<const GLvoid *>(this->getTexCoords()));
+    }
     cc_glglue_glEnableClientState(glue, GL_TEXTURE_COORD_ARRAY);
 
     for (i = 1; i <= lastenabled; i++) {
@@ -968,13 +1283,30 @@ SoPrimitiveVertexCacheP::enableArrays(const cc_glglue * glue,
     }
   }
   if (normal) {
-    cc_glglue_glNormalPointer(glue, GL_FLOAT, 0,
-                              reinterpret_cast<const GLvoid *>(this->normallist.getArrayPtr()));
+    if (this->compact) {
+      cc_glglue_glNormalPointer(glue, GL_BYTE, 4,
+                                reinterpret_cast<const GLvoid *>(this->getGLNormals()));
+    }
+    else {
+      cc_glglue_glNormalPointer(glue, GL_FLOAT, 0,
+                                reinterpret_cast<const GLvoid *>(this->normallist.getArrayPtr()));
+    }
     cc_glglue_glEnableClientState(glue, GL_NORMAL_ARRAY);
   }
 
-  cc_glglue_glVertexPointer(glue, 3, GL_FLOAT, 0,
-                            reinterpret_cast<const GLvoid *>(this->vertexlist.getArrayPtr()));
+  if (this->compact) {
+    // the coordinates are scaled back up by the modelview matrix,
+    // restored in disableArrays()
+    glPushMatrix();
+    glTranslatef(this->qcenter[0], this->qcenter[1], this->qcenter[2]);
+    glScalef(this->qscale, this->qscale, this->qscale);
+    cc_glglue_glVertexPointer(glue, 4, GL_SHORT, 0,
+                              reinterpret_cast<const GLvoid *>(this->cvertexlist.getArrayPtr()));
+  }
+  else {
+    cc_glglue_glVertexPointer(glue, 3, GL_FLOAT, 0,
+                              reinterpret_cast<const GLvoid *>(this->vertexlist.getArrayPtr()));
+  }
   cc_glglue_glEnableClientState(glue, GL_VERTEX_ARRAY);
 }
 
@@ -1006,6 +1338,9 @@ SoPrimitiveVertexCacheP::disableArrays(const cc_glglue * glue,
     cc_glglue_glDisableClientState(glue, GL_COLOR_ARRAY);
   }
   cc_glglue_glDisableClientState(glue, GL_VERTEX_ARRAY);
+  if (this->compact) {
+    glPopMatrix();
+  }
 }
 
 void
@@ -1027,13 +1362,20 @@ SoPrimitiveVertexCacheP::enableVBOs(const cc_glglue * glue,
     cc_glglue_glEnableClientState(glue, GL_COLOR_ARRAY);
   }
   if (texture) {
+    const SbBool halftexcoords = this->compact && pvcache_half_float_vertex(glue);
     if (this->texcoord0vbo == NULL) {
       this->texcoord0vbo = new SoVBO;
-      this->texcoord0vbo->setBufferData(this->texcoordlist.getArrayPtr(),
-                                        this->texcoordlist.getLength()*4*sizeof(float));
+      if (halftexcoords) {
+        this->texcoord0vbo->setBufferData(this->ctexcoordlist.getArrayPtr(),
+                                          this->ctexcoordlist.getLength()*sizeof(uint16_t));
+      }
+      else {
+        this->texcoord0vbo->setBufferData(this->getTexCoords(),
+                                          this->texcoordlist.getLength()*4*sizeof(float));
+      }
     }
     this->texcoord0vbo->bindBuffer(contextid);
-    cc_glglue_glTexCoordPointer(glue, 4, GL_FLOAT, 0, NULL);
+    cc_glglue_glTexCoordPointer(glue, 4, halftexcoords ? GL_HALF_FLOAT_ARB : GL_FLOAT, 0, NULL);
     cc_glglue_glEnableClientState(glue, GL_TEXTURE_COORD_ARRAY);
 
     for (i = 1; i <= lastenabled; i++) {
@@ -1057,21 +1399,55 @@ SoPrimitiveVertexCacheP::enableVBOs(const cc_glglue * glue,
   if (normal) {
     if (this->normalvbo == NULL) {
       this->normalvbo = new SoVBO;
-      this->normalvbo->setBufferData(this->normallist.getArrayPtr(),
-                                     this->normallist.getLength()*3*sizeof(float));
+      if (this->compact) {
+        this->normalvbo->setBufferData(this->getGLNormals(),
+                                       this->glnormallist.getLength()*sizeof(int8_t));
+      }
+      else {
+        this->normalvbo->setBufferData(this->normallist.getArrayPtr(),
+                                       this->normallist.getLength()*3*sizeof(float));
+      }
     }
     this->normalvbo->bindBuffer(contextid);
-    cc_glglue_glNormalPointer(glue, GL_FLOAT, 0, NULL);
+    if (this->compact) {
+      cc_glglue_glNormalPointer(glue, GL_BYTE, 4, NULL);
+    }
+    else {
+      cc_glglue_glNormalPointer(glue, GL_FLOAT, 0, NULL);
+    }
     cc_glglue_glEnableClientState(glue, GL_NORMAL_ARRAY);
   }
 
   if (this->vertexvbo == NULL) {
     this->vertexvbo = new SoVBO;
-    this->vertexvbo->setBufferData(this->vertexlist.getArrayPtr(),
-                                   this->vertexlist.getLength()*3*sizeof(float));
+    if (this->compact) {
+      this->vertexvbo->setBufferData(this->cvertexlist.getArrayPtr(),
+                                     this->cvertexlist.getLength()*sizeof(int16_t));
+      // Release the full precision arrays decoded for other uses, as
+      // rendering only needs the compact ones from now on. They are
+      // decoded again if asked for. The arrays the buffer objects are
+      // set up from stay, since SoVBO uploads them for each context.
+      this->vertexlist.truncate(0, TRUE);
+      this->normallist.truncate(0, TRUE);
+      if (pvcache_half_float_vertex(glue)) this->texcoordlist.truncate(0, TRUE);
+    }
+    else {
+      this->vertexvbo->setBufferData(this->vertexlist.getArrayPtr(),
+                                     this->vertexlist.getLength()*3*sizeof(float));
+    }
   }
   this->vertexvbo->bindBuffer(contextid);
-  cc_glglue_glVertexPointer(glue, 3, GL_FLOAT, 0, NULL);
+  if (this->compact) {
+    // the coordinates are scaled back up by the modelview matrix,
+    // restored in disableArrays()
+    glPushMatrix();
+    glTranslatef(this->qcenter[0], this->qcenter[1], this->qcenter[2]);
+    glScalef(this->qscale, this->qscale, this->qscale);
+    cc_glglue_glVertexPointer(glue, 4, GL_SHORT, 0, NULL);
+  }
+  else {
+    cc_glglue_glVertexPointer(glue, 3, GL_FLOAT, 0, NULL);
+  }
   cc_glglue_glEnableClientState(glue, GL_VERTEX_ARRAY);
 }
 
@@ -1101,13 +1477,14 @@ SoPrimitiveVertexCacheP::renderImmediate(const cc_glglue * glue,
   if (color) {
     colorptr = this->rgbalist.getArrayPtr();
   }
+  // the compact arrays are decoded for immediate mode rendering
   if (normal) {
-    normalptr = this->normallist.getArrayPtr();
+    normalptr = this->getNormals();
   }
   if (texture) {
-    texcoordptr = this->texcoordlist.getArrayPtr();
+    texcoordptr = this->getTexCoords();
   }
-  vertexptr = this->vertexlist.getArrayPtr();
+  vertexptr = this->getVertices();
 
   for (int i = 0; i < numindices; i++) {
     const int idx = indices[i];
@@ -1134,3 +1511,73 @@ SoPrimitiveVertexCacheP::renderImmediate(const cc_glglue * glue,
 }
 
 #undef PRIVATE
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SoPrimitiveVertex.h>
+#include <Inventor/actions/SoCallbackAction.h>
+
+BOOST_AUTO_TEST_CASE(compactLayout)
+{
+  SoCallbackAction cba;
+  SoState * state = cba.getState();
+
+  SoPrimitiveVertexCache * caches[2];
+  for (int c = 0; c < 2; c++) {
+    caches[c] = new SoPrimitiveVertexCache(state);
+    caches[c]->ref();
+    caches[c]->setLayout((c == 0) ?
+                         SoPrimitiveVertexCache::FULL_PRECISION :
+                         SoPrimitiveVertexCache::COMPACT);
+  }
+
+  // a triangle fan with normals in all octants
+  SoPrimitiveVertex pv[3];
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 3; j++) {
+      const float a = float(i * 3 + j) * 0.37f;
+      pv[j].setPoint(SbVec3f(100.0f * cosf(a), 0.5f * sinf(a), 10.0f + float(j)));
+      SbVec3f n(cosf(a), sinf(a * 1.7f), cosf(a * 2.3f) - 0.4f);
+      n.normalize();
+      pv[j].setNormal(n);
+      pv[j].setTextureCoords(SbVec4f(float(i) / 16.0f, 1.0f - float(j) / 3.0f, 0.0f, 1.0f));
+    }
+    for (int c = 0; c < 2; c++) {
+      caches[c]->addTriangle(&pv[0], &pv[1], &pv[2]);
+    }
+  }
+  for (int c = 0; c < 2; c++) {
+    caches[c]->close(state);
+  }
+
+  const int num = caches[0]->getNumVertices();
+  BOOST_CHECK_EQUAL(caches[1]->getNumVertices(), num);
+  BOOST_CHECK_EQUAL(caches[1]->getNumTriangleIndices(), caches[0]->getNumTriangleIndices());
+
+  // the coordinates are quantized to 16 bits relative to the bounding box
+  const float maxcoorderr = 100.0f / 32767.0f;
+  float coorderr = 0.0f, normalerr = 0.0f, texcoorderr = 0.0f;
+  for (int i = 0; i < num; i++) {
+    const SbVec3f d = caches[1]->getVertexArray()[i] - caches[0]->getVertexArray()[i];
+    coorderr = SbMax(coorderr, SbMax(fabsf(d[0]), SbMax(fabsf(d[1]), fabsf(d[2]))));
+    normalerr = SbMax(normalerr, (caches[1]->getNormalArray()[i] - caches[0]->getNormalArray()[i]).length());
+    for (int k = 0; k < 4; k++) {
+      texcoorderr = SbMax(texcoorderr, fabsf(caches[1]->getTexCoordArray()[i][k] -
+                                             caches[0]->getTexCoordArray()[i][k]));
+    }
+  }
+  BOOST_CHECK_MESSAGE(coorderr <= maxcoorderr, "coordinates should be within the quantization step");
+  BOOST_CHECK_MESSAGE(normalerr < 1.0e-3f, "normals should be within octahedral encoding precision");
+  BOOST_CHECK_MESSAGE(texcoorderr <= 1.0f / 2048.0f, "texture coordinates should be within half float precision");
+  for (int i = 0; i < caches[0]->getNumTriangleIndices(); i++) {
+    if (caches[0]->getTriangleIndex(i) != caches[1]->getTriangleIndex(i)) {
+      BOOST_ERROR("triangle indices should not be affected by the layout");
+      break;
+    }
+  }
+
+  caches[0]->unref();
+  caches[1]->unref();
+}
+
+#endif // COIN_TEST_SUITE
@@ -0,0 +1,205 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SoTriangleBVHCache SoTriangleBVHCache.h
+  \brief The SoTriangleBVHCache class stores a bounding volume hierarchy for the triangles of a shape.
+
+  \ingroup coin_caches
+
+  The cache is filled from the triangles generated by
+  SoShape::generatePrimitives() and is used to speed up ray picking
+  of large shapes.
+
+  Shapes can also store restart points, the data needed to continue
+  generating primitives from the start of a face. When a restart
+  point is available, only the faces containing the triangles hit by
+  the ray need to be generated again to create the picked points. Shapes with fewer triangles than
+  getMinTriangles() will not get a hierarchy, since generating
+  primitives is just as fast for them. The cache will still be valid,
+  so that the shape knows not to try again until something changes.
+
+  \internal
+*/
+
+#include "caches/SoTriangleBVHCache.h"
+
+#include <climits>
+#include <cstdlib>
+
+#include <Inventor/C/tidbits.h> // coin_getenv()
+
+// *************************************************************************
+
+static int COIN_RAYPICK_BVH_MIN_TRIANGLES = -1;
+
+// *************************************************************************
+
+/*!
+  Constructor.
+*/
+SoTriangleBVHCache::SoTriangleBVHCache(SoState * state)
+  : SoCache(state),
+    hashierarchy(FALSE)
+{
+}
+
+/*!
+  Destructor.
+*/
+SoTriangleBVHCache::~SoTriangleBVHCache()
+{
+}
+
+/*!
+  Adds a triangle while the cache is being created.
+*/
+void
+SoTriangleBVHCache::addTriangle(const SbVec3f & v0, const SbVec3f & v1, const SbVec3f & v2)
+{
+  this->bvh.addTriangle(v0, v1, v2);
+}
+
+/*!
+  Should be called when all triangles have been added. The
+  hierarchy is built here if there are enough triangles.
+*/
+void
+SoTriangleBVHCache::close(void)
+{
+  if (this->bvh.getNumTriangles() >= SoTriangleBVHCache::getMinTriangles()) {
+    this->bvh.build();
+    this->hashierarchy = TRUE;
+  }
+  else {
+    this->bvh.clear();
+    this->hashierarchy = FALSE;
+    this->restarttriangles.truncate(0, TRUE);
+    this->restartoffsets.truncate(0, TRUE);
+    this->restartdata.truncate(0, TRUE);
+  }
+}
+
+/*!
+  Returns \c TRUE if a hierarchy was built for this cache.
+*/
+SbBool
+SoTriangleBVHCache::hasHierarchy(void) const
+{
+  return this->hashierarchy;
+}
+
+/*!
+  Returns the triangle hierarchy.
+*/
+const SbTriangleBVH &
+SoTriangleBVHCache::getHierarchy(void) const
+{
+  return this->bvh;
+}
+
+/*!
+  Adds a restart point before the next triangle added. \a data is
+  interpreted by the shape only.
+*/
+void
+SoTriangleBVHCache::addRestartPoint(const int32_t * data, const int num)
+{
+  this->restarttriangles.append(this->bvh.getNumTriangles());
+  this->restartoffsets.append(this->restartdata.getLength());
+  for (int i = 0; i < num; i++) {
+    this->restartdata.append(data[i]);
+  }
+}
+
+/*!
+  Returns the number of restart points.
+*/
+int
+SoTriangleBVHCache::getNumRestartPoints(void) const
+{
+  return this->restarttriangles.getLength();
+}
+
+/*!
+  Returns the index of the last restart point added before \a
+  triangle, or -1 if there is no such restart point.
+*/
+int
+SoTriangleBVHCache::findRestartPoint(const int triangle) const
+{
+  int lo = 0;
+  int hi = this->restarttriangles.getLength();
+  // binary search for the first restart point after triangle
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (this->restarttriangles[mid] <= triangle) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo - 1;
+}
+
+/*!
+  Returns the index of the first triangle generated after restart
+  point \a idx.
+*/
+int
+SoTriangleBVHCache::getRestartPointTriangle(const int idx) const
+{
+  return this->restarttriangles[idx];
+}
+
+/*!
+  Returns the data stored for restart point \a idx.
+*/
+const int32_t *
+SoTriangleBVHCache::getRestartPointData(const int idx) const
+{
+  return this->restartdata.getArrayPtr() + this->restartoffsets[idx];
+}
+
+/*!
+  Returns the minimum number of triangles a shape needs to get a
+  hierarchy. Can be set using the COIN_RAYPICK_BVH_MIN_TRIANGLES
+  environment variable. A value of 0 disables the hierarchy.
+*/
+int
+SoTriangleBVHCache::getMinTriangles(void)
+{
+  if (COIN_RAYPICK_BVH_MIN_TRIANGLES < 0) {
+    const char * env = coin_getenv("COIN_RAYPICK_BVH_MIN_TRIANGLES");
+    if (env) COIN_RAYPICK_BVH_MIN_TRIANGLES = atoi(env);
+    else COIN_RAYPICK_BVH_MIN_TRIANGLES = 1024;
+    if (COIN_RAYPICK_BVH_MIN_TRIANGLES == 0) COIN_RAYPICK_BVH_MIN_TRIANGLES = INT_MAX;
+  }
+  return COIN_RAYPICK_BVH_MIN_TRIANGLES;
+}
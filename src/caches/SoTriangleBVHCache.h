@@ -0,0 +1,72 @@
+#ifndef COIN_SOTRIANGLEBVHCACHE_H
+#define COIN_SOTRIANGLEBVHCACHE_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* ! COIN_INTERNAL */
+
+#include <Inventor/caches/SoCache.h>
+#include <Inventor/lists/SbList.h>
+#include "base/SbTriangleBVH.h"
+
+class SoTriangleBVHCache : public SoCache {
+  typedef SoCache inherited;
+public:
+  SoTriangleBVHCache(SoState * state);
+  virtual ~SoTriangleBVHCache();
+
+  void addTriangle(const SbVec3f & v0, const SbVec3f & v1, const SbVec3f & v2);
+  void close(void);
+
+  SbBool hasHierarchy(void) const;
+  const SbTriangleBVH & getHierarchy(void) const;
+
+  void addRestartPoint(const int32_t * data, const int num);
+  int getNumRestartPoints(void) const;
+  int findRestartPoint(const int triangle) const;
+  int getRestartPointTriangle(const int idx) const;
+  const int32_t * getRestartPointData(const int idx) const;
+
+  static int getMinTriangles(void);
+
+private:
+  SbTriangleBVH bvh;
+  SbBool hashierarchy;
+  SbList <int> restarttriangles;
+  SbList <int> restartoffsets;
+  SbList <int32_t> restartdata;
+};
+
+#endif // !COIN_SOTRIANGLEBVHCACHE_H
@@ -41,3 +41,4 @@
 #include "SoGlyphCache.cpp"
 #include "SoShaderProgramCache.cpp"
 #include "SoVBOCache.cpp"
+#include "SoTriangleBVHCache.cpp"
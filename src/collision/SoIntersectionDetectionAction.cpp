@@ -43,6 +43,14 @@
   high-performance component in Coin.  Using it in a continuous manner
   over complex scene graphs is doomed to be a performance killer.
 
+  The primitive intersection tests are distributed over one thread
+  per processor by default. Set the environment variable
+  COIN_INTERSECTION_DETECTION_THREADS to use another number of
+  threads. The intersection callbacks are always invoked from the
+  thread calling apply(), in the same order from run to run. Note
+  that the filter callback may be invoked for a number of shape pairs
+  ahead of the intersection callbacks for earlier pairs.
+
   Below is a simple usage example for this class.  It was written as a
   standalone framework set up for profiling and optimization of the
   SoIntersectionDetectionAction.  It tests intersection of all shapes
@@ -120,11 +128,6 @@
 // intersection testing code in SoExtSelection. Check if that could be
 // used.
 
-// FIXME: I just noticed that there's an O(n^2) algorithm for removing
-// duplicates from SbOctTree::findItems() results in SbOctTree.cpp
-// (see the add_to_array() helper function). This may very well be a
-// serious bottleneck, should investigate. 20050512 mortene.
-
 // *************************************************************************
 
 #include <Inventor/collision/SoIntersectionDetectionAction.h>
@@ -134,15 +137,12 @@
 #endif // HAVE_CONFIG_H
 
 #include <Inventor/C/tidbits.h>
-#include <Inventor/SbOctTree.h>
 #include <Inventor/SbRotation.h>
 #include <Inventor/SbTime.h>
-#include <Inventor/SbViewportRegion.h>
 #include <Inventor/SbXfBox3f.h>
 #include <Inventor/SoPath.h>
 #include <Inventor/SoPrimitiveVertex.h>
 #include <Inventor/actions/SoCallbackAction.h>
-#include <Inventor/actions/SoGetBoundingBoxAction.h>
 #include <Inventor/actions/SoGetPrimitiveCountAction.h>
 #include <Inventor/actions/SoWriteAction.h>
 #include <Inventor/caches/SoBoundingBoxCache.h>
@@ -170,6 +170,7 @@
 #endif // HAVE_MANIPULATORS
 
 #include "actions/SoSubActionP.h"
+#include "base/SbTriangleBVH.h"
 #include "collision/SbTri3f.h"
 #include "coindefs.h"
 
@@ -179,7 +180,14 @@
 #endif // VC6.0
 
 #include "SbBasicP.h"
+#include "tidbitsp.h"
+
+#ifdef HAVE_THREADS
+#include <Inventor/C/threads/mutex.h>
+#include <Inventor/C/threads/wpool.h>
+#endif // HAVE_THREADS
 
+#include <algorithm>
 #include <list>
 #include <vector>
 
@@ -213,6 +221,9 @@
 
 class ShapeData;
 class PrimitiveData;
+class IntersectionTask;
+
+typedef void ida_job_f(void * closure, const int idx);
 
 class SoIntersectionDetectionAction :: PImpl {
 public:
@@ -246,8 +257,15 @@ public:
 
   void reset(void);
   void doIntersectionTesting(void);
-  void doPrimitiveIntersectionTesting(PrimitiveData * primitives1, PrimitiveData * primitives2, SbBool & cont);
-  void doInternalPrimitiveIntersectionTesting(PrimitiveData * primitives, SbBool & cont);
+  void addIntersectionTask(std::vector<IntersectionTask *> & tasks, PrimitiveData * primitives1, PrimitiveData * primitives2);
+  void doIntersectionTasks(std::vector<IntersectionTask *> & tasks, SbBool & cont);
+  void invokeIntersectionCallbacks(const IntersectionTask * task, SbBool & cont);
+
+  void runParallel(ida_job_f * func, void * closure, const int numjobs);
+  int numthreads;
+#ifdef HAVE_THREADS
+  cc_wpool * pool;
+#endif // HAVE_THREADS
 
   SoTypeList * prunetypes;
 
@@ -257,7 +275,6 @@ public:
   std::vector<SoIntersectionVisitationCallback> traversalcallbacks;
 
   SbList<ShapeData*> shapedata;
-  SbXfBox3f fullxfbbox;
 };
 
 float SoIntersectionDetectionAction::PImpl::staticepsilon = 0.0f;
@@ -274,6 +291,13 @@ SoIntersectionDetectionAction::PImpl::PImpl(void)
   this->traverser = NULL;
   this->prunetypes = new SoTypeList;
   this->traversaltypes = new SoTypeList;
+
+  this->numthreads = coin_num_processors();
+  const char * env = coin_getenv("COIN_INTERSECTION_DETECTION_THREADS");
+  if (env && atoi(env) > 0) { this->numthreads = atoi(env); }
+#ifdef HAVE_THREADS
+  this->pool = NULL;
+#endif // HAVE_THREADS
 }
 
 SoIntersectionDetectionAction::PImpl::~PImpl(void)
@@ -282,6 +306,9 @@ SoIntersectionDetectionAction::PImpl::~PImpl(void)
   delete this->traverser;
   delete this->prunetypes;
   delete this->traversaltypes;
+#ifdef HAVE_THREADS
+  if (this->pool) { cc_wpool_destruct(this->pool); }
+#endif // HAVE_THREADS
 }
 
 float
@@ -670,13 +697,6 @@ SoIntersectionDetectionAction::apply(SoNode * node)
 
   PRIVATE(this)->reset();
 
-  // Needs a bounding box for the full scene, for later initialization
-  // of the SbOctTree of shape bounding boxes.
-  SbViewportRegion vp;
-  SoGetBoundingBoxAction bboxaction(vp);
-  bboxaction.apply(node);
-  PRIVATE(this)->fullxfbbox = bboxaction.getXfBoundingBox();
-
   if (ida_debug()) { // debug
     SoGetPrimitiveCountAction counter;
     counter.apply(node);
@@ -708,13 +728,6 @@ SoIntersectionDetectionAction::apply(SoPath * path)
 {
   PRIVATE(this)->reset();
 
-  // Needs a bounding box for the full scene, for later initialization
-  // of the SbOctTree of shape bounding boxes.
-  SbViewportRegion vp;
-  SoGetBoundingBoxAction bboxaction(vp);
-  bboxaction.apply(path);
-  PRIVATE(this)->fullxfbbox = bboxaction.getXfBoundingBox();
-
   PRIVATE(this)->traverser->apply(path);
   PRIVATE(this)->doIntersectionTesting();
 }
@@ -724,13 +737,6 @@ SoIntersectionDetectionAction::apply(const SoPathList & paths, SbBool obeysRules
 {
   PRIVATE(this)->reset();
 
-  // Needs a bounding box for the full scene, for later initialization
-  // of the SbOctTree of shape bounding boxes.
-  SbViewportRegion vp;
-  SoGetBoundingBoxAction bboxaction(vp);
-  bboxaction.apply(paths, obeysRules);
-  PRIVATE(this)->fullxfbbox = bboxaction.getXfBoundingBox();
-
   PRIVATE(this)->traverser->apply(paths, obeysRules);
   PRIVATE(this)->doIntersectionTesting();
 }
@@ -742,62 +748,50 @@ public:
   PrimitiveData(void)
   {
     this->path = NULL;
-    this->octtree = NULL;
+    this->hierarchybuilt = FALSE;
   }
 
   ~PrimitiveData()
   {
-    delete this->octtree;
     for (unsigned int i = 0; i < this->numTriangles(); i++) { delete this->getTriangle(i); }
   }
 
+  // The hierarchy must be built before triangles can be looked up
+  // with findTriangles(). Building is not thread safe, but lookups
+  // are.
+  SbBool hasHierarchy(void) const { return this->hierarchybuilt; }
+
+  void buildHierarchy(void) {
+    if (this->hierarchybuilt) { return; }
+    for (unsigned int k = 0; k < this->numTriangles(); k++) {
+      SbVec3f a, b, c;
+      this->getTriangle(k)->getValue(a, b, c);
+      this->bvh.addTriangle(a, b, c);
+    }
+    this->bvh.build();
+    this->hierarchybuilt = TRUE;
 
-  const SbOctTree * getOctTree(void) {
-    if (this->octtree == NULL) {
-      const SbOctTreeFuncs funcs = {
-        NULL /* ptinsidefunc */,
-        PrimitiveData::insideboxfunc,
-        NULL /* insidespherefunc */,
-        NULL /* insideplanesfunc */
-      };
-
-      SbBox3f b = this->getBoundingBox();
-      // Add a 1% slack to the bounding box, to avoid problems in
-      // SbOctTree due to floating point inaccuracies (see assert() in
-      // SbOctTree::addItem()).
-      //
-      // This may be just a temporary hack -- see the FIXME at the
-      // same place as mentioned above.
-      SbMatrix m;
-      m.setTransform(SbVec3f(0, 0, 0), // translation
-                     SbRotation::identity(), // rotation
-                     SbVec3f(1.01f, 1.01f, 1.01f), // scalefactor
-                     SbRotation::identity(), // scaleorientation
-                     SbVec3f(b.getCenter())); // center
-      b.transform(m);
-
-      this->octtree = new SbOctTree(b, funcs);
-
-      if (ida_debug()) {
-        SoDebugError::postInfo("PrimitiveData::getOctTree",
-                               "made new octtree for PrimitiveData %p", this);
-      }
-
-      for (unsigned int k = 0; k < this->numTriangles(); k++) {
-        SbTri3f * t = this->getTriangle(k);
-        this->octtree->addItem(t);
-      }
+    if (ida_debug()) {
+      SoDebugError::postInfo("PrimitiveData::buildHierarchy",
+                             "made new hierarchy for PrimitiveData %p", this);
     }
-    return this->octtree;
   }
 
+  // Appends the indices of triangles with bounding boxes intersecting
+  // the box, in ascending order.
+  void findTriangles(const SbBox3f & box, std::vector<int> & result) const {
+    assert(this->hasHierarchy());
+    result.clear();
+    this->bvh.findTriangles(box, PrimitiveData::collectCB, &result);
+    std::sort(result.begin(), result.end());
+  }
 
   void setPath(SoPath * p) { this->path = p; }
   SoPath * getPath(void) const { return this->path; }
 
   void addTriangle(SbTri3f * t)
   {
-    assert(this->octtree == NULL && "all triangles must be added before making octtree");
+    assert(!this->hierarchybuilt && "all triangles must be added before making hierarchy");
     this->triangles.append(t);
     this->bbox.extendBy(t->getBoundingBox());
   }
@@ -811,19 +805,19 @@ public:
   SbMatrix invtransform;
 
 private:
-  static SbBool insideboxfunc(void * const item, const SbBox3f & box);
+  static void collectCB(void * closure, const int triangle);
 
   SoPath * path;
   SbList<SbTri3f*> triangles;
   SbBox3f bbox;
-  SbOctTree * octtree;
+  SbTriangleBVH bvh;
+  SbBool hierarchybuilt;
 };
 
-SbBool
-PrimitiveData::insideboxfunc(void * const item, const SbBox3f & box)
+void
+PrimitiveData::collectCB(void * closure, const int triangle)
 {
-  SbTri3f * tri = static_cast<SbTri3f *>(item);
-  return box.intersect(tri->getBoundingBox());
+  static_cast<std::vector<int> *>(closure)->push_back(triangle);
 }
 
 // *************************************************************************
@@ -1153,12 +1147,88 @@ expand_SbXfBox3f(const SbXfBox3f & box, float epsilon)
   return extbox;
 }
 
-// The callback test function for the SbOctTree.
-static SbBool
-shapeinsideboxfunc(void * const item, const SbBox3f & box)
+// Collects shape indices from the shape hierarchy.
+static void
+shapecollectcb(void * closure, const int shape)
 {
-  ShapeData * shape = static_cast<ShapeData *>(item);
-  return shape->xfbbox.intersect(box);
+  static_cast<std::vector<int> *>(closure)->push_back(shape);
+}
+
+// Narrow phase work for a pair of shapes, or for a single shape
+// against itself. The triangles of the first shape are iterated over
+// in chunks, and looked up in the triangle hierarchy of the second
+// shape. Chunks are processed in parallel, and the intersecting
+// triangle pairs are collected in chunk order, so that callbacks are
+// invoked in the same order for every run.
+class IntersectionTask {
+public:
+  enum { CHUNKSIZE = 256 };
+
+  IntersectionTask(PrimitiveData * p1, PrimitiveData * p2, const float e)
+    : primitives1(p1), primitives2(p2), epsilon(e)
+  {
+    const int numchunks = (p1->numTriangles() + CHUNKSIZE - 1) / CHUNKSIZE;
+    this->hits.resize(numchunks);
+    this->nrisectchks.resize(numchunks, 0);
+  }
+
+  int getNumChunks(void) const { return static_cast<int>(this->hits.size()); }
+  SbBool isInternal(void) const { return this->primitives1 == this->primitives2; }
+
+  void findIntersections(const int chunk);
+
+  PrimitiveData * primitives1;
+  PrimitiveData * primitives2;
+  float epsilon;
+  std::vector<std::vector<std::pair<int, int> > > hits;
+  std::vector<unsigned int> nrisectchks;
+};
+
+void
+IntersectionTask::findIntersections(const int chunk)
+{
+  const int start = chunk * CHUNKSIZE;
+  const int end = SbMin(start + static_cast<int>(CHUNKSIZE),
+                        static_cast<int>(this->primitives1->numTriangles()));
+  const SbBool internal = this->isInternal();
+  SbVec3f e(this->epsilon, this->epsilon, this->epsilon);
+  if (internal) {
+    // SbTri3f::intersect() reports some neighbouring triangles within
+    // a shape as intersecting when their bounding boxes are separated
+    // by floating point noise only. Add some slack so the results are
+    // the same as when testing all pairs.
+    const float slack = this->primitives1->getBoundingBox().getSize().length() * 1.0e-5f;
+    e = SbVec3f(slack, slack, slack);
+  }
+
+  std::vector<std::pair<int, int> > & result = this->hits[chunk];
+  std::vector<int> candidatetris;
+
+  for (int i = start; i < end; i++) {
+    const SbTri3f * t1 = this->primitives1->getTriangle(i);
+
+    SbBox3f tribbox = t1->getBoundingBox();
+    // Extend bbox in all 6 directions with the epsilon value.
+    tribbox.getMin() -= e;
+    tribbox.getMax() += e;
+
+    this->primitives2->findTriangles(tribbox, candidatetris);
+
+    for (size_t j = 0; j < candidatetris.size(); j++) {
+      // Triangles are not tested against themselves, and each pair
+      // within a shape is only tested once.
+      if (internal && candidatetris[j] <= i) { continue; }
+      const SbTri3f * t2 = this->primitives2->getTriangle(candidatetris[j]);
+      if (!tribbox.intersect(t2->getBoundingBox())) { continue; }
+
+      this->nrisectchks[chunk]++;
+
+      // Can ignore epsilon setting for internal testing, as that only
+      // indicates a distance between distinct shapes.
+      const SbBool hit = internal ? t1->intersect(*t2) : t1->intersect(*t2, this->epsilon);
+      if (hit) { result.push_back(std::pair<int, int>(i, candidatetris[j])); }
+    }
+  }
 }
 
 // Execute full set of intersection detection operations on all the
@@ -1182,36 +1252,20 @@ SoIntersectionDetectionAction::PImpl::doIntersectionTesting(void)
 
   }
 
-  const SbOctTreeFuncs funcs = {
-    NULL /* ptinsidefunc */,
-    shapeinsideboxfunc,
-    NULL /* insidespherefunc */,
-    NULL /* insideplanesfunc */
-  };
-
-  SbBox3f b = this->fullxfbbox.project();
-  // Add a 1% slack to the bounding box, to avoid problems in
-  // SbOctTree due to floating point inaccuracies (see assert() in
-  // SbOctTree::addItem()).
-  //
-  // This may be just a temporary hack -- see the FIXME at the
-  // same place.
-  SbMatrix m;
-  m.setTransform(SbVec3f(0, 0, 0), // translation
-                 SbRotation::identity(), // rotation
-                 SbVec3f(1.01f, 1.01f, 1.01f), // scalefactor
-                 SbRotation::identity(), // scaleorientation
-                 SbVec3f(b.getCenter())); // center
-  b.transform(m);
-
-  SbOctTree shapetree(b, funcs);
-  for (int k = 0; k < this->shapedata.getLength(); k++) {
+  // A hierarchy over the shape bounding boxes, made from degenerate
+  // triangles spanning the diagonal of each box, so that the
+  // triangle bounding box equals the shape bounding box.
+  SbTriangleBVH shapetree;
+  std::vector<int> shapeindices;
+  int k;
+  for (k = 0; k < this->shapedata.getLength(); k++) {
     ShapeData * shape = this->shapedata[k];
     if (shape->xfbbox.isEmpty()) { continue; }
-    shapetree.addItem(shape);
+    const SbBox3f box = shape->xfbbox.project();
+    shapetree.addTriangle(box.getMin(), box.getMax(), box.getMax());
+    shapeindices.push_back(k);
   }
-
-  if (ida_debug()) { shapetree.debugTree(stderr); }
+  shapetree.build();
 
   // For debugging.
   unsigned int nrshapeshapeisects = 0;
@@ -1219,24 +1273,22 @@ SoIntersectionDetectionAction::PImpl::doIntersectionTesting(void)
 
   const float theepsilon = this->getEpsilon();
 
-  for (int i = 0; i < this->shapedata.getLength(); i++) {
-    ShapeData * shape1 = this->shapedata[i];
+  // Narrow phase tasks are collected in batches, to bound memory use
+  // while still giving the worker threads enough to do.
+  const unsigned int maxbatchsize = 16 * this->numthreads;
+  std::vector<IntersectionTask *> tasks;
+  std::vector<int> candidateshapes;
+  SbBool cont = TRUE;
 
-    // If the shape has no geometry, immediately skip to next
-    // iteration of for-loop.
-    if (shape1->xfbbox.isEmpty()) { continue; }
-
-    // Remove shapes from octtree as we iterate over the full set, to
-    // avoid self-intersection and to avoid checks against other
-    // shapes happening both ways.
-    shapetree.removeItem(shape1);
+  for (k = 0; cont && k < static_cast<int>(shapeindices.size()); k++) {
+    const int i = shapeindices[k];
+    ShapeData * shape1 = this->shapedata[i];
 
     // FIXME: shouldn't we also invoke the filter-callback here? 20030403 mortene.
     if (this->internalsenabled) {
       nrselfisects++;
-      SbBool cont;
-      this->doInternalPrimitiveIntersectionTesting(shape1->getPrimitives(), cont);
-      if (!cont) { goto done; }
+      PrimitiveData * primitives = shape1->getPrimitives();
+      this->addIntersectionTask(tasks, primitives, primitives);
     }
 
     SbBox3f shapebbox = shape1->xfbbox.project();
@@ -1246,47 +1298,28 @@ SoIntersectionDetectionAction::PImpl::doIntersectionTesting(void)
       shapebbox.getMin() -= e;
       shapebbox.getMax() += e;
     }
-    SbList<void*> candidateshapes;
-    shapetree.findItems(shapebbox, candidateshapes);
+    candidateshapes.clear();
+    shapetree.findTriangles(shapebbox, shapecollectcb, &candidateshapes);
+    // Only check against shapes later in the list, to avoid checks
+    // against other shapes happening both ways.
+    std::sort(candidateshapes.begin(), candidateshapes.end());
 
     if (ida_debug()) {
       SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doIntersectionTesting",
                              "shape %d intersects %d other shapes",
-                             i, candidateshapes.getLength());
-
-      // debug, dump to .iv-file the "master" shape bbox given by i,
-      // plus ditto for all intersected shapes
-#if 0
-      if (i == 4) {
-        SoSeparator * root = new SoSeparator;
-        root->ref();
-
-        root->addChild(make_scene_graph(shape1->xfbbox, "mastershape"));
-
-        for (int j = 0; j < candidateshapes.getLength(); j++) {
-          ShapeData * s = (ShapeData * )candidateshapes[j];
-          SbString str;
-          str.sprintf("%d", j);
-          root->addChild(make_scene_graph(s->xfbbox, str.getString()));
-        }
-
-        SoOutput out;
-        SbBool ok = out.openFile("/tmp/shapechk.iv");
-        assert(ok);
-        SoWriteAction wa(&out);
-        wa.apply(root);
-
-        root->unref();
-      }
-#endif // debug
+                             i, static_cast<int>(candidateshapes.size()) - 1);
     }
 
     SbXfBox3f xfboxchk;
     if (theepsilon > 0.0f) { xfboxchk = expand_SbXfBox3f(shape1->xfbbox, theepsilon); }
     else { xfboxchk = shape1->xfbbox; }
 
-    for (int j = 0; j < candidateshapes.getLength(); j++) {
-      ShapeData * shape2 = static_cast<ShapeData *>(candidateshapes[j]);
+    for (size_t c = 0; c < candidateshapes.size(); c++) {
+      if (candidateshapes[c] <= k) { continue; }
+      const int j = shapeindices[candidateshapes[c]];
+      ShapeData * shape2 = this->shapedata[j];
+
+      if (!shapebbox.intersect(shape2->xfbbox.project())) { continue; }
 
       if (!xfboxchk.intersect(shape2->xfbbox)) {
         if (ida_debug()) {
@@ -1300,14 +1333,16 @@ SoIntersectionDetectionAction::PImpl::doIntersectionTesting(void)
       if (!this->filtercb ||
           this->filtercb(this->filterclosure, shape1->path, shape2->path)) {
         nrshapeshapeisects++;
-        SbBool cont;
-        this->doPrimitiveIntersectionTesting(shape1->getPrimitives(), shape2->getPrimitives(), cont);
-        if (!cont) { goto done; }
+        this->addIntersectionTask(tasks, shape1->getPrimitives(), shape2->getPrimitives());
       }
     }
+
+    if (tasks.size() >= maxbatchsize) { this->doIntersectionTasks(tasks, cont); }
   }
+  if (cont) { this->doIntersectionTasks(tasks, cont); }
+
+  for (size_t t = 0; t < tasks.size(); t++) { delete tasks[t]; }
 
- done:
   if (ida_debug()) {
     SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doIntersectionTesting",
                            "shape-shape intersections: %d, shape self-intersections: %d",
@@ -1315,96 +1350,148 @@ SoIntersectionDetectionAction::PImpl::doIntersectionTesting(void)
   }
 }
 
-// Intersection testing between primitives of different shapes.
+// Adds a narrow phase task for testing the primitives of two shapes,
+// or of a single shape against itself.
 void
-SoIntersectionDetectionAction::PImpl::doPrimitiveIntersectionTesting(PrimitiveData * primitives1,
-                                                             PrimitiveData * primitives2,
-                                                             SbBool & cont)
+SoIntersectionDetectionAction::PImpl::addIntersectionTask(std::vector<IntersectionTask *> & tasks,
+                                                          PrimitiveData * primitives1,
+                                                          PrimitiveData * primitives2)
 {
-  cont = TRUE;
-
   // for debugging
   if (ida_debug()) {
-    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doPrimitiveIntersectionTesting",
+    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::addIntersectionTask",
                            "primitives1 (%p) = %d tris, primitives2 (%p) = %d tris",
                            primitives1, primitives1->numTriangles(),
                            primitives2, primitives2->numTriangles());
   }
-  unsigned int nrisectchks = 0;
-  unsigned int nrhits = 0;
 
-  // Use the majority size shape from an octtree.
+  // Use the majority size shape from a hierarchy.
   //
   // (Some initial investigation indicates that this isn't a clear-cut
   // choice, by the way -- should investigate further. mortene.)
-  PrimitiveData * octtreeprims = primitives1;
+  PrimitiveData * treeprims = primitives1;
   PrimitiveData * iterationprims = primitives2;
   if (primitives1->numTriangles() < primitives2->numTriangles()) {
-    octtreeprims = primitives2;
+    treeprims = primitives2;
     iterationprims = primitives1;
   }
+  if (iterationprims->numTriangles() == 0) { return; }
 
-  const SbOctTree * octtree = octtreeprims->getOctTree();
+  tasks.push_back(new IntersectionTask(iterationprims, treeprims, this->getEpsilon()));
+}
 
-  const float theepsilon = this->getEpsilon();
-  const SbVec3f e(theepsilon, theepsilon, theepsilon);
+// jobs for runParallel(), building the triangle hierarchies needed by
+// a batch of tasks
+static void
+ida_build_hierarchy(void * closure, const int idx)
+{
+  std::vector<PrimitiveData *> * primitives = static_cast<std::vector<PrimitiveData *> *>(closure);
+  (*primitives)[idx]->buildHierarchy();
+}
 
-  for (unsigned int i = 0; i < iterationprims->numTriangles(); i++) {
-    SbTri3f * t1 = static_cast<SbTri3f *>(iterationprims->getTriangle(i));
+// jobs for runParallel(), testing one chunk of a task each
+struct ida_chunk_jobs {
+  std::vector<std::pair<IntersectionTask *, int> > chunks;
+};
 
-    SbBox3f tribbox = t1->getBoundingBox();
-    if (theepsilon > 0.0f) {
-      // Extend bbox in all 6 directions with the epsilon value.
-      tribbox.getMin() -= e;
-      tribbox.getMax() += e;
+static void
+ida_find_intersections(void * closure, const int idx)
+{
+  ida_chunk_jobs * jobs = static_cast<ida_chunk_jobs *>(closure);
+  jobs->chunks[idx].first->findIntersections(jobs->chunks[idx].second);
+}
+
+// Runs the narrow phase for a batch of tasks, then invokes the
+// intersection callbacks for the results, in task order. The batch
+// is emptied.
+void
+SoIntersectionDetectionAction::PImpl::doIntersectionTasks(std::vector<IntersectionTask *> & tasks,
+                                                          SbBool & cont)
+{
+  cont = TRUE;
+  if (tasks.empty()) { return; }
+
+  std::vector<PrimitiveData *> unbuilt;
+  ida_chunk_jobs jobs;
+  size_t t;
+  for (t = 0; t < tasks.size(); t++) {
+    PrimitiveData * treeprims = tasks[t]->primitives2;
+    if (!treeprims->hasHierarchy() &&
+        std::find(unbuilt.begin(), unbuilt.end(), treeprims) == unbuilt.end()) {
+      unbuilt.push_back(treeprims);
+    }
+    for (int c = 0; c < tasks[t]->getNumChunks(); c++) {
+      jobs.chunks.push_back(std::pair<IntersectionTask *, int>(tasks[t], c));
     }
+  }
+
+  this->runParallel(ida_build_hierarchy, &unbuilt, static_cast<int>(unbuilt.size()));
+  this->runParallel(ida_find_intersections, &jobs, static_cast<int>(jobs.chunks.size()));
+
+  for (t = 0; t < tasks.size() && cont; t++) {
+    this->invokeIntersectionCallbacks(tasks[t], cont);
+  }
+  for (t = 0; t < tasks.size(); t++) { delete tasks[t]; }
+  tasks.clear();
+}
+
+// Invokes the intersection callbacks for all intersecting triangle
+// pairs found by a task.
+void
+SoIntersectionDetectionAction::PImpl::invokeIntersectionCallbacks(const IntersectionTask * task,
+                                                                  SbBool & cont)
+{
+  cont = TRUE;
 
-    SbList<void*> candidatetris;
-    octtree->findItems(tribbox, candidatetris);
-
-    for (int j = 0; j < candidatetris.getLength(); j++) {
-      SbTri3f * t2 = static_cast<SbTri3f *>(candidatetris[j]);
-
-      nrisectchks++;
-
-      if (t1->intersect(*t2, theepsilon)) {
-        nrhits++;
-
-        SoIntersectingPrimitive p1;
-        p1.path = iterationprims->getPath();
-        p1.type = SoIntersectingPrimitive::TRIANGLE;
-        t1->getValue(p1.xf_vertex[0], p1.xf_vertex[1], p1.xf_vertex[2]);
-        iterationprims->invtransform.multVecMatrix(p1.xf_vertex[0], p1.vertex[0]);
-        iterationprims->invtransform.multVecMatrix(p1.xf_vertex[1], p1.vertex[1]);
-        iterationprims->invtransform.multVecMatrix(p1.xf_vertex[2], p1.vertex[2]);
-
-        SoIntersectingPrimitive p2;
-        p2.path = octtreeprims->getPath();
-        p2.type = SoIntersectingPrimitive::TRIANGLE;
-        t2->getValue(p2.xf_vertex[0], p2.xf_vertex[1], p2.xf_vertex[2]);
-        octtreeprims->invtransform.multVecMatrix(p2.xf_vertex[0], p2.vertex[0]);
-        octtreeprims->invtransform.multVecMatrix(p2.xf_vertex[1], p2.vertex[1]);
-        octtreeprims->invtransform.multVecMatrix(p2.xf_vertex[2], p2.vertex[2]);
-
-        std::vector<SoIntersectionCallback>::iterator it = this->callbacks.begin();
-        while (it != this->callbacks.end()) {
-          switch ( (*it).first((*it).second, &p1, &p2) ) {
-          case SoIntersectionDetectionAction::NEXT_PRIMITIVE:
-            // Break out of the switch, invoke next callback.
-            break;
-          case SoIntersectionDetectionAction::NEXT_SHAPE:
-            // FIXME: remaining callbacks won't be invoked -- should they? 20030328 mortene.
-            cont = TRUE;
-            goto done;
-          case SoIntersectionDetectionAction::ABORT:
-            // FIXME: remaining callbacks won't be invoked -- should they? 20030328 mortene.
-            cont = FALSE;
-            goto done;
-          default:
-            assert(0);
-          }
-          ++it;
+  PrimitiveData * primitives1 = task->primitives1;
+  PrimitiveData * primitives2 = task->primitives2;
+
+  unsigned int nrisectchks = 0;
+  unsigned int nrhits = 0;
+
+  for (int c = 0; c < task->getNumChunks(); c++) {
+    nrisectchks += task->nrisectchks[c];
+    const std::vector<std::pair<int, int> > & hits = task->hits[c];
+
+    for (size_t h = 0; h < hits.size(); h++) {
+      nrhits++;
+      const SbTri3f * t1 = primitives1->getTriangle(hits[h].first);
+      const SbTri3f * t2 = primitives2->getTriangle(hits[h].second);
+
+      SoIntersectingPrimitive p1;
+      p1.path = primitives1->getPath();
+      p1.type = SoIntersectingPrimitive::TRIANGLE;
+      t1->getValue(p1.xf_vertex[0], p1.xf_vertex[1], p1.xf_vertex[2]);
+      primitives1->invtransform.multVecMatrix(p1.xf_vertex[0], p1.vertex[0]);
+      primitives1->invtransform.multVecMatrix(p1.xf_vertex[1], p1.vertex[1]);
+      primitives1->invtransform.multVecMatrix(p1.xf_vertex[2], p1.vertex[2]);
+
+      SoIntersectingPrimitive p2;
+      p2.path = primitives2->getPath();
+      p2.type = SoIntersectingPrimitive::TRIANGLE;
+      t2->getValue(p2.xf_vertex[0], p2.xf_vertex[1], p2.xf_vertex[2]);
+      primitives2->invtransform.multVecMatrix(p2.xf_vertex[0], p2.vertex[0]);
+      primitives2->invtransform.multVecMatrix(p2.xf_vertex[1], p2.vertex[1]);
+      primitives2->invtransform.multVecMatrix(p2.xf_vertex[2], p2.vertex[2]);
+
+      std::vector<SoIntersectionCallback>::iterator it = this->callbacks.begin();
+      while (it != this->callbacks.end()) {
+        switch ( (*it).first((*it).second, &p1, &p2) ) {
+        case SoIntersectionDetectionAction::NEXT_PRIMITIVE:
+          // Break out of the switch, invoke next callback.
+          break;
+        case SoIntersectionDetectionAction::NEXT_SHAPE:
+          // FIXME: remaining callbacks won't be invoked -- should they? 20030328 mortene.
+          cont = TRUE;
+          goto done;
+        case SoIntersectionDetectionAction::ABORT:
+          // FIXME: remaining callbacks won't be invoked -- should they? 20030328 mortene.
+          cont = FALSE;
+          goto done;
+        default:
+          assert(0);
         }
+        ++it;
       }
     }
   }
@@ -1413,87 +1500,173 @@ done:
   // for debugging
   if (ida_debug()) {
     const unsigned int total = primitives1->numTriangles() + primitives2->numTriangles();
-    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doPrimitiveIntersectionTesting",
+    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::invokeIntersectionCallbacks",
                            "intersection checks = %d (pr primitive: %f)",
                            nrisectchks, float(nrisectchks) / total);
     SbString chksprhit;
     if (nrhits == 0) { chksprhit = "-"; }
     else { chksprhit.sprintf("%f", float(nrisectchks) / nrhits); }
-    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doPrimitiveIntersectionTesting",
+    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::invokeIntersectionCallbacks",
                            "hits = %d (chks pr hit: %s)", nrhits, chksprhit.getString());
   }
 }
 
-// Does intersection testing internally within the same
-// shape. Triangles are not tested against themselves.
-//
-// Can ignore epsilon setting, as that only indicates a distance
-// between distinct shapes.
-void
-SoIntersectionDetectionAction::PImpl::doInternalPrimitiveIntersectionTesting(PrimitiveData * primitives,
-                                                                     SbBool & cont)
+// Shared state for the threads running jobs in runParallel(). Jobs
+// are handed out in index order.
+struct ida_parallel_jobs {
+  ida_job_f * func;
+  void * closure;
+  int numjobs;
+  int next;
+#ifdef HAVE_THREADS
+  cc_mutex * mutex;
+#endif // HAVE_THREADS
+};
+
+static void
+ida_run_jobs(void * closure)
 {
-  // for debugging
-  if (ida_debug()) {
-    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doInternalPrimitiveIntersectionTesting",
-                           "triangles shape = %d", primitives->numTriangles());
+  ida_parallel_jobs * jobs = static_cast<ida_parallel_jobs *>(closure);
+  for (;;) {
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_lock(jobs->mutex); }
+#endif // HAVE_THREADS
+    const int idx = jobs->next++;
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_unlock(jobs->mutex); }
+#endif // HAVE_THREADS
+    if (idx >= jobs->numjobs) { return; }
+    jobs->func(jobs->closure, idx);
   }
-  unsigned int nrisectchks = 0;
+}
 
-  // FIXME: use the SbOctTree optimization, as above. Should refactor
-  // doPrimitiveIntersectionTesting() and
-  // doInternalPrimitiveIntersectionTesting() into common
-  // code. 20030328 mortene.
+// Runs \a numjobs invocations of \a func, distributed over the
+// worker pool and the calling thread, and returns when all are
+// done. The jobs must not touch the scene graph.
+void
+SoIntersectionDetectionAction::PImpl::runParallel(ida_job_f * func, void * closure, const int numjobs)
+{
+  ida_parallel_jobs jobs;
+  jobs.func = func;
+  jobs.closure = closure;
+  jobs.numjobs = numjobs;
+  jobs.next = 0;
+
+#ifdef HAVE_THREADS
+  jobs.mutex = NULL;
+  // the calling thread takes part in the work
+  const int numworkers = SbMin(this->numthreads, numjobs) - 1;
+  if (numworkers > 0 && cc_thread_implementation() != CC_NO_THREADS) {
+    if (this->pool == NULL) {
+      this->pool = cc_wpool_construct(numworkers);
+    }
+    else if (cc_wpool_get_num_workers(this->pool) < numworkers) {
+      cc_wpool_set_num_workers(this->pool, numworkers);
+    }
+    jobs.mutex = cc_mutex_construct();
 
-  cont = TRUE;
-  const int numprimitives = primitives->numTriangles();
-  for (int i = 0; i < numprimitives; i++ ) {
-    SbTri3f * t1 = static_cast<SbTri3f *>(primitives->getTriangle(i));
-    for (int j = i + 1; j < numprimitives; j++ ) {
-      SbTri3f * t2 = static_cast<SbTri3f *>(primitives->getTriangle(j));
-      nrisectchks++;
-      if ( t1->intersect(*t2) ) {
-        SoIntersectingPrimitive p1;
-        p1.path = primitives->getPath();
-        p1.type = SoIntersectingPrimitive::TRIANGLE;
-        t1->getValue(p1.xf_vertex[0], p1.xf_vertex[1], p1.xf_vertex[2]);
-        primitives->invtransform.multVecMatrix(p1.xf_vertex[0], p1.vertex[0]);
-        primitives->invtransform.multVecMatrix(p1.xf_vertex[1], p1.vertex[1]);
-        primitives->invtransform.multVecMatrix(p1.xf_vertex[2], p1.vertex[2]);
-
-        SoIntersectingPrimitive p2;
-        p2.path = primitives->getPath();
-        p2.type = SoIntersectingPrimitive::TRIANGLE;
-        t2->getValue(p2.xf_vertex[0], p2.xf_vertex[1], p2.xf_vertex[2]);
-        primitives->invtransform.multVecMatrix(p2.xf_vertex[0], p2.vertex[0]);
-        primitives->invtransform.multVecMatrix(p2.xf_vertex[1], p2.vertex[1]);
-        primitives->invtransform.multVecMatrix(p2.xf_vertex[2], p2.vertex[2]);
-
-        std::vector<SoIntersectionCallback>::iterator it = this->callbacks.begin();
-        while (it != this->callbacks.end()) {
-          switch ( (*it).first((*it).second, &p1, &p2) ) {
-          case SoIntersectionDetectionAction::NEXT_PRIMITIVE:
-            break;
-          case SoIntersectionDetectionAction::NEXT_SHAPE:
-            cont = TRUE;
-            goto done;
-          case SoIntersectionDetectionAction::ABORT:
-            cont = FALSE;
-            goto done;
-          default:
-            assert(0);
-          }
-          ++it;
-        }
-      }
+    cc_wpool_begin(this->pool, numworkers);
+    for (int i = 0; i < numworkers; i++) {
+      cc_wpool_start_worker(this->pool, ida_run_jobs, &jobs);
     }
+    cc_wpool_end(this->pool);
+
+    ida_run_jobs(&jobs);
+    cc_wpool_wait_all(this->pool);
+    cc_mutex_destruct(jobs.mutex);
+    return;
   }
- done:
-  // for debugging
-  if (ida_debug()) {
-    SoDebugError::postInfo("SoIntersectionDetectionAction::PImpl::doInternalPrimitiveIntersectionTesting",
-                           "intersection checks = %d", nrisectchks);
-  }
+#endif // HAVE_THREADS
+
+  ida_run_jobs(&jobs);
 }
 
 #undef PRIVATE
+
+#ifdef COIN_TEST_SUITE
+
+#include <vector>
+#include <Inventor/SbVec3f.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoSphere.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static std::vector<SbVec3f> *
+ida_test_hits(void)
+{
+  static std::vector<SbVec3f> hits;
+  return &hits;
+}
+
+static SoIntersectionDetectionAction::Resp
+ida_test_record_cb(void * closure,
+                   const SoIntersectingPrimitive * p1,
+                   const SoIntersectingPrimitive * p2)
+{
+  std::vector<SbVec3f> * hits = ida_test_hits();
+  for (int i = 0; i < 3; i++) { hits->push_back(p1->xf_vertex[i]); }
+  for (int i = 0; i < 3; i++) { hits->push_back(p2->xf_vertex[i]); }
+  if (closure) { *static_cast<int *>(closure) += 1; }
+  return SoIntersectionDetectionAction::NEXT_PRIMITIVE;
+}
+
+static SoIntersectionDetectionAction::Resp
+ida_test_abort_cb(void * closure,
+                  const SoIntersectingPrimitive *,
+                  const SoIntersectingPrimitive *)
+{
+  *static_cast<int *>(closure) += 1;
+  return SoIntersectionDetectionAction::ABORT;
+}
+
+BOOST_AUTO_TEST_CASE(deterministicResults)
+{
+  // a row of overlapping spheres, with a cube far away from them
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  for (int i = 0; i < 8; i++) {
+    SoSeparator * sep = new SoSeparator;
+    SoTranslation * t = new SoTranslation;
+    t->translation = SbVec3f(i * 1.5f, 0.0f, 0.0f);
+    sep->addChild(t);
+    sep->addChild(new SoSphere);
+    root->addChild(sep);
+  }
+  SoTranslation * t = new SoTranslation;
+  t->translation = SbVec3f(0.0f, 10.0f, 0.0f);
+  root->addChild(t);
+  root->addChild(new SoCube);
+
+  SoIntersectionDetectionAction ida;
+  ida.addIntersectionCallback(ida_test_record_cb, NULL);
+  ida.apply(root);
+  const std::vector<SbVec3f> first = *ida_test_hits();
+  ida_test_hits()->clear();
+  ida.apply(root);
+  const std::vector<SbVec3f> second = *ida_test_hits();
+  ida_test_hits()->clear();
+
+  BOOST_CHECK_MESSAGE(!first.empty(), "overlapping spheres should intersect");
+  BOOST_CHECK_MESSAGE(first == second, "results should come in the same order every run");
+
+  for (size_t i = 0; i < first.size(); i++) {
+    if (first[i][1] > 5.0f) {
+      BOOST_ERROR("the cube should not intersect anything");
+      break;
+    }
+  }
+
+  SoIntersectionDetectionAction abortida;
+  int numrecorded = 0, numaborted = 0;
+  abortida.addIntersectionCallback(ida_test_abort_cb, &numaborted);
+  abortida.addIntersectionCallback(ida_test_record_cb, &numrecorded);
+  abortida.apply(root);
+  ida_test_hits()->clear();
+  BOOST_CHECK_MESSAGE(numaborted == 1 && numrecorded == 0,
+                      "no callbacks should be invoked after ABORT");
+
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
@@ -307,6 +307,7 @@
 
 #include "elements/SoTextureScalePolicyElement.h" // internal element
 #include "elements/SoTextureScaleQualityElement.h" // internal  element
+#include "misc/SoStateP.h"
 #include "tidbitsp.h"
 #include "coindefs.h"
 
@@ -544,6 +545,34 @@ SoElement::~SoElement()
 {
 }
 
+/*!
+  Allocates memory for an element. Elements created by SoState for its
+  stacks are placed in memory owned by the state, which is reused
+  for the next state when the state is destructed. Elements created
+  anywhere else, like the copies made by copyMatchInfo(), are
+  allocated from the heap as usual.
+
+  \since Coin 4.1
+*/
+void *
+SoElement::operator new(size_t size)
+{
+  return SoStateP::allocateElement(size);
+}
+
+/*!
+  Frees the memory of an element allocated from the heap. Elements
+  placed in the memory of a state are destructed by the state, and
+  never deleted.
+
+  \since Coin 4.1
+*/
+void
+SoElement::operator delete(void * ptr)
+{
+  ::operator delete(ptr);
+}
+
 /*!
   This function initializes the element type in the given SoState.  It
   is called for the first element of each enabled element type in
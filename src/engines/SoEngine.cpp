@@ -54,6 +54,15 @@
   If you want complete control over when an engine gets destructed,
   use SoBase::ref() and SoBase::unref() for explicit
   referencing/dereferencing.
+
+  Engines are normally evaluated lazily, when a field connected to
+  one of their outputs is read. For large engine networks, where an
+  engine reads from an engine which reads from another engine and so
+  on, this means deep recursion down the network on the first read
+  after a change. With SoEngine::enableScheduling(), the engines which
+  get dirty are remembered instead, and SoEngine::evaluateScheduled()
+  evaluates all of them once, upstream engines before the engines
+  reading from them. SoRenderManager does this before each rendering.
 */
 
 // *************************************************************************
@@ -73,10 +82,21 @@
 #include "config.h"
 #endif // HAVE_CONFIG_H
 #include "coindefs.h" // COIN_STUB()
+#include "engines/SoEngineP.h"
+#include "misc/SbHash.h"
+#include "threads/threadsutilp.h"
+#include "tidbitsp.h"
 #ifdef COIN_THREADSAFE
 #include "threads/recmutexp.h"
 #endif // COIN_THREADSAFE
 
+#ifdef HAVE_THREADS
+#include <Inventor/C/threads/mutex.h>
+#include <Inventor/C/threads/wpool.h>
+#endif // HAVE_THREADS
+
+#include <cstdlib>
+
 // *************************************************************************
 
 // FIXME: document these properly. 20000405 mortene.
@@ -93,6 +113,366 @@
 
 SoType SoEngine::classTypeId STATIC_SOTYPE_INIT;
 
+uint32_t SoEngineP::connectionsgeneration = 0;
+
+// *************************************************************************
+
+// The engines which have become dirty since they were last evaluated,
+// while scheduling is enabled. SoEngine::evaluateScheduled() takes
+// over the set as the engines in flight, and swaps in the emptied set
+// from the previous evaluation to collect the next ones. Engines are
+// removed from both sets when they are destroyed.
+typedef SbHash<uintptr_t, SoEngine *> SoEngineScheduledMap;
+
+static SbBool soengine_scheduling = FALSE;
+static int soengine_numthreads = 1;
+static SoEngineScheduledMap * soengine_scheduled = NULL;
+static SoEngineScheduledMap * soengine_inflight = NULL;
+static SbBool soengine_inflightdestroyed = FALSE;
+static void * soengine_schedulemutex = NULL;
+#ifdef HAVE_THREADS
+static cc_wpool * soengine_pool = NULL;
+#endif // HAVE_THREADS
+
+static void
+soengine_schedule(SoEngine * engine)
+{
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  if (soengine_scheduled) {
+    soengine_scheduled->put(reinterpret_cast<uintptr_t>(engine), engine);
+  }
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+}
+
+static void
+soengine_unschedule(SoEngine * engine)
+{
+  const uintptr_t key = reinterpret_cast<uintptr_t>(engine);
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  if (soengine_scheduled) { (void)soengine_scheduled->erase(key); }
+  if (soengine_inflight && soengine_inflight->erase(key)) {
+    soengine_inflightdestroyed = TRUE;
+  }
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+}
+
+// Returns whether an engine in flight is still alive. Only needs to
+// look when some engine in flight has been destroyed, which hardly
+// ever happens during evaluation.
+static SbBool
+soengine_isinflight(SoEngine * engine)
+{
+  if (!soengine_inflightdestroyed) return TRUE;
+  SoEngine * dummy;
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  const SbBool found =
+    soengine_inflight->get(reinterpret_cast<uintptr_t>(engine), dummy);
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+  return found;
+}
+
+// The dependency graph of the scheduled engines. Nodes 0 to
+// engines.getLength()-1 are the engines, with edges from each engine
+// to the engines reading from it. When the engines are to be
+// evaluated by several threads, the engines are also grouped into
+// sets which are independent of each other, by a union-find over the
+// engines and the other field containers they read from or write to.
+struct soengine_network {
+  SbList<SoEngine *> engines;
+  SbHash<uintptr_t, int> nodeindex;
+  SbList<int> edgestart;
+  SbList<int> edges;
+  SbList<int> parent;
+  SbBool grouping;
+
+  soengine_network(const int sizehint)
+    : engines(sizehint), nodeindex(sizehint * 2), edgestart(sizehint + 1),
+      edges(sizehint), parent(sizehint), grouping(FALSE) { }
+
+  int find(int idx) {
+    while (this->parent[idx] != idx) {
+      this->parent[idx] = this->parent[this->parent[idx]];
+      idx = this->parent[idx];
+    }
+    return idx;
+  }
+  void join(int a, SoFieldContainer * container) {
+    if (!this->grouping || container == NULL) return;
+    const uintptr_t key = reinterpret_cast<uintptr_t>(container);
+    int b;
+    if (!this->nodeindex.get(key, b)) {
+      b = this->parent.getLength();
+      this->parent.append(b);
+      this->nodeindex.put(key, b);
+    }
+    a = this->find(a);
+    b = this->find(b);
+    if (a != b) { this->parent[b] = a; }
+  }
+
+  void build(const SbList<uintptr_t> & keys, const SbBool grouping);
+  void sort(SbList<int> & order) const;
+};
+
+void
+soengine_network::build(const SbList<uintptr_t> & keys, const SbBool groupingarg)
+{
+  this->grouping = groupingarg;
+  const int num = keys.getLength();
+  for (int i = 0; i < num; i++) {
+    SoEngine * engine = reinterpret_cast<SoEngine *>(keys[i]);
+    this->engines.append(engine);
+    this->nodeindex.put(keys[i], i);
+    this->parent.append(i);
+  }
+
+  SbList<SoField *> stack;
+  SbList<SoField *> visited;
+  SoFieldList slaves;
+  SoFieldList inputs;
+  for (int i = 0; i < num; i++) {
+    SoEngine * engine = this->engines[i];
+    this->edgestart.append(this->edges.getLength());
+
+    // Follow the output connections to the engines reading from this
+    // engine, also through fields in between, like when an engine
+    // reads a node field which is connected to this engine. Field
+    // converters are engines, and are found the same way.
+    const SoEngineOutputData * outputs = engine->getOutputData();
+    const int numoutputs = outputs ? outputs->getNumOutputs() : 0;
+    for (int j = 0; j < numoutputs; j++) {
+      const SoEngineOutput * output = outputs->getOutput(engine, j);
+      for (int k = 0; k < output->getNumConnections(); k++) {
+        stack.append((*output)[k]);
+      }
+    }
+    visited.truncate(0);
+    while (stack.getLength()) {
+      SoField * field = stack.pop();
+      SoFieldContainer * container = field->getContainer();
+      if (container && container->isOfType(SoEngine::getClassTypeId())) {
+        int idx;
+        if (this->nodeindex.get(reinterpret_cast<uintptr_t>(container), idx) &&
+            idx < num && idx != i) {
+          this->edges.append(idx);
+          this->join(i, container);
+        }
+      }
+      else {
+        this->join(i, container);
+      }
+      slaves.truncate(0);
+      if (field->getForwardConnections(slaves)) {
+        // fields connected to fields are rare, so a list is fine for
+        // not going around in circles
+        for (int k = 0; k < slaves.getLength(); k++) {
+          if (visited.find(slaves[k]) < 0) {
+            visited.append(slaves[k]);
+            stack.append(slaves[k]);
+          }
+        }
+      }
+    }
+
+    if (this->grouping) {
+      // Engines reading from the same node engine, or from the same
+      // unscheduled engine or node, might evaluate it concurrently.
+      inputs.truncate(0);
+      const int numinputs = engine->getFields(inputs);
+      for (int j = 0; j < numinputs; j++) {
+        SoEngineOutput * master;
+        if (inputs[j]->getConnectedEngine(master)) {
+          if (master->isNodeEngineOutput()) {
+            this->join(i, master->getNodeContainer());
+          }
+          else {
+            this->join(i, master->getContainer());
+          }
+        }
+        SoFieldList masters;
+        const int nummasters = inputs[j]->getConnections(masters);
+        for (int k = 0; k < nummasters; k++) {
+          this->join(i, masters[k]->getContainer());
+        }
+      }
+    }
+  }
+  this->edgestart.append(this->edges.getLength());
+}
+
+// Sorts the engines so that each engine comes after the engines it
+// reads from. An engine is taken as soon as all its inputs are done,
+// so a chain of engines is evaluated in one go, while the values just
+// written are still in the cache. Engines in a connection cycle are
+// appended in no particular order after the rest, the ordinary lazy
+// evaluation takes care of them.
+void
+soengine_network::sort(SbList<int> & order) const
+{
+  const int num = this->engines.getLength();
+  SbList<int> indegree(num);
+  for (int i = 0; i < num; i++) { indegree.append(0); }
+  for (int i = 0; i < this->edges.getLength(); i++) { indegree[this->edges[i]]++; }
+
+  SbList<int> ready;
+  for (int i = num - 1; i >= 0; i--) {
+    if (indegree[i] == 0) { ready.append(i); }
+  }
+  while (ready.getLength()) {
+    const int idx = ready.pop();
+    order.append(idx);
+    for (int j = this->edgestart[idx+1] - 1; j >= this->edgestart[idx]; j--) {
+      if (--indegree[this->edges[j]] == 0) { ready.append(this->edges[j]); }
+    }
+  }
+  if (order.getLength() < num) {
+    for (int i = 0; i < num; i++) {
+      if (indegree[i] > 0) { order.append(i); }
+    }
+  }
+}
+
+// The order the scheduled engines are evaluated in. A job is a range
+// of engines which are evaluated in order by the same thread. With
+// one thread, all engines are in one job.
+struct soengine_plan {
+  SbList<uintptr_t> keys;
+  soengine_network network;
+  SbList<SoEngine *> engines;
+  SbList<int> jobstart;
+  uint32_t generation;
+  int numthreads;
+
+  soengine_plan(const SbList<uintptr_t> & keys, const int numthreads);
+  SbBool matches(const SbList<uintptr_t> & keys, const int numthreadsarg) const {
+    const int num = this->network.engines.getLength();
+    if (this->generation != SoEngineP::connectionsgeneration ||
+        this->numthreads != numthreadsarg || keys.getLength() != num) {
+      return FALSE;
+    }
+    // the engines usually come in the same order as the last time
+    int i = 0;
+    while (i < num && keys[i] == this->keys[i]) { i++; }
+    for (; i < num; i++) {
+      int idx;
+      if (!this->network.nodeindex.get(keys[i], idx) || idx >= num) return FALSE;
+    }
+    return TRUE;
+  }
+};
+
+soengine_plan::soengine_plan(const SbList<uintptr_t> & keysarg, const int numthreadsarg)
+  : keys(keysarg), network(keysarg.getLength()), engines(keysarg.getLength())
+{
+  this->generation = SoEngineP::connectionsgeneration;
+  this->numthreads = numthreadsarg;
+  this->network.build(keysarg, numthreadsarg > 1);
+  SbList<int> order(keysarg.getLength());
+  this->network.sort(order);
+
+  const int num = order.getLength();
+  if (numthreadsarg > 1) {
+    // one job for each independent set of engines, which keeps the
+    // evaluation order within the set
+    const int numnodes = this->network.parent.getLength();
+    SbList<int> jobof(numnodes);
+    for (int i = 0; i < numnodes; i++) { jobof.append(-1); }
+    SbList<int> jobsize;
+    for (int i = 0; i < num; i++) {
+      const int root = this->network.find(order[i]);
+      if (jobof[root] < 0) {
+        jobof[root] = jobsize.getLength();
+        jobsize.append(0);
+      }
+      jobsize[jobof[root]]++;
+    }
+    SbList<int> fillpos;
+    int pos = 0;
+    for (int i = 0; i < jobsize.getLength(); i++) {
+      this->jobstart.append(pos);
+      fillpos.append(pos);
+      pos += jobsize[i];
+    }
+    this->jobstart.append(pos);
+    for (int i = 0; i < num; i++) { this->engines.append(NULL); }
+    for (int i = 0; i < num; i++) {
+      const int job = jobof[this->network.find(order[i])];
+      this->engines[fillpos[job]++] = this->network.engines[order[i]];
+    }
+  }
+  else {
+    for (int i = 0; i < num; i++) {
+      this->engines.append(this->network.engines[order[i]]);
+    }
+    this->jobstart.append(0);
+    this->jobstart.append(num);
+  }
+}
+
+static soengine_plan * soengine_cachedplan = NULL;
+
+static void
+soengine_scheduling_cleanup(void)
+{
+#ifdef HAVE_THREADS
+  if (soengine_pool) { cc_wpool_destruct(soengine_pool); }
+  soengine_pool = NULL;
+#endif // HAVE_THREADS
+  delete soengine_scheduled;
+  soengine_scheduled = NULL;
+  delete soengine_inflight;
+  soengine_inflight = NULL;
+  delete soengine_cachedplan;
+  soengine_cachedplan = NULL;
+  soengine_scheduling = FALSE;
+  soengine_numthreads = 1;
+  CC_MUTEX_DESTRUCT(soengine_schedulemutex);
+}
+
+// Shared state for the threads evaluating engines. Jobs are handed
+// out in index order.
+struct soengine_jobs {
+  const SbList<SoEngine *> * engines;
+  const SbList<int> * jobstart;
+  int next;
+  int evaluated;
+#ifdef HAVE_THREADS
+  cc_mutex * mutex;
+#endif // HAVE_THREADS
+};
+
+static void
+soengine_run_jobs(void * closure)
+{
+  soengine_jobs * jobs = static_cast<soengine_jobs *>(closure);
+  const int numjobs = jobs->jobstart->getLength() - 1;
+  for (;;) {
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_lock(jobs->mutex); }
+#endif // HAVE_THREADS
+    const int idx = jobs->next++;
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_unlock(jobs->mutex); }
+#endif // HAVE_THREADS
+    if (idx >= numjobs) { return; }
+    int evaluated = 0;
+    for (int i = (*jobs->jobstart)[idx]; i < (*jobs->jobstart)[idx+1]; i++) {
+      SoEngine * engine = (*jobs->engines)[i];
+      if (soengine_isinflight(engine)) {
+        engine->evaluateWrapper();
+        evaluated++;
+      }
+    }
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_lock(jobs->mutex); }
+#endif // HAVE_THREADS
+    jobs->evaluated += evaluated;
+#ifdef HAVE_THREADS
+    if (jobs->mutex) { cc_mutex_unlock(jobs->mutex); }
+#endif // HAVE_THREADS
+  }
+}
+
 // *************************************************************************
 
 /*!
@@ -111,6 +491,9 @@ SoEngine::~SoEngine()
 #if COIN_DEBUG && 0 // debug
   SoDebugError::postInfo("SoEngine::~SoEngine", "%p", this);
 #endif // debug
+  soengine_unschedule(this);
+  // a new engine might get the same address
+  SoEngineP::connectionsChanged();
 }
 
 // Overrides SoBase::destroy().
@@ -164,6 +547,14 @@ SoEngine::initClass(void)
   SoEngine::classTypeId =
     SoType::createType(SoFieldContainer::getClassTypeId(), SbName("Engine"));
 
+  CC_MUTEX_CONSTRUCT(soengine_schedulemutex);
+  coin_atexit(soengine_scheduling_cleanup, CC_ATEXIT_NORMAL);
+  const char * env = coin_getenv("COIN_ENGINE_SCHEDULING");
+  if (env) {
+    SoEngine::setNumSchedulingThreads(atoi(env));
+    SoEngine::enableScheduling(TRUE);
+  }
+
   SoEngine::initClasses();
 }
 
@@ -322,6 +713,9 @@ SoEngine::notify(SoNotList * nl)
   // The notification invocation could stem from a value change in
   // whatever this engine is connected to, so we need to be evaluated
   // on the next attempted read on our output(s).
+  if (!(this->flags & FLAG_ISDIRTY) && soengine_scheduling) {
+    soengine_schedule(this);
+  }
   this->flags |= FLAG_ISDIRTY;
 
   // Call inputChanged() only if we're being notified through one of
@@ -383,6 +777,180 @@ SoEngine::evaluateWrapper(void)
   }
 }
 
+/*!
+  Sets whether engines which get dirty should be remembered, so they
+  can be evaluated together by evaluateScheduled(). Scheduling is
+  disabled by default, unless the environment variable
+  COIN_ENGINE_SCHEDULING is set.
+
+  Disabling scheduling forgets the engines scheduled so far. They
+  will still be evaluated the ordinary way, when their outputs are
+  read.
+
+  \since Coin 4.1
+
+  \sa evaluateScheduled()
+*/
+void
+SoEngine::enableScheduling(const SbBool onoff)
+{
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  if (onoff && soengine_scheduled == NULL) {
+    soengine_scheduled = new SoEngineScheduledMap;
+    soengine_inflight = new SoEngineScheduledMap;
+  }
+  else if (!onoff && soengine_scheduled) {
+    soengine_scheduled->clear();
+  }
+  soengine_scheduling = onoff;
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+}
+
+/*!
+  Returns whether engines are scheduled for evaluateScheduled().
+
+  \since Coin 4.1
+
+  \sa enableScheduling()
+*/
+SbBool
+SoEngine::isSchedulingEnabled(void)
+{
+  return soengine_scheduling;
+}
+
+/*!
+  Sets the number of threads used by evaluateScheduled(). Pass 0 to
+  use one thread per processor. The default is 1, which means that
+  all engines are evaluated by the thread calling evaluateScheduled().
+
+  With more than one thread, sets of engines which neither read from
+  nor write to the same engines, nodes or fields are evaluated
+  concurrently. No other thread should read or write fields connected
+  to engines while this goes on. This is only done when Coin is built
+  with COIN_THREADSAFE. In other builds, all engines are evaluated by
+  the calling thread, whatever the number of threads is set to.
+
+  \since Coin 4.1
+
+  \sa getNumSchedulingThreads()
+*/
+void
+SoEngine::setNumSchedulingThreads(const int num)
+{
+  soengine_numthreads = (num > 0) ? num : coin_num_processors();
+}
+
+/*!
+  Returns the number of threads used by evaluateScheduled().
+
+  \since Coin 4.1
+
+  \sa setNumSchedulingThreads()
+*/
+int
+SoEngine::getNumSchedulingThreads(void)
+{
+  return soengine_numthreads;
+}
+
+/*!
+  Evaluates all engines which have become dirty since they were last
+  evaluated, while scheduling has been enabled. Each engine is
+  evaluated once, after the engines it reads from, so reading the
+  outputs afterwards does not have to evaluate anything. Returns the
+  number of engines which were scheduled.
+
+  SoRenderManager calls this method before rendering, so the engine
+  network is brought up to date once per frame.
+
+  \since Coin 4.1
+
+  \sa enableScheduling(), setNumSchedulingThreads()
+*/
+int
+SoEngine::evaluateScheduled(void)
+{
+  if (!soengine_scheduling) return 0;
+
+  SbList<uintptr_t> keys;
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  SoEngineScheduledMap * inflight = soengine_scheduled;
+  soengine_scheduled = soengine_inflight;
+  soengine_inflight = inflight;
+  soengine_inflightdestroyed = FALSE;
+  soengine_inflight->makeKeyList(keys);
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+  if (keys.getLength() == 0) return 0;
+
+  int numthreads = soengine_numthreads;
+  // evaluateWrapper() is only safe to call from several threads at
+  // once when the field and node locks are real
+#if !defined(HAVE_THREADS) || !defined(COIN_THREADSAFE)
+  numthreads = 1;
+#endif // !HAVE_THREADS || !COIN_THREADSAFE
+
+  // the network is only built again when the scheduled engines or
+  // their connections change, which they usually don't from one
+  // frame to the next
+  if (soengine_cachedplan == NULL ||
+      !soengine_cachedplan->matches(keys, numthreads)) {
+    delete soengine_cachedplan;
+    soengine_cachedplan = new soengine_plan(keys, numthreads);
+  }
+  const soengine_plan * plan = soengine_cachedplan;
+
+  soengine_jobs jobs;
+  jobs.engines = &plan->engines;
+  jobs.jobstart = &plan->jobstart;
+  jobs.next = 0;
+  jobs.evaluated = 0;
+
+#ifdef HAVE_THREADS
+  jobs.mutex = NULL;
+#endif // HAVE_THREADS
+
+#if defined(HAVE_THREADS) && defined(COIN_THREADSAFE)
+  // the calling thread takes part in the work
+  const int numworkers = SbMin(numthreads, plan->jobstart.getLength() - 1) - 1;
+  if (numworkers > 0) {
+    if (soengine_pool == NULL) {
+      soengine_pool = cc_wpool_construct(numworkers);
+    }
+    else if (cc_wpool_get_num_workers(soengine_pool) < numworkers) {
+      cc_wpool_set_num_workers(soengine_pool, numworkers);
+    }
+    jobs.mutex = cc_mutex_construct();
+    cc_wpool_begin(soengine_pool, numworkers);
+    for (int i = 0; i < numworkers; i++) {
+      cc_wpool_start_worker(soengine_pool, soengine_run_jobs, &jobs);
+    }
+    cc_wpool_end(soengine_pool);
+    soengine_run_jobs(&jobs);
+    cc_wpool_wait_all(soengine_pool);
+    cc_mutex_destruct(jobs.mutex);
+  }
+  else
+#endif // HAVE_THREADS && COIN_THREADSAFE
+  {
+    // lock like SoEngine::destroy() does, as evaluateWrapper() should
+    // not be called from more than one thread at a time
+#ifdef COIN_THREADSAFE
+    cc_recmutex_internal_field_lock();
+#endif // COIN_THREADSAFE
+    soengine_run_jobs(&jobs);
+#ifdef COIN_THREADSAFE
+    cc_recmutex_internal_field_unlock();
+#endif // COIN_THREADSAFE
+  }
+
+  CC_MUTEX_LOCK(soengine_schedulemutex);
+  soengine_inflight->clear();
+  soengine_inflightdestroyed = FALSE;
+  CC_MUTEX_UNLOCK(soengine_schedulemutex);
+  return jobs.evaluated;
+}
+
 /*!
   Returns the SoFieldData class which holds information about inputs
   in this engine.
@@ -552,3 +1120,82 @@ SoEngine::setDirty(void)
 {
   this->flags |= FLAG_ISDIRTY;
 }
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/engines/SoCalculator.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+// a chain of engines, connected the other way around of how they are
+// created, is evaluated upstream first in one go
+BOOST_AUTO_TEST_CASE(evaluateScheduledChain)
+{
+  const SbBool wasenabled = SoEngine::isSchedulingEnabled();
+  SoEngine::enableScheduling(TRUE);
+
+  const int NUMENGINES = 64;
+  SoCalculator * calc[NUMENGINES];
+  for (int i = 0; i < NUMENGINES; i++) {
+    calc[i] = new SoCalculator;
+    calc[i]->ref();
+    calc[i]->expression = "oa = a + 1";
+  }
+  for (int i = NUMENGINES - 1; i > 0; i--) {
+    calc[i]->a.connectFrom(&calc[i-1]->oa);
+  }
+  SoTranslation * translation = new SoTranslation;
+  translation->ref();
+  SoCalculator * last = new SoCalculator;
+  last->ref();
+  last->expression = "oA = vec3f(a, 0, 0)";
+  translation->translation.connectFrom(&last->oA);
+  // through a node field in between
+  SoCalculator * reader = new SoCalculator;
+  reader->ref();
+  reader->expression = "oa = A[0]";
+  reader->A.connectFrom(&translation->translation);
+  last->a.connectFrom(&calc[NUMENGINES-1]->oa);
+
+  (void)SoEngine::evaluateScheduled();
+  calc[0]->a = 10.0f;
+  BOOST_CHECK(SoEngine::evaluateScheduled() >= NUMENGINES + 2);
+  BOOST_CHECK_EQUAL(SoEngine::evaluateScheduled(), 0);
+  BOOST_CHECK_EQUAL(last->a[0], 10.0f + NUMENGINES);
+  BOOST_CHECK(translation->translation.getValue() == SbVec3f(10.0f + NUMENGINES, 0.0f, 0.0f));
+  BOOST_CHECK_EQUAL(reader->A[0][0], 10.0f + NUMENGINES);
+
+  // destroyed engines are forgotten
+  calc[0]->a = 20.0f;
+  reader->unref();
+  last->unref();
+  translation->unref();
+  for (int i = 0; i < NUMENGINES; i++) { calc[i]->unref(); }
+  BOOST_CHECK_EQUAL(SoEngine::evaluateScheduled(), 0);
+
+  SoEngine::enableScheduling(wasenabled);
+}
+
+// engines are evaluated the ordinary way when scheduling is disabled
+BOOST_AUTO_TEST_CASE(evaluateScheduledDisabled)
+{
+  const SbBool wasenabled = SoEngine::isSchedulingEnabled();
+  SoEngine::enableScheduling(FALSE);
+
+  SoCalculator * first = new SoCalculator;
+  first->ref();
+  first->expression = "oa = a * 2";
+  SoCalculator * second = new SoCalculator;
+  second->ref();
+  second->expression = "oa = a + 1";
+  second->a.connectFrom(&first->oa);
+
+  first->a = 4.0f;
+  BOOST_CHECK_EQUAL(SoEngine::evaluateScheduled(), 0);
+  BOOST_CHECK_EQUAL(second->a[0], 8.0f);
+
+  second->unref();
+  first->unref();
+  SoEngine::enableScheduling(wasenabled);
+}
+
+#endif // COIN_TEST_SUITE
@@ -45,6 +45,7 @@
 #include <Inventor/engines/SoEngineOutput.h>
 
 #include "SbBasicP.h"
+#include "engines/SoEngineP.h"
 
 #include <Inventor/engines/SoEngine.h>
 #include <Inventor/engines/SoNodeEngine.h>
@@ -269,6 +270,7 @@ SoEngineOutput::addConnection(SoField * f)
 #endif // COIN_DEBUG
 
   this->slaves.append(f);
+  SoEngineP::connectionsChanged();
 
   // An engine's reference count increases with the number of
   // connections it has.
@@ -312,6 +314,7 @@ SoEngineOutput::removeConnection(SoField * f)
   }
 #endif // COIN_DEBUG
   this->slaves.remove(i);
+  SoEngineP::connectionsChanged();
 
   // SoProtoInstance has some special memory handling. Don't ref
   // and unref if the connection is to an SoProtoInstance
@@ -38,6 +38,9 @@
 */
 
 #include <Inventor/engines/SoTransformVec3f.h>
+
+#include <vector>
+
 #include <Inventor/lists/SoEngineOutputList.h>
 
 #include "engines/SoSubEngineP.h"
@@ -110,6 +113,23 @@ SoTransformVec3f::evaluate(void)
   SO_ENGINE_OUTPUT(direction, SoMFVec3f, setNum(numoutputs));
   SO_ENGINE_OUTPUT(normalDirection, SoMFVec3f, setNum(numoutputs));
 
+  if (nummatrices == 1 && numvec > 0) {
+    // the common case of transforming a set of vectors with a single
+    // matrix is done on the complete arrays
+    const SbMatrix & m = this->matrix[0];
+    std::vector<SbVec3f> pts(numoutputs), dirs(numoutputs), ndirs(numoutputs);
+    m.multVecMatrix(this->vector.getValues(0), &pts[0], numoutputs);
+    m.multDirMatrix(this->vector.getValues(0), &dirs[0], numoutputs);
+    for (int i = 0; i < numoutputs; i++) {
+      ndirs[i] = dirs[i];
+      (void) ndirs[i].normalize(); // null vector is ok
+    }
+    SO_ENGINE_OUTPUT(point, SoMFVec3f, setValues(0, numoutputs, &pts[0]));
+    SO_ENGINE_OUTPUT(direction, SoMFVec3f, setValues(0, numoutputs, &dirs[0]));
+    SO_ENGINE_OUTPUT(normalDirection, SoMFVec3f, setValues(0, numoutputs, &ndirs[0]));
+    return;
+  }
+
   SbVec3f pt, dir, ndir;
 
   for (int i = 0; i < numoutputs; i++) {
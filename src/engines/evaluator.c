@@ -476,3 +476,471 @@ so_eval_delete(so_eval_node *node)
     free(node);
   }
 }
+
+/*
+ * compiled programs. Every value in the tree structure gets a slot
+ * of SO_EVAL_LANES floats, and the program is a list of instructions
+ * that each compute one slot from up to three other slots for all
+ * lanes. Vector operations are split into one instruction per
+ * component, and boolean values are stored as 1.0f or 0.0f.
+ */
+
+/* slot layout of the registers */
+#define SLOT_IN_FLT 0   /* a-h */
+#define SLOT_IN_VEC 8   /* A-H, three slots each */
+#define SLOT_TMP_FLT 32 /* ta-th */
+#define SLOT_TMP_VEC 40 /* tA-tH */
+#define SLOT_OUT_FLT 64 /* oa-od */
+#define SLOT_OUT_VEC 68 /* oA-oD */
+#define SLOT_FIRST_FREE 80
+
+/* instruction opcodes */
+enum {
+  OP_COPY,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_FMOD,
+  OP_NEG,
+  OP_AND,
+  OP_OR,
+  OP_NOT,
+  OP_LEQ,
+  OP_GEQ,
+  OP_LT,
+  OP_GT,
+  OP_EQ,
+  OP_NEQ,
+  OP_TEST,
+  OP_TEST_VEC,
+  OP_SELECT,
+  OP_COS,
+  OP_SIN,
+  OP_TAN,
+  OP_ACOS,
+  OP_ASIN,
+  OP_ATAN,
+  OP_ATAN2,
+  OP_COSH,
+  OP_SINH,
+  OP_TANH,
+  OP_SQRT,
+  OP_LEN,
+  OP_EXP,
+  OP_LOG,
+  OP_LOG10,
+  OP_CEIL,
+  OP_FLOOR,
+  OP_FABS,
+  OP_POW,
+  OP_NORMALIZE
+};
+
+typedef struct {
+  int op;
+  int dst, a, b, c;
+} so_eval_instruction;
+
+typedef struct {
+  int slot;
+  float value;
+} so_eval_constant;
+
+struct so_eval_program {
+  so_eval_instruction *code;
+  int numcode, maxcode;
+  so_eval_constant *constants;
+  int numconstants, maxconstants;
+  int numslots;
+  float *slots;
+  int serial;
+  int failed;
+  char tmpwritten[SLOT_OUT_FLT - SLOT_TMP_FLT];
+};
+
+/* the slots holding the result of compiling a node */
+typedef struct {
+  int slot[3];
+} so_eval_operand;
+
+static int
+program_register_slot(const char *regname, int component)
+{
+  char name = regname[0];
+  int fltbase = SLOT_IN_FLT, vecbase = SLOT_IN_VEC;
+  if (name == 't' || name == 'o') {
+    fltbase = name == 't' ? SLOT_TMP_FLT : SLOT_OUT_FLT;
+    vecbase = name == 't' ? SLOT_TMP_VEC : SLOT_OUT_VEC;
+    name = regname[1];
+  }
+  if (name >= 'a' && name <= 'h') return fltbase + (name - 'a');
+  assert(name >= 'A' && name <= 'H');
+  assert(component >= 0 && component <= 2);
+  return vecbase + 3 * (name - 'A') + component;
+}
+
+static int
+program_new_slot(so_eval_program *program)
+{
+  return program->numslots++;
+}
+
+static int
+program_constant(so_eval_program *program, float value)
+{
+  if (program->numconstants == program->maxconstants) {
+    program->maxconstants = program->maxconstants ? program->maxconstants * 2 : 16;
+    program->constants = (so_eval_constant*)
+      realloc(program->constants, program->maxconstants * sizeof(so_eval_constant));
+  }
+  program->constants[program->numconstants].slot = program_new_slot(program);
+  program->constants[program->numconstants].value = value;
+  return program->constants[program->numconstants++].slot;
+}
+
+/* marks the program as serial if a temporary register is read before
+   it has been written */
+static void
+program_read_slot(so_eval_program *program, int slot)
+{
+  if (slot >= SLOT_TMP_FLT && slot < SLOT_OUT_FLT &&
+      !program->tmpwritten[slot - SLOT_TMP_FLT]) {
+    program->serial = 1;
+  }
+}
+
+static int
+program_emit(so_eval_program *program, int op, int dst, int a, int b, int c)
+{
+  so_eval_instruction *instr;
+  if (program->numcode == program->maxcode) {
+    program->maxcode = program->maxcode ? program->maxcode * 2 : 64;
+    program->code = (so_eval_instruction*)
+      realloc(program->code, program->maxcode * sizeof(so_eval_instruction));
+  }
+  if (dst < 0) dst = program_new_slot(program);
+  else if (dst >= SLOT_TMP_FLT && dst < SLOT_OUT_FLT) {
+    program->tmpwritten[dst - SLOT_TMP_FLT] = 1;
+  }
+  instr = &program->code[program->numcode++];
+  instr->op = op;
+  instr->dst = dst;
+  instr->a = a < 0 ? 0 : a;
+  instr->b = b < 0 ? 0 : b;
+  instr->c = c < 0 ? 0 : c;
+  return dst;
+}
+
+/* returns the slot holding the dot product, computed in the same
+   order as dot_product() */
+static int
+program_dot(so_eval_program *program, const so_eval_operand *v0,
+            const so_eval_operand *v1)
+{
+  int xx = program_emit(program, OP_MUL, -1, v0->slot[0], v1->slot[0], -1);
+  int yy = program_emit(program, OP_MUL, -1, v0->slot[1], v1->slot[1], -1);
+  int zz = program_emit(program, OP_MUL, -1, v0->slot[2], v1->slot[2], -1);
+  int xy = program_emit(program, OP_ADD, -1, xx, yy, -1);
+  return program_emit(program, OP_ADD, -1, xy, zz, -1);
+}
+
+static void
+program_compile_node(so_eval_program *program, so_eval_node *node,
+                     so_eval_operand *result)
+{
+  so_eval_operand op1, op2, op3;
+  int i, op = -1;
+
+  if (program->failed) return;
+
+  if (node->id == ID_ASSIGN_FLT) {
+    int dst = program_register_slot(node->child1->regname,
+                                    node->child1->regidx < 0 ? 0 : node->child1->regidx);
+    program_compile_node(program, node->child2, &op1);
+    (void) program_emit(program, OP_COPY, dst, op1.slot[0], -1, -1);
+    return;
+  }
+  if (node->id == ID_ASSIGN_VEC) {
+    int dst[3];
+    program_compile_node(program, node->child2, &op1);
+    for (i = 0; i < 3; i++) {
+      dst[i] = program_register_slot(node->child1->regname, i);
+    }
+    /* if a component is read after another component of the same
+       register has been assigned, copy through new slots */
+    for (i = 0; i < 3; i++) {
+      if ((op1.slot[i] == dst[0] && i > 0) ||
+          (op1.slot[i] == dst[1] && i > 1)) break;
+    }
+    if (i < 3) {
+      for (i = 0; i < 3; i++) {
+        op1.slot[i] = program_emit(program, OP_COPY, -1, op1.slot[i], -1, -1);
+      }
+    }
+    for (i = 0; i < 3; i++) {
+      (void) program_emit(program, OP_COPY, dst[i], op1.slot[i], -1, -1);
+    }
+    return;
+  }
+
+  if (node->child1) program_compile_node(program, node->child1, &op1);
+  if (node->child2) program_compile_node(program, node->child2, &op2);
+  if (node->child3) program_compile_node(program, node->child3, &op3);
+  if (program->failed) return;
+
+  switch (node->id) {
+  case ID_ADD: op = OP_ADD; break;
+  case ID_SUB: op = OP_SUB; break;
+  case ID_MUL: op = OP_MUL; break;
+  case ID_DIV: op = OP_DIV; break;
+  case ID_FMOD: op = OP_FMOD; break;
+  case ID_NEG: op = OP_NEG; break;
+  case ID_AND: op = OP_AND; break;
+  case ID_OR: op = OP_OR; break;
+  case ID_NOT: op = OP_NOT; break;
+  case ID_LEQ: op = OP_LEQ; break;
+  case ID_GEQ: op = OP_GEQ; break;
+  case ID_LT: op = OP_LT; break;
+  case ID_GT: op = OP_GT; break;
+  /* vectors are compared by their first component only, like
+     so_eval_traverse() does */
+  case ID_EQ: op = OP_EQ; break;
+  case ID_NEQ: op = OP_NEQ; break;
+  case ID_TEST_FLT: op = OP_TEST; break;
+  case ID_COS: op = OP_COS; break;
+  case ID_SIN: op = OP_SIN; break;
+  case ID_TAN: op = OP_TAN; break;
+  case ID_ACOS: op = OP_ACOS; break;
+  case ID_ASIN: op = OP_ASIN; break;
+  case ID_ATAN: op = OP_ATAN; break;
+  case ID_ATAN2: op = OP_ATAN2; break;
+  case ID_COSH: op = OP_COSH; break;
+  case ID_SINH: op = OP_SINH; break;
+  case ID_TANH: op = OP_TANH; break;
+  case ID_SQRT: op = OP_SQRT; break;
+  case ID_EXP: op = OP_EXP; break;
+  case ID_LOG: op = OP_LOG; break;
+  case ID_LOG10: op = OP_LOG10; break;
+  case ID_CEIL: op = OP_CEIL; break;
+  case ID_FLOOR: op = OP_FLOOR; break;
+  case ID_FABS: op = OP_FABS; break;
+  case ID_POW: op = OP_POW; break;
+  case ID_FLT_COND:
+    result->slot[0] = program_emit(program, OP_SELECT, -1, op1.slot[0],
+                                   op2.slot[0], op3.slot[0]);
+    return;
+  case ID_RAND:
+    /* the random numbers would be drawn in a different order */
+    program->failed = 1;
+    return;
+  case ID_ADD_VEC:
+  case ID_SUB_VEC:
+    for (i = 0; i < 3; i++) {
+      result->slot[i] = program_emit(program, node->id == ID_ADD_VEC ? OP_ADD : OP_SUB,
+                                     -1, op1.slot[i], op2.slot[i], -1);
+    }
+    return;
+  case ID_NEG_VEC:
+    for (i = 0; i < 3; i++) {
+      result->slot[i] = program_emit(program, OP_NEG, -1, op1.slot[i], -1, -1);
+    }
+    return;
+  case ID_MUL_VEC_FLT:
+  case ID_DIV_VEC_FLT:
+    for (i = 0; i < 3; i++) {
+      result->slot[i] = program_emit(program, node->id == ID_MUL_VEC_FLT ? OP_MUL : OP_DIV,
+                                     -1, op1.slot[i], op2.slot[0], -1);
+    }
+    return;
+  case ID_CROSS:
+    for (i = 0; i < 3; i++) {
+      int j = (i + 1) % 3, k = (i + 2) % 3;
+      int s0 = program_emit(program, OP_MUL, -1, op1.slot[j], op2.slot[k], -1);
+      int s1 = program_emit(program, OP_MUL, -1, op1.slot[k], op2.slot[j], -1);
+      result->slot[i] = program_emit(program, OP_SUB, -1, s0, s1, -1);
+    }
+    return;
+  case ID_DOT:
+    result->slot[0] = program_dot(program, &op1, &op2);
+    return;
+  case ID_LEN:
+    result->slot[0] = program_emit(program, OP_LEN, -1, program_dot(program, &op1, &op1), -1, -1);
+    return;
+  case ID_NORMALIZE:
+    {
+      int len = program_emit(program, OP_LEN, -1, program_dot(program, &op1, &op1), -1, -1);
+      for (i = 0; i < 3; i++) {
+        result->slot[i] = program_emit(program, OP_NORMALIZE, -1, op1.slot[i], len, -1);
+      }
+    }
+    return;
+  case ID_TEST_VEC:
+    result->slot[0] = program_emit(program, OP_TEST_VEC, -1, op1.slot[0],
+                                   op1.slot[1], op1.slot[2]);
+    return;
+  case ID_VEC3F:
+    result->slot[0] = op1.slot[0];
+    result->slot[1] = op2.slot[0];
+    result->slot[2] = op3.slot[0];
+    return;
+  case ID_VEC_COND:
+    for (i = 0; i < 3; i++) {
+      result->slot[i] = program_emit(program, OP_SELECT, -1, op1.slot[0],
+                                     op2.slot[i], op3.slot[i]);
+    }
+    return;
+  case ID_FLT_REG:
+  case ID_VEC_REG:
+    for (i = 0; i < (node->id == ID_FLT_REG ? 1 : 3); i++) {
+      result->slot[i] = program_register_slot(node->regname, i);
+      program_read_slot(program, result->slot[i]);
+    }
+    return;
+  case ID_VEC_REG_COMP:
+    result->slot[0] = program_register_slot(node->regname, node->regidx);
+    program_read_slot(program, result->slot[0]);
+    return;
+  case ID_VALUE:
+    result->slot[0] = program_constant(program, node->value);
+    return;
+  case ID_SEPARATOR:
+    return;
+  default:
+    assert(0 && "Whoops. Unknown node id!\n");
+    program->failed = 1;
+    return;
+  }
+  result->slot[0] = program_emit(program, op, -1, op1.slot[0],
+                                 node->child2 ? op2.slot[0] : -1, -1);
+}
+
+so_eval_program *
+so_eval_compile(so_eval_node * const *nodes, int numnodes)
+{
+  int i, j;
+  so_eval_operand dummy;
+  so_eval_program *program = (so_eval_program*) malloc(sizeof(so_eval_program));
+  program->code = NULL;
+  program->numcode = program->maxcode = 0;
+  program->constants = NULL;
+  program->numconstants = program->maxconstants = 0;
+  program->numslots = SLOT_FIRST_FREE;
+  program->slots = NULL;
+  program->serial = 0;
+  program->failed = 0;
+  for (i = 0; i < SLOT_OUT_FLT - SLOT_TMP_FLT; i++) program->tmpwritten[i] = 0;
+
+  for (i = 0; i < numnodes; i++) {
+    if (nodes[i]) program_compile_node(program, nodes[i], &dummy);
+  }
+  if (program->failed) {
+    so_eval_program_delete(program);
+    return NULL;
+  }
+
+  program->slots = (float*) malloc(program->numslots * SO_EVAL_LANES * sizeof(float));
+  for (i = 0; i < program->numslots * SO_EVAL_LANES; i++) program->slots[i] = 0.0f;
+  for (i = 0; i < program->numconstants; i++) {
+    float *slot = program->slots + program->constants[i].slot * SO_EVAL_LANES;
+    for (j = 0; j < SO_EVAL_LANES; j++) slot[j] = program->constants[i].value;
+  }
+  return program;
+}
+
+void
+so_eval_program_delete(so_eval_program *program)
+{
+  if (program != NULL) {
+    free(program->code);
+    free(program->constants);
+    free(program->slots);
+    free(program);
+  }
+}
+
+float *
+so_eval_program_register(so_eval_program *program, const char *regname,
+                         int component)
+{
+  return program->slots + program_register_slot(regname, component) * SO_EVAL_LANES;
+}
+
+int
+so_eval_program_is_serial(const so_eval_program *program)
+{
+  return program->serial;
+}
+
+/* runs the same expression as so_eval_traverse() for all lanes */
+#define PROGRAM_LOOP(expr) \
+  for (i = 0; i < numlanes; i++) { d[i] = (expr); } \
+  break
+
+void
+so_eval_program_run(so_eval_program *program, int numlanes)
+{
+  int i, n;
+  assert(numlanes >= 0 && numlanes <= SO_EVAL_LANES);
+  for (n = 0; n < program->numcode; n++) {
+    const so_eval_instruction *instr = &program->code[n];
+    float *d = program->slots + instr->dst * SO_EVAL_LANES;
+    const float *a = program->slots + instr->a * SO_EVAL_LANES;
+    const float *b = program->slots + instr->b * SO_EVAL_LANES;
+    const float *c = program->slots + instr->c * SO_EVAL_LANES;
+
+    switch (instr->op) {
+    case OP_COPY: PROGRAM_LOOP(a[i]);
+    case OP_ADD: PROGRAM_LOOP(a[i] + b[i]);
+    case OP_SUB: PROGRAM_LOOP(a[i] - b[i]);
+    case OP_MUL: PROGRAM_LOOP(a[i] * b[i]);
+    case OP_DIV: PROGRAM_LOOP(a[i] / (b[i] == 0.0f ? FLT_EPSILON : b[i]));
+    case OP_FMOD: PROGRAM_LOOP(b[i] != 0.0f ? (float) fmod(a[i], b[i]) : 0.0f);
+    case OP_NEG: PROGRAM_LOOP(- a[i]);
+    case OP_AND: PROGRAM_LOOP((a[i] != 0.0f && b[i] != 0.0f) ? 1.0f : 0.0f);
+    case OP_OR: PROGRAM_LOOP((a[i] != 0.0f || b[i] != 0.0f) ? 1.0f : 0.0f);
+    case OP_NOT: PROGRAM_LOOP(a[i] == 0.0f ? 1.0f : 0.0f);
+    case OP_LEQ: PROGRAM_LOOP(a[i] <= b[i] ? 1.0f : 0.0f);
+    case OP_GEQ: PROGRAM_LOOP(a[i] >= b[i] ? 1.0f : 0.0f);
+    case OP_LT: PROGRAM_LOOP(a[i] < b[i] ? 1.0f : 0.0f);
+    case OP_GT: PROGRAM_LOOP(a[i] > b[i] ? 1.0f : 0.0f);
+    case OP_EQ: PROGRAM_LOOP(a[i] == b[i] ? 1.0f : 0.0f);
+    case OP_NEQ: PROGRAM_LOOP(a[i] != b[i] ? 1.0f : 0.0f);
+    case OP_TEST: PROGRAM_LOOP(a[i] != 0.0f ? 1.0f : 0.0f);
+    case OP_TEST_VEC:
+      PROGRAM_LOOP((a[i] != 0.0f || b[i] != 0.0f || c[i] != 0.0f) ? 1.0f : 0.0f);
+    case OP_SELECT: PROGRAM_LOOP(a[i] != 0.0f ? b[i] : c[i]);
+    case OP_COS: PROGRAM_LOOP((float) cos(a[i]));
+    case OP_SIN: PROGRAM_LOOP((float) sin(a[i]));
+    case OP_TAN: PROGRAM_LOOP((float) tan(a[i]));
+    case OP_ACOS: PROGRAM_LOOP((float) acos(clamp(a[i], -1.0f, 1.0f)));
+    case OP_ASIN: PROGRAM_LOOP((float) asin(clamp(a[i], -1.0f, 1.0f)));
+    case OP_ATAN: PROGRAM_LOOP((float) atan(a[i]));
+    case OP_ATAN2:
+      PROGRAM_LOOP(b[i] == 0.0 ?
+                   (float) (a[i] >= 0.0f ? M_PI * 0.5 : - M_PI * 0.5) :
+                   (float) atan2(a[i], b[i]));
+    case OP_COSH: PROGRAM_LOOP((float) cosh(a[i]));
+    case OP_SINH: PROGRAM_LOOP((float) sinh(a[i]));
+    case OP_TANH: PROGRAM_LOOP((float) tanh(a[i]));
+    case OP_SQRT: PROGRAM_LOOP(a[i] > 0.0f ? (float) sqrt(a[i]) : 0.0f);
+    case OP_LEN: PROGRAM_LOOP((float) sqrt(a[i]));
+    case OP_EXP: PROGRAM_LOOP((float) exp(a[i]));
+    case OP_LOG: PROGRAM_LOOP(a[i] <= 0.0f ? -128.0f : (float) log(a[i]));
+    case OP_LOG10: PROGRAM_LOOP(a[i] <= 0.0f ? -38.0f : (float) log10(a[i]));
+    case OP_CEIL: PROGRAM_LOOP((float) ceil(a[i]));
+    case OP_FLOOR: PROGRAM_LOOP((float) floor(a[i]));
+    case OP_FABS: PROGRAM_LOOP((float) fabs(a[i]));
+    case OP_POW:
+      PROGRAM_LOOP(a[i] == 0.0f ? 0.0f :
+                   a[i] > 0.0f ? (float) pow(a[i], b[i]) :
+                   (float) pow(a[i], floor(b[i] + 0.5)));
+    case OP_NORMALIZE: PROGRAM_LOOP(b[i] > 0.0f ? a[i] / b[i] : 0.0f);
+    default:
+      assert(0 && "Whoops. Unknown opcode!\n");
+      break;
+    }
+  }
+}
+
+#undef PROGRAM_LOOP
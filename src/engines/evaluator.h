@@ -49,6 +49,14 @@
  * the inputs will change more often than the expression, so I
  * think this is better than parsing the expression every time.
  *
+ * For evaluating many values, the trees can be compiled into a flat
+ * register program with so_eval_compile(). All registers hold
+ * SO_EVAL_LANES values, one for each field index, and
+ * so_eval_program_run() evaluates all lanes at once. Use
+ * so_eval_program_register() to fill in the input registers and read
+ * back the output registers. The results are identical to those of
+ * so_eval_evaluate().
+ *
  * Call so_eval_parse() to build the tree structure. This method
  * returns NULL if an error occurred. The actual error message
  * can be found by using so_eval_error().
@@ -99,6 +107,35 @@ extern "C" {
      check this after calling so_eval_parse() */
   char * so_eval_error(void); /* defined in epsilon.y */
 
+  /* the compiled form of one or more tree structures */
+  typedef struct so_eval_program so_eval_program;
+
+  /* number of field indices evaluated in one so_eval_program_run() */
+#define SO_EVAL_LANES 64
+
+  /* compiles the tree structures, to be evaluated in order, into a
+     program. NULL entries are skipped. Returns NULL if the trees can
+     not be compiled, which is the case when they use rand(), as the
+     random numbers would be drawn in a different order */
+  so_eval_program *so_eval_compile(so_eval_node * const *nodes, int numnodes);
+
+  /* free memory used by program */
+  void so_eval_program_delete(so_eval_program *program);
+
+  /* returns the lane array for a register (like "a", "tA" or "oB")
+     or a component of a vector register. Temporary registers must be
+     set and output registers cleared before each run */
+  float *so_eval_program_register(so_eval_program *program,
+                                  const char *regname, int component);
+
+  /* returns TRUE if the program reads temporary registers before
+     writing them, so that each field index depends on the previous
+     one. Such programs must be run with one lane at a time */
+  int so_eval_program_is_serial(const so_eval_program *program);
+
+  /* evaluates the program for the first numlanes lanes */
+  void so_eval_program_run(so_eval_program *program, int numlanes);
+
   /* methods to create misc nodes */
   so_eval_node *so_eval_create_unary(int id, so_eval_node *topnode);
   so_eval_node *so_eval_create_binary(int id, so_eval_node *lhs, so_eval_node *rhs);
@@ -132,6 +132,7 @@
 #endif // HAVE_CONFIG_H
 #include "SbBasicP.h"
 #include "engines/SoConvertAll.h"
+#include "engines/SoEngineP.h"
 #include "fields/SoGlobalField.h"
 #include "io/SoWriterefCounter.h"
 #include "misc/SoConfigSettings.h"
@@ -143,6 +144,7 @@ inline unsigned int SbHashFunc(const void * key)
 {
   return SbHashFunc(reinterpret_cast<size_t>(key));
 }
+#include "misc/SoDBP.h"
 #include "coindefs.h" // COIN_STUB(), COIN_CHECK_THREAD()
 
 #ifdef COIN_THREADSAFE
@@ -555,6 +557,7 @@ SoField::~SoField()
   // set status bit to avoid evaluating this field while
   // disconnecting connections.
   this->setStatusBits(FLAG_ISDESTRUCTING);
+  SoDBP::forgetBatchEdit(this);
 
 #if COIN_DEBUG_EXTRA
   int wLevel =
@@ -888,6 +891,7 @@ SoField::connectFrom(SoField * master, SbBool notnotify, SbBool append)
   this->storage->masterfields.append(master); // slave -> master link
   if (!containerisconverter)
     master->storage->slaves.append(this); // master -> slave link
+  SoEngineP::connectionsChanged();
 
 
   // Notification.  ///////////////////////////////////////////////
@@ -1061,6 +1065,7 @@ SoField::disconnect(SoField * master)
 
   // Remove bookkeeping material.
   if (!containerisconverter) master->storage->slaves.removeItem(this);
+  SoEngineP::connectionsChanged();
 
   this->storage->masterfields.remove(idx);
 
@@ -1438,6 +1443,13 @@ SoField::touch(void)
 void
 SoField::startNotify(void)
 {
+  if (SoDB::isBatchEditing()) {
+    // notified when the batch edit ends, see SoDB::startBatchEdit()
+    this->setDefault(FALSE);
+    if (this->isNotifyEnabled()) SoDBP::recordBatchEdit(NULL, this);
+    return;
+  }
+
   SoNotList l;
 #if COIN_DEBUG_EXTRA
   int wLevel =
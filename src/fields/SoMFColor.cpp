@@ -98,6 +98,15 @@ SoMFColor::write1Value(SoOutput * out, int idx) const
   sosfvec3f_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFColor::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 3);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 
@@ -107,6 +116,7 @@ SoMFColor::write1Value(SoOutput * out, int idx) const
 void
 SoMFColor::setValues(int start, int numarg, const float rgb[][3])
 {
+  this->unshareValues();
   if(start+numarg > this->maxNum) this->makeRoom(start+numarg);
   else if(start+numarg > this->num) this->num = start+numarg;
 
@@ -120,6 +130,7 @@ SoMFColor::setValues(int start, int numarg, const float rgb[][3])
 void
 SoMFColor::setHSVValues(int start, int numarg, const float hsv[][3])
 {
+  this->unshareValues();
   if(start+numarg > this->maxNum) this->makeRoom(start+numarg);
   else if(start+numarg > this->num) this->num = start+numarg;
 
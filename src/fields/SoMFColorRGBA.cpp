@@ -98,6 +98,15 @@ SoMFColorRGBA::write1Value(SoOutput * out, int idx) const
   sosfvec4f_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFColorRGBA::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 4);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 
@@ -94,6 +94,14 @@ SoMFDouble::write1Value(SoOutput * out, int idx) const
   sosfdouble_write_value(out, (*this)[idx]);
 }
 
+// Writes all the doubles in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFDouble::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(), this->values, 1);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 
@@ -117,4 +125,24 @@ BOOST_AUTO_TEST_CASE(initialized)
   BOOST_CHECK_EQUAL(field.getNum(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(readExactValues)
+{
+  // every value must be read as the closest double
+  static const double expected[] = {
+    0.1, -0.5, 5.0, 1e22, 1e23, 0.0, 1.7976931348623157e308,
+    4.9406564584124654e-324, 1.2345678901234568e29, 3.141592653589793,
+    123.456, 2.5e-3
+  };
+  SoMFDouble field;
+  SbBool ok = field.set("[ 0.1, -.5, 5., 1e22, 1e23, -0, 1.7976931348623157e308, "
+                        "4.9406564584124654e-324, 123456789012345678901234567890, "
+                        "3.14159265358979323846264338327950288, 123.456, 25E-4 ]");
+  BOOST_CHECK_MESSAGE(ok, "failed to read values");
+  const int num = sizeof(expected) / sizeof(expected[0]);
+  BOOST_REQUIRE_EQUAL(field.getNum(), num);
+  for (int i = 0; i < num; i++) {
+    BOOST_CHECK_MESSAGE(field[i] == expected[i], "value read differently");
+  }
+}
+
 #endif // COIN_TEST_SUITE
@@ -93,6 +93,14 @@ SoMFFloat::write1Value(SoOutput * out, int idx) const
   sosffloat_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFFloat::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(), this->values, 1);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 
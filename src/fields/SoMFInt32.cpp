@@ -56,6 +56,7 @@
 #endif // COIN_DEBUG
 
 #include "fields/SoSubFieldP.h"
+#include "fields/shared.h"
 
 
 SO_MFIELD_SOURCE_MALLOC(SoMFInt32, int32_t, int32_t);
@@ -96,6 +97,27 @@ SoMFInt32::write1Value(SoOutput * out, int idx) const
   sosfint32_write_value(out, (*this)[idx]);
 }
 
+// Writes all the integers in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFInt32::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(), this->values, 1);
+}
+
+// Reads all the integers in one go, instead of one value at the time
+// through read1Value().
+SbBool
+SoMFInt32::readBinaryValues(SoInput * in, int numarg)
+{
+  assert(in->isBinary());
+  assert(numarg >= 0);
+  assert(numarg <= this->maxNum);
+
+  if (numarg == 0) return TRUE;
+  return in->readBinaryArray(this->values, numarg);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 
@@ -117,4 +139,17 @@ BOOST_AUTO_TEST_CASE(initialized)
   BOOST_CHECK_EQUAL(field.getNum(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(readIntegerFormats)
+{
+  static const int32_t expected[] = { 10, -7, 3, 31, 8, 2147483647, -2147483647, 0 };
+  SoMFInt32 field;
+  SbBool ok = field.set("[ 10, -7, +3, 0x1f, 010, 2147483647, -2147483647, 0 ]");
+  BOOST_CHECK_MESSAGE(ok, "failed to read values");
+  const int num = sizeof(expected) / sizeof(expected[0]);
+  BOOST_REQUIRE_EQUAL(field.getNum(), num);
+  for (int i = 0; i < num; i++) {
+    BOOST_CHECK_EQUAL(field[i], expected[i]);
+  }
+}
+
 #endif // COIN_TEST_SUITE
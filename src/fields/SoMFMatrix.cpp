@@ -97,6 +97,15 @@ SoMFMatrix::write1Value(SoOutput * out, int idx) const
   out->decrementIndent();
 }
 
+// Writes all the matrices in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFMatrix::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 16);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -130,4 +139,53 @@ BOOST_AUTO_TEST_CASE(initialized)
   BOOST_CHECK_EQUAL(field.getNum(), 0);
 }
 
+#include <cstdlib>
+#include <Inventor/SoDB.h>
+#include <Inventor/SoInput.h>
+#include <Inventor/SoOutput.h>
+#include <Inventor/actions/SoWriteAction.h>
+#include <Inventor/nodes/SoMultipleCopy.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+// binary arrays are written in one go, check that they come out right
+BOOST_AUTO_TEST_CASE(binaryRoundTrip)
+{
+  const int NUM = 257;
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoMultipleCopy * copies = new SoMultipleCopy;
+  root->addChild(copies);
+  copies->matrix.setNum(NUM);
+  SbMatrix * matrices = copies->matrix.startEditing();
+  for (int i = 0; i < NUM; i++) {
+    for (int j = 0; j < 16; j++) {
+      matrices[i][j / 4][j % 4] = float(i * 16 + j) * 0.125f - 1000.0f;
+    }
+  }
+  copies->matrix.finishEditing();
+
+  SoOutput out;
+  out.setBinary(TRUE);
+  out.setBuffer(malloc(1024), 1024, realloc);
+  SoWriteAction wa(&out);
+  wa.apply(root);
+  void * buf;
+  size_t size;
+  BOOST_REQUIRE(out.getBuffer(buf, size));
+
+  SoInput in;
+  in.setBuffer(buf, size);
+  SoSeparator * result = SoDB::readAll(&in);
+  BOOST_REQUIRE(result);
+  result->ref();
+  BOOST_REQUIRE(result->getNumChildren() == 1);
+  SoMultipleCopy * readcopies = static_cast<SoMultipleCopy *>(result->getChild(0));
+  BOOST_CHECK_MESSAGE(readcopies->matrix == copies->matrix,
+                      "binary SoMFMatrix values differ");
+
+  result->unref();
+  root->unref();
+  free(buf);
+}
+
 #endif // COIN_TEST_SUITE
@@ -98,6 +98,15 @@ SoMFUInt32::write1Value(SoOutput * out, int idx) const
   sosfuint32_write_value(out, (*this)[idx]);
 }
 
+// Writes all the integers in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFUInt32::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const int32_t *>(this->values), 1);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -100,6 +100,15 @@ SoMFVec2d::write1Value(SoOutput * out, int idx) const
   sosfvec2d_write_value(out, (*this)[idx]);
 }
 
+// Writes all the doubles in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec2d::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const double *>(this->values), 2);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
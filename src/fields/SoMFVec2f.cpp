@@ -98,6 +98,15 @@ SoMFVec2f::write1Value(SoOutput * out, int idx) const
   sosfvec2f_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec2f::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 2);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -109,6 +118,7 @@ SoMFVec2f::write1Value(SoOutput * out, int idx) const
 void
 SoMFVec2f::setValues(int start, int numarg, const float xy[][2])
 {
+  this->unshareValues();
   if (start+numarg > this->maxNum) this->allocValues(start+numarg);
   else if (start+numarg > this->num) this->num = start+numarg;
 
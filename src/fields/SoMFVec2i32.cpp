@@ -100,6 +100,15 @@ SoMFVec2i32::write1Value(SoOutput * out, int idx) const
   sosfvec2i32_write_value(out, (*this)[idx]);
 }
 
+// Writes all the integers in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec2i32::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const int32_t *>(this->values), 2);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
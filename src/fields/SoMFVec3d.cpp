@@ -91,6 +91,15 @@ SoMFVec3d::write1Value(SoOutput * out, int idx) const
   sosfvec3d_write_value(out, (*this)[idx]);
 }
 
+// Writes all the doubles in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec3d::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const double *>(this->values), 3);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -107,6 +116,7 @@ SoMFVec3d::write1Value(SoOutput * out, int idx) const
 void
 SoMFVec3d::setValues(int start, int numarg, const double xyz[][3])
 {
+  this->unshareValues();
   if (start+numarg > this->maxNum) this->allocValues(start+numarg);
   else if (start+numarg > this->num) this->num = start+numarg;
 
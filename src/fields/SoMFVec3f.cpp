@@ -54,9 +54,11 @@
 
 #include <Inventor/SoInput.h>
 #include <Inventor/errors/SoDebugError.h>
+#include <Inventor/errors/SoReadError.h>
 
 #include "fields/SoSubFieldP.h"
 #include "fields/shared.h"
+#include "tidbitsp.h"
 
 // *************************************************************************
 
@@ -104,6 +106,40 @@ SoMFVec3f::write1Value(SoOutput * out, int idx) const
   sosfvec3f_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec3f::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 3);
+}
+
+// Reads all the floats in one go, instead of one value at the time
+// through read1Value().
+SbBool
+SoMFVec3f::readBinaryValues(SoInput * in, int numarg)
+{
+  assert(in->isBinary());
+  assert(numarg >= 0);
+  assert(numarg <= this->maxNum);
+
+  if (numarg == 0) return TRUE;
+  float * f = const_cast<float *>(this->values[0].getValue());
+  if (!in->readBinaryArray(f, numarg * 3)) return FALSE;
+
+  // same check as in SoInput::read(float &)
+  for (int i = 0; i < numarg * 3; i++) {
+    if (!coin_finite((double)f[i])) {
+      SoReadError::post(in,
+                        "Detected non-valid floating point number, replacing "
+                        "with 0.0f");
+      f[i] = 0.0f;
+    }
+  }
+  return TRUE;
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -120,6 +156,7 @@ SoMFVec3f::write1Value(SoOutput * out, int idx) const
 void
 SoMFVec3f::setValues(int start, int numarg, const float xyz[][3])
 {
+  this->unshareValues();
   if (start+numarg > this->maxNum) this->allocValues(start+numarg);
   else if (start+numarg > this->num) this->num = start+numarg;
 
@@ -178,4 +215,148 @@ BOOST_AUTO_TEST_CASE(initialized)
   BOOST_CHECK_EQUAL(field.getNum(), 0);
 }
 
+#include <cstdlib>
+#include <Inventor/SoDB.h>
+#include <Inventor/SoInput.h>
+#include <Inventor/SoOutput.h>
+#include <Inventor/actions/SoWriteAction.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+// binary arrays are read in one go, check that they come out right
+BOOST_AUTO_TEST_CASE(binaryRoundTrip)
+{
+  const int NUM = 1001;
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoCoordinate3 * coords = new SoCoordinate3;
+  SoIndexedFaceSet * faceset = new SoIndexedFaceSet;
+  root->addChild(coords);
+  root->addChild(faceset);
+  coords->point.setNum(NUM);
+  faceset->coordIndex.setNum(NUM);
+  SbVec3f * pts = coords->point.startEditing();
+  int32_t * idx = faceset->coordIndex.startEditing();
+  for (int i = 0; i < NUM; i++) {
+    pts[i].setValue(float(i) * 0.25f, -float(i) * 1.5f, float(i % 17) - 1.0e6f);
+    idx[i] = (i % 4 == 3) ? -1 : i * 3;
+  }
+  coords->point.finishEditing();
+  faceset->coordIndex.finishEditing();
+
+  SoOutput out;
+  out.setBinary(TRUE);
+  out.setBuffer(malloc(1024), 1024, realloc);
+  SoWriteAction wa(&out);
+  wa.apply(root);
+  void * buf;
+  size_t size;
+  BOOST_REQUIRE(out.getBuffer(buf, size));
+
+  SoInput in;
+  in.setBuffer(buf, size);
+  SoSeparator * result = SoDB::readAll(&in);
+  BOOST_REQUIRE(result);
+  result->ref();
+  BOOST_REQUIRE(result->getNumChildren() == 2);
+  SoCoordinate3 * readcoords = static_cast<SoCoordinate3 *>(result->getChild(0));
+  SoIndexedFaceSet * readfaceset = static_cast<SoIndexedFaceSet *>(result->getChild(1));
+  BOOST_CHECK_MESSAGE(readcoords->point == coords->point,
+                      "binary SoMFVec3f values differ");
+  BOOST_CHECK_MESSAGE(readfaceset->coordIndex == faceset->coordIndex,
+                      "binary SoMFInt32 values differ");
+
+  result->unref();
+  root->unref();
+  free(buf);
+}
+
+// copies share the values array until one of them is modified
+BOOST_AUTO_TEST_CASE(copyOnWrite)
+{
+  SoCoordinate3 * coords = new SoCoordinate3;
+  coords->ref();
+  coords->point.setNum(100);
+  SbVec3f * pts = coords->point.startEditing();
+  for (int i = 0; i < 100; i++) pts[i].setValue(float(i), 0.0f, 0.0f);
+  coords->point.finishEditing();
+
+  SoCoordinate3 * copy = static_cast<SoCoordinate3 *>(coords->copy());
+  copy->ref();
+  SoMFVec3f field;
+  field = copy->point;
+  BOOST_CHECK_MESSAGE(copy->point.getValues(0) == coords->point.getValues(0) &&
+                      field.getValues(0) == coords->point.getValues(0),
+                      "copied values not shared");
+
+  copy->point.set1Value(5, SbVec3f(-1.0f, -1.0f, -1.0f));
+  BOOST_CHECK_MESSAGE(copy->point.getValues(0) != coords->point.getValues(0),
+                      "modified copy still shares values");
+  BOOST_CHECK(coords->point[5] == SbVec3f(5.0f, 0.0f, 0.0f));
+  BOOST_CHECK(field[5] == SbVec3f(5.0f, 0.0f, 0.0f));
+  BOOST_CHECK(copy->point[5] == SbVec3f(-1.0f, -1.0f, -1.0f));
+  BOOST_CHECK(copy->point[6] == SbVec3f(6.0f, 0.0f, 0.0f));
+
+  // the original and the field still share, and the last one to be
+  // modified keeps the array without copying it
+  const SbVec3f * shared = coords->point.getValues(0);
+  field.setNum(50);
+  BOOST_CHECK_EQUAL(field.getNum(), 50);
+  BOOST_CHECK_EQUAL(coords->point.getNum(), 100);
+  field.set1Value(0, SbVec3f(1.0f, 2.0f, 3.0f));
+  coords->point.set1Value(0, SbVec3f(3.0f, 2.0f, 1.0f));
+  BOOST_CHECK_MESSAGE(coords->point.getValues(0) == shared,
+                      "last user of the array did not take it over");
+  BOOST_CHECK(field[0] == SbVec3f(1.0f, 2.0f, 3.0f));
+  BOOST_CHECK(coords->point[0] == SbVec3f(3.0f, 2.0f, 1.0f));
+
+  // an array with a single value is copied as well
+  SoMFVec3f single, other;
+  single.setValue(SbVec3f(1.0f, 1.0f, 1.0f));
+  other = single;
+  BOOST_CHECK(other.getValues(0) == single.getValues(0));
+  other.set1Value(0, SbVec3f(2.0f, 2.0f, 2.0f));
+  BOOST_CHECK(other.getValues(0) != single.getValues(0));
+  BOOST_CHECK_EQUAL(other.getNum(), 1);
+  BOOST_CHECK(single[0] == SbVec3f(1.0f, 1.0f, 1.0f));
+  BOOST_CHECK(other[0] == SbVec3f(2.0f, 2.0f, 2.0f));
+
+  copy->unref();
+  coords->unref();
+}
+
+// the same values read twice end up in the same array
+BOOST_AUTO_TEST_CASE(shareReadValues)
+{
+  SbString points;
+  for (int i = 0; i < 32; i++) {
+    SbString p;
+    p.sprintf("%d 0 1, ", i);
+    points += p;
+  }
+  SbString scene;
+  scene.sprintf("#Inventor V2.1 ascii\n"
+                "Separator { Coordinate3 { point [ %s ] } "
+                "Coordinate3 { point [ %s ] } }",
+                points.getString(), points.getString());
+
+  SoInput in;
+  in.setBuffer(scene.getString(), scene.getLength());
+  SoSeparator * root = SoDB::readAll(&in);
+  BOOST_REQUIRE(root);
+  root->ref();
+  BOOST_REQUIRE(root->getNumChildren() == 2);
+  SoMFVec3f & first = static_cast<SoCoordinate3 *>(root->getChild(0))->point;
+  SoMFVec3f & second = static_cast<SoCoordinate3 *>(root->getChild(1))->point;
+  BOOST_CHECK_EQUAL(first.getNum(), 32);
+  BOOST_CHECK_MESSAGE(first.getValues(0) == second.getValues(0),
+                      "identical values read twice not shared");
+
+  second.startEditing()[31] = SbVec3f(0.0f, 0.0f, 0.0f);
+  second.finishEditing();
+  BOOST_CHECK(first[31] == SbVec3f(31.0f, 0.0f, 1.0f));
+  root->unref();
+}
+
 #endif // COIN_TEST_SUITE
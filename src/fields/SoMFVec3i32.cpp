@@ -106,6 +106,15 @@ SoMFVec3i32::write1Value(SoOutput * out, int idx) const
   sosfvec3i32_write_value(out, (*this)[idx]);
 }
 
+// Writes all the integers in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec3i32::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const int32_t *>(this->values), 3);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -102,6 +102,15 @@ SoMFVec4d::write1Value(SoOutput * out, int idx) const
   sosfvec4d_write_value(out, (*this)[idx]);
 }
 
+// Writes all the doubles in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec4d::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const double *>(this->values), 4);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
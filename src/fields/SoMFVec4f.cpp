@@ -100,6 +100,15 @@ SoMFVec4f::write1Value(SoOutput * out, int idx) const
   sosfvec4f_write_value(out, (*this)[idx]);
 }
 
+// Writes all the floats in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec4f::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const float *>(this->values), 4);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
@@ -111,6 +120,7 @@ SoMFVec4f::write1Value(SoOutput * out, int idx) const
 void
 SoMFVec4f::setValues(int start, int numarg, const float xyzw[][4])
 {
+  this->unshareValues();
   if(start+numarg > this->maxNum) this->allocValues(start+numarg);
   else if(start+numarg > this->num) this->num = start+numarg;
 
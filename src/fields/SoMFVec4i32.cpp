@@ -102,6 +102,15 @@ SoMFVec4i32::write1Value(SoOutput * out, int idx) const
   sosfvec4i32_write_value(out, (*this)[idx]);
 }
 
+// Writes all the integers in one go, instead of one value at the time
+// through write1Value().
+void
+SoMFVec4i32::writeBinaryValues(SoOutput * out) const
+{
+  somfield_write_binary_array(out, this->getNum(),
+                              reinterpret_cast<const int32_t *>(this->values), 4);
+}
+
 #endif // DOXYGEN_SKIP_THIS
 
 // *************************************************************************
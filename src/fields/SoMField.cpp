@@ -236,6 +236,16 @@
   very careful about how your application and DLLs are linked to the
   underlying C library.
 
+  Fields of the most common value types (SoMFFloat, SoMFInt32,
+  SoMFUInt32, SoMFVec2f, SoMFVec3f, SoMFVec3d, SoMFVec4f and
+  SoMFColor) share their values array with other fields of the same
+  type when possible, as when copying a node with SoNode::copy(),
+  assigning one field to another, or reading the same values from
+  file more than once. The array is only copied when one of the
+  fields sharing it is modified. This is why the values must never be
+  changed through the pointer returned from getValues(); use
+  startEditing() and finishEditing() instead.
+
   \sa SoSField
 */
 
@@ -253,6 +263,16 @@
 #include <Inventor/errors/SoReadError.h>
 #include <Inventor/fields/SoSubField.h>
 
+#include <Inventor/fields/SoMFColor.h>
+#include <Inventor/fields/SoMFFloat.h>
+#include <Inventor/fields/SoMFInt32.h>
+#include <Inventor/fields/SoMFUInt32.h>
+#include <Inventor/fields/SoMFVec2f.h>
+#include <Inventor/fields/SoMFVec3d.h>
+#include <Inventor/fields/SoMFVec3f.h>
+#include <Inventor/fields/SoMFVec4f.h>
+
+#include "misc/SbHash.h"
 #include "threads/threadsutilp.h"
 #include "tidbitsp.h"
 #include "coindefs.h" // COIN_WORKAROUND_*
@@ -261,6 +281,7 @@
 using std::memcpy;
 using std::memset;
 using std::strlen;
+using std::memcmp;
 #endif // !COIN_WORKAROUND_NO_USING_STD_FUNCS
 
 // *************************************************************************
@@ -300,6 +321,126 @@ somfield_mutex_cleanup(void)
 
 // *************************************************************************
 
+// Bookkeeping for values arrays shared between fields. An array is
+// registered here while more than one field uses it, and while it
+// can be found by its contents after having been read from file. A
+// field is sharing its array if the array is registered here, and
+// must detach from it before writing to it. Keeping this out of
+// SoMField itself leaves the layout of the public field classes
+// unchanged.
+
+struct somfield_sharedarray {
+  int refcount;
+  int maxnum;
+  // set for arrays read from file, which can be looked up by content
+  SbBool hashed;
+  uint32_t hash;
+  SoType type;
+  int num;
+};
+
+typedef SbHash<uintptr_t, somfield_sharedarray *> SoMFieldSharedArrayMap;
+typedef SbHash<uint32_t, uintptr_t> SoMFieldReadArrayMap;
+
+static void * somfield_sharing_mutex = NULL;
+static SoMFieldSharedArrayMap * somfield_sharedarrays = NULL;
+static SoMFieldReadArrayMap * somfield_readarrays = NULL;
+// number of registered arrays, read without locking the mutex, so the
+// fields can skip the lookup while nothing is shared
+static int somfield_numshared = 0;
+
+// Arrays read from file with fewer values than this are not worth
+// looking up.
+static const int SOMFIELD_MIN_SHARED_READ = 16;
+
+static void
+somfield_sharing_cleanup(void)
+{
+  if (somfield_sharedarrays) {
+    SbList<uintptr_t> keys;
+    somfield_sharedarrays->makeKeyList(keys);
+    for (int i = 0; i < keys.getLength(); i++) {
+      somfield_sharedarray * array = NULL;
+      (void)somfield_sharedarrays->get(keys[i], array);
+      delete array;
+    }
+  }
+  delete somfield_sharedarrays;
+  somfield_sharedarrays = NULL;
+  delete somfield_readarrays;
+  somfield_readarrays = NULL;
+  CC_MUTEX_DESTRUCT(somfield_sharing_mutex);
+}
+
+// Only fields whose values are plain data, and which never write to
+// their array without calling unshareValues() first, may share.
+static SbBool
+somfield_can_share(const SoType & type)
+{
+  return
+    type == SoMFVec3f::getClassTypeId() ||
+    type == SoMFInt32::getClassTypeId() ||
+    type == SoMFVec2f::getClassTypeId() ||
+    type == SoMFFloat::getClassTypeId() ||
+    type == SoMFColor::getClassTypeId() ||
+    type == SoMFUInt32::getClassTypeId() ||
+    type == SoMFVec4f::getClassTypeId() ||
+    type == SoMFVec3d::getClassTypeId();
+}
+
+static uint32_t
+somfield_hash_values(const void * ptr, size_t size)
+{
+  // all the shareable value types are made of 4 or 8 byte words
+  const unsigned char * bytes = static_cast<const unsigned char *>(ptr);
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i + 4 <= size; i += 4) {
+    uint32_t w;
+    (void)memcpy(&w, bytes + i, 4);
+    h = (h ^ w) * 16777619u;
+    h ^= h >> 15;
+  }
+  return h ^ static_cast<uint32_t>(size);
+}
+
+// Must be called with the sharing mutex locked.
+static void
+somfield_register_array(uintptr_t key, somfield_sharedarray * array)
+{
+  (void)somfield_sharedarrays->put(key, array);
+  CC_ATOMIC_STORE_RELEASE(&somfield_numshared,
+                          int(somfield_sharedarrays->getNumElements()));
+}
+
+// Must be called with the sharing mutex locked.
+static void
+somfield_forget_array(uintptr_t key, somfield_sharedarray * array)
+{
+  (void)somfield_sharedarrays->erase(key);
+  CC_ATOMIC_STORE_RELEASE(&somfield_numshared,
+                          int(somfield_sharedarrays->getNumElements()));
+  uintptr_t readkey;
+  if (array->hashed &&
+      somfield_readarrays->get(array->hash, readkey) && readkey == key) {
+    (void)somfield_readarrays->erase(array->hash);
+  }
+  delete array;
+}
+
+static SbBool
+somfield_is_shared(const void * values)
+{
+  if (CC_ATOMIC_LOAD_ACQUIRE(&somfield_numshared) == 0) return FALSE;
+  CC_MUTEX_LOCK(somfield_sharing_mutex);
+  somfield_sharedarray * array = NULL;
+  const SbBool shared =
+    somfield_sharedarrays->get(reinterpret_cast<uintptr_t>(values), array);
+  CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+  return shared;
+}
+
+// *************************************************************************
+
 
 /*!
   \copydetails SoField::getClassTypeId(void)
@@ -320,6 +461,11 @@ SoMField::initClass(void)
 
   CC_MUTEX_CONSTRUCT(somfield_mutex);
   coin_atexit(somfield_mutex_cleanup, CC_ATEXIT_NORMAL);
+
+  CC_MUTEX_CONSTRUCT(somfield_sharing_mutex);
+  somfield_sharedarrays = new SoMFieldSharedArrayMap;
+  somfield_readarrays = new SoMFieldReadArrayMap;
+  coin_atexit(somfield_sharing_cleanup, CC_ATEXIT_NORMAL);
 }
 
 void
@@ -368,6 +514,7 @@ SoMField::makeRoom(int newnum)
 SbBool
 SoMField::set1(const int index, const char * const valuestring)
 {
+  this->unshareValues();
   int oldnum = this->num;
   // make sure the array has room for the new item
   if (index >= this->maxNum) this->allocValues(index+1);
@@ -468,6 +615,12 @@ SoMField::readValue(SoInput * in)
   // FIXME: temporary disable notification (if on) during reading the
   // field elements. 20000429 mortene.
 
+  // The values read will replace the current ones, so there is no
+  // point in copying a shared array first.
+  if (!this->userDataIsUsed && somfield_is_shared(this->valuesPtr())) {
+    this->allocValues(0);
+  }
+
   // This macro is convenient for reading with error detection.
 #define READ_VAL(val) \
   if (!in->read(val)) { \
@@ -549,6 +702,8 @@ SoMField::readValue(SoInput * in)
 
 #undef READ_VAL
 
+  this->shareReadValues();
+
   // We need to trigger the notification chain here, as this function
   // can be used on a node in a scene graph in any state -- not only
   // during initial scene graph import.
@@ -794,7 +949,7 @@ SoMField::allocValues(int newnum)
   assert(newnum >= 0);
 
   if (newnum == 0) {
-    if (!this->userDataIsUsed) {
+    if (this->releaseValues()) {
       delete[] static_cast<unsigned char *>(this->valuesPtr());
     }
     this->setValuesPtr(NULL);
@@ -837,7 +992,7 @@ SoMField::allocValues(int newnum)
         if (buffersize > copysize) {
           (void)memset(newblock + copysize, 0, buffersize - copysize);
         }
-        if (!this->userDataIsUsed) {
+        if (this->releaseValues()) {
           delete[] static_cast<unsigned char *>(this->valuesPtr());
         }
         this->setValuesPtr(newblock);
@@ -860,6 +1015,170 @@ SoMField::allocValues(int newnum)
 }
 #endif // DOXYGEN_SKIP_THIS
 
+/*!
+  Makes this field use the values array of \a field, which must be of
+  the same type, instead of copying the values. The array is copied
+  only when one of the fields is modified. Returns \c FALSE if the
+  array can not be shared, and the values must be copied as usual.
+
+  \since Coin 4.1
+*/
+SbBool
+SoMField::shareValues(const SoMField & field)
+{
+  if (&field == this) return FALSE;
+  const SoType type = this->getTypeId();
+  if (field.getTypeId() != type || !somfield_can_share(type)) return FALSE;
+
+  const int numvalues = field.getNum(); // evaluates the field
+  if (numvalues == 0 || field.userDataIsUsed) return FALSE;
+
+  SoMField & source = const_cast<SoMField &>(field);
+  void * values = source.valuesPtr();
+  if (values != this->valuesPtr()) {
+    this->allocValues(0);
+
+    CC_MUTEX_LOCK(somfield_sharing_mutex);
+    const uintptr_t key = reinterpret_cast<uintptr_t>(values);
+    somfield_sharedarray * array = NULL;
+    if (!somfield_sharedarrays->get(key, array)) {
+      array = new somfield_sharedarray;
+      array->refcount = 1;
+      array->maxnum = source.maxNum;
+      array->hashed = FALSE;
+      somfield_register_array(key, array);
+    }
+    array->refcount++;
+    CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+
+    this->setValuesPtr(values);
+    this->maxNum = source.maxNum;
+    this->userDataIsUsed = FALSE;
+  }
+  this->num = numvalues;
+
+  this->setChangedIndices();
+  this->valueChanged();
+  return TRUE;
+}
+
+/*!
+  Makes sure the field has a values array of its own, which it can
+  write to. Must be called before changing any values in the array.
+
+  \since Coin 4.1
+*/
+void
+SoMField::unshareValues(void)
+{
+  if (!this->userDataIsUsed && somfield_is_shared(this->valuesPtr())) {
+    this->detachValues();
+  }
+}
+
+/*!
+  Gives up the field's use of its values array. Returns \c TRUE if the
+  field owned the array and should delete it, or \c FALSE if the
+  array is still used by other fields, or is application data set
+  with setValuesPointer().
+
+  \since Coin 4.1
+*/
+SbBool
+SoMField::releaseValues(void)
+{
+  if (this->userDataIsUsed) return FALSE;
+  if (CC_ATOMIC_LOAD_ACQUIRE(&somfield_numshared) == 0) return TRUE;
+
+  CC_MUTEX_LOCK(somfield_sharing_mutex);
+  const uintptr_t key = reinterpret_cast<uintptr_t>(this->valuesPtr());
+  somfield_sharedarray * array = NULL;
+  SbBool last = TRUE;
+  if (somfield_sharedarrays->get(key, array)) {
+    if (--array->refcount == 0) somfield_forget_array(key, array);
+    else last = FALSE;
+  }
+  CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+  return last;
+}
+
+// Gives the field an array of its own. If no other field is using the
+// shared array anymore, the field takes it over instead of copying it.
+void
+SoMField::detachValues(void)
+{
+  CC_MUTEX_LOCK(somfield_sharing_mutex);
+  const uintptr_t key = reinterpret_cast<uintptr_t>(this->valuesPtr());
+  somfield_sharedarray * array = NULL;
+  SbBool copy = FALSE;
+  if (somfield_sharedarrays->get(key, array)) {
+    if (array->refcount == 1) somfield_forget_array(key, array);
+    else copy = TRUE;
+  }
+  CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+
+  if (copy) {
+    // Make allocValues() believe the array is too small, so it moves
+    // the values to a new block and gives up the shared array through
+    // releaseValues(). Growing by one value makes the block grow from
+    // the single slot also when there is only one value.
+    const int numvalues = this->num;
+    this->maxNum = 1;
+    this->allocValues(numvalues + 1);
+    this->num = numvalues;
+  }
+}
+
+// Called after values have been read from file. Makes the field use
+// an array read earlier with the same values, or makes its own array
+// available to fields reading the same values later.
+void
+SoMField::shareReadValues(void)
+{
+  const SoType type = this->getTypeId();
+  if (this->num < SOMFIELD_MIN_SHARED_READ || this->userDataIsUsed ||
+      !somfield_can_share(type)) return;
+
+  const size_t size = size_t(this->num) * size_t(this->fieldSizeof());
+  void * values = this->valuesPtr();
+  const uint32_t hash = somfield_hash_values(values, size);
+
+  CC_MUTEX_LOCK(somfield_sharing_mutex);
+  uintptr_t key = reinterpret_cast<uintptr_t>(values);
+  somfield_sharedarray * array = NULL;
+  if (somfield_sharedarrays->get(key, array)) {
+    // already shared
+    CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+    return;
+  }
+  if (somfield_readarrays->get(hash, key) &&
+      somfield_sharedarrays->get(key, array) &&
+      array->type == type && array->num == this->num &&
+      memcmp(reinterpret_cast<void *>(key), values, size) == 0) {
+    array->refcount++;
+    CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+
+    const int numvalues = this->num;
+    this->allocValues(0);
+    this->setValuesPtr(reinterpret_cast<void *>(key));
+    this->maxNum = array->maxnum;
+    this->num = numvalues;
+    return;
+  }
+
+  array = new somfield_sharedarray;
+  array->refcount = 1;
+  array->maxnum = this->maxNum;
+  array->hashed = TRUE;
+  array->hash = hash;
+  array->type = type;
+  array->num = this->num;
+  key = reinterpret_cast<uintptr_t>(values);
+  somfield_register_array(key, array);
+  (void)somfield_readarrays->put(hash, key);
+  CC_MUTEX_UNLOCK(somfield_sharing_mutex);
+}
+
 SoNotRec
 SoMField::createNotRec(SoBase * cont)
 {
@@ -593,3 +593,36 @@ sosfvec4d_write_value(SoOutput * out, const SbVec4d & v)
 }
 
 // *************************************************************************
+
+// Write the number of values followed by all the values of a
+// multiple-value field in binary format, with a single
+// SoOutput::writeBinaryArray() call. Used from the writeBinaryValues()
+// overrides of the SoMField subclasses storing int32, float or double
+// components contiguously.
+void
+somfield_write_binary_array(SoOutput * out, int num,
+                            const int32_t * values, int numcomponents)
+{
+  out->write(num);
+  if (num > 0) out->writeBinaryArray(values, num * numcomponents);
+}
+
+// Write float components. See above.
+void
+somfield_write_binary_array(SoOutput * out, int num,
+                            const float * values, int numcomponents)
+{
+  out->write(num);
+  if (num > 0) out->writeBinaryArray(values, num * numcomponents);
+}
+
+// Write double components. See above.
+void
+somfield_write_binary_array(SoOutput * out, int num,
+                            const double * values, int numcomponents)
+{
+  out->write(num);
+  if (num > 0) out->writeBinaryArray(values, num * numcomponents);
+}
+
+// *************************************************************************
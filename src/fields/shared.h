@@ -111,6 +111,13 @@ void sosfvec4ui32_write_value(SoOutput * out, const SbVec4ui32 & v);
 void sosfvec4f_write_value(SoOutput * out, const SbVec4f & v);
 void sosfvec4d_write_value(SoOutput * out, const SbVec4d & v);
 
+void somfield_write_binary_array(SoOutput * out, int num,
+                                 const int32_t * values, int numcomponents);
+void somfield_write_binary_array(SoOutput * out, int num,
+                                 const float * values, int numcomponents);
+void somfield_write_binary_array(SoOutput * out, int num,
+                                 const double * values, int numcomponents);
+
 // *************************************************************************
 
 #endif // ! COIN_FIELDS_SHARED_H
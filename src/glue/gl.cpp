@@ -1218,6 +1218,48 @@ glglue_resolve_symbols(cc_glglue * w)
   }
 #endif /* GL_VERSION_1_4 */
 
+  w->glDrawBuffers = NULL;
+  w->max_draw_buffers = 1;
+#if defined(GL_VERSION_2_0)
+  if (cc_glglue_glversion_matches_at_least(w, 2, 0, 0)) {
+    w->glDrawBuffers = (COIN_PFNGLDRAWBUFFERSPROC)PROC(w, glDrawBuffers);
+  }
+#endif /* GL_VERSION_2_0 */
+#ifdef GL_ARB_draw_buffers
+  if (!w->glDrawBuffers && cc_glglue_glext_supported(w, "GL_ARB_draw_buffers")) {
+    w->glDrawBuffers = (COIN_PFNGLDRAWBUFFERSPROC)PROC(w, glDrawBuffersARB);
+  }
+#endif /* GL_ARB_draw_buffers */
+  if (w->glDrawBuffers) {
+    GLint maxbuffers = 1;
+    glGetIntegerv(GL_MAX_DRAW_BUFFERS_ARB, &maxbuffers);
+    w->max_draw_buffers = (int) maxbuffers;
+  }
+
+  w->glDrawElementsInstanced = NULL;
+#if defined(GL_VERSION_3_1)
+  if (cc_glglue_glversion_matches_at_least(w, 3, 1, 0)) {
+    w->glDrawElementsInstanced = (COIN_PFNGLDRAWELEMENTSINSTANCEDPROC)PROC(w, glDrawElementsInstanced);
+  }
+#endif /* GL_VERSION_3_1 */
+#ifdef GL_ARB_draw_instanced
+  if (!w->glDrawElementsInstanced && cc_glglue_glext_supported(w, "GL_ARB_draw_instanced")) {
+    w->glDrawElementsInstanced = (COIN_PFNGLDRAWELEMENTSINSTANCEDPROC)PROC(w, glDrawElementsInstancedARB);
+  }
+#endif /* GL_ARB_draw_instanced */
+
+  w->glVertexAttribDivisor = NULL;
+#if defined(GL_VERSION_3_3)
+  if (cc_glglue_glversion_matches_at_least(w, 3, 3, 0)) {
+    w->glVertexAttribDivisor = (COIN_PFNGLVERTEXATTRIBDIVISORPROC)PROC(w, glVertexAttribDivisor);
+  }
+#endif /* GL_VERSION_3_3 */
+#ifdef GL_ARB_instanced_arrays
+  if (!w->glVertexAttribDivisor && cc_glglue_glext_supported(w, "GL_ARB_instanced_arrays")) {
+    w->glVertexAttribDivisor = (COIN_PFNGLVERTEXATTRIBDIVISORPROC)PROC(w, glVertexAttribDivisorARB);
+  }
+#endif /* GL_ARB_instanced_arrays */
+
   w->glVertexPointer = NULL; /* for cc_glglue_has_vertex_array() */
 #if defined(GL_VERSION_1_1)
   if (cc_glglue_glversion_matches_at_least(w, 1, 1, 0)) {
@@ -5442,6 +5484,39 @@ coin_glglue_has_generate_mipmap(const cc_glglue * glue)
   return (glue->glGenerateMipmap != NULL);
 }
 
+/* Weighted blended order independent transparency renders into two
+   floating point color buffers of a framebuffer object with a
+   fragment shader, and tests against a copy of the depth buffer. */
+SbBool
+coin_glglue_can_do_weightedblend(const cc_glglue * glue)
+{
+  if (!glglue_allow_newer_opengl(glue)) return FALSE;
+  return
+    glue->has_fbo &&
+    glue->has_arb_shader_objects &&
+    cc_glglue_glext_supported(glue, "GL_ARB_fragment_shader") &&
+    glue->has_depth_texture &&
+    (glue->max_draw_buffers >= 2) &&
+    (cc_glglue_glversion_matches_at_least(glue, 3, 0, 0) ||
+     cc_glglue_glext_supported(glue, "GL_ARB_texture_float"));
+}
+
+/* Instanced rendering draws the vertex arrays of a shape once per
+   instance, with a vertex shader transforming them by a matrix from a
+   per-instance vertex attribute array. */
+SbBool
+coin_glglue_can_do_instancing(const cc_glglue * glue)
+{
+  if (!glglue_allow_newer_opengl(glue)) return FALSE;
+  return
+    glue->has_arb_shader_objects &&
+    glue->has_arb_vertex_shader &&
+    cc_glglue_has_vertex_buffer_object(glue) &&
+    (glue->glVertexAttribPointerARB != NULL) &&
+    (glue->glDrawElementsInstanced != NULL) &&
+    (glue->glVertexAttribDivisor != NULL);
+}
+
 void
 cc_glglue_glGenerateMipmap(const cc_glglue * glue, GLenum target)
 {
@@ -227,6 +227,13 @@ typedef void *(APIENTRY * COIN_PFNGLBLENDEQUATIONPROC)(GLenum);
 /* Typedef for glBlendFuncSeparate */
 typedef void *(APIENTRY * COIN_PFNGLBLENDFUNCSEPARATEPROC)(GLenum, GLenum, GLenum, GLenum);
 
+/* Typedef for glDrawBuffers[ARB] */
+typedef void (APIENTRY * COIN_PFNGLDRAWBUFFERSPROC)(GLsizei n, const GLenum * bufs);
+
+/* Typedefs for instanced rendering */
+typedef void (APIENTRY * COIN_PFNGLDRAWELEMENTSINSTANCEDPROC)(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices, GLsizei primcount);
+typedef void (APIENTRY * COIN_PFNGLVERTEXATTRIBDIVISORPROC)(GLuint index, GLuint divisor);
+
 /* typedefs for OpenGL vertex arrays */
 typedef void (APIENTRY * COIN_PFNGLVERTEXPOINTERPROC)(GLint size, GLenum type, GLsizei stride, const GLvoid * pointer);
 typedef void (APIENTRY * COIN_PFNGLTEXCOORDPOINTERPROC)(GLint size, GLenum type, GLsizei stride, const GLvoid * pointer);
@@ -646,6 +653,12 @@ struct cc_glglue {
 
   COIN_PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
 
+  COIN_PFNGLDRAWBUFFERSPROC glDrawBuffers;
+  int max_draw_buffers;
+
+  COIN_PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+  COIN_PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+
   COIN_PFNGLVERTEXPOINTERPROC glVertexPointer;
   COIN_PFNGLTEXCOORDPOINTERPROC glTexCoordPointer;
   COIN_PFNGLNORMALPOINTERPROC glNormalPointer;
@@ -946,6 +959,8 @@ GLenum coin_glglue_get_texture_format(const cc_glglue * glw, int numcomponents);
 SbBool coin_glglue_vbo_in_displaylist_supported(const cc_glglue * glw);
 SbBool coin_glglue_non_power_of_two_textures(const cc_glglue * glue);
 SbBool coin_glglue_has_generate_mipmap(const cc_glglue * glue);
+SbBool coin_glglue_can_do_weightedblend(const cc_glglue * glue);
+SbBool coin_glglue_can_do_instancing(const cc_glglue * glue);
 
 /* context creation callback */
 typedef void coin_glglue_instance_created_cb(const uint32_t contextid, void * closure);
@@ -129,6 +129,7 @@
 #include "coindefs.h" // COIN_STUB(), COIN_OBSOLETED()
 #include "io/SoInputP.h"
 #include "io/SoInput_FileInfo.h"
+#include "io/SoInput_Prefetcher.h"
 
 // This (POSIX-compliant) macro is missing from the Win32 API header
 // files for MSVC++ 6.0.
@@ -506,6 +507,7 @@ SoInput::openFile(const char * fileName, SbBool okIfNotFound)
     this->filestack.insert(newfile, 0);
 
     SoInput::addDirectoryFirst(SoInput::getPathname(fullname).getString());
+    PRIVATE(this)->startPrefetching();
     return TRUE;
   }
 
@@ -550,7 +552,11 @@ SoInput::pushFile(const char * filename)
   SbString fullname;
   FILE * fp = this->findFile(filename, fullname);
   if (fp) {
-    SoInput_Reader * reader = SoInput_Reader::createReader(fp, fullname);
+    SoInput_Reader * reader = NULL;
+    if (PRIVATE(this)->prefetcher) {
+      reader = PRIVATE(this)->prefetcher->createReader(fp, fullname);
+    }
+    if (reader == NULL) { reader = SoInput_Reader::createReader(fp, fullname); }
     SoInput_FileInfo * newfile =
       new SoInput_FileInfo(reader, PRIVATE(this)->copied_references);
     this->filestack.insert(newfile, 0);
@@ -588,6 +594,51 @@ SoInput::closeFile(void)
     delete this->getTopOfStack();
     this->filestack.remove(0);
   }
+  PRIVATE(this)->stopPrefetching();
+}
+
+/*!
+  Sets the number of worker threads used to load the files referenced
+  from SoFile and SoVRMLInline nodes in advance, while the file opened
+  with openFile() is being parsed. The files are still parsed one at
+  a time, in the same order as without prefetching, so the resulting
+  scene graph is the same. Prefetching helps when a scene is split
+  over many files, and reading the files takes a considerable part of
+  the loading time -- e.g. on network file systems.
+
+  Only uncompressed files are prefetched, and only sub-files of ASCII
+  files are found. Set \a numthreads to 0 to disable prefetching.
+
+  The default value is taken from the COIN_SOINPUT_PREFETCH_THREADS
+  environment variable, and is 0 if it isn't set. Prefetching is only
+  done if Coin was built with thread support.
+
+  \sa getNumPrefetchThreads(), pushFile()
+  \since Coin 4.1
+*/
+void
+SoInput::setNumPrefetchThreads(const int numthreads)
+{
+  const int old = this->getNumPrefetchThreads();
+  PRIVATE(this)->numprefetchthreads = SbMax(numthreads, 0);
+  if (PRIVATE(this)->numprefetchthreads != old) {
+    PRIVATE(this)->startPrefetching();
+  }
+}
+
+/*!
+  Returns the number of worker threads used to prefetch sub-files.
+
+  \sa setNumPrefetchThreads()
+  \since Coin 4.1
+*/
+int
+SoInput::getNumPrefetchThreads(void) const
+{
+  if (PRIVATE(this)->numprefetchthreads < 0) {
+    PRIVATE(this)->numprefetchthreads = SoInput_Prefetcher::getDefaultNumThreads();
+  }
+  return PRIVATE(this)->numprefetchthreads;
 }
 
 /*!
@@ -1457,9 +1508,17 @@ SbBool
 SoInput::readBinaryArray(int32_t * l, int length)
 {
   assert(length > 0);
-  if (!this->checkHeader() ||
-      !this->getTopOfStack()->getChunkOfBytes((unsigned char *)l,
-                                              length * sizeof(int32_t)))
+  if (!this->checkHeader()) return FALSE;
+
+  // convert straight from the read buffer when possible
+  SoInput_FileInfo * fi = this->getTopOfStack();
+  const char * direct = fi->getDirectChunk(length * sizeof(int32_t));
+  if (direct) {
+    coin_ntoh_uint32_array(direct, l, length);
+    return TRUE;
+  }
+
+  if (!fi->getChunkOfBytes((unsigned char *)l, length * sizeof(int32_t)))
     return FALSE;
 
   this->convertInt32Array((char *)l, l, length);
@@ -1475,9 +1534,17 @@ SbBool
 SoInput::readBinaryArray(float * f, int length)
 {
   assert(length > 0);
-  if (!this->checkHeader() ||
-      !this->getTopOfStack()->getChunkOfBytes((unsigned char *)f,
-                                              length * sizeof(float)))
+  if (!this->checkHeader()) return FALSE;
+
+  // convert straight from the read buffer when possible
+  SoInput_FileInfo * fi = this->getTopOfStack();
+  const char * direct = fi->getDirectChunk(length * sizeof(float));
+  if (direct) {
+    coin_ntoh_uint32_array(direct, f, length);
+    return TRUE;
+  }
+
+  if (!fi->getChunkOfBytes((unsigned char *)f, length * sizeof(float)))
     return FALSE;
 
   this->convertFloatArray((char *)f, f, length);
@@ -2362,11 +2429,7 @@ SoInput::convertShortArray(char * from, short * to, int len)
 void
 SoInput::convertInt32Array(char * from, int32_t * to, int len)
 {
-  for (int i=0; i < len; i++) {
-    this->convertInt32(from, to);
-    from += sizeof(int32_t);
-    to++;
-  }
+  coin_ntoh_uint32_array(from, to, len);
 }
 
 /*!
@@ -2378,11 +2441,7 @@ SoInput::convertInt32Array(char * from, int32_t * to, int len)
 void
 SoInput::convertFloatArray(char * from, float * to, int len)
 {
-  for (int i=0; i < len; i++) {
-    this->convertFloat(from, to);
-    from += sizeof(float);
-    to++;
-  }
+  coin_ntoh_uint32_array(from, to, len);
 }
 
 /*!
@@ -2394,11 +2453,7 @@ SoInput::convertFloatArray(char * from, float * to, int len)
 void
 SoInput::convertDoubleArray(char * from, double * to, int len)
 {
-  for (int i=0; i < len; i++) {
-    this->convertDouble(from, to);
-    from += sizeof(double);
-    to++;
-  }
+  coin_ntoh_uint64_array(from, to, len);
 }
 
 /*!
@@ -39,6 +39,7 @@
 
 #include "io/SoInputP.h"
 #include "io/SoInput_FileInfo.h"
+#include "io/SoInput_Prefetcher.h"
 
 // *************************************************************************
 
@@ -64,6 +65,33 @@ SoInputP::debugBinary(void)
   return debug ? TRUE : FALSE;
 }
 
+// Starts prefetching the sub-files of the file opened with
+// SoInput::openFile(), if prefetching is enabled.
+void
+SoInputP::startPrefetching(void)
+{
+  this->stopPrefetching();
+
+  const int numthreads = this->owner->getNumPrefetchThreads();
+  const int numfiles = this->owner->filestack.getLength();
+  if ((numthreads <= 0) || (numfiles == 0)) return;
+
+  SoInput_FileInfo * root = this->owner->filestack[numfiles - 1];
+  if (root->isMemBuffer() || (root->ivFilePointer() == coin_get_stdin()) ||
+      (root->ivFilename().getLength() == 0)) return;
+
+  this->prefetcher = new SoInput_Prefetcher(root->ivFilename(),
+                                            SoInput::getDirectories(),
+                                            numthreads);
+}
+
+void
+SoInputP::stopPrefetching(void)
+{
+  delete this->prefetcher;
+  this->prefetcher = NULL;
+}
+
 // *************************************************************************
 /*
   Important note: Up until Coin 3.1.1 we used to have a bug in SoInput
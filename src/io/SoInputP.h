@@ -43,6 +43,7 @@
 
 class SoInput;
 class SoInput_FileInfo;
+class SoInput_Prefetcher;
 
 // *************************************************************************
 
@@ -51,6 +52,8 @@ public:
   SoInputP(SoInput * owner) {
     this->owner = owner;
     this->usingstdin = FALSE;
+    this->prefetcher = NULL;
+    this->numprefetchthreads = -1;
   }
 
   static SbBool debug(void);
@@ -58,6 +61,9 @@ public:
 
   SoInput_FileInfo * getTopOfStackPopOnEOF(void);
 
+  void startPrefetching(void);
+  void stopPrefetching(void);
+
   static SbBool isNameStartChar(unsigned char c, SbBool validIdent);
   static SbBool isNameChar(unsigned char c, SbBool validIdent);
   static SbBool isNameStartCharVRML1(unsigned char c, SbBool validIdent);
@@ -67,6 +73,9 @@ public:
 
   SbBool usingstdin;
 
+  SoInput_Prefetcher * prefetcher;
+  int numprefetchthreads;
+
   SbHash<const char *, SoBase *> copied_references;
 
 private:
@@ -32,8 +32,9 @@
 
 #include "io/SoInput_FileInfo.h"
 
+#include <cfloat> // FLT_EVAL_METHOD
+#include <cstdlib>
 #include <cstring>
-#include <cmath> // pow()
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -54,6 +55,169 @@ const unsigned int READBUFSIZE = 65536*2;
 
 // *************************************************************************
 
+// Number parsing. SoInput_FileInfo::readInteger(), readUnsignedInteger()
+// and readReal() first try to scan the number directly in the read
+// buffer, and only go through get() and putBack() one character at a
+// time if the number isn't completely inside the buffer. The syntax
+// accepted is the same in both cases.
+
+// Returns the length of the integer at \a s, with the syntax of
+// SoInput_FileInfo::readUnsignedIntegerString(), optionally preceded
+// by a sign. Returns 0 if there is no valid integer, or if it might
+// continue past \a end.
+static size_t
+soinput_scan_integer(const char * s, const char * end, const SbBool sign)
+{
+  const char * p = s;
+  if (sign && (p < end) && ((*p == '-') || (*p == '+'))) p++;
+
+  const char * digits = p;
+  if ((p + 1 < end) && (p[0] == '0') && (p[1] == 'x')) {
+    p += 2;
+    digits = p;
+    while ((p < end) && isxdigit((unsigned char) *p)) p++;
+  }
+  else {
+    while ((p < end) && (*p >= '0') && (*p <= '9')) p++;
+  }
+  if ((p == digits) || (p == end)) return 0;
+  return p - s;
+}
+
+// Converts the integer at \a s, as found by soinput_scan_integer(),
+// the same way strtol() / strtoul() with base 0 would. Short decimal
+// numbers are converted directly.
+static long
+soinput_convert_integer(const char * s, const size_t len, const SbBool issigned)
+{
+  const SbBool sign = (s[0] == '-') || (s[0] == '+');
+  const char * digits = sign ? s + 1 : s;
+  const size_t numdigits = len - (sign ? 1 : 0);
+
+  // no octal or hexadecimal numbers, and no overflow
+  if ((numdigits <= 9) && ((digits[0] != '0') || (numdigits == 1))) {
+    long value = 0;
+    for (size_t i = 0; i < numdigits; i++) { value = value * 10 + (digits[i] - '0'); }
+    return (s[0] == '-') ? -value : value;
+  }
+
+  SbString str(s, 0, int(len) - 1);
+  if (issigned) { return strtol(str.getString(), NULL, 0); }
+  return (long) strtoul(str.getString(), NULL, 0);
+}
+
+// Returns the length of the real number at \a s, with the syntax of
+// SoInput_FileInfo::readReal(). Returns 0 if there is no valid number,
+// or if it might continue past \a end.
+static size_t
+soinput_scan_real(const char * s, const char * end)
+{
+  const char * p = s;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) p++;
+
+  int numdigits = 0;
+  while ((p < end) && (*p >= '0') && (*p <= '9')) { p++; numdigits++; }
+  if ((p < end) && (*p == '.')) {
+    p++;
+    while ((p < end) && (*p >= '0') && (*p <= '9')) { p++; numdigits++; }
+  }
+  if (numdigits == 0) return 0;
+
+  if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+    p++;
+    if ((p < end) && ((*p == '-') || (*p == '+'))) p++;
+    const char * exponent = p;
+    while ((p < end) && (*p >= '0') && (*p <= '9')) p++;
+    if (p == exponent) return 0;
+  }
+  if (p == end) return 0;
+  return p - s;
+}
+
+// Converts a real number with the syntax of soinput_scan_real() to
+// the closest double. When the significant digits fit in 53 bits and
+// the power of ten is exactly representable, one multiplication or
+// division gives the correctly rounded result. Other numbers are
+// rare in practice, and are converted with strtod() in the "C"
+// locale.
+static double
+soinput_convert_real(const char * s, const size_t len)
+{
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char * p = s;
+  const char * end = s + len;
+  SbBool minus = FALSE;
+  if ((*p == '-') || (*p == '+')) { minus = (*p == '-'); p++; }
+
+  uint64_t mantissa = 0;
+  int numdigits = 0;
+  int exp10 = 0;
+  SbBool truncated = FALSE;
+  for (; (p < end) && (*p >= '0') && (*p <= '9'); p++) {
+    if (numdigits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa) numdigits++;
+    }
+    else {
+      exp10++;
+      truncated = truncated || (*p != '0');
+    }
+  }
+  if ((p < end) && (*p == '.')) {
+    for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++) {
+      if (numdigits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) numdigits++;
+        exp10--;
+      }
+      else {
+        truncated = truncated || (*p != '0');
+      }
+    }
+  }
+  if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+    p++;
+    SbBool expminus = FALSE;
+    if ((*p == '-') || (*p == '+')) { expminus = (*p == '-'); p++; }
+    int exponent = 0;
+    for (; (p < end) && (*p >= '0') && (*p <= '9'); p++) {
+      if (exponent < 100000) exponent = exponent * 10 + (*p - '0');
+    }
+    exp10 += expminus ? -exponent : exponent;
+  }
+
+  double value;
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD != 0) && (FLT_EVAL_METHOD != 1)
+  // extended precision intermediates (x87) break the exact rounding
+  const SbBool exact = FALSE;
+#else
+  const SbBool exact = TRUE;
+#endif
+  if (mantissa == 0) {
+    value = 0.0;
+  }
+  else if (exact && !truncated && (mantissa <= (((uint64_t) 1) << 53)) &&
+           (exp10 >= -22) && (exp10 <= 22)) {
+    value = (double) mantissa;
+    if (exp10 < 0) value /= pow10[-exp10];
+    else value *= pow10[exp10];
+  }
+  else {
+    SbString str(s, 0, int(len) - 1);
+    cc_string storedlocale;
+    SbBool changed = coin_locale_set_portable(&storedlocale);
+    value = strtod(str.getString(), NULL);
+    if (changed) { coin_locale_reset(&storedlocale); }
+    return value;
+  }
+  return minus ? -value : value;
+}
+
+// *************************************************************************
+
 SoInput_FileInfo::SoInput_FileInfo(SoInput_Reader * readerptr,
                                    const SbHash<const char *, SoBase *> & refs)
   : references(refs)
@@ -71,8 +235,10 @@ SoInput_FileInfo::SoInput_FileInfo(SoInput_Reader * readerptr,
   this->threadbufidx = 0;
   this->threadeof = FALSE;
   this->readbuf = NULL;
+  this->readbufstorage = NULL;
 #else // HAVE_THREADS && SOINPUT_ASYNC_IO
-  this->readbuf = new char[READBUFSIZE];
+  this->readbufstorage = NULL;
+  this->readbuf = NULL;
 #endif // !(HAVE_THREADS && SOINPUT_ASYNC_IO)
   this->readbuflen = 0;
   this->readbufidx = 0;
@@ -110,7 +276,7 @@ SoInput_FileInfo::~SoInput_FileInfo()
   delete[] this->threadbuf[0];
   delete[] this->threadbuf[1];
 #else // HAVE_THREADS && SOINPUT_ASYNC_IO
-  delete[] this->readbuf;
+  delete[] this->readbufstorage;
 #endif // !(HAVE_THREADS && SOINPUT_ASYNC_IO)
   delete this->reader;
   // to be safe, delete this after deleting the reader
@@ -181,7 +347,21 @@ SoInput_FileInfo::doBufferRead(void)
 
 #else // HAVE_THREADS && SOINPUT_ASYNC_IO
 
-  size_t len = this->getReader()->readBuffer(this->readbuf, READBUFSIZE);
+  // readers with all data in memory hand it over in one go, so the
+  // data is never copied into the read buffer
+  SoInput_Reader * reader = this->getReader();
+  const char * direct = NULL;
+  size_t len = 0;
+  if (reader->readDirect(direct, len)) {
+    if (len > 0) { this->readbuf = direct; }
+  }
+  else {
+    if (this->readbufstorage == NULL) {
+      this->readbufstorage = new char[READBUFSIZE];
+    }
+    len = reader->readBuffer(this->readbufstorage, READBUFSIZE);
+    this->readbuf = this->readbufstorage;
+  }
   if (len == 0) {
     this->readbufidx = 0;
     this->readbuflen = 0;
@@ -215,9 +395,13 @@ SoInput_FileInfo::getChunkOfBytes(unsigned char * ptr, size_t length)
 
   do {
     // Grab bytes from the buffer.
-    while ((this->readbufidx < this->readbuflen) && (length > 0)) {
-      *ptr++ = this->readbuf[this->readbufidx++];
-      --length;
+    size_t n = this->readbuflen - this->readbufidx;
+    if (n > length) { n = length; }
+    if (n > 0) {
+      memcpy(ptr, this->readbuf + this->readbufidx, n);
+      this->readbufidx += n;
+      ptr += n;
+      length -= n;
     }
 
     // Fetch more bytes if necessary. doBufferRead() sets the eof-flag
@@ -229,6 +413,23 @@ SoInput_FileInfo::getChunkOfBytes(unsigned char * ptr, size_t length)
   return !this->eof;
 }
 
+// Returns a pointer to the next length bytes and skips past them, if
+// they are all available in the read buffer. Returns NULL otherwise,
+// and getChunkOfBytes() must be used instead. This avoids copying
+// large binary arrays when the complete file is in memory.
+const char *
+SoInput_FileInfo::getDirectChunk(size_t length)
+{
+  if ((this->readbufidx == 0) && (this->backbuffer.getLength() > 0)) {
+    return NULL;
+  }
+  if ((this->readbuflen - this->readbufidx) < length) { return NULL; }
+
+  const char * chunk = this->readbuf + this->readbufidx;
+  this->readbufidx += length;
+  return chunk;
+}
+
 void
 SoInput_FileInfo::addReference(const SbName & name, SoBase * base,
                                SbBool /* addToGlobalDict */) // FIXME: why the unused arg?
@@ -348,6 +549,8 @@ SoInput_FileInfo::skipWhiteSpace(void)
   const char COMMENT_CHAR = '#';
 
   while (TRUE) {
+    if (this->skipBufferedWhiteSpace()) return TRUE;
+
     char c;
     SbBool gotchar;
     while ((gotchar = this->get(c)) && this->isSpace(c)) ;
@@ -371,6 +574,64 @@ SoInput_FileInfo::skipWhiteSpace(void)
   return TRUE;
 }
 
+// Skips whitespace directly in the read buffer, with the same line
+// counting as get(). Returns TRUE if the next character in the buffer
+// starts a token, i.e. it's not whitespace or a comment.
+SbBool
+SoInput_FileInfo::skipBufferedWhiteSpace(void)
+{
+  const char * start, * end;
+  if (!this->getBufferedChars(start, end)) return FALSE;
+
+  const char * p = start;
+  int lastc = this->lastchar;
+  while ((p < end) && this->isSpace(*p)) {
+    const char c = *p++;
+    if ((c == '\r') || ((c == '\n') && (lastc != '\r'))) this->linenr++;
+    lastc = c;
+  }
+  this->readbufidx += p - start;
+
+  if ((p < end) && (*p != '#')) {
+    // same state as after reading and putting back the character
+    this->lastputback = (int) *p;
+    this->lastchar = -1;
+    return TRUE;
+  }
+  if (p > start) {
+    this->lastchar = lastc;
+    this->lastputback = -1;
+  }
+  return FALSE;
+}
+
+// Points start and end at the characters remaining in the read
+// buffer. Returns FALSE if there are none, or if characters have been
+// put back in front of them.
+SbBool
+SoInput_FileInfo::getBufferedChars(const char *& start, const char *& end) const
+{
+  if (((this->readbufidx == 0) && (this->backbuffer.getLength() > 0)) ||
+      (this->readbufidx >= this->readbuflen)) {
+    return FALSE;
+  }
+  start = this->readbuf + this->readbufidx;
+  end = this->readbuf + this->readbuflen;
+  return TRUE;
+}
+
+// Skips a token of len characters without line breaks in the read
+// buffer. The state is left the same as after reading the token with
+// get(), and then reading and putting back the next character.
+void
+SoInput_FileInfo::skipBufferedChars(const size_t len)
+{
+  assert(this->readbufidx + len < this->readbuflen);
+  this->readbufidx += len;
+  this->lastputback = (int) this->readbuf[this->readbufidx];
+  this->lastchar = -1;
+}
+
 // Returns TRUE if an attempt at reading the file header went
 // without hitting EOF. Check this->ivversion != 0.0f to see if the
 // header parse actually succeeded.
@@ -519,6 +780,17 @@ SbBool
 SoInput_FileInfo::readUnsignedInteger(uint32_t & l)
 {
   assert(!this->isBinary());
+
+  const char * start, * end;
+  if (this->getBufferedChars(start, end)) {
+    const size_t len = soinput_scan_integer(start, end, FALSE);
+    if (len > 0) {
+      l = (uint32_t) soinput_convert_integer(start, len, FALSE);
+      this->skipBufferedChars(len);
+      return TRUE;
+    }
+  }
+
   // FIXME: fixed size buffer for input of unknown
   // length. Ouch. 19990530 mortene.
   char str[512];
@@ -537,56 +809,27 @@ SbBool
 SoInput_FileInfo::readInteger(int32_t & l)
 {
   assert(!this->isBinary());
+
+  const char * start, * end;
+  if (this->getBufferedChars(start, end)) {
+    const size_t len = soinput_scan_integer(start, end, TRUE);
+    if (len > 0) {
+      l = (int32_t) soinput_convert_integer(start, len, TRUE);
+      this->skipBufferedChars(len);
+      return TRUE;
+    }
+  }
+
   // FIXME: fixed size buffer for input of unknown
   // length. Ouch. 19990530 mortene.
   char str[512];
   char * s = str;
-  SbBool minus = FALSE;
-  if (this->readChar(s, '-')) {
-    minus = TRUE;
-    s++;
-  }
+  if (this->readChar(s, '-')) s++;
   else if (this->readChar(s, '+')) s++;
   if (! this->readUnsignedIntegerString(s))
     return FALSE;
 
-  // FIXME: check man page of strtol and exploit the functionality
-  // provided better -- it looks like we are duplicating some of the
-  // effort. 19990530 mortene.
-#if 1 // old code
-  l = strtol(str, NULL, 0);
-#else // first version of replacement of strtol. Not activated yet
-  int i, n = strlen(s);
-  if (n >= 3 && s[0] == '0' && s[1] == 'x') {
-    int v = 0;
-    int mul = 1;
-    for (i = 2; i < n; i++) {
-      char c = s[(n-1)-i+2];
-      if (c >= '0' && c <= '9') {
-        v += (c-'0') * mul;
-      }
-      else if (c >= 'a' && c <= 'f') {
-        v += ((c-'a')+10) * mul;
-      }
-      else {
-        v += ((c-'A')+10) * mul;
-      }
-      mul <<= 4;
-    }
-    l = v;
-  }
-  else {
-    int v = 0;
-    int mul = 1;
-    for (i = 0; i < n; i++) {
-      char c = s[(n-1)-i];
-      v += (c-'0') * mul;
-      mul *= 10;
-    }
-    l = v;
-  }
-  if (minus) l = -l;
-#endif // strtol replacement
+  l = (int32_t) soinput_convert_integer(str, strlen(str), TRUE);
   return TRUE;
 }
 
@@ -594,46 +837,36 @@ SbBool
 SoInput_FileInfo::readReal(double & d)
 {
   assert(!this->isBinary());
+
+  const char * start, * end;
+  if (this->getBufferedChars(start, end)) {
+    const size_t len = soinput_scan_real(start, end);
+    if (len > 0) {
+      d = soinput_convert_real(start, len);
+      this->skipBufferedChars(len);
+      return TRUE;
+    }
+  }
+
   const int BUFSIZE = 2048;
-  SbBool minus = FALSE;
   SbBool gotNum = FALSE;
-  int i, n;
+  int n;
   char str[BUFSIZE];
   char * s = str;
 
-  double number;
-  double exponent;
-
   n = this->readChar(s, '-');
-  if (n == 0) {
-    n = this->readChar(s, '+');
-  }
-  else minus = TRUE;
+  if (n == 0) n = this->readChar(s, '+');
   s += n;
 
   if ((n = this->readDigits(s)) > 0) {
     gotNum = TRUE;
-    number = 0.0;
-    double mul = 1.0;
-    for (i = 0; i < n; i++) {
-      number += (s[(n-1)-i] - '0') * mul;
-      mul *= 10.0;
-    }
     s += n;
   }
-  else {
-    number = 0.0;
-  }
   if (this->readChar(s, '.') > 0) {
     s++;
 
     if ((n = this->readDigits(s)) > 0) {
       gotNum = TRUE;
-      double mul = 0.1;
-      for (i = 0; i < n; i++) {
-        number += (s[i]-'0') * mul;
-        mul *= 0.1;
-      }
       s += n;
     }
   }
@@ -641,8 +874,6 @@ SoInput_FileInfo::readReal(double & d)
   if (! gotNum)
     return FALSE;
 
-  if (minus) number = -number;
-
   n = this->readChar(s, 'e');
   if (n == 0)
     n = this->readChar(s, 'E');
@@ -650,30 +881,15 @@ SoInput_FileInfo::readReal(double & d)
   if (n > 0) {
     s += n;
 
-    minus = FALSE;
     n = this->readChar(s, '-');
-    if (n == 0) {
-      n = this->readChar(s, '+');
-    }
-    else minus = TRUE;
+    if (n == 0) n = this->readChar(s, '+');
     s += n;
 
-    if ((n = this->readDigits(s)) > 0) {
-      exponent = 0.0;
-      double mul = 1.0;
-      for (i = 0; i < n; i++) {
-        exponent += (s[(n-1)-i]-'0') * mul;
-        mul *= 10.0;
-      }
-      if (minus) exponent = -exponent;
-
-      number *= pow(10.0, exponent);
-    }
-    else
-      return FALSE;
+    if ((n = this->readDigits(s)) > 0) s += n;
+    else return FALSE;
   }
 
-  d = number;
+  d = soinput_convert_real(str, s - str);
   return TRUE;
 }
 
@@ -79,6 +79,7 @@ public:
   size_t getNumBytesParsedSoFar(void) const;
 
   SbBool getChunkOfBytes(unsigned char * ptr, size_t length);
+  const char * getDirectChunk(size_t length);
   SbBool get(char & c);
 
   void putBack(const char c);
@@ -210,6 +211,10 @@ public:
   SbBool readInteger(int32_t & l);
   SbBool readReal(double & d);
 
+  SbBool skipBufferedWhiteSpace(void);
+  SbBool getBufferedChars(const char *& start, const char *& end) const;
+  void skipBufferedChars(const size_t len);
+
   const SbHash<const char *, SoBase *> & getReferences() const {
     return this->references;
   }
@@ -228,7 +233,10 @@ private:
   void * userdata;
   SbBool isbinary;
 
-  char * readbuf;
+  // points into readbufstorage, or directly to the data of readers
+  // which have everything in memory
+  const char * readbuf;
+  char * readbufstorage;
   size_t readbufidx;
   size_t readbuflen;
   size_t totalread;
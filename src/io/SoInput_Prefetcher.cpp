@@ -0,0 +1,489 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#include "io/SoInput_Prefetcher.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/stat.h>
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif // HAVE_SYS_TYPES_H
+
+#include <Inventor/C/tidbits.h>
+#include <Inventor/SoInput.h>
+#include <Inventor/lists/SbStringList.h>
+
+#ifdef HAVE_THREADS
+#include <Inventor/C/threads/condvar.h>
+#include <Inventor/C/threads/mutex.h>
+#include <Inventor/C/threads/thread.h>
+#include <Inventor/C/threads/wpool.h>
+#endif // HAVE_THREADS
+
+#include "io/SoInput_Reader.h"
+
+#ifndef S_ISDIR
+ #ifdef _S_IFDIR
+ #define S_ISDIR(s) ((s) & _S_IFDIR)
+ #else // Ai.
+ #error Can neither find nor make an S_ISDIR macro to test stat structures.
+ #endif // !_S_IFDIR
+#endif // !S_ISDIR
+
+// *************************************************************************
+
+// The workers stop loading files when this much prefetched data is
+// waiting to be parsed, and continue when the parser catches up.
+static const size_t SOINPUT_PREFETCH_MAX_BYTES = 256 * 1024 * 1024;
+
+struct SoInput_Prefetcher::Entry {
+  enum State {
+    QUEUED,
+    LOADING,
+    LOADED,
+    DONE
+  };
+
+  SbString fullname;
+  // the directory search list SoInput will have when the files
+  // referenced from this file are pushed
+  std::vector<SbString> searchdirs;
+  State state;
+  // FALSE if SoInput already read the file by itself, and it's only
+  // loaded to find the files it references
+  SbBool wanted;
+  char * data;
+  size_t datalen;
+  time_t mtime;
+};
+
+// *************************************************************************
+
+// A minimal tokenizer for the ASCII Inventor and VRML formats, which
+// is just good enough to pick the file names out of SoFile and
+// SoVRMLInline nodes. It's fine if it finds a name which isn't used,
+// it will only cause a file to be loaded in vain.
+class SoInput_PrefetchScanner {
+public:
+  enum Token {
+    END,
+    WORD,
+    STRING,
+    OPEN_BRACE,
+    CLOSE_BRACE,
+    OPEN_BRACKET,
+    CLOSE_BRACKET
+  };
+
+  SoInput_PrefetchScanner(const char * data, const size_t datalen)
+    : ptr(data), end(data + datalen), token(NULL), tokenlen(0) { }
+
+  Token next(void) {
+    for (;;) {
+      while ((this->ptr < this->end) &&
+             (isspace((unsigned char) *this->ptr) || (*this->ptr == ','))) {
+        this->ptr++;
+      }
+      if (this->ptr == this->end) return END;
+      if (*this->ptr != '#') break;
+      while ((this->ptr < this->end) && (*this->ptr != '\n') && (*this->ptr != '\r')) {
+        this->ptr++;
+      }
+    }
+
+    this->token = this->ptr;
+    switch (*this->ptr++) {
+    case '{': return OPEN_BRACE;
+    case '}': return CLOSE_BRACE;
+    case '[': return OPEN_BRACKET;
+    case ']': return CLOSE_BRACKET;
+    case '"':
+      this->token = this->ptr;
+      while ((this->ptr < this->end) && (*this->ptr != '"')) {
+        if ((*this->ptr == '\\') && (this->ptr + 1 < this->end)) this->ptr++;
+        this->ptr++;
+      }
+      this->tokenlen = this->ptr - this->token;
+      if (this->ptr < this->end) this->ptr++; // skip the closing '"'
+      return STRING;
+    default:
+      while ((this->ptr < this->end) &&
+             !isspace((unsigned char) *this->ptr) &&
+             !strchr(",{}[]\"#", *this->ptr)) {
+        this->ptr++;
+      }
+      this->tokenlen = this->ptr - this->token;
+      return WORD;
+    }
+  }
+
+  SbBool isWord(const char * word) const {
+    const size_t len = strlen(word);
+    return (this->tokenlen == len) && (strncmp(this->token, word, len) == 0);
+  }
+
+  SbString getString(void) const {
+    SbString s;
+    for (size_t i = 0; i < this->tokenlen; i++) {
+      if ((this->token[i] == '\\') && (i + 1 < this->tokenlen)) i++;
+      s += this->token[i];
+    }
+    return s;
+  }
+
+  // Finds the file names in the ASCII Inventor or VRML file in \a
+  // data. Binary files aren't scanned.
+  static void findFileNames(const char * data, const size_t datalen,
+                            std::vector<SbString> & names) {
+    if ((datalen == 0) || (data[0] != '#')) return;
+    const char * eol = data;
+    while ((eol < data + datalen) && (*eol != '\n') && (*eol != '\r')) eol++;
+    const SbString header(data, 0, int(eol - data) - 1);
+    if (header.find("binary") != -1) return;
+
+    SoInput_PrefetchScanner scanner(data, datalen);
+    Token t = scanner.next();
+    while (t != END) {
+      const char * fieldname = NULL;
+      if (t == WORD) {
+        if (scanner.isWord("File")) fieldname = "name";
+        else if (scanner.isWord("Inline")) fieldname = "url";
+      }
+      t = scanner.next();
+      if (!fieldname || (t != OPEN_BRACE)) continue;
+
+      int depth = 1;
+      while ((depth > 0) && ((t = scanner.next()) != END)) {
+        if (t == OPEN_BRACE) depth++;
+        else if (t == CLOSE_BRACE) depth--;
+        else if ((depth == 1) && (t == WORD) && scanner.isWord(fieldname)) {
+          t = scanner.next();
+          if (t == OPEN_BRACKET) t = scanner.next();
+          if ((t == STRING) || (t == WORD)) names.push_back(scanner.getString());
+          else if (t == CLOSE_BRACE) depth--;
+        }
+      }
+      if (t != END) t = scanner.next();
+    }
+  }
+
+private:
+  const char * ptr;
+  const char * end;
+  const char * token;
+  size_t tokenlen;
+};
+
+// *************************************************************************
+
+/*!
+  Starts loading the files referenced from \a rootfile on \a numthreads
+  worker threads. \a searchdirs is the current directory search list
+  of SoInput.
+*/
+SoInput_Prefetcher::SoInput_Prefetcher(const SbString & rootfile,
+                                       const SbStringList & searchdirs,
+                                       const int numthreads)
+  : numbytes(0), numactive(0), stop(FALSE), mutex(NULL), cond(NULL), pool(NULL)
+{
+#ifdef HAVE_THREADS
+  if ((numthreads <= 0) || (cc_thread_implementation() == CC_NO_THREADS)) return;
+
+  // The root file is only scanned, as SoInput is already reading it.
+  Entry * root = new Entry;
+  root->fullname = rootfile;
+  for (int i = 0; i < searchdirs.getLength(); i++) {
+    root->searchdirs.push_back(*searchdirs[i]);
+  }
+  root->state = Entry::QUEUED;
+  root->wanted = FALSE;
+  root->data = NULL;
+  root->datalen = 0;
+  root->mtime = 0;
+  this->entries.put(root->fullname, root);
+  this->queue.push_back(root);
+
+  this->mutex = cc_mutex_construct();
+  this->cond = cc_condvar_construct();
+  this->pool = cc_wpool_construct(numthreads);
+  cc_wpool_begin(this->pool, numthreads);
+  for (int i = 0; i < numthreads; i++) {
+    cc_wpool_start_worker(this->pool, SoInput_Prefetcher::workerCB, this);
+  }
+  cc_wpool_end(this->pool);
+#endif // HAVE_THREADS
+}
+
+/*!
+  Stops the worker threads and frees data which wasn't used.
+*/
+SoInput_Prefetcher::~SoInput_Prefetcher()
+{
+#ifdef HAVE_THREADS
+  if (this->pool) {
+    cc_mutex_lock(this->mutex);
+    this->stop = TRUE;
+    cc_condvar_wake_all(this->cond);
+    cc_mutex_unlock(this->mutex);
+
+    cc_wpool_wait_all(this->pool);
+    cc_wpool_destruct(this->pool);
+    cc_condvar_destruct(this->cond);
+    cc_mutex_destruct(this->mutex);
+  }
+#endif // HAVE_THREADS
+
+  for (SbHash<SbString, Entry *>::const_iterator it = this->entries.const_begin();
+       it != this->entries.const_end(); ++it) {
+    free(it->obj->data);
+    delete it->obj;
+  }
+}
+
+/*!
+  Returns a reader for the prefetched contents of \a fullname, as
+  opened by SoInput::findFile() with \a fp, or \c NULL if the file
+  hasn't been prefetched. The reader takes over \a fp.
+
+  If the file is being loaded, this waits for it to finish. If it
+  hasn't been started on yet, the workers will skip it, and the caller
+  is better off reading it itself.
+*/
+SoInput_Reader *
+SoInput_Prefetcher::createReader(FILE * fp, const SbString & fullname)
+{
+#ifdef HAVE_THREADS
+  if (this->pool == NULL) return NULL;
+
+  cc_mutex_lock(this->mutex);
+  Entry * entry = NULL;
+  if (!this->entries.get(fullname, entry)) {
+    cc_mutex_unlock(this->mutex);
+    return NULL;
+  }
+  while (entry->state == Entry::LOADING) {
+    cc_condvar_wait(this->cond, this->mutex);
+  }
+  if (entry->state != Entry::LOADED) {
+    entry->wanted = FALSE;
+    cc_mutex_unlock(this->mutex);
+    return NULL;
+  }
+
+  char * data = entry->data;
+  const size_t datalen = entry->datalen;
+  const time_t mtime = entry->mtime;
+  entry->data = NULL;
+  entry->state = Entry::DONE;
+  this->numbytes -= datalen;
+  cc_condvar_wake_all(this->cond);
+  cc_mutex_unlock(this->mutex);
+
+  // make sure the file hasn't changed since it was loaded
+  SbBool unchanged = (ftell(fp) == 0);
+#ifdef HAVE_FSTAT
+  struct stat sb;
+  unchanged = unchanged && (fstat(fileno(fp), &sb) == 0) &&
+    ((size_t) sb.st_size == datalen) && (sb.st_mtime == mtime);
+#endif // HAVE_FSTAT
+  if (!unchanged) {
+    free(data);
+    return NULL;
+  }
+  return new SoInput_PrefetchedFileReader(fullname.getString(), fp, data, datalen);
+#else // ! HAVE_THREADS
+  return NULL;
+#endif // ! HAVE_THREADS
+}
+
+/*!
+  Returns the number of worker threads to use when it hasn't been set
+  with SoInput::setNumPrefetchThreads(). Set by the
+  COIN_SOINPUT_PREFETCH_THREADS environment variable, 0 by default.
+*/
+int
+SoInput_Prefetcher::getDefaultNumThreads(void)
+{
+  const char * env = coin_getenv("COIN_SOINPUT_PREFETCH_THREADS");
+  return env ? atoi(env) : 0;
+}
+
+void
+SoInput_Prefetcher::workerCB(void * closure)
+{
+  static_cast<SoInput_Prefetcher *>(closure)->runWorker();
+}
+
+// Loads files until the queue is empty and no other worker can add
+// more files to it, or until the prefetcher is destructed.
+void
+SoInput_Prefetcher::runWorker(void)
+{
+#ifdef HAVE_THREADS
+  cc_mutex_lock(this->mutex);
+  for (;;) {
+    while (!this->stop) {
+      // either done, or a file can be loaded without going over the
+      // memory limit
+      if (this->queue.empty() ? (this->numactive == 0) :
+          (this->numbytes < SOINPUT_PREFETCH_MAX_BYTES)) break;
+      cc_condvar_wait(this->cond, this->mutex);
+    }
+    if (this->stop || this->queue.empty()) break;
+
+    Entry * entry = this->queue.front();
+    this->queue.pop_front();
+    entry->state = Entry::LOADING;
+    this->numactive++;
+    cc_mutex_unlock(this->mutex);
+
+    // Find the referenced files the same way SoInput::findFile()
+    // does, so the names match what SoInput will look them up with.
+    std::vector<SbString> names, found;
+    char * data = NULL;
+    size_t datalen = 0;
+    const SbBool ok = SoInput_Prefetcher::loadFile(entry, data, datalen);
+    if (ok) { SoInput_PrefetchScanner::findFileNames(data, datalen, names); }
+    for (size_t i = 0; i < names.size(); i++) {
+      const char * basename = names[i].getString();
+      if (basename[0] == '\0') continue;
+      for (size_t d = 0; d <= entry->searchdirs.size(); d++) {
+        SbString n = (d == 0) ? SbString("") : entry->searchdirs[d - 1];
+        const int namelen = n.getLength();
+        if ((namelen && n[namelen - 1] != '/' && n[namelen - 1] != '\\') &&
+            (basename[0] != '/' && basename[0] != '\\')) {
+          n += "/";
+        }
+        n += basename;
+
+        struct stat buf;
+        if ((stat(n.getString(), &buf) == 0) && !S_ISDIR(buf.st_mode)) {
+          found.push_back(n);
+          break;
+        }
+      }
+    }
+
+    cc_mutex_lock(this->mutex);
+    this->numactive--;
+    if (ok && entry->wanted) {
+      entry->data = data;
+      entry->datalen = datalen;
+      entry->state = Entry::LOADED;
+      this->numbytes += datalen;
+    }
+    else {
+      free(data);
+      entry->state = Entry::DONE;
+    }
+
+    // Queue the referenced files first, in file order, so the files
+    // are loaded in about the same order as they are parsed.
+    std::deque<Entry *>::iterator pos = this->queue.begin();
+    for (size_t i = 0; i < found.size(); i++) {
+      Entry * dummy;
+      if (this->entries.get(found[i], dummy)) continue;
+
+      Entry * child = new Entry;
+      child->fullname = found[i];
+      const SbString dir = SoInput::getPathname(found[i]);
+      if (dir.getLength()) child->searchdirs.push_back(dir);
+      child->searchdirs.insert(child->searchdirs.end(),
+                               entry->searchdirs.begin(), entry->searchdirs.end());
+      child->state = Entry::QUEUED;
+      child->wanted = TRUE;
+      child->data = NULL;
+      child->datalen = 0;
+      child->mtime = 0;
+      this->entries.put(child->fullname, child);
+      pos = this->queue.insert(pos, child) + 1;
+    }
+    cc_condvar_wake_all(this->cond);
+  }
+  cc_condvar_wake_all(this->cond);
+  cc_mutex_unlock(this->mutex);
+#endif // HAVE_THREADS
+}
+
+// Reads the complete file into memory. Returns FALSE if the file
+// can't be read, or if it's compressed, as compressed files are left
+// to SoInput.
+SbBool
+SoInput_Prefetcher::loadFile(Entry * entry, char *& data, size_t & datalen)
+{
+  data = NULL;
+  datalen = 0;
+  FILE * fp = fopen(entry->fullname.getString(), "rb");
+  if (fp == NULL) return FALSE;
+
+#ifdef HAVE_FSTAT
+  struct stat sb;
+  if ((fstat(fileno(fp), &sb) != 0) || !(sb.st_mode & S_IFREG) ||
+      ((off_t) (size_t) sb.st_size != sb.st_size)) {
+    fclose(fp);
+    return FALSE;
+  }
+  const size_t size = (size_t) sb.st_size;
+  entry->mtime = sb.st_mtime;
+#else // ! HAVE_FSTAT
+  long end = -1;
+  if (fseek(fp, 0, SEEK_END) == 0) { end = ftell(fp); }
+  if ((end < 0) || (fseek(fp, 0, SEEK_SET) != 0)) {
+    fclose(fp);
+    return FALSE;
+  }
+  const size_t size = (size_t) end;
+#endif // ! HAVE_FSTAT
+
+  data = (char *) malloc(size ? size : 1);
+  const size_t numread = data ? fread(data, 1, size, fp) : 0;
+  fclose(fp);
+
+  const unsigned char * header = (const unsigned char *) data;
+  const SbBool compressed = (numread >= 2) &&
+    (((header[0] == 0x1f) && (header[1] == 0x8b)) || // gzip
+     ((numread >= 3) && (header[0] == 'B') && (header[1] == 'Z') && (header[2] == 'h')));
+  if ((data == NULL) || (numread != size) || compressed) {
+    free(data);
+    data = NULL;
+    return FALSE;
+  }
+  datalen = size;
+  return TRUE;
+}
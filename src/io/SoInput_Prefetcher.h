@@ -0,0 +1,91 @@
+#ifndef COIN_SOINPUT_PREFETCHER_H
+#define COIN_SOINPUT_PREFETCHER_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* ! COIN_INTERNAL */
+
+// *************************************************************************
+
+#include <Inventor/SbString.h>
+#include <Inventor/C/threads/common.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+
+#include "misc/SbHash.h"
+
+class SbStringList;
+class SoInput_Reader;
+
+// *************************************************************************
+
+// Loads the files referenced from SoFile and SoVRMLInline nodes in
+// advance, on worker threads, while the main thread parses the scene
+// graph. Parsing itself is still done sequentially by SoInput, which
+// asks for the prefetched data with createReader() when a sub-file is
+// pushed.
+class SoInput_Prefetcher {
+public:
+  SoInput_Prefetcher(const SbString & rootfile, const SbStringList & searchdirs,
+                     const int numthreads);
+  ~SoInput_Prefetcher();
+
+  SoInput_Reader * createReader(FILE * fp, const SbString & fullname);
+
+  static int getDefaultNumThreads(void);
+
+private:
+  struct Entry;
+
+  static void workerCB(void * closure);
+  void runWorker(void);
+  static SbBool loadFile(Entry * entry, char *& data, size_t & datalen);
+
+  SbHash<SbString, Entry *> entries;
+  std::deque<Entry *> queue;
+  size_t numbytes;
+  int numactive;
+  SbBool stop;
+
+  cc_mutex * mutex;
+  cc_condvar * cond;
+  cc_wpool * pool;
+};
+
+// *************************************************************************
+
+#endif // ! COIN_SOINPUT_PREFETCHER_H
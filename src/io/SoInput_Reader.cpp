@@ -33,6 +33,7 @@
 #include "io/SoInput_Reader.h"
 
 #include <cstring>
+#include <cstdlib>
 #include <cassert>
 #ifdef HAVE_CONFIG_H
 #include <config.h>
@@ -50,11 +51,19 @@
 #include <sys/stat.h>
 #endif
 
+#ifdef HAVE_WINDOWS_H
+#include <windows.h> // CreateFileMapping(), MapViewOfFile()
+#elif defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif // HAVE_MMAP
+
+#include <Inventor/C/tidbits.h>
 #include <Inventor/errors/SoDebugError.h>
 
 #include "io/gzmemio.h"
 #include "glue/zlib.h"
 #include "glue/bzip2.h"
+#include "coindefs.h" // COIN_UNUSED_ARG()
 
 // We don't want to include bzlib.h, so we just define the constants
 // we use here
@@ -91,6 +100,13 @@ SoInput_Reader::getFilePointer(void)
   return NULL;
 }
 
+SbBool
+SoInput_Reader::readDirect(const char *& COIN_UNUSED_ARG(buf),
+                           size_t & COIN_UNUSED_ARG(buflen))
+{
+  return FALSE;
+}
+
 // creates the correct reader based on the file type in fp (will
 // examine the file header). If fullname is empty, it's assumed that
 // file FILE pointer is passed from the user, and that we cannot
@@ -181,6 +197,10 @@ SoInput_Reader::createReader(FILE * fp, const SbString & fullname)
     }
   }
 
+  if ((reader == NULL) && trycompression) {
+    reader = SoInput_MappedFileReader::create(fullname.getString(), fp);
+  }
+
   if (reader == NULL) {
     reader = new SoInput_FileReader(fullname.getString(), fp);
   }
@@ -236,6 +256,208 @@ SoInput_FileReader::getFilePointer(void)
   return this->fp;
 }
 
+//
+// memory mapped file class
+//
+
+// Files smaller than this are read with fread(), as mapping them
+// doesn't make any difference. Can be changed with the
+// COIN_SOINPUT_MMAP_MIN_SIZE environment variable.
+static const long SOINPUT_MMAP_MIN_SIZE = 1024 * 1024;
+
+SoInput_MappedFileReader::SoInput_MappedFileReader(const char * const filenamearg,
+                                                   FILE * filepointer)
+{
+  this->fp = filepointer;
+  this->filename = filenamearg;
+  this->data = NULL;
+  this->datalen = 0;
+  this->datapos = 0;
+  this->maphandle = NULL;
+}
+
+// Maps the file into memory, with the remaining data starting at the
+// current position of the file pointer. Returns NULL if the file is
+// too small or can't be mapped, and the caller should read it with
+// SoInput_FileReader instead.
+SoInput_MappedFileReader *
+SoInput_MappedFileReader::create(const char * const filename, FILE * filepointer)
+{
+  long minsize = SOINPUT_MMAP_MIN_SIZE;
+  const char * env = coin_getenv("COIN_SOINPUT_MMAP_MIN_SIZE");
+  if (env) { minsize = atol(env); }
+  if (minsize < 0) { return NULL; }
+
+#if defined(HAVE_FSTAT) && (defined(HAVE_WINDOWS_H) || defined(HAVE_MMAP))
+  const int fd = fileno(filepointer);
+  struct stat sb;
+  if ((fd < 0) || (fstat(fd, &sb) != 0)) { return NULL; }
+  const long offset = ftell(filepointer);
+  // the file must be addressable, also on 32-bit systems
+  const size_t size = (size_t) sb.st_size;
+  if ((offset < 0) || ((off_t) size != sb.st_size) ||
+      (size < (size_t) minsize) || ((size_t) offset >= size)) {
+    return NULL;
+  }
+
+  const char * data = NULL;
+  void * maphandle = NULL;
+#ifdef HAVE_WINDOWS_H
+  HANDLE file = (HANDLE) _get_osfhandle(fd);
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) { return NULL; }
+  data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL) {
+    CloseHandle(mapping);
+    return NULL;
+  }
+  maphandle = mapping;
+#else // mmap()
+  void * addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) { return NULL; }
+#ifdef MADV_SEQUENTIAL
+  (void) madvise(addr, size, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+  data = (const char *) addr;
+#endif // mmap()
+
+  SoInput_MappedFileReader * reader =
+    new SoInput_MappedFileReader(filename, filepointer);
+  reader->data = data;
+  reader->datalen = size;
+  reader->datapos = (size_t) offset;
+  reader->maphandle = maphandle;
+  return reader;
+#else // no mmap() support
+  return NULL;
+#endif // no mmap() support
+}
+
+SoInput_MappedFileReader::~SoInput_MappedFileReader()
+{
+#ifdef HAVE_WINDOWS_H
+  if (this->data) {
+    UnmapViewOfFile(this->data);
+    CloseHandle((HANDLE) this->maphandle);
+  }
+#elif defined(HAVE_MMAP)
+  if (this->data) { munmap((void *) this->data, this->datalen); }
+#endif // HAVE_MMAP
+
+  // same rules as for SoInput_FileReader
+  if (this->fp &&
+      (this->filename != "<stdin>") &&
+      (this->filename.getLength())) {
+    fclose(this->fp);
+  }
+}
+
+SoInput_Reader::ReaderType
+SoInput_MappedFileReader::getType(void) const
+{
+  return MAPPED_FILE;
+}
+
+size_t
+SoInput_MappedFileReader::readBuffer(char * buffer, const size_t readlen)
+{
+  size_t len = this->datalen - this->datapos;
+  if (len > readlen) len = readlen;
+
+  memcpy(buffer, this->data + this->datapos, len);
+  this->datapos += len;
+
+  return len;
+}
+
+SbBool
+SoInput_MappedFileReader::readDirect(const char *& buffer, size_t & buflen)
+{
+  buffer = this->data + this->datapos;
+  buflen = this->datalen - this->datapos;
+  this->datapos = this->datalen;
+  return TRUE;
+}
+
+const SbString &
+SoInput_MappedFileReader::getFilename(void)
+{
+  return this->filename;
+}
+
+FILE *
+SoInput_MappedFileReader::getFilePointer(void)
+{
+  return this->fp;
+}
+
+//
+// prefetched file class
+//
+
+SoInput_PrefetchedFileReader::SoInput_PrefetchedFileReader(const char * const filenamearg,
+                                                           FILE * filepointer,
+                                                           char * dataarg,
+                                                           size_t datalenarg)
+{
+  this->filename = filenamearg;
+  this->fp = filepointer;
+  this->data = dataarg;
+  this->datalen = datalenarg;
+  this->datapos = 0;
+}
+
+SoInput_PrefetchedFileReader::~SoInput_PrefetchedFileReader()
+{
+  free(this->data);
+
+  // same rules as for SoInput_FileReader
+  if (this->fp &&
+      (this->filename != "<stdin>") &&
+      (this->filename.getLength())) {
+    fclose(this->fp);
+  }
+}
+
+SoInput_Reader::ReaderType
+SoInput_PrefetchedFileReader::getType(void) const
+{
+  return PREFETCHED_FILE;
+}
+
+size_t
+SoInput_PrefetchedFileReader::readBuffer(char * buffer, const size_t readlen)
+{
+  size_t len = this->datalen - this->datapos;
+  if (len > readlen) len = readlen;
+
+  memcpy(buffer, this->data + this->datapos, len);
+  this->datapos += len;
+
+  return len;
+}
+
+SbBool
+SoInput_PrefetchedFileReader::readDirect(const char *& buffer, size_t & buflen)
+{
+  buffer = this->data + this->datapos;
+  buflen = this->datalen - this->datapos;
+  this->datapos = this->datalen;
+  return TRUE;
+}
+
+const SbString &
+SoInput_PrefetchedFileReader::getFilename(void)
+{
+  return this->filename;
+}
+
+FILE *
+SoInput_PrefetchedFileReader::getFilePointer(void)
+{
+  return this->fp;
+}
+
 //
 // standard membuffer class
 //
@@ -269,6 +491,15 @@ SoInput_MemBufferReader::readBuffer(char * buffer, const size_t readlen)
   return len;
 }
 
+SbBool
+SoInput_MemBufferReader::readDirect(const char *& buffer, size_t & len)
+{
+  buffer = this->buf + this->bufpos;
+  len = this->buflen - this->bufpos;
+  this->bufpos = this->buflen;
+  return TRUE;
+}
+
 //
 // gzip readers
 //
@@ -55,7 +55,9 @@ public:
     MEMBUFFER,
     GZFILE,
     BZ2FILE,
-    GZMEMBUFFER
+    GZMEMBUFFER,
+    MAPPED_FILE,
+    PREFETCHED_FILE
   };
 
   // must be overloaded to return type
@@ -65,6 +67,13 @@ public:
   // read or 0 if eof
   virtual size_t readBuffer(char * buf, const size_t readlen) = 0;
 
+  // should be overloaded by readers which have all data in memory,
+  // to avoid copying the data through readBuffer(). Sets buf to point
+  // to the remaining data and buflen to its size (0 at eof), and
+  // returns TRUE. The data must stay valid until the reader is
+  // destructed. Default method returns FALSE.
+  virtual SbBool readDirect(const char *& buf, size_t & buflen);
+
   // should be overloaded to return filename. Default method returns
   // an empty string.
   virtual const SbString & getFilename(void);
@@ -96,6 +105,55 @@ public:
 
 };
 
+class SoInput_MappedFileReader : public SoInput_Reader {
+public:
+  static SoInput_MappedFileReader * create(const char * const filename,
+                                           FILE * filepointer);
+  virtual ~SoInput_MappedFileReader();
+
+  virtual ReaderType getType(void) const;
+  virtual size_t readBuffer(char * buf, const size_t readlen);
+  virtual SbBool readDirect(const char *& buf, size_t & buflen);
+
+  virtual const SbString & getFilename(void);
+  virtual FILE * getFilePointer(void);
+
+public:
+  SbString filename;
+  FILE * fp;
+  const char * data;
+  size_t datalen;
+  size_t datapos;
+  void * maphandle;
+
+private:
+  SoInput_MappedFileReader(const char * const filename, FILE * filepointer);
+};
+
+// Reads a file from a buffer which was loaded in advance by
+// SoInput_Prefetcher. The reader takes over the buffer, which must be
+// allocated with malloc().
+class SoInput_PrefetchedFileReader : public SoInput_Reader {
+public:
+  SoInput_PrefetchedFileReader(const char * const filename, FILE * filepointer,
+                               char * data, size_t datalen);
+  virtual ~SoInput_PrefetchedFileReader();
+
+  virtual ReaderType getType(void) const;
+  virtual size_t readBuffer(char * buf, const size_t readlen);
+  virtual SbBool readDirect(const char *& buf, size_t & buflen);
+
+  virtual const SbString & getFilename(void);
+  virtual FILE * getFilePointer(void);
+
+public:
+  SbString filename;
+  FILE * fp;
+  char * data;
+  size_t datalen;
+  size_t datapos;
+};
+
 class SoInput_MemBufferReader : public SoInput_Reader {
 public:
   SoInput_MemBufferReader(const void * bufPointer, size_t bufSize);
@@ -103,6 +161,7 @@ public:
 
   virtual ReaderType getType(void) const;
   virtual size_t readBuffer(char * buf, const size_t readlen);
+  virtual SbBool readDirect(const char *& buf, size_t & buflen);
 
 public:
   char * buf;
@@ -252,6 +252,44 @@ public:
     return dict;
   }
 
+  // Writes num 4- or 8-byte words in network byte order. The first
+  // word goes out on its own and is padded exactly like
+  // writeBytesWithPadding() would do, which leaves the stream
+  // word-aligned for the rest of the array. The remaining words are
+  // then byte swapped in bulk and handed to the writer a chunk at a
+  // time, instead of through one convert/write/pad round per value.
+  void writeWordArray(SoOutput * out, const void * values,
+                      const int num, const size_t wordsize) {
+    assert(wordsize == sizeof(uint32_t) || wordsize == sizeof(uint64_t));
+    if (num <= 0) return;
+
+    uint64_t chunk[512];
+    const size_t chunkwords = sizeof(chunk) / wordsize;
+    const unsigned char * src = (const unsigned char *)values;
+    size_t remaining = (size_t)num;
+    size_t n = 1;
+
+    while (remaining > 0 && !this->disabledwriting) {
+      if (wordsize == sizeof(uint32_t)) coin_hton_uint32_array(src, chunk, n);
+      else coin_hton_uint64_array(src, chunk, n);
+      out->writeBinaryArray((const unsigned char *)chunk, (int)(n * wordsize));
+
+      if (remaining == (size_t)num && out->isBinary()) {
+        static const unsigned char padbytes[HOSTWORDSIZE] = { 0 };
+        size_t writeposition = this->getWriter()->bytesInBuf();
+        if (this->getWriter()->getType() == SoOutput_Writer::MEMBUFFER) {
+          writeposition -= ((SoOutput_MemBufferWriter*)this->getWriter())->startoffset;
+        }
+        const size_t padsize = (HOSTWORDSIZE - (writeposition % HOSTWORDSIZE)) % HOSTWORDSIZE;
+        if (padsize) out->writeBinaryArray(padbytes, (int)padsize);
+      }
+
+      src += n * wordsize;
+      remaining -= n;
+      n = remaining < chunkwords ? remaining : chunkwords;
+    }
+  }
+
   SoOutput_Writer * getWriter(void) {
     if (this->writer == NULL) {
       this->writer = SoOutput_Writer::createWriter(coin_get_stdout(), FALSE,
@@ -1051,13 +1089,7 @@ SoOutput::writeBinaryArray(const unsigned char * constc, const int length)
 void
 SoOutput::writeBinaryArray(const int32_t * const l, const int length)
 {
-  // Slooooow. We can do much better by using convertInt32Array().
-
-  char val[sizeof(int32_t)];
-  for (int i=0; i < length; i++) {
-    this->convertInt32(l[i], val);
-    this->writeBytesWithPadding(val, sizeof(int32_t));
-  }
+  PRIVATE(this)->writeWordArray(this, l, length, sizeof(int32_t));
 }
 
 /*!
@@ -1066,13 +1098,7 @@ SoOutput::writeBinaryArray(const int32_t * const l, const int length)
 void
 SoOutput::writeBinaryArray(const float * const f, const int length)
 {
-  // Slooooow. We can do much better by using convertFloatArray().
-
-  char val[sizeof(float)];
-  for (int i=0; i < length; i++) {
-    this->convertFloat(f[i], val);
-    this->writeBytesWithPadding(val, sizeof(float));
-  }
+  PRIVATE(this)->writeWordArray(this, f, length, sizeof(float));
 }
 
 /*!
@@ -1081,13 +1107,7 @@ SoOutput::writeBinaryArray(const float * const f, const int length)
 void
 SoOutput::writeBinaryArray(const double * const d, const int length)
 {
-  // Slooooow. We can do much better by using convertDoubleArray().
-
-  char val[sizeof(double)];
-  for (int i=0; i < length; i++) {
-    this->convertDouble(d[i], val);
-    this->writeBytesWithPadding(val, sizeof(double));
-  }
+  PRIVATE(this)->writeWordArray(this, d, length, sizeof(double));
 }
 
 /*!
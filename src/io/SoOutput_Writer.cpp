@@ -33,6 +33,7 @@
 #include "io/SoOutput_Writer.h"
 #include "coindefs.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <cassert>
 
@@ -220,6 +221,26 @@ SoOutput_MemBufferWriter::makeRoomInBuf(size_t bytes)
   return TRUE;
 }
 
+// size of the buffer used to batch up writes to the compressing
+// writers
+static const size_t WRITEBUFSIZE = 128 * 1024;
+
+// Appends numbytes bytes to the write buffer, or returns FALSE if it
+// has to be flushed first.
+static SbBool
+soout_buffer_append(char *& writebuf, size_t & writebuflen,
+                    const char * buf, size_t numbytes)
+{
+  if (writebuf == NULL) {
+    writebuf = (char *) malloc(WRITEBUFSIZE);
+    if (writebuf == NULL) return FALSE;
+  }
+  if (writebuflen + numbytes > WRITEBUFSIZE) return FALSE;
+  memcpy(writebuf + writebuflen, buf, numbytes);
+  writebuflen += numbytes;
+  return TRUE;
+}
+
 //
 // zlib writer
 //
@@ -227,6 +248,9 @@ SoOutput_MemBufferWriter::makeRoomInBuf(size_t bytes)
 SoOutput_GZFileWriter::SoOutput_GZFileWriter(FILE * fp, const SbBool shouldclose, const float level)
 {
   this->gzfp = NULL;
+  this->writecounter = 0;
+  this->writebuf = NULL;
+  this->writebuflen = 0;
 
   int fd = fileno(fp);
   if (fd >= 0 && !shouldclose) fd = dup(fd);
@@ -252,8 +276,13 @@ SoOutput_GZFileWriter::SoOutput_GZFileWriter(FILE * fp, const SbBool shouldclose
 SoOutput_GZFileWriter::~SoOutput_GZFileWriter()
 {
   if (this->gzfp) {
+    if (!this->flushBuffer()) {
+      SoDebugError::postWarning("SoOutput_GZFileWriter::~SoOutput_GZFileWriter",
+                                "I/O error while writing.");
+    }
     cc_zlibglue_gzclose(this->gzfp);
   }
+  free(this->writebuf);
 }
 
 
@@ -263,25 +292,44 @@ SoOutput_GZFileWriter::getType(void) const
   return GZFILE;
 }
 
+SbBool
+SoOutput_GZFileWriter::writeCompressed(const char * buf, size_t numbytes)
+{
+  // FIXME: the numbytes cast (as size_t can be 64 bits wide) is
+  // there to humour the interface of *gzwrite() -- should really be
+  // fixed in the interface instead. 20050526 mortene.
+  return cc_zlibglue_gzwrite(this->gzfp, buf, (int)numbytes) == (int)numbytes;
+}
+
+SbBool
+SoOutput_GZFileWriter::flushBuffer(void)
+{
+  const size_t len = this->writebuflen;
+  this->writebuflen = 0;
+  return (len == 0) || this->writeCompressed(this->writebuf, len);
+}
+
 size_t
 SoOutput_GZFileWriter::write(const char * buf, size_t numbytes, const SbBool COIN_UNUSED_ARG(binary))
 {
   if (this->gzfp) {
-    // FIXME: the numbytes cast (as size_t can be 64 bits wide) is
-    // there to humour the interface of *gzwrite() -- should really be
-    // fixed in the interface instead. 20050526 mortene.
-    return cc_zlibglue_gzwrite(this->gzfp, buf, (int)numbytes);
+    if (!soout_buffer_append(this->writebuf, this->writebuflen, buf, numbytes)) {
+      if (!this->flushBuffer()) return 0;
+      if (!soout_buffer_append(this->writebuf, this->writebuflen, buf, numbytes) &&
+          !this->writeCompressed(buf, numbytes)) return 0;
+    }
+    this->writecounter += numbytes;
+    return numbytes;
   }
   return 0;
 }
 
+// Counted here rather than with gztell(), so the bytes still in the
+// write buffer are included.
 size_t 
 SoOutput_GZFileWriter::bytesInBuf(void)
 {
-  if (this->gzfp) {
-    return cc_zlibglue_gztell(this->gzfp);
-  }
-  return 0;
+  return this->writecounter;
 }
 
 //
@@ -292,6 +340,8 @@ SoOutput_BZ2FileWriter::SoOutput_BZ2FileWriter(FILE * fparg, const SbBool should
 {
   this->fp = shouldclose ? fparg : NULL;
   this->writecounter = 0;
+  this->writebuf = NULL;
+  this->writebuflen = 0;
 
   int bzerror = BZ_OK;
   int numblocks =  (int) SbClamp((level * 8.0f) + 1.0f, 1.0f, 9.0f);
@@ -307,6 +357,9 @@ SoOutput_BZ2FileWriter::SoOutput_BZ2FileWriter(FILE * fparg, const SbBool should
 
 SoOutput_BZ2FileWriter::~SoOutput_BZ2FileWriter()
 {
+  // on failure, the file has already been closed with a warning
+  if (this->bzfp) (void) this->flushBuffer();
+
   if (this->bzfp) {
     int bzerror = BZ_OK;
     cc_bzglue_BZ2_bzWriteClose(&bzerror, this->bzfp, 0, NULL, NULL);
@@ -317,6 +370,7 @@ SoOutput_BZ2FileWriter::~SoOutput_BZ2FileWriter()
     }
   }
   if (this->fp) fclose(fp);
+  free(this->writebuf);
 }
 
 
@@ -326,22 +380,41 @@ SoOutput_BZ2FileWriter::getType(void) const
   return BZ2FILE;
 }
 
+SbBool
+SoOutput_BZ2FileWriter::writeCompressed(const char * buf, size_t numbytes)
+{
+  int bzerror = BZ_OK;
+  // FIXME: about the cast; see note about the call to *gzmwrite()
+  // above. 20050526 mortene.
+  cc_bzglue_BZ2_bzWrite(&bzerror, this->bzfp, (void*) buf, (int)numbytes);
+    
+  if (bzerror != BZ_OK) {
+    assert(bzerror == BZ_IO_ERROR);
+    SoDebugError::postWarning("SoOutput_BZ2FileWriter::write", 
+                              "I/O error while writing.");    
+    cc_bzglue_BZ2_bzWriteClose(&bzerror, this->bzfp, 0, NULL, NULL);
+    this->bzfp = NULL;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+SbBool
+SoOutput_BZ2FileWriter::flushBuffer(void)
+{
+  const size_t len = this->writebuflen;
+  this->writebuflen = 0;
+  return (len == 0) || this->writeCompressed(this->writebuf, len);
+}
+
 size_t
 SoOutput_BZ2FileWriter::write(const char * buf, size_t numbytes, const SbBool COIN_UNUSED_ARG(binary))
 {
   if (this->bzfp) {
-    int bzerror = BZ_OK;
-    // FIXME: about the cast; see note about the call to *gzmwrite()
-    // above. 20050526 mortene.
-    cc_bzglue_BZ2_bzWrite(&bzerror, this->bzfp, (void*) buf, (int)numbytes);
-    
-    if (bzerror != BZ_OK) {
-      assert(bzerror == BZ_IO_ERROR);
-      SoDebugError::postWarning("SoOutput_BZ2FileWriter::write", 
-                                "I/O error while writing.");    
-      cc_bzglue_BZ2_bzWriteClose(&bzerror, this->bzfp, 0, NULL, NULL);
-      this->bzfp = NULL;
-      return 0;
+    if (!soout_buffer_append(this->writebuf, this->writebuflen, buf, numbytes)) {
+      if (!this->flushBuffer()) return 0;
+      if (!soout_buffer_append(this->writebuf, this->writebuflen, buf, numbytes) &&
+          !this->writeCompressed(buf, numbytes)) return 0;
     }
     this->writecounter += numbytes;
     return numbytes;
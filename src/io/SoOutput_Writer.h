@@ -118,7 +118,10 @@ public:
   size_t startoffset;
 };
 
-// class for zlib writing
+// class for zlib writing. The compressing writers collect small
+// writes in a buffer and hand them to the compression library in
+// WRITEBUFSIZE chunks, as writing binary files tends to come through
+// as a long sequence of 4 byte writes.
 class SoOutput_GZFileWriter : public SoOutput_Writer {
 public:
   SoOutput_GZFileWriter(FILE * fp, const SbBool shouldclose, const float level);
@@ -129,7 +132,13 @@ public:
   virtual size_t write(const char * buf, size_t numbytes, const SbBool binary);
 
 public:
+  SbBool writeCompressed(const char * buf, size_t numbytes);
+  SbBool flushBuffer(void);
+
   void * gzfp;
+  size_t writecounter;
+  char * writebuf;
+  size_t writebuflen;
 };
 
 class SoOutput_BZ2FileWriter : public SoOutput_Writer {
@@ -142,9 +151,14 @@ public:
   virtual size_t write(const char * buf, size_t numbytes, const SbBool binary);
 
 public:
+  SbBool writeCompressed(const char * buf, size_t numbytes);
+  SbBool flushBuffer(void);
+
   void * bzfp;
   FILE * fp;
   size_t writecounter;
+  char * writebuf;
+  size_t writebuflen;
 };
 
 #endif // COIN_SOOUTPUT_WRITER_H
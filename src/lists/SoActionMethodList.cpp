@@ -39,6 +39,12 @@
   An SoActionMethodList contains one function pointer per node
   type. Each action contains an SoActioMethodList to know which
   functions to call during scene graph traversal.
+
+  setUp() also fills in a flat dispatch table with the resolved
+  function pointers indexed by SoType::getKey(), which is what
+  SoAction::traverse() uses to look up the method for each node. When
+  new node types are created, only the entries for the new types are
+  resolved and added.
 */
 
 #include <Inventor/lists/SoActionMethodList.h>
@@ -60,11 +66,48 @@
 
 class SoActionMethodListP {
 public:
+  SoActionMethodListP(void)
+    : dispatch(NULL), numdispatch(0), dispatchsize(0),
+      generation(0), parentgeneration(0) { }
+  ~SoActionMethodListP() {
+    for (int i = 0; i < this->retired.getLength(); i++) {
+      delete[] this->retired[i];
+    }
+    delete[] this->dispatch;
+  }
+
+  void setUpTypes(SoActionMethodList * list, const SoTypeList & types,
+                  const int firstkey);
+  SoActionMethod getOwnMethod(const int idx) const {
+    return idx < this->ownmethods.getLength() ? this->ownmethods[idx] : NULL;
+  }
+  void setOwnMethod(const int idx, const SoActionMethod method) {
+    while (this->ownmethods.getLength() <= idx) { this->ownmethods.append(NULL); }
+    this->ownmethods[idx] = method;
+  }
+
   SoActionMethodList * parent;
   int setupnumtypes;
   SbList <SoType> addedtypes;
   SbList <SoActionMethod> addedmethods;
 
+  // the methods before inheriting unset methods from the parent
+  // action, indexed like the list itself
+  SbList <SoActionMethod> ownmethods;
+
+  // the methods indexed by type key. Replaced tables are kept until
+  // the list is destructed, since actions being applied in other
+  // threads may still use them.
+  SoActionMethod * dispatch;
+  int numdispatch;
+  int dispatchsize;
+  SbList <SoActionMethod *> retired;
+
+  // incremented for each complete setup, so that derived actions
+  // know when to start over
+  uint32_t generation;
+  uint32_t parentgeneration;
+
 #ifdef COIN_THREADSAFE
   SbMutex mutex;
 #endif // COIN_THREADSAFE
@@ -142,6 +185,58 @@ static void unsetActionMethod(SoAction *, SoNode *)
 {
 }
 
+// resolves the methods of the node types with keys from firstkey and
+// up, which all must be set for the other types
+void
+SoActionMethodListP::setUpTypes(SoActionMethodList * list,
+                                const SoTypeList & types, const int firstkey)
+{
+  int i;
+  const int n = types.getLength();
+
+  // for node types with no action method, inherit from parent nodetype(s)
+  for (i = 0; i < n; i++) {
+    SoType type = types[i];
+    if (type.getKey() < firstkey) continue;
+    int idx = SoNode::getActionMethodIndex(type);
+    SoActionMethod m = this->getOwnMethod(idx);
+    if (m == NULL) {
+      do {
+        type = type.getParent();
+        m = this->getOwnMethod(SoNode::getActionMethodIndex(type));
+      } while (m == NULL);
+      this->setOwnMethod(idx, m);
+    }
+  }
+
+  // make room for the new types, with some slack for types to come
+  const int numtypes = SoType::getNumTypes();
+  if (numtypes > this->dispatchsize) {
+    if (this->dispatch) { this->retired.append(this->dispatch); }
+    SoActionMethod * dispatch = new SoActionMethod[numtypes * 2];
+    for (i = 0; i < numtypes * 2; i++) {
+      dispatch[i] = i < this->numdispatch ? this->dispatch[i] : NULL;
+    }
+    this->dispatch = dispatch;
+    this->dispatchsize = numtypes * 2;
+  }
+
+  // inherit unset methods from parent action
+  for (i = 0; i < n; i++) {
+    const int key = types[i].getKey();
+    if (key < firstkey) continue;
+    const int idx = SoNode::getActionMethodIndex(types[i]);
+    SoActionMethod m = this->ownmethods[idx];
+    if (m == unsetActionMethod) {
+      assert(this->parent);
+      m = (*this->parent)[idx];
+    }
+    (*list)[idx] = m;
+    this->dispatch[key] = m;
+  }
+  this->numdispatch = numtypes;
+}
+
 /*!
   This method must be called as the last initialization step before
   using the list. It fills in \c NULL entries with the parent's
@@ -151,61 +246,141 @@ void
 SoActionMethodList::setUp(void)
 {
   PRIVATE(this)->lock();
+  if (PRIVATE(this)->parent != NULL) {
+    // start over if the parent action has started over
+    PRIVATE(this)->parent->setUp();
+    if (PRIVATE(this)->parentgeneration != PRIVATE(PRIVATE(this)->parent)->generation) {
+      PRIVATE(this)->parentgeneration = PRIVATE(PRIVATE(this)->parent)->generation;
+      PRIVATE(this)->setupnumtypes = 0;
+    }
+  }
+
   if (PRIVATE(this)->setupnumtypes != SoType::getNumTypes()) {
     int i, n;
+    const int firstkey = PRIVATE(this)->setupnumtypes;
 
-    this->truncate(0); // clear action method list
+    if (firstkey == 0) {
+      this->truncate(0); // clear action method list
+      PRIVATE(this)->ownmethods.truncate(0);
 
-    // first set all methods that have been set directly through SO_ACTION_ADD_METHOD()
-    n = PRIVATE(this)->addedtypes.getLength();
-    for (i = 0; i < n; i++) {
-      (*this)[SoNode::getActionMethodIndex(PRIVATE(this)->addedtypes[i])] = PRIVATE(this)->addedmethods[i];
-    }
-    
-    // make sure SoNode's action method is set to avoid a NULL action method
-    i = SoNode::getActionMethodIndex(SoNode::getClassTypeId());
-    if ((*this)[i] == NULL) {
-      if (PRIVATE(this)->parent == NULL) {
-        (*this)[i] = SoAction::nullAction;
+      // first set all methods that have been set directly through SO_ACTION_ADD_METHOD()
+      n = PRIVATE(this)->addedtypes.getLength();
+      for (i = 0; i < n; i++) {
+        const int idx = SoNode::getActionMethodIndex(PRIVATE(this)->addedtypes[i]);
+        (*this)[idx] = PRIVATE(this)->addedmethods[i];
+        PRIVATE(this)->setOwnMethod(idx, PRIVATE(this)->addedmethods[i]);
       }
-      else {
+
+      // make sure SoNode's action method is set to avoid a NULL action method
+      i = SoNode::getActionMethodIndex(SoNode::getClassTypeId());
+      if (PRIVATE(this)->getOwnMethod(i) == NULL) {
         // set to a dummy method to detect unset methods in the final pass
-        (*this)[i] = unsetActionMethod;
+        PRIVATE(this)->setOwnMethod(i, PRIVATE(this)->parent == NULL ?
+                                    SoAction::nullAction : unsetActionMethod);
+      }
+
+      // the dispatch table might be in use, so start on a new one
+      if (PRIVATE(this)->dispatch) {
+        PRIVATE(this)->retired.append(PRIVATE(this)->dispatch);
+        PRIVATE(this)->dispatch = NULL;
+        PRIVATE(this)->numdispatch = 0;
+        PRIVATE(this)->dispatchsize = 0;
       }
+      PRIVATE(this)->generation++;
     }
 
-    // for node types with no action method, inherit from parent nodetype(s)
     SoTypeList allnodes;
     SoType::getAllDerivedFrom(SoNode::getClassTypeId(), allnodes);
-    n = allnodes.getLength();
-
-    for (i = 0; i < n; i++) {
-      SoType type = allnodes[i];
-      int idx = SoNode::getActionMethodIndex(type);
-      SoActionMethod m = (*this)[idx];
-      if (m == NULL) {
-        do {
-          type = type.getParent();
-          m = (*this)[SoNode::getActionMethodIndex(type)];
-        } while (m == NULL);
-        (*this)[idx] = m;
-      }
-    }
+    PRIVATE(this)->setUpTypes(this, allnodes, firstkey);
 
-    // inherit unset methods from parent action
-    if (PRIVATE(this)->parent != NULL) {
-      PRIVATE(this)->parent->setUp();
-      n = this->getLength();
-      for (i = 0; i < n; i++) {
-        if ((*this)[i] == unsetActionMethod) {
-          (*this)[i] = (*PRIVATE(this)->parent)[i];
-        }
-      }
-    }
     // used to detect when a new node has been added
     PRIVATE(this)->setupnumtypes = SoType::getNumTypes();
   }
   PRIVATE(this)->unlock();
 }
 
+/*!
+  Returns the flat dispatch table set up by the last setUp() call,
+  with the method for each node type indexed by SoType::getKey(), and
+  sets \a numentries to the number of entries in it. Entries for types
+  which are not node types are \c NULL.
+
+  The table stays valid for the lifetime of the list, but new node
+  types are only included after the next setUp().
+
+  \since Coin 4.1
+*/
+const SoActionMethod *
+SoActionMethodList::getDispatchTable(int & numentries) const
+{
+  numentries = PRIVATE(this)->numdispatch;
+  return PRIVATE(this)->dispatch;
+}
+
 #undef PRIVATE
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoSubNode.h>
+
+class ActionMethodListTestCube : public SoCube {
+  SO_NODE_HEADER(ActionMethodListTestCube);
+public:
+  static void initClass(void) {
+    SO_NODE_INIT_CLASS(ActionMethodListTestCube, SoCube, "Cube");
+  }
+  ActionMethodListTestCube(void) {
+    SO_NODE_CONSTRUCTOR(ActionMethodListTestCube);
+  }
+};
+
+SO_NODE_SOURCE(ActionMethodListTestCube);
+
+static void
+testCubeMethod(SoAction *, SoNode *)
+{
+}
+
+// node types created after an action has been applied get their
+// methods from their parent types
+BOOST_AUTO_TEST_CASE(dispatchNewNodeTypes)
+{
+  SoActionMethodList methods(NULL);
+  methods.addMethod(SoCube::getClassTypeId(), testCubeMethod);
+  methods.setUp();
+  int numentries;
+  const SoActionMethod * dispatch = methods.getDispatchTable(numentries);
+  BOOST_CHECK_EQUAL(numentries, SoType::getNumTypes());
+  BOOST_CHECK(dispatch[SoCube::getClassTypeId().getKey()] == testCubeMethod);
+  BOOST_CHECK(dispatch[SoSeparator::getClassTypeId().getKey()] == SoAction::nullAction);
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  root->addChild(new SoCube);
+  SoGetBoundingBoxAction action(SbViewportRegion(100, 100));
+  action.apply(root);
+  BOOST_CHECK(action.getBoundingBox().getMax() == SbVec3f(1.0f, 1.0f, 1.0f));
+
+  if (ActionMethodListTestCube::getClassTypeId() == SoType::badType()) {
+    ActionMethodListTestCube::initClass();
+  }
+  const int key = ActionMethodListTestCube::getClassTypeId().getKey();
+  root->replaceChild(0, new ActionMethodListTestCube);
+  action.apply(root);
+  BOOST_CHECK(action.getBoundingBox().getMax() == SbVec3f(1.0f, 1.0f, 1.0f));
+
+  methods.setUp();
+  dispatch = methods.getDispatchTable(numentries);
+  BOOST_CHECK(key < numentries);
+  BOOST_CHECK(dispatch[key] == testCubeMethod);
+  BOOST_CHECK(methods[SoNode::getActionMethodIndex(ActionMethodListTestCube::getClassTypeId())] ==
+              testCubeMethod);
+
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
@@ -69,6 +69,8 @@
 #include <cassert>
 #include <cstring>
 
+#include <boost/static_assert.hpp>
+
 #include <Inventor/C/tidbits.h>
 #include <Inventor/SoDB.h>
 #include <Inventor/SoInput.h>
@@ -85,6 +87,7 @@
 #include <Inventor/sensors/SoDataSensor.h>
 
 #include "misc/SoBaseP.h"
+#include "misc/SoDBP.h"
 #include "nodes/SoUnknownNode.h"
 #include "fields/SoGlobalField.h"
 #include "misc/SbHash.h"
@@ -180,6 +183,34 @@ SoType SoBase::classTypeId STATIC_SOTYPE_INIT;
 // <mortene@sim.no>
 #define ALIVE_PATTERN 0xd
 
+// The layout of SoBase::objdata, which is private.
+struct sobase_objdata {
+  signed int referencecount : 28;
+  unsigned int alive : 4;
+};
+
+BOOST_STATIC_ASSERT(sizeof(sobase_objdata) == sizeof(int32_t));
+
+// Adds delta to the reference count in objdata, and returns the new
+// count. Atomics can not operate on a bitfield, so the 32-bit word
+// holding both the count and the alive pattern is replaced as a whole
+// with a compare-and-swap, which leaves the alive pattern intact.
+static int32_t
+sobase_add_refcount(const void * objdata, const int delta)
+{
+  // the bitfields of SoBase::objdata are mutable
+  int32_t * word = static_cast<int32_t *>(const_cast<void *>(objdata));
+  int32_t oldword = *static_cast<volatile int32_t *>(word);
+  sobase_objdata data;
+  int32_t newword;
+  do {
+    (void)memcpy(&data, &oldword, sizeof(int32_t));
+    data.referencecount += delta;
+    (void)memcpy(&newword, &data, sizeof(int32_t));
+  } while (!CC_ATOMIC_COMPARE_EXCHANGE(word, oldword, newword));
+  return data.referencecount;
+}
+
 unsigned int SbHashFunc(const SoBase * key) {
   return SbHashFunc(reinterpret_cast<size_t>(key));
 }
@@ -240,6 +271,8 @@ SoBase::~SoBase()
   // used to check that we are still alive.
   this->objdata.alive = (~ALIVE_PATTERN) & 0xf;
 
+  SoDBP::forgetBatchEdit(this);
+
   if (SoBase::PImpl::auditordict) {
     //SoAuditorList * l;
     if (SoBase::PImpl::auditordict->find(this)!=SoBase::PImpl::auditordict->const_end()) {
@@ -373,7 +406,6 @@ SoBase::initClass(void)
   SoBase::PImpl::refwriteprefix = new SbString("+");
   SoBase::PImpl::allbaseobj = new SoBaseSet;
 
-  CC_MUTEX_CONSTRUCT(SoBase::PImpl::mutex);
   CC_MUTEX_CONSTRUCT(SoBase::PImpl::obj2name_mutex);
   CC_MUTEX_CONSTRUCT(SoBase::PImpl::name2obj_mutex);
   CC_MUTEX_CONSTRUCT(SoBase::PImpl::allbaseobj_mutex);
@@ -414,7 +446,6 @@ SoBase::cleanClass(void)
 
   SoBase::classTypeId STATIC_SOTYPE_INIT;
 
-  CC_MUTEX_DESTRUCT(SoBase::PImpl::mutex);
   CC_MUTEX_DESTRUCT(SoBase::PImpl::obj2name_mutex);
   CC_MUTEX_DESTRUCT(SoBase::PImpl::allbaseobj_mutex);
   CC_MUTEX_DESTRUCT(SoBase::PImpl::name2obj_mutex);
@@ -481,19 +512,14 @@ SoBase::ref(void) const
 
   if (COIN_DEBUG) this->assertAlive();
 
-  CC_MUTEX_LOCK(SoBase::PImpl::mutex);
-#if COIN_DEBUG
-  int32_t currentrefcount = this->objdata.referencecount;
-#endif // COIN_DEBUG
-  this->objdata.referencecount++;
-  CC_MUTEX_UNLOCK(SoBase::PImpl::mutex);
+  const int32_t refcount = sobase_add_refcount(&this->objdata, 1);
 
 #if COIN_DEBUG
-  if (this->objdata.referencecount < currentrefcount) {
+  if (refcount == -(1 << 27)) {
     SoDebugError::post("SoBase::ref",
                        "%p ('%s') - referencecount overflow!: %d -> %d",
                        this, this->getTypeId().getName().getString(),
-                       currentrefcount, this->objdata.referencecount);
+                       (1 << 27) - 1, refcount);
 
     // The reference counter is contained within 27 bits of signed
     // integer, which means it can go up to about ~67 million
@@ -512,7 +538,7 @@ SoBase::ref(void) const
     SoDebugError::postInfo("SoBase::ref",
                            "%p ('%s') - referencecount: %d",
                            this, this->getTypeId().getName().getString(),
-                           this->objdata.referencecount);
+                           refcount);
   }
 #endif // COIN_DEBUG
 }
@@ -533,18 +559,14 @@ SoBase::unref(void) const
 
   if (COIN_DEBUG) this->assertAlive();
 
-  CC_MUTEX_LOCK(SoBase::PImpl::mutex);
-  this->objdata.referencecount--;
-  int refcount = this->objdata.referencecount;
-
-  CC_MUTEX_UNLOCK(SoBase::PImpl::mutex);
+  const int32_t refcount = sobase_add_refcount(&this->objdata, -1);
 
 #if COIN_DEBUG
   if (SoBase::PImpl::tracerefs) {
     SoDebugError::postInfo("SoBase::unref",
                            "%p ('%s') - referencecount: %d",
                            this, this->getTypeId().getName().getString(),
-                           this->objdata.referencecount);
+                           refcount);
   }
   if (refcount < 0) {
     // Do the debug output in two calls, since the getTypeId() might
@@ -574,13 +596,13 @@ SoBase::unrefNoDelete(void) const
 
   if (COIN_DEBUG) this->assertAlive();
 
-  this->objdata.referencecount--;
+  const int32_t refcount = sobase_add_refcount(&this->objdata, -1);
 #if COIN_DEBUG
   if (SoBase::PImpl::tracerefs) {
     SoDebugError::postInfo("SoBase::unrefNoDelete",
                            "%p ('%s') - referencecount: %d",
                            this, this->getTypeId().getName().getString(),
-                           this->objdata.referencecount);
+                           refcount);
   }
 #endif // COIN_DEBUG
 }
@@ -791,6 +813,11 @@ SoBase::removeName(SoBase * const base, const char * const name)
 void
 SoBase::startNotify(void)
 {
+  if (SoDB::isBatchEditing()) {
+    SoDBP::recordBatchEdit(this, NULL);
+    return;
+  }
+
   SoNotList l;
   SoNotRec rec(createNotRec());
   l.append(&rec);
@@ -66,7 +66,6 @@ const char SoBase::PImpl::ROUTE_KEYWORD[] = "ROUTE";
 const char SoBase::PImpl::PROTO_KEYWORD[] = "PROTO";
 const char SoBase::PImpl::EXTERNPROTO_KEYWORD[] = "EXTERNPROTO";
 
-void * SoBase::PImpl::mutex = NULL;
 void * SoBase::PImpl::name2obj_mutex = NULL;
 void * SoBase::PImpl::obj2name_mutex = NULL;
 void * SoBase::PImpl::auditor_mutex = NULL;
@@ -62,7 +62,6 @@ public:
   static const char PROTO_KEYWORD[];
   static const char EXTERNPROTO_KEYWORD[];
 
-  static void * mutex;
   static void * name2obj_mutex;
   static void * obj2name_mutex;
   static void * auditor_mutex;
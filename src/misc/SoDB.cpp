@@ -1172,6 +1172,79 @@ SoDB::endNotify(void)
 
 }
 
+/*!
+  Starts a batch of changes to the scene graph. Until the matching
+  endBatchEdit(), changing fields, or calling touch() on fields and
+  nodes, does not send any notifications. The changed objects are
+  recorded instead, and notified when the batch ends.
+
+  Use this when changing many nodes at once, for instance when
+  updating thousands of transforms from a simulation every frame:
+
+  \code
+  SoDB::startBatchEdit();
+  for (int i = 0; i < numtransforms; i++) {
+    transforms[i]->translation = positions[i];
+    transforms[i]->rotation = orientations[i];
+  }
+  SoDB::endBatchEdit();
+  \endcode
+
+  Without the batch, each of the changes above notifies all the way
+  up through the parents to the root, and to every sensor on the way.
+
+  Calls can be nested, and only the outermost endBatchEdit() sends
+  notifications. Fields keep their new values, and connected fields
+  and engines are evaluated as usual when read, but they are not
+  marked as needing evaluation before the batch ends either.
+
+  \since Coin 4.1
+  \sa endBatchEdit(), isBatchEditing()
+*/
+void
+SoDB::startBatchEdit(void)
+{
+  if (SoDBP::batchedits == NULL) {
+    SoDBP::batchedits = new SbList<SoDBP::BatchEditRecord>;
+    SoDBP::batcheditindex = new SbHash<uintptr_t, int>;
+  }
+  SoDBP::batcheditcounter++;
+}
+
+/*!
+  Returns \c TRUE if a batch of changes started with startBatchEdit()
+  is in progress.
+
+  \since Coin 4.1
+  \sa startBatchEdit()
+*/
+SbBool
+SoDB::isBatchEditing(void)
+{
+  return SoDBP::batcheditcounter > 0;
+}
+
+/*!
+  Ends a batch of changes started with startBatchEdit(). Every field
+  or node changed during the batch is notified once, in the order
+  they were first changed. The notifications share a single pass
+  through the scene graph, so a node above several changed nodes is
+  notified only once, and sensors are triggered once for the whole
+  batch. Node ids and caches are invalidated just as they would have
+  been by the individual changes.
+
+  \since Coin 4.1
+  \sa startBatchEdit()
+*/
+void
+SoDB::endBatchEdit(void)
+{
+  assert(SoDBP::batcheditcounter > 0 && "endBatchEdit() without startBatchEdit()");
+  if (--SoDBP::batcheditcounter == 0 && !SoDBP::flushingbatchedits) {
+    SoDBP::flushBatchEdits();
+  }
+}
+
 /*!
   Turn on or off the real time sensor.
 
@@ -1699,6 +1772,10 @@ SoDB::removeRoute(SoNode * fromnode, const char * eventout,
 #include <Inventor/nodes/SoNode.h>
 #include <Inventor/nodes/SoSeparator.h>
 #include <Inventor/nodes/SoRotationXYZ.h>
+#include <Inventor/nodes/SoTransform.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/sensors/SoNodeSensor.h>
+#include <Inventor/sensors/SoFieldSensor.h>
 #include <boost/detail/workaround.hpp>
 
 BOOST_AUTO_TEST_CASE(globalRealTimeField)
@@ -1896,6 +1973,82 @@ BOOST_AUTO_TEST_CASE(globalfield_import)
   g->unref();
 }
 
+static void
+count_triggers_cb(void * data, SoSensor *)
+{
+  (*static_cast<int *>(data))++;
+}
+
+BOOST_AUTO_TEST_CASE(batchEdit)
+{
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  const int numtransforms = 100;
+  SoTransform * transforms[numtransforms];
+  SoSeparator * seps[numtransforms];
+  for (int i = 0; i < numtransforms; i++) {
+    seps[i] = new SoSeparator;
+    transforms[i] = new SoTransform;
+    seps[i]->addChild(transforms[i]);
+    seps[i]->addChild(new SoCube);
+    root->addChild(seps[i]);
+  }
+  SoCube * removed = new SoCube;
+  root->addChild(removed);
+
+  int roottriggers = 0, fieldtriggers = 0;
+  SoNodeSensor rootsensor(count_triggers_cb, &roottriggers);
+  rootsensor.setPriority(0);
+  rootsensor.attach(root);
+  SoFieldSensor fieldsensor(count_triggers_cb, &fieldtriggers);
+  fieldsensor.setPriority(0);
+  fieldsensor.attach(&transforms[7]->translation);
+
+  const SbUniqueId rootid = root->getNodeId();
+  const SbUniqueId sepid = seps[3]->getNodeId();
+  const SbUniqueId untouchedid = seps[5]->getNodeId();
+
+  SoDB::startBatchEdit();
+  for (int i = 0; i < numtransforms; i += 2) {
+    transforms[i]->translation.setValue(float(i), 0.0f, 0.0f);
+    transforms[i]->rotation.setValue(SbVec3f(0.0f, 1.0f, 0.0f), float(i));
+    transforms[i]->translation.setValue(float(i), 1.0f, 0.0f);
+  }
+  SoDB::startBatchEdit(); // nested
+  seps[3]->touch();
+  removed->width = 3.0f;
+  root->removeChild(removed); // destructed with a pending notification
+  SoDB::endBatchEdit();
+
+  BOOST_CHECK_MESSAGE(SoDB::isBatchEditing(), "nested batch edit ended the outer one");
+  BOOST_CHECK_MESSAGE(roottriggers == 0 && fieldtriggers == 0,
+                      "notification sent during batch edit");
+  BOOST_CHECK_MESSAGE(root->getNodeId() == rootid,
+                      "node id changed during batch edit");
+  BOOST_CHECK_MESSAGE(transforms[6]->translation.getValue() == SbVec3f(6.0f, 1.0f, 0.0f),
+                      "field value not set during batch edit");
+
+  SoDB::endBatchEdit();
+
+  BOOST_CHECK_MESSAGE(!SoDB::isBatchEditing(), "batch edit not ended");
+  BOOST_CHECK_MESSAGE(roottriggers == 1,
+                      "root sensor should trigger once for the whole batch");
+  BOOST_CHECK_MESSAGE(fieldtriggers == 0, "sensor on unchanged field triggered");
+  BOOST_CHECK_MESSAGE(root->getNodeId() != rootid, "root node id not updated");
+  BOOST_CHECK_MESSAGE(seps[3]->getNodeId() != sepid, "touched node id not updated");
+  BOOST_CHECK_MESSAGE(seps[5]->getNodeId() == untouchedid,
+                      "node id of unchanged subgraph updated");
+
+  SoDB::startBatchEdit();
+  transforms[7]->translation.setValue(1.0f, 2.0f, 3.0f);
+  transforms[7]->translation.setValue(1.0f, 2.0f, 4.0f);
+  SoDB::endBatchEdit();
+  BOOST_CHECK_MESSAGE(fieldtriggers == 1 && roottriggers == 2,
+                      "changed field should be notified once");
+
+  root->unref();
+}
+
 // *************************************************************************
 
 #endif // COIN_TEST_SUITE
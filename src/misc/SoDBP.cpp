@@ -6,6 +6,7 @@
 #include <Inventor/fields/SoSFTime.h>
 #include <Inventor/errors/SoDebugError.h>
 #include <Inventor/sensors/SoTimerSensor.h>
+#include <Inventor/misc/SoNotification.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -30,6 +31,10 @@ SoTimerSensor * SoDBP::globaltimersensor = NULL;
 UInt32ToInt16Map * SoDBP::converters = NULL;
 SbBool SoDBP::isinitialized = FALSE;
 int SoDBP::notificationcounter = 0;
+int SoDBP::batcheditcounter = 0;
+SbBool SoDBP::flushingbatchedits = FALSE;
+SbList<SoDBP::BatchEditRecord> * SoDBP::batchedits = NULL;
+SbHash<uintptr_t, int> * SoDBP::batcheditindex = NULL;
 SbList<SoDBP::ProgressCallbackInfo> * SoDBP::progresscblist = NULL;
 
 // *************************************************************************
@@ -120,6 +125,12 @@ SoDBP::clean(void)
   // first nullify the callback function pointer.)
   SoDBP::sensormanager->setChangedCallback(NULL, NULL);
 
+  delete SoDBP::batchedits;
+  SoDBP::batchedits = NULL;
+  delete SoDBP::batcheditindex;
+  SoDBP::batcheditindex = NULL;
+  SoDBP::batcheditcounter = 0;
+
   delete SoDBP::globaltimersensor;
   SoDBP::globaltimersensor = NULL;
   delete SoDBP::converters;
@@ -139,6 +150,81 @@ SoDBP::clean(void)
 #endif // COIN_THREADSAFE
 }
 
+// Called instead of starting a notification when a field or another
+// object is changed during a batch edit. Each object is recorded
+// once, no matter how many times it is changed.
+void
+SoDBP::recordBatchEdit(SoBase * base, SoField * field)
+{
+  const uintptr_t object = field ?
+    reinterpret_cast<uintptr_t>(field) : reinterpret_cast<uintptr_t>(base);
+  int idx;
+  if (!SoDBP::batcheditindex->get(object, idx)) {
+    (void) SoDBP::batcheditindex->put(object, SoDBP::batchedits->getLength());
+    BatchEditRecord record;
+    record.base = base;
+    record.field = field;
+    SoDBP::batchedits->append(record);
+  }
+}
+
+// Called when a field or an SoBase is destructed, so that a batch
+// edit does not notify through a dangling pointer. The records are
+// cleared when the batch is flushed, so outside of batch edits this
+// returns without a lookup.
+void
+SoDBP::forgetBatchEdit(const void * object)
+{
+  if (SoDBP::batchedits == NULL || SoDBP::batchedits->getLength() == 0) return;
+  int idx;
+  const uintptr_t key = reinterpret_cast<uintptr_t>(object);
+  if (SoDBP::batcheditindex->get(key, idx)) {
+    (void) SoDBP::batcheditindex->erase(key);
+    BatchEditRecord & record = (*SoDBP::batchedits)[idx];
+    record.base = NULL;
+    record.field = NULL;
+  }
+}
+
+// Sends the notifications recorded during a batch edit, in the order
+// the objects were first changed. All the notification lists share
+// the time stamp of the first one, so SoNode::notify() lets each node
+// through only once, and the paths shared by many changed objects
+// are only traversed once. Separator caches and node ids are updated
+// just as they would have been by the individual notifications.
+void
+SoDBP::flushBatchEdits(void)
+{
+  if (SoDBP::batchedits == NULL || SoDBP::batchedits->getLength() == 0) return;
+
+  SoDBP::flushingbatchedits = TRUE;
+  SoDB::startNotify();
+
+  SoNotList stamp;
+  // batch edits started and ended by the auditors append to the list
+  // while it is flushed, and are picked up by this loop
+  for (int i = 0; i < SoDBP::batchedits->getLength(); i++) {
+    const BatchEditRecord record = (*SoDBP::batchedits)[i];
+    if (record.field) {
+      SoNotList l(&stamp);
+      record.field->notify(&l);
+    }
+    else if (record.base) {
+      // as in SoBase::startNotify()
+      SoNotList l(&stamp);
+      SoNotRec rec(record.base->createNotRec());
+      l.append(&rec);
+      l.setLastType(SoNotRec::CONTAINER);
+      record.base->notify(&l);
+    }
+  }
+  SoDBP::batchedits->truncate(0);
+  SoDBP::batcheditindex->clear();
+
+  SoDBP::flushingbatchedits = FALSE;
+  SoDB::endNotify();
+}
+
 void
 SoDBP::removeRealTimeFieldCB(void)
 {
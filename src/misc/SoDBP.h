@@ -48,6 +48,7 @@
 
 class SoSensor;
 class SbRWMutex;
+class SoField;
 
 // *************************************************************************
 
@@ -94,6 +95,21 @@ public:
   static int notificationcounter;
   static SbBool isinitialized;
 
+  // objects changed during SoDB::startBatchEdit() /
+  // SoDB::endBatchEdit(), in the order they were first changed
+  struct BatchEditRecord {
+    SoBase * base;
+    SoField * field;
+  };
+  static int batcheditcounter;
+  static SbBool flushingbatchedits;
+  static SbList<BatchEditRecord> * batchedits;
+  static SbHash<uintptr_t, int> * batcheditindex;
+
+  static void recordBatchEdit(SoBase * base, SoField * field);
+  static void forgetBatchEdit(const void * object);
+  static void flushBatchEdits(void);
+
   static SbBool is3dsFile(SoInput * in);
   static SoSeparator * read3DSFile(SoInput * in);
 
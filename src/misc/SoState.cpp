@@ -84,6 +84,9 @@
 
 #include <Inventor/misc/SoState.h>
 
+#include <cstdlib>
+#include <new>
+
 #include <Inventor/SbName.h>
 #include <Inventor/elements/SoElement.h>
 #include <Inventor/errors/SoDebugError.h>
@@ -95,6 +98,7 @@
 #endif // HAVE_CONFIG_H
 
 #include "rendering/SoGL.h"
+#include "misc/SoStateP.h"
 
 // *************************************************************************
 
@@ -111,16 +115,162 @@ public:
   sostate_pushstore * prev;
 };
 
-// class to store private data members
-class SoStateP {
+// Internal class used to allocate the memory of a state. Allocations
+// are never freed one by one; clear() makes all the memory available
+// again at once, without giving it back to the system. The chunks
+// are kept in a list, and clear() rewinds to the first one.
+class sostate_arena {
+public:
+  sostate_arena(void) {
+    this->first = this->current = NULL;
+  }
+  ~sostate_arena() {
+    chunk * c = this->first;
+    while (c) {
+      chunk * next = c->next;
+      free(c);
+      c = next;
+    }
+  }
+  void * allocate(size_t size) {
+    size = (size + ALIGNMENT - 1) & ~static_cast<size_t>(ALIGNMENT - 1);
+    if (!this->current || this->current->used + size > this->current->size) {
+      this->nextChunk(size);
+    }
+    char * data = reinterpret_cast<char *>(this->current + 1);
+    void * ptr = data + this->current->used;
+    this->current->used += size;
+    return ptr;
+  }
+  void clear(void) {
+    for (chunk * c = this->first; c; c = c->next) c->used = 0;
+    this->current = this->first;
+  }
+
+private:
+  enum { ALIGNMENT = 16, CHUNKSIZE = 16384 };
+  // sized so that the data following the header is aligned
+  struct chunk {
+    chunk * next;
+    size_t size;
+    size_t used;
+    size_t pad;
+  };
+  void nextChunk(size_t size) {
+    chunk * next = this->current ? this->current->next : this->first;
+    if (!next || next->size < size) {
+      const size_t chunksize = size > CHUNKSIZE ? size : CHUNKSIZE;
+      chunk * c = static_cast<chunk *>(malloc(sizeof(chunk) + chunksize));
+      c->size = chunksize;
+      c->used = 0;
+      c->next = next;
+      if (this->current) this->current->next = c;
+      else this->first = c;
+      next = c;
+    }
+    this->current = next;
+  }
+  chunk * first;
+  chunk * current;
+};
+
+// Arenas of states that have been destructed, waiting for the next
+// state created in the same thread. Short-lived actions, like the
+// pick actions applied for every mouse event, will then construct
+// their states without allocating any memory.
+//
+// The cache is kept in plain variables, which stay valid after the
+// thread's destructors have run: states destructed after that, e.g.
+// by static actions at exit, just delete their arenas. The cleanup
+// object frees the cached arenas when the thread exits.
+enum { SOSTATE_MAXCACHEDARENAS = 4 };
+static thread_local sostate_arena * sostate_cachedarenas[SOSTATE_MAXCACHEDARENAS];
+static thread_local int sostate_numcachedarenas = 0;
+
+class sostate_arenacache_cleanup {
 public:
-  SoAction * action;
-  SoElement ** initial;
-  int depth;
-  SbBool ispopping;
-  class sostate_pushstore * pushstore;
+  void touch(void) { }
+  ~sostate_arenacache_cleanup() {
+    for (int i = 0; i < sostate_numcachedarenas; i++) {
+      delete sostate_cachedarenas[i];
+    }
+    sostate_numcachedarenas = -1;
+  }
 };
 
+static thread_local sostate_arenacache_cleanup sostate_cachecleanup;
+
+static sostate_arena *
+sostate_take_arena(void)
+{
+  if (sostate_numcachedarenas > 0) {
+    return sostate_cachedarenas[--sostate_numcachedarenas];
+  }
+  return new sostate_arena;
+}
+
+static void
+sostate_give_arena(sostate_arena * arena)
+{
+  if (sostate_numcachedarenas < 0 ||
+      sostate_numcachedarenas == SOSTATE_MAXCACHEDARENAS) {
+    delete arena;
+    return;
+  }
+  sostate_cachecleanup.touch(); // registers the thread exit cleanup
+  arena->clear();
+  sostate_cachedarenas[sostate_numcachedarenas++] = arena;
+}
+
+// The arena SoElement::operator new() should allocate the next
+// element from. Set by SoStateP::createElement() only.
+static thread_local sostate_arena * sostate_elementarena = NULL;
+
+void *
+SoStateP::allocateElement(size_t size)
+{
+  sostate_arena * arena = sostate_elementarena;
+  if (arena) {
+    // only the element itself goes into the arena, not whatever its
+    // constructor might allocate
+    sostate_elementarena = NULL;
+    return arena->allocate(size);
+  }
+  return ::operator new(size);
+}
+
+SoElement *
+SoStateP::createElement(const SoType & type)
+{
+  sostate_elementarena = this->arena;
+  SoElement * element = static_cast<SoElement *>(type.createInstance());
+  if (sostate_elementarena) {
+    // the class has its own operator new
+    sostate_elementarena = NULL;
+    this->heapelements.append(element);
+  }
+  return element;
+}
+
+void
+SoStateP::destroyElement(SoElement * element)
+{
+  const int idx = this->heapelements.getLength() ? this->heapelements.find(element) : -1;
+  if (idx >= 0) {
+    this->heapelements.removeFast(idx);
+    delete element;
+  }
+  else {
+    element->~SoElement();
+  }
+}
+
+sostate_pushstore *
+SoStateP::createPushStore(void)
+{
+  return new (this->arena->allocate(sizeof(sostate_pushstore))) sostate_pushstore;
+}
+
 #define PRIVATE(obj) ((obj)->pimpl)
 
 // *************************************************************************
@@ -142,6 +292,7 @@ SoState::SoState(SoAction * theAction, const SoTypeList & enabledelements)
   PRIVATE(this)->action = theAction;
   PRIVATE(this)->depth = 0;
   PRIVATE(this)->ispopping = FALSE;
+  PRIVATE(this)->arena = sostate_take_arena();
   this->cacheopen = FALSE;
 
   int i;
@@ -150,8 +301,9 @@ SoState::SoState(SoAction * theAction, const SoTypeList & enabledelements)
 
   // the stack member can be accessed from inline methods, and is
   // therefore not moved to the private class.
-  this->stack = new SoElement * [this->numstacks];
-  PRIVATE(this)->initial = new SoElement * [this->numstacks];
+  const size_t stacksize = this->numstacks * sizeof(SoElement *);
+  this->stack = static_cast<SoElement **>(PRIVATE(this)->arena->allocate(stacksize));
+  PRIVATE(this)->initial = static_cast<SoElement **>(PRIVATE(this)->arena->allocate(stacksize));
 
   for (i = 0; i < this->numstacks; i++) {
     PRIVATE(this)->initial[i] = NULL;
@@ -163,7 +315,7 @@ SoState::SoState(SoAction * theAction, const SoTypeList & enabledelements)
     SoType type = enabledelements[i];
     assert(type.isBad() || type.canCreateInstance());
     if (!type.isBad()) {
-      SoElement * const element = (SoElement *) type.createInstance();
+      SoElement * const element = PRIVATE(this)->createElement(type);
       element->setDepth(PRIVATE(this)->depth);
       const int stackindex = element->getStackIndex();
       this->stack[stackindex] = element;
@@ -171,7 +323,7 @@ SoState::SoState(SoAction * theAction, const SoTypeList & enabledelements)
       element->init(this); // called for first element in state stack
     }
   }
-  PRIVATE(this)->pushstore = new sostate_pushstore;
+  PRIVATE(this)->pushstore = PRIVATE(this)->createPushStore();
 }
 
 /*!
@@ -188,21 +340,19 @@ SoState::~SoState(void)
     SoElement * next;
     while (elem) {
       next = elem->nextup;
-      delete elem;
+      PRIVATE(this)->destroyElement(elem);
       elem = next;
     }
   }
 
-  delete[] PRIVATE(this)->initial;
-  delete[] this->stack;
-
   sostate_pushstore * item = PRIVATE(this)->pushstore;
   while (item->prev) item = item->prev; // go to first item
   while (item) {
     sostate_pushstore * next = item->next;
-    delete item;
+    item->~sostate_pushstore();
     item = next;
   }
+  sostate_give_arena(PRIVATE(this)->arena);
   delete PRIVATE(this);
 }
 
@@ -249,7 +399,7 @@ SoState::getElement(const int stackindex)
   if (element->getDepth() < PRIVATE(this)->depth) { // create elt of correct depth
     SoElement * next = element->nextup;
     if (! next) { // allocate new element
-      next = (SoElement *) element->getTypeId().createInstance();
+      next = PRIVATE(this)->createElement(element->getTypeId());
       next->nextdown = element;
       element->nextup = next;
     }
@@ -275,7 +425,7 @@ void
 SoState::push(void)
 {
   if (PRIVATE(this)->pushstore->next == NULL) {
-    sostate_pushstore * store = new sostate_pushstore;
+    sostate_pushstore * store = PRIVATE(this)->createPushStore();
     store->prev = PRIVATE(this)->pushstore;
     PRIVATE(this)->pushstore->next = store;
   }
@@ -352,3 +502,43 @@ SoState::setCacheOpen(const SbBool open)
 }
 
 #undef PRIVATE
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/elements/SoModelMatrixElement.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoGroup.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+BOOST_AUTO_TEST_CASE(reusedArenaGivesFreshElements)
+{
+  SoGroup * root = new SoGroup;
+  root->ref();
+  SoTranslation * translation = new SoTranslation;
+  translation->translation.setValue(1.0f, 0.0f, 0.0f);
+  root->addChild(translation);
+  root->addChild(new SoCube);
+
+  // The translation changes the initial model matrix element, as the
+  // group does not push the state. The next action will get the
+  // memory of this state, but must still start out with elements
+  // of its own.
+  for (int i = 0; i < 3; i++) {
+    SoGetBoundingBoxAction action(SbViewportRegion(100, 100));
+    SoState * state = action.getState();
+    BOOST_CHECK_MESSAGE(SoModelMatrixElement::get(state) == SbMatrix::identity(),
+                        "model matrix left over from a previous state");
+    action.apply(root);
+    BOOST_CHECK_MESSAGE(action.getBoundingBox().getCenter() == SbVec3f(1.0f, 0.0f, 0.0f),
+                        "wrong bounding box");
+    // elements copied for caches live on the heap, not in the arena
+    const int stackindex = SoModelMatrixElement::getClassStackIndex();
+    SoElement * copy = state->getConstElement(stackindex)->copyMatchInfo();
+    delete copy;
+  }
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
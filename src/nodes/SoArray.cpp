@@ -46,6 +46,11 @@
   SoMultipleCopy group node, which can do general transformations
   (including rotation and scaling) for its child.
 
+  When SoGLRenderAction::setInstancedRendering() is enabled, the
+  children are traversed once and their shapes are drawn for all the
+  elements of the array with instanced draw calls, when the OpenGL
+  driver and the shapes allow it.
+
   <b>FILE FORMAT/DEFAULTS:</b>
   \code
     Array {
@@ -74,6 +79,7 @@
 #include <Inventor/misc/SoState.h>
 
 #include "nodes/SoSubNodeP.h"
+#include "rendering/SoGLInstancer.h"
 
 /*!
   \enum SoArray::Origin
@@ -125,6 +131,40 @@
 
 // *************************************************************************
 
+// Returns the translation of the element with index i along the Z
+// axis, j along the Y axis and k along the X axis.
+static SbVec3f
+soarray_instance_pos(const SoArray * array, const int i, const int j, const int k)
+{
+  float multfactor_i = float(i);
+  float multfactor_j = float(j);
+  float multfactor_k = float(k);
+
+  switch (array->origin.getValue()) {
+  case SoArray::FIRST:
+    break;
+  case SoArray::CENTER:
+    multfactor_i = -float(array->numElements3.getValue()-1.0f)/2.0f + float(i);
+    multfactor_j = -float(array->numElements2.getValue()-1.0f)/2.0f + float(j);
+    multfactor_k = -float(array->numElements1.getValue()-1.0f)/2.0f + float(k);
+    break;
+  case SoArray::LAST:
+    multfactor_i = -multfactor_i;
+    multfactor_j = -multfactor_j;
+    multfactor_k = -multfactor_k;
+    break;
+
+  default: assert(0); break;
+  }
+
+  return
+    array->separation3.getValue() * multfactor_i +
+    array->separation2.getValue() * multfactor_j +
+    array->separation1.getValue() * multfactor_k;
+}
+
+// *************************************************************************
+
 SO_NODE_SOURCE(SoArray);
 
 /*!
@@ -154,6 +194,7 @@ SoArray::SoArray(void)
 */
 SoArray::~SoArray()
 {
+  SoGLInstancer::remove(this);
 }
 
 // Doc in superclass.
@@ -344,6 +385,30 @@ SoArray::getBoundingBox(SoGetBoundingBoxAction * action)
 void
 SoArray::GLRender(SoGLRenderAction * action)
 {
+  const int n1 = this->numElements1.getValue();
+  const int n2 = this->numElements2.getValue();
+  const int n3 = this->numElements3.getValue();
+  const int num = (n1 > 0 && n2 > 0 && n3 > 0) ? n1 * n2 * n3 : 0;
+  SoGLInstancer * instancer = SoGLInstancer::acquire(action, this, num);
+  if (instancer) {
+    if (instancer->needsMatrices(this)) {
+      // in the same order as doAction() visits the elements
+      SbList<SbMatrix> matrices(num);
+      for (int i = 0; i < n3; i++) {
+        for (int j = 0; j < n2; j++) {
+          for (int k = 0; k < n1; k++) {
+            SbMatrix m;
+            m.setTranslate(soarray_instance_pos(this, i, j, k));
+            matrices.append(m);
+          }
+        }
+      }
+      instancer->setMatrices(matrices.getArrayPtr(), num, this->getNodeId());
+    }
+    instancer->render(action, this);
+    instancer->release();
+    return;
+  }
   SoArray::doAction(action);
 }
 
@@ -362,32 +427,7 @@ SoArray::doAction(SoAction *action)
   for (int i=0; i < numElements3.getValue(); i++) {
     for (int j=0; j < numElements2.getValue(); j++) {
       for (int k=0; k < numElements1.getValue(); k++) {
-
-        float multfactor_i = float(i);
-        float multfactor_j = float(j);
-        float multfactor_k = float(k);
-
-        switch (origin.getValue()) {
-        case SoArray::FIRST:
-          break;
-        case SoArray::CENTER:
-          multfactor_i = -float(numElements3.getValue()-1.0f)/2.0f + float(i);
-          multfactor_j = -float(numElements2.getValue()-1.0f)/2.0f + float(j);
-          multfactor_k = -float(numElements1.getValue()-1.0f)/2.0f + float(k);
-          break;
-        case SoArray::LAST:
-          multfactor_i = -multfactor_i;
-          multfactor_j = -multfactor_j;
-          multfactor_k = -multfactor_k;
-          break;
-
-        default: assert(0); break;
-        }
-
-        SbVec3f instance_pos =
-          separation3.getValue() * multfactor_i +
-          separation2.getValue() * multfactor_j +
-          separation1.getValue() * multfactor_k;
+        SbVec3f instance_pos = soarray_instance_pos(this, i, j, k);
 
         action->getState()->push();
 
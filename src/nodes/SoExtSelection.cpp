@@ -350,6 +350,10 @@ public:
 
   void selectAndReset(SoHandleEventAction * action);
   void performSelection(SoHandleEventAction * action);
+  void startSelection(const SbViewportRegion & vp);
+  void searchAllShapes(SoNode * root);
+  void convertRectangle(void);
+  void convertWorldLasso(const SbViewVolume & vv, const SbViewportRegion & vp);
 
   void validateViewportBBox(SbBox2s & bbox, 
                             const SbVec2s & vpsize);
@@ -451,6 +455,9 @@ public:
   unsigned int drawcounter;
   SoPathList *visitedshapepaths;
   SbBool somefacesvisible;
+  // lasso in world coordinates for select(), projected when the
+  // camera is traversed
+  SbList<SbVec3f> worldlasso;
   SoPathList dummypathlist;
 
 private:
@@ -1250,27 +1257,82 @@ SoExtSelection::GLRenderBelowPath(SoGLRenderAction * action)
 /*!
   Simulate lasso selection programmatically.
 
-  This function is currently just stubbed.
-*/
+  The \a numcoords points in \a lasso are given in world coordinates,
+  and are projected to the viewport \a vp using the first camera
+  found when traversing \a root. Two points are taken to be opposite
+  corners of a rectangle, more than two points a lasso polygon.
+
+  Shapes below this node are selected according to the lassoPolicy
+  field and the selection policy. If \a shiftpolicy is \c TRUE, the
+  selection behaves as if the shift key was held down.
 
+  The selection does not need an OpenGL context, and always behaves
+  as if lassoMode is \c ALL_SHAPES. Shapes with projected bounding
+  boxes completely inside or outside the lasso are accepted or
+  rejected without testing their primitives.
+*/
 void
-SoExtSelection::select(SoNode * COIN_UNUSED_ARG(root), int COIN_UNUSED_ARG(numcoords), SbVec3f * COIN_UNUSED_ARG(lasso), const SbViewportRegion & COIN_UNUSED_ARG(vp), SbBool COIN_UNUSED_ARG(shiftpolicy))
+SoExtSelection::select(SoNode * root, int numcoords, SbVec3f * lasso, const SbViewportRegion & vp, SbBool shiftpolicy)
 {
-  // FIXME: Implement this for TGS compatibility...
-  COIN_STUB_ONCE();
+  if (numcoords < 1) return;
+
+  PRIVATE(this)->runningselection.reset();
+  PRIVATE(this)->runningselection.mode = (numcoords == 2) ?
+    SoExtSelectionP::SelectionState::RECTANGLE :
+    SoExtSelectionP::SelectionState::LASSO;
+  for (int i = 0; i < numcoords; i++) {
+    PRIVATE(this)->worldlasso.append(lasso[i]);
+  }
+  PRIVATE(this)->wasshiftdown = shiftpolicy;
+
+  PRIVATE(this)->startSelection(vp);
+  PRIVATE(this)->searchAllShapes(root);
+  PRIVATE(this)->selectPaths();
+
+  PRIVATE(this)->worldlasso.truncate(0);
+  PRIVATE(this)->runningselection.reset();
+
+  this->finishCBList->invokeCallbacks(this);
+  this->touch();
 }
 
 /*!
   Simulate lasso selection programmatically.
 
-  This function is currently just stubbed.
-*/
+  The \a numcoords points in \a lasso are given in normalized
+  coordinates, where <0, 0> is the lower left corner and <1, 1> the
+  upper right corner of the viewport \a vp. Two points are taken to
+  be opposite corners of a rectangle, more than two points a lasso
+  polygon. A camera should be present in \a root.
 
+  See the other select() method for more information.
+*/
 void
-SoExtSelection::select(SoNode * COIN_UNUSED_ARG(root), int COIN_UNUSED_ARG(numcoords), SbVec2f * COIN_UNUSED_ARG(lasso), const SbViewportRegion & COIN_UNUSED_ARG(vp), SbBool COIN_UNUSED_ARG(shiftpolicy))
+SoExtSelection::select(SoNode * root, int numcoords, SbVec2f * lasso, const SbViewportRegion & vp, SbBool shiftpolicy)
 {
-  // FIXME: Implement this for TGS compatibility...
-  COIN_STUB_ONCE();
+  if (numcoords < 1) return;
+
+  const SbVec2s org = vp.getViewportOriginPixels();
+  const SbVec2s siz = vp.getViewportSizePixels();
+
+  PRIVATE(this)->runningselection.reset();
+  PRIVATE(this)->runningselection.mode = (numcoords == 2) ?
+    SoExtSelectionP::SelectionState::RECTANGLE :
+    SoExtSelectionP::SelectionState::LASSO;
+  for (int i = 0; i < numcoords; i++) {
+    PRIVATE(this)->runningselection.coords.append(SbVec2s((short) (org[0] + lasso[i][0] * siz[0]),
+                                                          (short) (org[1] + lasso[i][1] * siz[1])));
+  }
+  PRIVATE(this)->wasshiftdown = shiftpolicy;
+
+  PRIVATE(this)->startSelection(vp);
+  PRIVATE(this)->searchAllShapes(root);
+  PRIVATE(this)->selectPaths();
+
+  PRIVATE(this)->runningselection.reset();
+
+  this->finishCBList->invokeCallbacks(this);
+  this->touch();
 }
 
 /*!
@@ -1492,6 +1554,10 @@ SoExtSelectionP::cameraCB(void * data,
   // Save viewvolume for later use.
   thisp->pimpl->offscreenviewvolume = vv;
 
+  if (PRIVATE(thisp)->worldlasso.getLength()) {
+    PRIVATE(thisp)->convertWorldLasso(vv, vp);
+  }
+
   SbBox2s rectbbox;
   for (int i = 0; i < PRIVATE(thisp)->runningselection.coords.getLength(); i++) {
     rectbbox.extendBy(PRIVATE(thisp)->runningselection.coords[i]);
@@ -1521,6 +1587,12 @@ SoExtSelectionP::testShape(SoCallbackAction * action, const SoShape * shape)
   int i;
   SoState * state = action->getState();
 
+  // a lasso given in world coordinates is not known until a camera
+  // has been traversed
+  if (this->runningselection.coords.getLength() == 0) {
+    return SoCallbackAction::PRUNE;
+  }
+
   SbBox2s rectbbox;
   for (i = 0; i < this->runningselection.coords.getLength(); i++) {
     rectbbox.extendBy(this->runningselection.coords[i]);
@@ -1569,6 +1641,54 @@ project_pt(const SbMatrix & projmatrix, const SbVec3f & v,
                  (short) SbClamp(normpt[1], -32768.0f, 32767.0f));
 }
 
+// classification of a projected bounding box against the lasso
+enum LassoBoxRelation { BOX_OUTSIDE, BOX_INSIDE, BOX_STRADDLES };
+
+// Project a bounding box to screen, and find how the screen space
+// rectangle enclosing it relates to the lasso polygon. Boxes partly
+// behind the eye can't be projected reliably, and are reported as
+// straddling the lasso.
+static LassoBoxRelation
+classify_projbox(const SbList <SbVec2s> & poly, const SbBox2s & lassorect,
+                 const SbMatrix & projmatrix, const SbBox3f & bbox,
+                 const SbVec2s & vporg, const SbVec2s & vpsize)
+{
+  const SbVec3f & mincorner = bbox.getMin();
+  const SbVec3f & maxcorner = bbox.getMax();
+
+  SbBox2s rect;
+  for (int i = 0; i < 8; i++) {
+    SbVec3f corner(i & 1 ? maxcorner[0] : mincorner[0],
+                   i & 2 ? maxcorner[1] : mincorner[1],
+                   i & 4 ? maxcorner[2] : mincorner[2]);
+    const float w =
+      corner[0] * projmatrix[0][3] + corner[1] * projmatrix[1][3] +
+      corner[2] * projmatrix[2][3] + projmatrix[3][3];
+    if (w <= 0.0f) return BOX_STRADDLES;
+    rect.extendBy(project_pt(projmatrix, corner, vporg, vpsize));
+  }
+  if (!lassorect.intersect(rect)) return BOX_OUTSIDE;
+
+  const SbVec2s & rmin = rect.getMin();
+  const SbVec2s & rmax = rect.getMax();
+  const SbVec2s c0(rmin[0], rmin[1]);
+  const SbVec2s c1(rmax[0], rmin[1]);
+  const SbVec2s c2(rmax[0], rmax[1]);
+  const SbVec2s c3(rmin[0], rmax[1]);
+
+  if (poly_line_intersect(poly, c0, c1, FALSE) ||
+      poly_line_intersect(poly, c1, c2, FALSE) ||
+      poly_line_intersect(poly, c2, c3, FALSE) ||
+      poly_line_intersect(poly, c3, c0, FALSE)) {
+    return BOX_STRADDLES;
+  }
+  // no edges cross, so either one is inside the other, or they are
+  // disjoint
+  if (point_in_poly(poly, c0)) return BOX_INSIDE;
+  if (rect.intersect(poly[0])) return BOX_STRADDLES;
+  return BOX_OUTSIDE;
+}
+
 // test for intersection between bounding box and lasso/rectangle
 SoCallbackAction::Response
 SoExtSelectionP::testBBox(SoCallbackAction * action,
@@ -1652,20 +1772,10 @@ SoExtSelectionP::testBBox(SoCallbackAction * action,
 SoCallbackAction::Response
 SoExtSelectionP::testPrimitives(SoCallbackAction * action,
                                 const SbMatrix & projmatrix,
-                                const SoShape * /* shape */,
+                                const SoShape * shape,
                                 const SbBox2s & lassorect,
                                 const SbBool full)
 {
-  // FIXME: consider quick reject based on bounding box for now we
-  // just initialize some variables, and trust that the user has a
-  // sensible scene graph so that shapes are culled in the separators.
-  // ????-??-?? pederb.
-  //
-  // FIXME: I believe what pederb mention above would be a _very_
-  // important optimization -- especially when using VISIBLE_SHAPES
-  // with a small rectangle/polygon selection in a huge scene.
-  // 20050309 mortene.
-
   this->primcbdata.fulltest = full;
   this->primcbdata.projmatrix = projmatrix;
   this->primcbdata.lassorect = lassorect;
@@ -1676,6 +1786,44 @@ SoExtSelectionP::testPrimitives(SoCallbackAction * action,
   this->primcbdata.abort = FALSE;
   this->primcbdata.onlyrect = (this->runningselection.mode == SelectionState::LASSO);
   this->primcbdata.hasgeometry = FALSE;
+
+  // Quick accept or reject based on the projected bounding box of the
+  // shape, so that only shapes straddling the lasso edge need to have
+  // their primitives tested. This can't be done for VISIBLE_SHAPES,
+  // where all primitives are needed for the offscreen buffer. Shapes
+  // can only be accepted without generating primitives if there are
+  // no filter callbacks that should see them.
+  if (this->primcbdata.allshapes) {
+    SbBox3f bbox;
+    SbVec3f center;
+    const SoBoundingBoxCache * bboxcache = shape->getBoundingBoxCache();
+    if (bboxcache && bboxcache->isValid(action->getState())) {
+      bbox = bboxcache->getProjectedBox();
+    }
+    else {
+      ((SoShape *)shape)->computeBBox(action, bbox, center);
+    }
+    if (!bbox.isEmpty()) {
+      switch (classify_projbox(this->runningselection.coords, lassorect,
+                               projmatrix, bbox, this->primcbdata.vporg,
+                               this->primcbdata.vpsize)) {
+      case BOX_OUTSIDE:
+        this->primcbdata.allhit = FALSE;
+        return SoCallbackAction::PRUNE;
+      case BOX_INSIDE:
+        if (!this->triangleFilterCB && !this->lineFilterCB && !this->pointFilterCB) {
+          // postShapeCallback() is still invoked, and will pick up the hit
+          this->primcbdata.hit = TRUE;
+          this->primcbdata.hasgeometry = TRUE;
+          return SoCallbackAction::PRUNE;
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
   // signal to callback action that we want to generate primitives for
   // this shape
   return SoCallbackAction::CONTINUE;
@@ -2550,35 +2698,63 @@ SoExtSelectionP::selectAndReset(SoHandleEventAction * action)
   this->runningselection.reset();
 }
 
-// start a selecting for the current lasso/rectangle
+// convert a two-point rectangle to a polygon
 void
-SoExtSelectionP::performSelection(SoHandleEventAction * action)
+SoExtSelectionP::convertRectangle(void)
+{
+  assert(this->runningselection.coords.getLength() == 2);
+
+  const SbVec2s p0 = this->runningselection.coords[0];
+  const SbVec2s p1 = this->runningselection.coords[1];
+  this->runningselection.coords[1] = SbVec2s(p1[0], p0[1]);
+  this->runningselection.coords.append(p1);
+  this->runningselection.coords.append(SbVec2s(p0[0], p1[1]));
+}
+
+// project the world space lasso given to select() into the viewport
+void
+SoExtSelectionP::convertWorldLasso(const SbViewVolume & vv,
+                                   const SbViewportRegion & vp)
+{
+  const SbVec2s org = vp.getViewportOriginPixels();
+  const SbVec2s siz = vp.getViewportSizePixels();
+
+  this->runningselection.coords.truncate(0);
+  for (int i = 0; i < this->worldlasso.getLength(); i++) {
+    SbVec3f ndc;
+    vv.projectToScreen(this->worldlasso[i], ndc);
+    this->runningselection.coords.append(SbVec2s((short) SbClamp(org[0] + ndc[0] * siz[0], -32768.0f, 32767.0f),
+                                                 (short) SbClamp(org[1] + ndc[1] * siz[1], -32768.0f, 32767.0f)));
+  }
+  if (this->runningselection.mode == SelectionState::RECTANGLE) {
+    this->convertRectangle();
+  }
+}
+
+// common setup before searching for shapes inside the lasso
+void
+SoExtSelectionP::startSelection(const SbViewportRegion & vp)
 {
   assert(this->runningselection.mode != SelectionState::NONE);
 
   if (SoExtSelectionP::debug()) {
     for (int i = 0; i < this->runningselection.coords.getLength(); i++) {
       const SbVec2s & c = this->runningselection.coords[i];
-      SoDebugError::postInfo("SoExtSelectionP::performSelection",
+      SoDebugError::postInfo("SoExtSelectionP::startSelection",
                              "coord[%d]==<%d, %d>", i, c[0], c[1]);
     }
   }
 
   // convert the rectangle to a polygon
-  if (this->runningselection.mode == SelectionState::RECTANGLE) {
-    assert(this->runningselection.coords.getLength() == 2);
-
-    const SbVec2s p0 = this->runningselection.coords[0];
-    const SbVec2s p1 = this->runningselection.coords[1];
-    this->runningselection.coords[1] = SbVec2s(p1[0], p0[1]);
-    this->runningselection.coords.append(p1);
-    this->runningselection.coords.append(SbVec2s(p0[0], p1[1]));
+  if (this->runningselection.mode == SelectionState::RECTANGLE &&
+      this->worldlasso.getLength() == 0) {
+    this->convertRectangle();
   }
 
   //Send signal to client that tris are coming up,
   PUBLIC(this)->startCBList->invokeCallbacks(PUBLIC(this));
 
-  this->curvp = SoViewportRegionElement::get(action->getState());
+  this->curvp = vp;
   this->cbaction->setViewportRegion(this->curvp);
 
   switch (PUBLIC(this)->policy.getValue()) {
@@ -2591,19 +2767,32 @@ SoExtSelectionP::performSelection(SoHandleEventAction * action)
   default:
     break;
   }
+}
 
-  if (PUBLIC(this)->lassoMode.getValue() == SoExtSelection::ALL_SHAPES) {
-    this->offscreencolorcounter = 1;
-    this->offscreenskipcounter = 0;
-    this->applyonlyonselectedtriangles = FALSE;
-    this->offscreencolorcounteroverflow = FALSE;
-    this->drawcallbackcounter = 0;
-    this->drawcounter = 0;
+// search for all shapes inside the lasso, regardless of visibility
+void
+SoExtSelectionP::searchAllShapes(SoNode * root)
+{
+  this->offscreencolorcounter = 1;
+  this->offscreenskipcounter = 0;
+  this->applyonlyonselectedtriangles = FALSE;
+  this->offscreencolorcounteroverflow = FALSE;
+  this->drawcallbackcounter = 0;
+  this->drawcounter = 0;
 
-    // Execute 'search' for triangles
-    primcbdata.allshapes = TRUE;
-    this->cbaction->apply(action->getCurPath()->getHead());
+  // Execute 'search' for triangles
+  primcbdata.allshapes = TRUE;
+  this->cbaction->apply(root);
+}
 
+// start a selecting for the current lasso/rectangle
+void
+SoExtSelectionP::performSelection(SoHandleEventAction * action)
+{
+  this->startSelection(SoViewportRegionElement::get(action->getState()));
+
+  if (PUBLIC(this)->lassoMode.getValue() == SoExtSelection::ALL_SHAPES) {
+    this->searchAllShapes(action->getCurPath()->getHead());
   }
   else {
 
@@ -2777,3 +2966,81 @@ SoExtSelectionP::validateViewportBBox(SbBox2s & bbox,
 
 #undef PRIVATE
 #undef PUBLIC
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbVec2f.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoOrthographicCamera.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+// a 10x10 grid of small cubes in the z=0 plane, centered in the view
+// of an orthographic camera, so one unit is ten pixels in a 100x100
+// viewport
+static SoExtSelection *
+extsel_create_grid(void)
+{
+  SoExtSelection * sel = new SoExtSelection;
+  SoOrthographicCamera * camera = new SoOrthographicCamera;
+  camera->position = SbVec3f(0.0f, 0.0f, 10.0f);
+  camera->height = 10.0f;
+  camera->nearDistance = 1.0f;
+  camera->farDistance = 20.0f;
+  sel->addChild(camera);
+
+  for (int y = 0; y < 10; y++) {
+    for (int x = 0; x < 10; x++) {
+      SoSeparator * sep = new SoSeparator;
+      SoTranslation * t = new SoTranslation;
+      t->translation = SbVec3f(x - 4.5f, y - 4.5f, 0.0f);
+      SoCube * cube = new SoCube;
+      cube->width = cube->height = cube->depth = 0.5f;
+      sep->addChild(t);
+      sep->addChild(cube);
+      sel->addChild(sep);
+    }
+  }
+  return sel;
+}
+
+BOOST_AUTO_TEST_CASE(selectProgrammatic)
+{
+  SoExtSelection * sel = extsel_create_grid();
+  sel->ref();
+  const SbViewportRegion vp(100, 100);
+
+  // the right edge of the rectangle cuts through the fifth column
+  SbVec2f rect[2] = { SbVec2f(0.0f, 0.0f), SbVec2f(0.45f, 1.0f) };
+
+  sel->lassoPolicy = SoExtSelection::PART;
+  sel->select(sel, 2, rect, vp, FALSE);
+  BOOST_CHECK_MESSAGE(sel->getNumSelected() == 50,
+                      "PART should select the five leftmost columns");
+
+  sel->lassoPolicy = SoExtSelection::FULL;
+  sel->select(sel, 2, rect, vp, FALSE);
+  BOOST_CHECK_MESSAGE(sel->getNumSelected() == 40,
+                      "FULL should select the four leftmost columns");
+
+  // the same lasso as a polygon in world coordinates
+  SbVec3f lasso[4] = {
+    SbVec3f(-5.0f, -5.0f, 0.0f), SbVec3f(-0.5f, -5.0f, 0.0f),
+    SbVec3f(-0.5f, 5.0f, 0.0f), SbVec3f(-5.0f, 5.0f, 0.0f)
+  };
+  sel->lassoPolicy = SoExtSelection::PART;
+  sel->select(sel, 4, lasso, vp, FALSE);
+  BOOST_CHECK_MESSAGE(sel->getNumSelected() == 50,
+                      "PART should select the five leftmost columns");
+
+  // a triangle covering the lower left half, with shift held down to
+  // toggle the selection
+  SbVec2f tri[3] = { SbVec2f(0.0f, 0.0f), SbVec2f(1.0f, 0.0f), SbVec2f(0.0f, 1.0f) };
+  sel->lassoPolicy = SoExtSelection::FULL;
+  sel->select(sel, 3, tri, vp, TRUE);
+  BOOST_CHECK_MESSAGE(sel->getNumSelected() == 50 + 45 - 2 * 35,
+                      "shift should toggle the FULL triangle selection");
+
+  sel->unref();
+}
+
+#endif // COIN_TEST_SUITE
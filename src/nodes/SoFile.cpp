@@ -470,3 +470,73 @@ SoFile::getSearchOK()
 {
   return SoFileP::searchok;
 }
+
+#ifdef COIN_TEST_SUITE
+
+#include <cstdio>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SoInput.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+static SbBox3f
+sofile_test_read(const char * filename, const int numthreads)
+{
+  SoInput in;
+  in.setNumPrefetchThreads(numthreads);
+  BOOST_REQUIRE(in.openFile(filename));
+  SoSeparator * root = SoDB::readAll(&in);
+  BOOST_REQUIRE(root != NULL);
+  root->ref();
+
+  SoGetBoundingBoxAction bbaction(SbViewportRegion(100, 100));
+  bbaction.apply(root);
+  root->unref();
+  return bbaction.getBoundingBox();
+}
+
+BOOST_AUTO_TEST_CASE(prefetchSubFiles)
+{
+  static const char * files[][2] = {
+    { "SoFile_prefetch_root.iv",
+      "#Inventor V2.1 ascii\n"
+      "Separator {\n"
+      "  File { name \"SoFile_prefetch_a.iv\" }\n"
+      "  Translation { translation 10 0 0 }\n"
+      "  # File { name \"SoFile_prefetch_missing.iv\" }\n"
+      "  File { name SoFile_prefetch_b.iv }\n"
+      "}\n" },
+    { "SoFile_prefetch_a.iv",
+      "#Inventor V2.1 ascii\n"
+      "Separator {\n"
+      "  Translation { translation 0 5 0 }\n"
+      "  File { name \"SoFile_prefetch_b.iv\" }\n"
+      "}\n" },
+    { "SoFile_prefetch_b.iv",
+      "#Inventor V2.1 ascii\n"
+      "Cube { width 1 height 1 depth 1 }\n" }
+  };
+  const int numfiles = sizeof(files) / sizeof(files[0]);
+
+  for (int i = 0; i < numfiles; i++) {
+    FILE * fp = fopen(files[i][0], "wb");
+    BOOST_REQUIRE(fp != NULL);
+    fputs(files[i][1], fp);
+    fclose(fp);
+  }
+
+  const SbBox3f sequential = sofile_test_read(files[0][0], 0);
+  const SbBox3f prefetched = sofile_test_read(files[0][0], 4);
+
+  for (int i = 0; i < numfiles; i++) { remove(files[i][0]); }
+
+  BOOST_CHECK_MESSAGE(sequential.getMin() == SbVec3f(-0.5f, -0.5f, -0.5f) &&
+                      sequential.getMax() == SbVec3f(10.5f, 5.5f, 0.5f),
+                      "sub-files not read");
+  BOOST_CHECK_MESSAGE(prefetched.getMin() == sequential.getMin() &&
+                      prefetched.getMax() == sequential.getMax(),
+                      "prefetched sub-files read differently");
+}
+
+#endif // COIN_TEST_SUITE
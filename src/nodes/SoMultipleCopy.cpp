@@ -43,6 +43,11 @@
   scaling) for its children. Apart from transformations, the
   appearance of its children will be identical.
 
+  When SoGLRenderAction::setInstancedRendering() is enabled, the
+  children are traversed once and their shapes are drawn for all the
+  matrices with instanced draw calls, when the OpenGL driver and the
+  shapes allow it.
+
   <b>FILE FORMAT/DEFAULTS:</b>
   \code
     MultipleCopy {
@@ -69,6 +74,7 @@
 #include <Inventor/nodes/SoSwitch.h> // SO_SWITCH_ALL
 
 #include "nodes/SoSubNodeP.h"
+#include "rendering/SoGLInstancer.h"
 
 // *************************************************************************
 
@@ -105,6 +111,7 @@ SoMultipleCopy::SoMultipleCopy(void)
 */
 SoMultipleCopy::~SoMultipleCopy()
 {
+  SoGLInstancer::remove(this);
 }
 
 // Doc in superclass.
@@ -169,6 +176,17 @@ SoMultipleCopy::getBoundingBox(SoGetBoundingBoxAction * action)
 void
 SoMultipleCopy::GLRender(SoGLRenderAction * action)
 {
+  SoGLInstancer * instancer =
+    SoGLInstancer::acquire(action, this, this->matrix.getNum());
+  if (instancer) {
+    if (instancer->needsMatrices(this)) {
+      instancer->setMatrices(this->matrix.getValues(0), this->matrix.getNum(),
+                             this->getNodeId());
+    }
+    instancer->render(action, this);
+    instancer->release();
+    return;
+  }
   SoMultipleCopy::doAction((SoAction*)action);
 }
 
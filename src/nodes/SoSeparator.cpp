@@ -64,8 +64,9 @@
 #include "config.h"
 #endif // HAVE_CONFIG_H
 
-#include <cstdlib> // strtol(), rand()
+#include <cstdlib> // strtol(), rand(), qsort()
 #include <climits> // LONG_MIN, LONG_MAX
+#include <cstring> // memset()
 
 #include <Inventor/actions/SoCallbackAction.h>
 #include <Inventor/actions/SoGLRenderAction.h>
@@ -97,6 +98,8 @@
 #include "glue/glp.h"
 #include "rendering/SoGL.h"
 #include "misc/SoDBP.h"
+#include "misc/SbHash.h"
+#include "rendering/SoGLRenderQueue.h"
 
 #include <Inventor/annex/Profiler/SoProfiler.h>
 #include "profiler/SoNodeProfiling.h"
@@ -250,6 +253,16 @@ int SoSeparator::numrendercaches = 2;
   Policy for caching bounding box calculations. Default value is
   SoSeparator::AUTO.
 
+  When caching, a separator with many children that do not affect the
+  traversal state (typically other separators) also keeps the bounding
+  box of each child. A change below one of the children then only
+  recomputes that child, and the cached boxes of the other children
+  are combined with it, so a local edit in a large scene graph does not
+  make the next bounding box traversal visit the whole graph. The box
+  is combined in a different order than by a full traversal, so it
+  may differ slightly from the box of an uncached traversal when the
+  children have different transformations.
+
   See also documentation for SoSeparator::renderCaching.
 */
 /*!
@@ -281,6 +294,7 @@ int SoSeparator::numrendercaches = 2;
 // glcachelist
 typedef struct {
   SoGLCacheList * glcachelist;
+  SoGLRenderQueue * renderqueue;
 } soseparator_storage;
 
 static void
@@ -288,6 +302,7 @@ soseparator_storage_construct(void * data)
 {
   soseparator_storage * ptr = (soseparator_storage*) data;
   ptr->glcachelist = NULL;
+  ptr->renderqueue = NULL;
 }
 
 static void
@@ -295,6 +310,178 @@ soseparator_storage_destruct(void * data)
 {
   soseparator_storage * ptr = (soseparator_storage*) data;
   delete ptr->glcachelist;
+  delete ptr->renderqueue;
+}
+
+// *************************************************************************
+
+// The bounding box of a child, or of a range of children, of a
+// separator using a SoSeparatorBBoxTree.
+struct SoSeparatorBBoxNode {
+  SbXfBox3f box;
+  SbVec3f centersum;
+  int numcenters;
+  SbBool linesorpoints;
+};
+
+// Keeps the bounding boxes of the children of a wide separator in a
+// tree where each node combines FANOUT nodes of the level below, so
+// that a change to a few children only recomputes the path from their
+// leaves to the root. Only used when no child affects the traversal
+// state, so that each child's box is independent of its siblings.
+class SoSeparatorBBoxTree {
+public:
+  enum {
+    FANOUT = 8,
+    // separators with fewer children are traversed as before
+    MINCHILDREN = 16
+  };
+
+  SoSeparatorBBoxTree(void)
+    : nodes(NULL), numnodes(0), childindex(NULL), dirty(NULL), valid(FALSE) { }
+  ~SoSeparatorBBoxTree() {
+    delete[] this->nodes;
+    delete[] this->dirty;
+    delete this->childindex;
+  }
+
+  static SbBool canTrack(const SoChildList * children);
+
+  void reset(const SoChildList * children);
+  SbBool markDirty(const SoNode * child);
+
+  int getNumLeaves(void) const { return this->levelstart[1]; }
+  SoSeparatorBBoxNode & getLeaf(const int idx) { return this->nodes[idx]; }
+  const SoSeparatorBBoxNode & getRoot(void) const { return this->nodes[this->numnodes - 1]; }
+
+  void build(void);
+  void update(SbList<int> & leaves);
+
+  SoSeparatorBBoxNode * nodes;
+  int numnodes;
+  // start of each level in nodes, the leaves first
+  SbList<int> levelstart;
+  // index of each child, or -1 for children added more than once
+  SbHash<const SoNode *, int> * childindex;
+  char * dirty;
+  SbList<int> dirtylist;
+  // FALSE after a change that is not below a single child
+  SbBool valid;
+
+private:
+  void combine(const int level, const int idx);
+};
+
+SbBool
+SoSeparatorBBoxTree::canTrack(const SoChildList * children)
+{
+  const int n = children->getLength();
+  if (n < MINCHILDREN) return FALSE;
+  for (int i = 0; i < n; i++) {
+    if ((*children)[i]->affectsState()) return FALSE;
+  }
+  return TRUE;
+}
+
+void
+SoSeparatorBBoxTree::reset(const SoChildList * children)
+{
+  const int n = children->getLength();
+  if (this->levelstart.getLength() == 0 || n != this->getNumLeaves()) {
+    this->levelstart.truncate(0);
+    int start = 0, num = n;
+    for (;;) {
+      this->levelstart.append(start);
+      start += num;
+      if (num == 1) break;
+      num = (num + FANOUT - 1) / FANOUT;
+    }
+    this->levelstart.append(start);
+    delete[] this->nodes;
+    this->nodes = new SoSeparatorBBoxNode[start];
+    this->numnodes = start;
+    delete[] this->dirty;
+    this->dirty = new char[n];
+  }
+  (void)memset(this->dirty, 0, n);
+  this->dirtylist.truncate(0);
+
+  delete this->childindex;
+  this->childindex = new SbHash<const SoNode *, int>(n * 2);
+  for (int i = 0; i < n; i++) {
+    if (!this->childindex->put((*children)[i], i)) {
+      this->childindex->put((*children)[i], -1);
+    }
+  }
+  this->valid = TRUE;
+}
+
+SbBool
+SoSeparatorBBoxTree::markDirty(const SoNode * child)
+{
+  int idx;
+  if (!this->childindex->get(child, idx) || idx < 0) return FALSE;
+  if (!this->dirty[idx]) {
+    this->dirty[idx] = 1;
+    this->dirtylist.append(idx);
+  }
+  return TRUE;
+}
+
+void
+SoSeparatorBBoxTree::combine(const int level, const int idx)
+{
+  const int first = this->levelstart[level - 1] + idx * FANOUT;
+  const int last = SbMin(first + FANOUT, this->levelstart[level]);
+  SoSeparatorBBoxNode & node = this->nodes[this->levelstart[level] + idx];
+
+  node.box.makeEmpty();
+  node.centersum.setValue(0.0f, 0.0f, 0.0f);
+  node.numcenters = 0;
+  node.linesorpoints = FALSE;
+  for (int i = first; i < last; i++) {
+    const SoSeparatorBBoxNode & child = this->nodes[i];
+    if (!child.box.isEmpty()) node.box.extendBy(child.box);
+    node.centersum += child.centersum;
+    node.numcenters += child.numcenters;
+    if (child.linesorpoints) node.linesorpoints = TRUE;
+  }
+}
+
+void
+SoSeparatorBBoxTree::build(void)
+{
+  for (int level = 1; level < this->levelstart.getLength() - 1; level++) {
+    const int num = this->levelstart[level + 1] - this->levelstart[level];
+    for (int i = 0; i < num; i++) this->combine(level, i);
+  }
+}
+
+// qsort callback used for sorting the changed leaves
+extern "C" {
+static int
+compare_leaf(const void * v0, const void * v1)
+{
+  return *static_cast<const int *>(v0) - *static_cast<const int *>(v1);
+}
+}
+
+void
+SoSeparatorBBoxTree::update(SbList<int> & leaves)
+{
+  // sorted so that leaves with a common parent are next to each other
+  qsort((void *)leaves.getArrayPtr(), leaves.getLength(), sizeof(int), compare_leaf);
+
+  int divisor = 1;
+  for (int level = 1; level < this->levelstart.getLength() - 1; level++) {
+    divisor *= FANOUT;
+    int prev = -1;
+    for (int i = 0; i < leaves.getLength(); i++) {
+      const int idx = leaves[i] / divisor;
+      if (idx != prev) this->combine(level, idx);
+      prev = idx;
+    }
+  }
 }
 
 // *************************************************************************
@@ -317,6 +504,14 @@ public:
   SoBoundingBoxCache * bboxcache;
   uint32_t bboxcache_usecount;
   uint32_t bboxcache_destroycount;
+  SoSeparatorBBoxTree * bboxtree;
+
+  SbBool hasValidBBoxCache(SoState * state) const {
+    return this->bboxcache &&
+      (!this->bboxtree || this->bboxtree->dirtylist.getLength() == 0) &&
+      this->bboxcache->isValid(state);
+  }
+  void getChildBoundingBoxes(SoGetBoundingBoxAction * action, const SbBool update);
 
 #ifdef COIN_THREADSAFE
   // FIXME: a mutex for every SoSeparator instance seems a bit
@@ -337,6 +532,9 @@ public:
   enum { YES, NO, MAYBE } hassoundchild;
 
   SoGLCacheList * getGLCacheList(SbBool createifnull);
+  SoGLRenderQueue * getRenderQueue(void);
+  static void GLRenderQueued(SoGLRenderAction * action, SoGLRenderQueue * queue,
+                             SoSeparator * separator);
 
   void invalidateGLCaches(void) {
     glcachestorage->applyToAll(invalidate_gl_cache, NULL);
@@ -373,6 +571,121 @@ SoSeparatorP::getGLCacheList(SbBool createifnull)
   return ptr->glcachelist;
 }
 
+SoGLRenderQueue *
+SoSeparatorP::getRenderQueue(void)
+{
+  soseparator_storage * ptr =
+    (soseparator_storage*) this->glcachestorage->get();
+  if (ptr->renderqueue == NULL) {
+    ptr->renderqueue = new SoGLRenderQueue;
+  }
+  return ptr->renderqueue;
+}
+
+// Renders the children of separator in retained mode. Child
+// separators with many children are handled like they were part of
+// separator, so that each of their children is queued separately.
+// The queued shapes are flushed before other nodes are rendered or
+// change the state, which keeps the drawing order.
+void
+SoSeparatorP::GLRenderQueued(SoGLRenderAction * action, SoGLRenderQueue * queue,
+                             SoSeparator * separator)
+{
+  SoState * state = action->getState();
+  SoChildList * children = separator->getChildren();
+  const int n = children->getLength();
+  SbBool changedstate = FALSE;
+  action->pushCurPath();
+  for (int i = 0; i < n && !action->hasTerminated(); i++) {
+    SoNode * child = (*children)[i];
+    action->popPushCurPath(i, child);
+    if (action->abortNow()) {
+      SoCacheElement::invalidate(state);
+      break;
+    }
+    // subclasses may render their children differently
+    if (child->getTypeId() != SoSeparator::getClassTypeId()) {
+      queue->flush(action);
+      child->GLRenderBelowPath(action);
+      changedstate = TRUE;
+    }
+    else if (static_cast<SoSeparator *>(child)->getNumChildren() >= SoSeparatorBBoxTree::MINCHILDREN) {
+      state->push();
+      SoSeparatorP::GLRenderQueued(action, queue, static_cast<SoSeparator *>(child));
+      state->pop();
+    }
+    else {
+      queue->render(action, child);
+    }
+  }
+  action->popCurPath();
+  // the state is popped after returning
+  if (changedstate) queue->flush(action);
+}
+
+// Traverses the changed children, or all children if not updating,
+// and stores their bounding boxes in the tree.
+void
+SoSeparatorP::getChildBoundingBoxes(SoGetBoundingBoxAction * action, const SbBool update)
+{
+  SoState * state = action->getState();
+  SoChildList * children = PUBLIC(this)->getChildren();
+  SoSeparatorBBoxTree * tree = this->bboxtree;
+
+  SbList<int> leaves;
+  this->lock();
+  if (update) {
+    for (int i = 0; i < tree->dirtylist.getLength(); i++) {
+      leaves.append(tree->dirtylist[i]);
+      tree->dirty[tree->dirtylist[i]] = 0;
+    }
+    tree->dirtylist.truncate(0);
+  }
+  this->unlock();
+
+  // the center is averaged from the tree, like SoGroup does it
+  const SbBool centerset = action->isCenterSet();
+  const SbVec3f center = action->getCenter();
+  action->resetCenter();
+
+  // the children are traversed with a cache of their own, so that we
+  // know which of them has lines or points
+  SoBoundingBoxCache * probe = NULL;
+  const int num = update ? leaves.getLength() : tree->getNumLeaves();
+  for (int i = 0; i < num; i++) {
+    const int idx = update ? leaves[i] : i;
+    if (!probe) {
+      probe = new SoBoundingBoxCache(state);
+      probe->ref();
+    }
+    state->push();
+    SoCacheElement::set(state, probe);
+    children->traverse(action, idx);
+    state->pop();
+
+    SoSeparatorBBoxNode & leaf = tree->getLeaf(idx);
+    leaf.box = action->getXfBoundingBox();
+    leaf.numcenters = action->isCenterSet() ? 1 : 0;
+    if (leaf.numcenters) leaf.centersum = action->getCenter();
+    else leaf.centersum.setValue(0.0f, 0.0f, 0.0f);
+    // the flag can't be cleared, so a new cache is needed for the
+    // next child
+    leaf.linesorpoints = probe->hasLinesOrPoints();
+    if (leaf.linesorpoints) {
+      probe->unref();
+      probe = NULL;
+    }
+    action->getXfBoundingBox().makeEmpty();
+    action->resetCenter();
+  }
+  if (probe) probe->unref();
+
+  if (update) tree->update(leaves);
+  else tree->build();
+
+  if (centerset) action->setCenter(center, FALSE);
+}
+
 // *************************************************************************
 
 SO_NODE_SOURCE(SoSeparator);
@@ -441,6 +754,7 @@ SoSeparator::commonConstructor(void)
   PRIVATE(this)->bboxcache = NULL;
   PRIVATE(this)->bboxcache_usecount = 0;
   PRIVATE(this)->bboxcache_destroycount = 0;
+  PRIVATE(this)->bboxtree = NULL;
 
   // This environment variable is used for local stability / robustness /
   // correctness testing of the render caching. If set >= 1,
@@ -466,6 +780,7 @@ SoSeparator::~SoSeparator()
   if (PRIVATE(this)->bboxcache) {
     PRIVATE(this)->bboxcache->unref();
   }
+  delete PRIVATE(this)->bboxtree;
 }
 
 /*!
@@ -526,6 +841,19 @@ SoSeparator::getBoundingBox(SoGetBoundingBoxAction * action)
 
   SbBool validcache = iscaching && PRIVATE(this)->bboxcache && PRIVATE(this)->bboxcache->isValid(state);
 
+  // if only a few children have changed since the cache was made, the
+  // cache can be updated by traversing just those children
+  SbBool update = FALSE;
+  SoSeparatorBBoxTree * tree = PRIVATE(this)->bboxtree;
+  if (validcache && tree && tree->dirtylist.getLength()) {
+    validcache = FALSE;
+    update = tree->valid &&
+      tree->dirtylist.getLength() <= tree->getNumLeaves() / SoSeparatorBBoxTree::FANOUT;
+    for (int i = 0; update && i < tree->dirtylist.getLength(); i++) {
+      if ((*this->children)[tree->dirtylist[i]]->affectsState()) update = FALSE;
+    }
+  }
+
   if (iscaching && validcache) {
     SoCacheElement::addCacheDependency(state, PRIVATE(this)->bboxcache);
     PRIVATE(this)->bboxcache_usecount++;
@@ -542,7 +870,7 @@ SoSeparator::getBoundingBox(SoGetBoundingBoxAction * action)
     SbBool storedinvalid = FALSE;
 
     // check if we should disable auto caching
-    if (PRIVATE(this)->bboxcache_destroycount > 10 && this->boundingBoxCaching.getValue() == AUTO) {
+    if (!update && PRIVATE(this)->bboxcache_destroycount > 10 && this->boundingBoxCaching.getValue() == AUTO) {
       if (float(PRIVATE(this)->bboxcache_usecount) / float(PRIVATE(this)->bboxcache_destroycount) < 5.0f) {
         iscaching = FALSE;
       }
@@ -553,29 +881,52 @@ SoSeparator::getBoundingBox(SoGetBoundingBoxAction * action)
     }
     state->push();
 
+    SoBoundingBoxCache * oldcache = NULL;
     if (iscaching) {
       // lock before changing the bboxcache pointer so that the notify()
       // function can be used by another thread.
       PRIVATE(this)->lock();
-      // if we get here, we know bbox cache is not created or is invalid
-      if (PRIVATE(this)->bboxcache) {
-        PRIVATE(this)->bboxcache_destroycount++;
-        PRIVATE(this)->bboxcache->unref();
-      }
+      // if we get here, we know bbox cache is not created, is invalid,
+      // or needs to be updated for some of the children
+      oldcache = PRIVATE(this)->bboxcache;
+      if (oldcache && !update) PRIVATE(this)->bboxcache_destroycount++;
       PRIVATE(this)->bboxcache = new SoBoundingBoxCache(state);
       PRIVATE(this)->bboxcache->ref();
+      if (!update) {
+        if (SoSeparatorBBoxTree::canTrack(this->children)) {
+          if (!PRIVATE(this)->bboxtree) PRIVATE(this)->bboxtree = new SoSeparatorBBoxTree;
+          PRIVATE(this)->bboxtree->reset(this->children);
+        }
+        else {
+          delete PRIVATE(this)->bboxtree;
+          PRIVATE(this)->bboxtree = NULL;
+        }
+      }
       PRIVATE(this)->unlock();
       // set active cache to record cache dependencies
       SoCacheElement::set(state, PRIVATE(this)->bboxcache);
+      // the unchanged children depend on the same elements as before
+      if (update) SoCacheElement::addCacheDependency(state, oldcache);
+      if (oldcache) oldcache->unref();
     }
 
     SoLocalBBoxMatrixElement::makeIdentity(state);
     action->getXfBoundingBox().makeEmpty();
-    inherited::getBoundingBox(action);
+    if (iscaching && PRIVATE(this)->bboxtree) {
+      PRIVATE(this)->getChildBoundingBoxes(action, update);
+      const SoSeparatorBBoxNode & root = PRIVATE(this)->bboxtree->getRoot();
+      childrenbbox = root.box;
+      childrencenterset = root.numcenters > 0;
+      if (childrencenterset) childrencenter = root.centersum / float(root.numcenters);
+      if (root.linesorpoints) SoBoundingBoxCache::setHasLinesOrPoints(state);
+    }
+    else {
+      inherited::getBoundingBox(action);
 
-    childrenbbox = action->getXfBoundingBox();
-    childrencenterset = action->isCenterSet();
-    if (childrencenterset) childrencenter = action->getCenter();
+      childrenbbox = action->getXfBoundingBox();
+      childrencenterset = action->isCenterSet();
+      if (childrencenterset) childrencenter = action->getCenter();
+    }
 
     action->getXfBoundingBox() = abox; // reset action bbox
 
@@ -653,12 +1004,30 @@ void
 SoSeparator::GLRenderBelowPath(SoGLRenderAction * action)
 {
   SoState * state = action->getState();
+  // shapes are also recorded for instanced rendering, see SoGLInstancer
+  const SbBool recording = SoGLRenderQueue::getRecording(state) != NULL;
+  if (action->isRetainedRendering()) {
+    // the outermost separator keeps the render queue
+    if (!recording && !SoCacheElement::anyOpen(state)) {
+      state->push();
+      if (!this->cullTest(state)) {
+        SoGLRenderQueue * queue = PRIVATE(this)->getRenderQueue();
+        queue->beginFrame();
+        SoSeparatorP::GLRenderQueued(action, queue, this);
+        queue->endFrame(action);
+      }
+      state->pop();
+      return;
+    }
+  }
+
   state->push();
   SbBool didcull = FALSE;
 
   SoGLCacheList * createcache = NULL;
+  // shapes being recorded for a render queue must be traversed
   if ((this->renderCaching.getValue() != OFF) &&
-      (SoSeparator::getNumRenderCaches() > 0)) {
+      (SoSeparator::getNumRenderCaches() > 0) && !recording) {
 
     // test if bbox is outside view-volume
     if (!state->isCacheOpen()) {
@@ -858,7 +1227,7 @@ void
 SoSeparator::rayPick(SoRayPickAction * action)
 {
   if (this->pickCulling.getValue() == OFF ||
-      !PRIVATE(this)->bboxcache || !PRIVATE(this)->bboxcache->isValid(action->getState()) ||
+      !PRIVATE(this)->hasValidBBoxCache(action->getState()) ||
       !action->hasWorldSpaceRay() ||
       ray_intersect(action, PRIVATE(this)->bboxcache->getProjectedBox())) {
     SoSeparator::doAction(action);
@@ -948,12 +1317,23 @@ SoSeparator::getPrimitiveCount(SoGetPrimitiveCountAction * action)
 void
 SoSeparator::notify(SoNotList * nl)
 {
+  // read before the list is passed on, as our own record is added to it
+  const SoNotRec * rec = nl->getLastRec();
+  const SoBase * child = rec->getType() == SoNotRec::PARENT ? rec->getBase() : NULL;
+
   inherited::notify(nl);
 
   // lock before using the cache pointers so that we know the pointers
   // are valid while reading them
   PRIVATE(this)->lock();
-  if (PRIVATE(this)->bboxcache) PRIVATE(this)->bboxcache->invalidate();
+  // a change below a single child only needs that child's bounding
+  // box to be recomputed
+  SoSeparatorBBoxTree * tree = PRIVATE(this)->bboxtree;
+  if (!tree || !tree->valid || !child ||
+      !tree->markDirty(static_cast<const SoNode *>(child))) {
+    if (PRIVATE(this)->bboxcache) PRIVATE(this)->bboxcache->invalidate();
+    if (tree) tree->valid = FALSE;
+  }
   PRIVATE(this)->invalidateGLCaches();
   PRIVATE(this)->hassoundchild = SoSeparatorP::MAYBE;
   PRIVATE(this)->unlock();
@@ -985,14 +1365,26 @@ SoSeparatorP::doCull(SoSeparatorP * thisp, SoState * state,
                      SbBool (* cullfunc)(SoState *, const SbBox3f &, const SbBool))
 {
   if (PUBLIC(thisp)->renderCulling.getValue() == SoSeparator::OFF) return FALSE;
-  if (SoCullElement::completelyInside(state)) return FALSE;
+
+  // separators completely inside the view volume may still be hidden
+  // behind other geometry
+  SoAction * action = state->getAction();
+  SoGLRenderAction * glaction =
+    action->isOfType(SoGLRenderAction::getClassTypeId()) ?
+    static_cast<SoGLRenderAction *>(action) : NULL;
+  const SbBool occlusion = glaction && glaction->isOcclusionCulling();
+  if (!occlusion && SoCullElement::completelyInside(state)) return FALSE;
 
   SbBool outside = FALSE;
-  if (thisp->bboxcache &&
-      thisp->bboxcache->isValid(state)) {
+  if (thisp->hasValidBBoxCache(state)) {
     const SbBox3f & bbox = thisp->bboxcache->getProjectedBox();
     if (!bbox.isEmpty()) {
-      outside = (*cullfunc)(state, bbox, TRUE);
+      if (!SoCullElement::completelyInside(state)) {
+        outside = (*cullfunc)(state, bbox, TRUE);
+      }
+      if (!outside && occlusion) {
+        outside = glaction->isOccluded(bbox);
+      }
     }
   }
 
@@ -1038,6 +1430,93 @@ SoSeparator::cullTestNoPush(SoState * state)
 
 // *************************************************************************
 
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoPointSet.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+// checks that the wide separator gives the same box as a group with
+// the same children, which is always traversed in full
+static SbBool
+separator_same_bbox(SoSeparator * sep, SoGroup * reference)
+{
+  SoGetBoundingBoxAction action(SbViewportRegion(100, 100));
+  action.apply(sep);
+  const SbBox3f box = action.getBoundingBox();
+  const SbVec3f center = action.getCenter();
+  action.apply(reference);
+  const SbBox3f refbox = action.getBoundingBox();
+  const SbVec3f refcenter = action.getCenter();
+
+  const float tolerance = 1.0e-4f;
+  return
+    box.getMin().equals(refbox.getMin(), tolerance) &&
+    box.getMax().equals(refbox.getMax(), tolerance) &&
+    center.equals(refcenter, tolerance);
+}
+
+BOOST_AUTO_TEST_CASE(changedChildBoundingBox)
+{
+  const int numchildren = 100;
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoGroup * reference = new SoGroup;
+  reference->ref();
+
+  SoTranslation * translations[numchildren];
+  for (int i = 0; i < numchildren; i++) {
+    SoSeparator * child = new SoSeparator;
+    translations[i] = new SoTranslation;
+    translations[i]->translation = SbVec3f(float(i), 0.0f, 0.0f);
+    child->addChild(translations[i]);
+    if (i == 10) {
+      SoCoordinate3 * coords = new SoCoordinate3;
+      coords->point.set1Value(0, SbVec3f(0.0f, -5.0f, 0.0f));
+      coords->point.set1Value(1, SbVec3f(0.0f, 5.0f, 0.0f));
+      child->addChild(coords);
+      child->addChild(new SoPointSet);
+    }
+    else {
+      child->addChild(new SoCube);
+    }
+    root->addChild(child);
+    reference->addChild(child);
+  }
+
+  BOOST_CHECK_MESSAGE(separator_same_bbox(root, reference),
+                      "wrong initial bounding box");
+
+  translations[42]->translation = SbVec3f(42.0f, 100.0f, 0.0f);
+  BOOST_CHECK_MESSAGE(separator_same_bbox(root, reference),
+                      "wrong bounding box after moving one child");
+
+  translations[99]->translation = SbVec3f(0.0f, 0.0f, -50.0f);
+  translations[3]->translation = SbVec3f(0.0f, 0.0f, 50.0f);
+  BOOST_CHECK_MESSAGE(separator_same_bbox(root, reference),
+                      "wrong bounding box after moving two children");
+
+  SoGetBoundingBoxAction action(SbViewportRegion(100, 100));
+  action.apply(root);
+  BOOST_CHECK_MESSAGE(action.getBoundingBox().getMax()[1] > 100.0f,
+                      "moved child not included in bounding box");
+
+  root->removeChild(42);
+  reference->removeChild(42);
+  BOOST_CHECK_MESSAGE(separator_same_bbox(root, reference),
+                      "wrong bounding box after removing a child");
+
+  reference->unref();
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
+
+// *************************************************************************
+
 #undef PRIVATE
 #undef PUBLIC
 #undef GLCACHE_DEBUG
@@ -0,0 +1,385 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SoDepthSorter SoDepthSorter.h
+  \brief The SoDepthSorter class orders the transparent objects of a frame back to front.
+
+  \ingroup coin_rendering
+
+  Used by SoGLRenderAction for the SORTED_OBJECT_* transparency
+  types. The bounding box of each transparent shape is kept between
+  frames, and is only computed again when the shape's node id changes
+  or when the elements it was computed from have changed, like a
+  bounding box cache. Shapes which keep a valid bounding box cache of
+  their own use that one.
+
+  The paths are sorted on their distance from the camera, with the
+  farthest first. The order of the previous frame is tried first when
+  the number of paths is unchanged, as it is then most likely the same
+  objects in the same traversal order. With a camera that has moved
+  only a little, that order needs few corrections, and an insertion
+  sort fixes it in close to linear time. If it needs too many, the
+  distances are sorted from scratch with a radix sort on their bit
+  patterns.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "rendering/SoDepthSorter.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <cstring>
+
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbVec3f.h>
+#include <Inventor/actions/SoAction.h>
+#include <Inventor/caches/SoBoundingBoxCache.h>
+#include <Inventor/elements/SoCacheElement.h>
+#include <Inventor/misc/SoState.h>
+#include <Inventor/nodes/SoShape.h>
+
+// *************************************************************************
+
+namespace {
+
+// The insertion sort gives up after moving this many paths per path
+// in total, and leaves the sorting to the radix sort.
+const int MAX_MOVES_PER_PATH = 4;
+
+// Maps a distance to an unsigned key which sorts the farthest first.
+inline uint32_t
+depth_key(const float distance)
+{
+  uint32_t bits;
+  (void)memcpy(&bits, &distance, sizeof(bits));
+  // flip all bits of negative numbers and the sign bit of positive
+  // ones to make the keys of increasing numbers increase
+  bits = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+  return ~bits;
+}
+
+template <class Type> void
+set_length(SbList<Type> & list, const int num)
+{
+  list.ensureCapacity(num);
+  if (list.getLength() > num) list.truncate(num);
+  while (list.getLength() < num) list.append(Type());
+}
+
+} // anonymous namespace
+
+// *************************************************************************
+
+/*!
+  Constructor.
+*/
+SoDepthSorter::SoDepthSorter(void)
+  : incremental(FALSE), frame(0), numused(0)
+{
+}
+
+/*!
+  Destructor.
+*/
+SoDepthSorter::~SoDepthSorter()
+{
+  for (SbHash<const SoNode *, sods_bbox *>::const_iterator iter = this->bboxes.const_begin();
+       iter != this->bboxes.const_end(); ++iter) {
+    iter->obj->cache->unref();
+    delete iter->obj;
+  }
+}
+
+/*!
+  Starts a new frame. Must be called before getBBox().
+*/
+void
+SoDepthSorter::beginFrame(void)
+{
+  this->frame++;
+  this->numused = 0;
+}
+
+/*!
+  Returns the bounding box and center of \a shape in object space, for
+  the current state of \a action.
+*/
+void
+SoDepthSorter::getBBox(SoAction * action, SoShape * shape, SbBox3f & box, SbVec3f & center)
+{
+  SoState * state = action->getState();
+  this->numused++;
+
+  const SoBoundingBoxCache * shapecache = shape->getBoundingBoxCache();
+  if (shapecache && shapecache->isValid(state)) {
+    box = shapecache->getProjectedBox();
+    center = shapecache->isCenterSet() ? shapecache->getCenter() : box.getCenter();
+    return;
+  }
+
+  sods_bbox * entry = NULL;
+  if (this->bboxes.get(shape, entry)) {
+    if (entry->nodeid == shape->getNodeId() && entry->cache->isValid(state)) {
+      entry->frame = this->frame;
+      box = entry->cache->getProjectedBox();
+      center = entry->cache->getCenter();
+      return;
+    }
+    if (entry->frame == this->frame) {
+      // shared by paths with different states in this frame, so don't
+      // replace the cache for each of them
+      shape->computeBBox(action, box, center);
+      return;
+    }
+    entry->cache->unref();
+    entry->cache = NULL;
+  }
+
+  // must push state to make cache dependencies work
+  state->push();
+  const SbBool storedinvalid = SoCacheElement::setInvalid(FALSE);
+  SoBoundingBoxCache * cache = new SoBoundingBoxCache(state);
+  cache->ref();
+  SoCacheElement::set(state, cache);
+  shape->computeBBox(action, box, center);
+  cache->set(box, TRUE, center);
+  state->pop();
+  SoCacheElement::setInvalid(storedinvalid);
+
+  if (entry == NULL) {
+    entry = new sods_bbox;
+    (void)this->bboxes.put(shape, entry);
+  }
+  entry->nodeid = shape->getNodeId();
+  entry->cache = cache;
+  entry->frame = this->frame;
+}
+
+/*!
+  Forgets the bounding boxes of shapes which were not used since
+  beginFrame().
+*/
+void
+SoDepthSorter::endFrame(void)
+{
+  if (static_cast<int>(this->bboxes.getNumElements()) <= this->numused) return;
+
+  SbList<const SoNode *> nodes;
+  this->bboxes.makeKeyList(nodes);
+  for (int i = 0; i < nodes.getLength(); i++) {
+    sods_bbox * entry;
+    (void)this->bboxes.get(nodes[i], entry);
+    if (entry->frame != this->frame) {
+      entry->cache->unref();
+      delete entry;
+      (void)this->bboxes.erase(nodes[i]);
+    }
+  }
+}
+
+/*!
+  Sorts the \a num \a distances, farthest first. The result is
+  available from getOrder() as the indices of the distances in sorted
+  order. The order of equal distances is unspecified.
+*/
+void
+SoDepthSorter::sort(const float * distances, const int num)
+{
+  this->keys.truncate(0);
+  this->keys.ensureCapacity(num);
+  for (int i = 0; i < num; i++) {
+    this->keys.append(depth_key(distances[i]));
+  }
+
+  this->incremental = FALSE;
+  if (num > 1 && this->order.getLength() == num) {
+    this->incremental = this->insertionSort(num);
+    if (this->incremental) return;
+  }
+  this->radixSort(num);
+}
+
+// Insertion sort of the keys, starting from the previous order. The
+// previous order is always a permutation of the indices, also when
+// this gives up. Returns FALSE if it gave up.
+SbBool
+SoDepthSorter::insertionSort(const int num)
+{
+  set_length(this->tmpkeys, num);
+  uint32_t * sorted = const_cast<uint32_t *>(this->tmpkeys.getArrayPtr());
+  int * indices = const_cast<int *>(this->order.getArrayPtr());
+  const uint32_t * unsorted = this->keys.getArrayPtr();
+  for (int i = 0; i < num; i++) {
+    sorted[i] = unsorted[indices[i]];
+  }
+
+  const int maxmoves = num * MAX_MOVES_PER_PATH;
+  int moves = 0;
+  for (int i = 1; i < num; i++) {
+    const uint32_t key = sorted[i];
+    if (sorted[i-1] <= key) continue;
+    const int index = indices[i];
+    int j = i;
+    do {
+      sorted[j] = sorted[j-1];
+      indices[j] = indices[j-1];
+      j--;
+    } while (j > 0 && sorted[j-1] > key);
+    sorted[j] = key;
+    indices[j] = index;
+    moves += i - j;
+    if (moves > maxmoves) return FALSE;
+  }
+  return TRUE;
+}
+
+// Least significant byte first radix sort of the keys. Bytes which
+// are the same in all keys are skipped.
+void
+SoDepthSorter::radixSort(const int num)
+{
+  set_length(this->order, num);
+  set_length(this->tmporder, num);
+  set_length(this->tmpkeys, num);
+  int * const orderptr = const_cast<int *>(this->order.getArrayPtr());
+  for (int i = 0; i < num; i++) {
+    orderptr[i] = i;
+  }
+  if (num < 2) return;
+
+  uint32_t * srckeys = const_cast<uint32_t *>(this->keys.getArrayPtr());
+  uint32_t * dstkeys = const_cast<uint32_t *>(this->tmpkeys.getArrayPtr());
+  int * srcorder = orderptr;
+  int * dstorder = const_cast<int *>(this->tmporder.getArrayPtr());
+
+  int counts[4][256];
+  (void)memset(counts, 0, sizeof(counts));
+  for (int i = 0; i < num; i++) {
+    const uint32_t key = srckeys[i];
+    counts[0][key & 0xff]++;
+    counts[1][(key >> 8) & 0xff]++;
+    counts[2][(key >> 16) & 0xff]++;
+    counts[3][key >> 24]++;
+  }
+
+  for (int pass = 0; pass < 4; pass++) {
+    const int shift = pass * 8;
+    int * count = counts[pass];
+    if (count[(srckeys[0] >> shift) & 0xff] == num) continue;
+
+    int offset = 0;
+    for (int i = 0; i < 256; i++) {
+      const int n = count[i];
+      count[i] = offset;
+      offset += n;
+    }
+    for (int i = 0; i < num; i++) {
+      const uint32_t key = srckeys[i];
+      const int dst = count[(key >> shift) & 0xff]++;
+      dstkeys[dst] = key;
+      dstorder[dst] = srcorder[i];
+    }
+    uint32_t * tmpkeyptr = srckeys; srckeys = dstkeys; dstkeys = tmpkeyptr;
+    int * tmporderptr = srcorder; srcorder = dstorder; dstorder = tmporderptr;
+  }
+  if (srcorder != orderptr) {
+    (void)memcpy(orderptr, srcorder, num * sizeof(int));
+  }
+}
+
+// *************************************************************************
+
+#ifdef COIN_TEST_SUITE
+
+#include <cstdlib>
+#include <rendering/SoDepthSorter.h>
+
+static SbBool
+is_sorted(const SoDepthSorter & sorter, const SbList<float> & distances)
+{
+  const int * order = sorter.getOrder();
+  SbList<SbBool> seen;
+  for (int i = 0; i < distances.getLength(); i++) seen.append(FALSE);
+  for (int i = 0; i < distances.getLength(); i++) {
+    if (order[i] < 0 || order[i] >= distances.getLength() || seen[order[i]]) return FALSE;
+    seen[order[i]] = TRUE;
+    if (i > 0 && distances[order[i-1]] < distances[order[i]]) return FALSE;
+  }
+  return TRUE;
+}
+
+BOOST_AUTO_TEST_CASE(backToFront)
+{
+  SoDepthSorter sorter;
+  SbList<float> distances;
+  srand(42);
+  for (int i = 0; i < 5000; i++) {
+    distances.append((float(rand()) / float(RAND_MAX) - 0.25f) * 1000.0f);
+  }
+  // some ties, zeros of both signs and tiny numbers
+  distances[10] = distances[20] = distances[30];
+  distances[40] = 0.0f;
+  distances[41] = -0.0f;
+  distances[42] = 1.0e-30f;
+  distances[43] = -1.0e-30f;
+
+  sorter.sort(distances.getArrayPtr(), distances.getLength());
+  BOOST_CHECK_MESSAGE(is_sorted(sorter, distances), "distances not sorted farthest first");
+
+  // a camera moving a little keeps the order nearly valid
+  for (int i = 0; i < distances.getLength(); i++) {
+    distances[i] += float(i % 7) * 0.01f;
+  }
+  sorter.sort(distances.getArrayPtr(), distances.getLength());
+  BOOST_CHECK_MESSAGE(sorter.wasIncremental(), "small changes should not be sorted from scratch");
+  BOOST_CHECK_MESSAGE(is_sorted(sorter, distances), "small changes not sorted farthest first");
+
+  // turning the camera around reverses the order
+  for (int i = 0; i < distances.getLength(); i++) {
+    distances[i] = -distances[i];
+  }
+  sorter.sort(distances.getArrayPtr(), distances.getLength());
+  BOOST_CHECK_MESSAGE(!sorter.wasIncremental(), "reversed order should be sorted from scratch");
+  BOOST_CHECK_MESSAGE(is_sorted(sorter, distances), "reversed order not sorted farthest first");
+
+  distances.truncate(1);
+  sorter.sort(distances.getArrayPtr(), distances.getLength());
+  BOOST_CHECK_MESSAGE(sorter.getOrder()[0] == 0, "single distance not sorted");
+}
+
+#endif // COIN_TEST_SUITE
@@ -0,0 +1,87 @@
+#ifndef COIN_SODEPTHSORTER_H
+#define COIN_SODEPTHSORTER_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* !COIN_INTERNAL */
+
+#include <Inventor/SbBasic.h>
+#include <Inventor/lists/SbList.h>
+
+#include "misc/SbHash.h"
+
+class SbBox3f;
+class SbVec3f;
+class SoAction;
+class SoBoundingBoxCache;
+class SoNode;
+class SoShape;
+
+// The cached bounding box of a shape, used while its node id is
+// unchanged and the cache is valid for the current state.
+struct sods_bbox {
+  SbUniqueId nodeid;
+  SoBoundingBoxCache * cache;
+  int frame;
+};
+
+class SoDepthSorter {
+public:
+  SoDepthSorter(void);
+  ~SoDepthSorter();
+
+  void beginFrame(void);
+  void getBBox(SoAction * action, SoShape * shape, SbBox3f & box, SbVec3f & center);
+  void endFrame(void);
+
+  void sort(const float * distances, const int num);
+  const int * getOrder(void) const { return this->order.getArrayPtr(); }
+  SbBool wasIncremental(void) const { return this->incremental; }
+
+private:
+  SbBool insertionSort(const int num);
+  void radixSort(const int num);
+
+  SbHash<const SoNode *, sods_bbox *> bboxes;
+  SbList<uint32_t> keys;
+  SbList<uint32_t> tmpkeys;
+  SbList<int> order;
+  SbList<int> tmporder;
+  SbBool incremental;
+  int frame;
+  int numused;
+};
+
+#endif // !COIN_SODEPTHSORTER_H
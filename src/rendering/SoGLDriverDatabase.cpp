@@ -267,6 +267,10 @@ SoGLDriverDatabaseP::initFunctions(void)
                        (glglue_feature_test_f *) &coin_glglue_has_generate_mipmap;
   this->featuremap[SbName(SO_GL_GLSL_CLIP_VERTEX_HW).getString()] =
                        (glglue_feature_test_f *) &glsl_clip_vertex_hw_wrapper;
+  this->featuremap[SbName(SO_GL_WEIGHTED_BLEND).getString()] =
+                       (glglue_feature_test_f *) &coin_glglue_can_do_weightedblend;
+  this->featuremap[SbName(SO_GL_INSTANCED_RENDERING).getString()] =
+                       (glglue_feature_test_f *) &coin_glglue_can_do_instancing;
 }
 
 SbBool
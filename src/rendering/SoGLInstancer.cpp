@@ -0,0 +1,612 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+
+/*!
+  \class SoGLInstancer SoGLInstancer.h
+  \brief The SoGLInstancer class draws the copies of an SoMultipleCopy or SoArray with instanced draw calls.
+
+  \ingroup coin_rendering
+
+  Used by SoMultipleCopy and SoArray when
+  SoGLRenderAction::setInstancedRendering() is enabled. The children
+  are traversed for the first copy only, while their shapes are
+  recorded the same way SoGLRenderQueue records the shapes of a
+  child separator. Each recorded shape is then drawn for the other
+  copies with one instanced draw call. The matrix of each copy is
+  kept in a vertex buffer object and read as a per-instance vertex
+  attribute by a vertex shader, which also does the lighting of the
+  fixed function pipeline. In later frames the children are not
+  traversed at all as long as the node and the state they depend on
+  are unchanged.
+
+  The copies are rendered by traversing the children once per copy
+  instead when the shapes can not be recorded, when the children
+  depend on SoSwitchElement, which differs between the copies, when
+  they look at the model matrix of the copy to decide what to render,
+  like level of detail nodes, billboards and screen space complexity
+  do, or when the node is rendered with clip planes, shaders, an open
+  cache or inside a recording render queue. An open render cache is
+  invalidated, so that an SoSeparator above the node stops caching
+  it in a display list.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "rendering/SoGLInstancer.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <cmath>
+#include <cstring>
+
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/caches/SoCache.h>
+#include <Inventor/caches/SoPrimitiveVertexCache.h>
+#include <Inventor/elements/SoCacheElement.h>
+#include <Inventor/elements/SoClipPlaneElement.h>
+#include <Inventor/elements/SoComplexityTypeElement.h>
+#include <Inventor/elements/SoGLCacheContextElement.h>
+#include <Inventor/elements/SoGLLightIdElement.h>
+#include <Inventor/elements/SoGLShaderProgramElement.h>
+#include <Inventor/elements/SoModelMatrixElement.h>
+#include <Inventor/elements/SoSwitchElement.h>
+#include <Inventor/elements/SoViewingMatrixElement.h>
+#include <Inventor/misc/SoContextHandler.h>
+#include <Inventor/misc/SoGLDriverDatabase.h>
+#include <Inventor/misc/SoChildList.h>
+#include <Inventor/misc/SoState.h>
+#include <Inventor/nodes/SoComplexity.h>
+#include <Inventor/nodes/SoGroup.h>
+#include <Inventor/nodes/SoLOD.h>
+#include <Inventor/nodes/SoLevelOfDetail.h>
+#include <Inventor/VRMLnodes/SoVRMLBillboard.h>
+#include <Inventor/VRMLnodes/SoVRMLLOD.h>
+#include <Inventor/system/gl.h>
+
+#include "glue/glp.h"
+#include "misc/SbHash.h"
+#include "rendering/SoGL.h"
+#include "tidbitsp.h"
+#include "threads/threadsutilp.h"
+
+// *************************************************************************
+
+// The program of one context. A program which failed to compile is
+// kept with a 0 handle, so that it is not tried again.
+struct soinst_program {
+  COIN_GLhandle program;
+  GLint instancematrix;
+  GLint itemmatrix;
+  GLint numlights;
+  GLint lighting;
+};
+
+static SbHash<const SoNode *, SoGLInstancer *> * soinst_instancers = NULL;
+static SbHash<uint32_t, soinst_program *> * soinst_programs = NULL;
+
+// Children which are recorded this many times without the node id
+// changing depend on something that changes every frame, and are
+// traversed once per copy instead.
+static const int SOINST_MAX_RECORDS = 2;
+
+// Places each vertex with the matrix of the shape relative to the
+// copy, and the matrix of the copy, and lights it like the fixed
+// function pipeline does with a local viewer off and color material
+// on for the diffuse color. Normals are transformed with the
+// cofactor matrix, which is the inverse transpose up to a scale.
+static const char * soinst_vertex_program =
+  "#version 120\n"
+  "uniform mat4 itemmatrix;\n"
+  "uniform int numlights;\n"
+  "uniform int lighting;\n"
+  "attribute mat4 instancematrix;\n"
+  "vec4 shade(vec3 normal, vec3 eyepos)\n"
+  "{\n"
+  "  vec4 ambient = vec4(0.0);\n"
+  "  vec4 diffuse = vec4(0.0);\n"
+  "  vec4 specular = vec4(0.0);\n"
+  "  for (int i = 0; i < gl_MaxLights; i++) {\n"
+  "    if (i >= numlights) break;\n"
+  "    vec3 l;\n"
+  "    float att = 1.0;\n"
+  "    if (gl_LightSource[i].position.w == 0.0) {\n"
+  "      l = normalize(gl_LightSource[i].position.xyz);\n"
+  "    }\n"
+  "    else {\n"
+  "      vec3 d = gl_LightSource[i].position.xyz - eyepos;\n"
+  "      float dist = length(d);\n"
+  "      l = d / dist;\n"
+  "      att = 1.0 / (gl_LightSource[i].constantAttenuation +\n"
+  "                   gl_LightSource[i].linearAttenuation * dist +\n"
+  "                   gl_LightSource[i].quadraticAttenuation * dist * dist);\n"
+  "      if (gl_LightSource[i].spotCutoff <= 90.0) {\n"
+  "        float spot = dot(-l, normalize(gl_LightSource[i].spotDirection));\n"
+  "        att *= (spot < gl_LightSource[i].spotCosCutoff) ? 0.0 :\n"
+  "          pow(spot, gl_LightSource[i].spotExponent);\n"
+  "      }\n"
+  "    }\n"
+  "    float ndotl = max(dot(normal, l), 0.0);\n"
+  "    ambient += gl_LightSource[i].ambient * att;\n"
+  "    diffuse += gl_LightSource[i].diffuse * ndotl * att;\n"
+  "    if (ndotl > 0.0) {\n"
+  "      float ndoth = max(dot(normal, normalize(l + vec3(0.0, 0.0, 1.0))), 0.0);\n"
+  "      specular += gl_LightSource[i].specular * pow(ndoth, gl_FrontMaterial.shininess) * att;\n"
+  "    }\n"
+  "  }\n"
+  "  vec4 color = gl_FrontMaterial.emission +\n"
+  "    gl_FrontMaterial.ambient * (gl_LightModel.ambient + ambient) +\n"
+  "    gl_Color * diffuse + gl_FrontMaterial.specular * specular;\n"
+  "  return vec4(clamp(color.rgb, 0.0, 1.0), gl_Color.a);\n"
+  "}\n"
+  "void main(void)\n"
+  "{\n"
+  "  mat4 m = instancematrix * itemmatrix;\n"
+  "  vec4 eyepos = gl_ModelViewMatrix * (m * gl_Vertex);\n"
+  "  gl_Position = gl_ProjectionMatrix * eyepos;\n"
+  "  gl_FogFragCoord = abs(eyepos.z);\n"
+  "  if (lighting != 0) {\n"
+  "    mat3 a = mat3(m);\n"
+  "    mat3 cofactor = mat3(cross(a[1], a[2]), cross(a[2], a[0]), cross(a[0], a[1]));\n"
+  "    float s = sign(dot(a[0], cross(a[1], a[2])));\n"
+  "    vec3 normal = normalize(gl_NormalMatrix * (cofactor * gl_Normal * s));\n"
+  "    vec3 pos = eyepos.xyz / eyepos.w;\n"
+  "    gl_FrontColor = shade(normal, pos);\n"
+  "    gl_BackColor = shade(-normal, pos);\n"
+  "  }\n"
+  "  else {\n"
+  "    gl_FrontColor = gl_Color;\n"
+  "    gl_BackColor = gl_Color;\n"
+  "  }\n"
+  "}\n";
+
+// Compiles and links the program, and looks up its inputs. Leaves
+// the handle at 0 on failure.
+static void
+soinst_create_program(const cc_glglue * glue, soinst_program * prog)
+{
+  prog->program = 0;
+  GLint ok = 0;
+  COIN_GLhandle shader = glue->glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
+  if (!shader) return;
+  glue->glShaderSourceARB(shader, 1, (const COIN_GLchar **)&soinst_vertex_program, NULL);
+  glue->glCompileShaderARB(shader);
+  glue->glGetObjectParameterivARB(shader, GL_OBJECT_COMPILE_STATUS_ARB, &ok);
+  if (!ok) {
+    glue->glDeleteObjectARB(shader);
+    return;
+  }
+
+  COIN_GLhandle program = glue->glCreateProgramObjectARB();
+  glue->glAttachObjectARB(program, shader);
+  glue->glLinkProgramARB(program);
+  // the shader is deleted with the program it is attached to
+  glue->glDeleteObjectARB(shader);
+  glue->glGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &ok);
+  prog->instancematrix = glue->glGetAttribLocationARB(program, "instancematrix");
+  if (!ok || prog->instancematrix < 0) {
+    glue->glDeleteObjectARB(program);
+    return;
+  }
+  prog->program = program;
+  prog->itemmatrix = glue->glGetUniformLocationARB(program, "itemmatrix");
+  prog->numlights = glue->glGetUniformLocationARB(program, "numlights");
+  prog->lighting = glue->glGetUniformLocationARB(program, "lighting");
+}
+
+// Returns the program of the context, creating it the first time.
+// Returns NULL if it could not be created.
+static const soinst_program *
+soinst_get_program(const cc_glglue * glue, const uint32_t contextid)
+{
+  soinst_program * prog = NULL;
+  CC_GLOBAL_LOCK;
+  if (!soinst_programs->get(contextid, prog)) {
+    prog = new soinst_program;
+    soinst_create_program(glue, prog);
+    soinst_programs->put(contextid, prog);
+  }
+  CC_GLOBAL_UNLOCK;
+  return prog->program ? prog : NULL;
+}
+
+// Returns TRUE if node or a node below it uses the model matrix to
+// decide what to render. The recorded shapes would then be the ones
+// of the first copy for all copies, since the cache only compares the
+// nodes the matrix was set by.
+static SbBool
+soinst_uses_matrix(SoNode * node)
+{
+  if (node->isOfType(SoLOD::getClassTypeId()) ||
+      node->isOfType(SoLevelOfDetail::getClassTypeId())) return TRUE;
+#ifdef HAVE_VRML97
+  if (node->isOfType(SoVRMLLOD::getClassTypeId()) ||
+      node->isOfType(SoVRMLBillboard::getClassTypeId())) return TRUE;
+#endif // HAVE_VRML97
+  if (node->isOfType(SoComplexity::getClassTypeId()) &&
+      static_cast<SoComplexity *>(node)->type.getValue() == SoComplexity::SCREEN_SPACE) {
+    return TRUE;
+  }
+  SoChildList * children = node->getChildren();
+  if (children) {
+    for (int i = 0; i < children->getLength(); i++) {
+      if (soinst_uses_matrix((*children)[i])) return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static void
+soinst_context_destruction_cb(uint32_t contextid, void * COIN_UNUSED_ARG(closure))
+{
+  soinst_program * prog = NULL;
+  CC_GLOBAL_LOCK;
+  if (soinst_programs->get(contextid, prog)) {
+    if (prog->program) {
+      const cc_glglue * glue = cc_glglue_instance(static_cast<int>(contextid));
+      glue->glDeleteObjectARB(prog->program);
+    }
+    delete prog;
+    soinst_programs->erase(contextid);
+  }
+  CC_GLOBAL_UNLOCK;
+}
+
+// *************************************************************************
+
+/*!
+  Constructor.
+*/
+SoGLInstancer::SoGLInstancer(void)
+  : matricesid(0), matrixvbo(NULL), busy(FALSE)
+{
+  this->chunk.node = NULL;
+  this->chunk.nodeid = 0;
+  this->chunk.contextid = 0;
+  this->chunk.cache = NULL;
+  this->chunk.ok = TRUE;
+  this->chunk.numrecords = 0;
+  this->chunk.visitframe = this->chunk.drawframe = -1;
+}
+
+/*!
+  Destructor.
+*/
+SoGLInstancer::~SoGLInstancer()
+{
+  SoGLRenderQueue::clearChunk(&this->chunk);
+  delete this->matrixvbo;
+}
+
+/*!
+  Sets up the instancers and the per-context programs. Called from
+  SoGLRenderAction::initClass().
+*/
+void
+SoGLInstancer::initClass(void)
+{
+  soinst_instancers = new SbHash<const SoNode *, SoGLInstancer *>;
+  soinst_programs = new SbHash<uint32_t, soinst_program *>;
+  SoContextHandler::addContextDestructionCallback(soinst_context_destruction_cb, NULL);
+  coin_atexit(reinterpret_cast<coin_atexit_f *>(SoGLInstancer::cleanup), CC_ATEXIT_NORMAL);
+}
+
+void
+SoGLInstancer::cleanup(void)
+{
+  SoContextHandler::removeContextDestructionCallback(soinst_context_destruction_cb, NULL);
+  for (SbHash<const SoNode *, SoGLInstancer *>::const_iterator iter =
+         soinst_instancers->const_begin();
+       iter != soinst_instancers->const_end();
+       ++iter) {
+    delete iter->obj;
+  }
+  // the GL programs are gone with their contexts
+  for (SbHash<uint32_t, soinst_program *>::const_iterator iter =
+         soinst_programs->const_begin();
+       iter != soinst_programs->const_end();
+       ++iter) {
+    delete iter->obj;
+  }
+  delete soinst_instancers;
+  delete soinst_programs;
+  soinst_instancers = NULL;
+  soinst_programs = NULL;
+}
+
+/*!
+  Returns the instancer of \a node, which is about to render
+  \a numinstances copies of its children with \a action, or \c NULL
+  if the copies should be rendered by traversing the children once
+  per copy. The instancer must be given back with release().
+*/
+SoGLInstancer *
+SoGLInstancer::acquire(SoGLRenderAction * action, const SoNode * node,
+                       const int numinstances)
+{
+  if (!action->isInstancedRendering() || numinstances < 2) return NULL;
+
+  SoState * state = action->getState();
+  const SoAction::PathCode pathcode = action->getCurPathCode();
+  if (pathcode != SoAction::NO_PATH && pathcode != SoAction::BELOW_PATH) return NULL;
+  if (SoGLRenderQueue::getRecording(state) != NULL) return NULL;
+  if (SoGLShaderProgramElement::get(state) != NULL) return NULL;
+  if (SoClipPlaneElement::getInstance(state)->getNum() > 0) return NULL;
+
+  const cc_glglue * glue = sogl_glue_instance(state);
+  if (!SoGLDriverDatabase::isSupported(glue, SO_GL_INSTANCED_RENDERING) ||
+      !SoGLDriverDatabase::isSupported(glue, SO_GL_VERTEX_ARRAY)) return NULL;
+
+  // instanced draw calls are not compiled into display lists
+  if (SoCacheElement::anyOpen(state)) {
+    SoCacheElement::invalidate(state);
+    return NULL;
+  }
+
+  SoGLInstancer * instancer = NULL;
+  CC_GLOBAL_LOCK;
+  if (!soinst_instancers->get(node, instancer)) {
+    instancer = new SoGLInstancer;
+    soinst_instancers->put(node, instancer);
+  }
+  // another thread is rendering the same node
+  if (instancer->busy) instancer = NULL;
+  else instancer->busy = TRUE;
+  CC_GLOBAL_UNLOCK;
+  return instancer;
+}
+
+/*!
+  Deletes the instancer of \a node, if any. Called when \a node is
+  destructed.
+*/
+void
+SoGLInstancer::remove(const SoNode * node)
+{
+  SoGLInstancer * instancer = NULL;
+  CC_GLOBAL_LOCK;
+  if (soinst_instancers && soinst_instancers->get(node, instancer)) {
+    soinst_instancers->erase(node);
+  }
+  CC_GLOBAL_UNLOCK;
+  delete instancer;
+}
+
+/*!
+  Gives back an instancer returned by acquire().
+*/
+void
+SoGLInstancer::release(void)
+{
+  CC_GLOBAL_LOCK;
+  this->busy = FALSE;
+  CC_GLOBAL_UNLOCK;
+}
+
+/*!
+  Returns \c TRUE if the matrices of the copies must be set again
+  with setMatrices() before \a node is rendered.
+*/
+SbBool
+SoGLInstancer::needsMatrices(const SoNode * node) const
+{
+  return node->getNodeId() != this->matricesid;
+}
+
+/*!
+  Sets the \a num matrices of the copies, which are multiplied with
+  the model matrix of the node. \a id should be the node id.
+*/
+void
+SoGLInstancer::setMatrices(const SbMatrix * matrices, const int num, const SbUniqueId id)
+{
+  this->matrices.truncate(0);
+  for (int i = 0; i < num; i++) this->matrices.append(matrices[i]);
+  this->matricesid = id;
+
+  if (!this->matrixvbo) this->matrixvbo = new SoVBO(GL_ARRAY_BUFFER);
+  const intptr_t size = num * 16 * sizeof(float);
+  void * data = this->matrixvbo->allocBufferData(size, id);
+  (void)memcpy(data, matrices, size);
+}
+
+/*!
+  Renders the children of \a group once for each of the matrices set
+  with setMatrices().
+*/
+void
+SoGLInstancer::render(SoGLRenderAction * action, SoGroup * group)
+{
+  SoState * state = action->getState();
+  const int num = this->matrices.getLength();
+  const SbUniqueId nodeid = group->getNodeId();
+  if (nodeid != this->chunk.nodeid) {
+    this->chunk.ok = TRUE;
+    this->chunk.numrecords = 0;
+  }
+
+  int first = 0;
+  if (this->chunk.ok) {
+    if (nodeid != this->chunk.nodeid || !this->isValid(state, 0) ||
+        !SoGLLazyElement::preCacheCall(state, &this->chunk.prestate)) {
+      // the first copy is rendered while it is recorded
+      this->record(action, group);
+      first = 1;
+    }
+    if (this->chunk.ok && this->draw(state, first)) return;
+  }
+  for (int i = first; i < num; i++) {
+    this->traverse(action, group, i);
+  }
+}
+
+// Returns TRUE if the elements the recorded shapes depend on are
+// unchanged for the copy with the given index.
+SbBool
+SoGLInstancer::isValid(SoState * state, const int instance) const
+{
+  if (!this->chunk.cache ||
+      this->chunk.contextid != static_cast<uint32_t>(SoGLCacheContextElement::get(state))) return FALSE;
+
+  state->push();
+  SoSwitchElement::set(state, instance);
+  const SbBool valid = this->chunk.cache->isValid(state);
+  state->pop();
+  return valid;
+}
+
+void
+SoGLInstancer::record(SoGLRenderAction * action, SoGroup * group)
+{
+  SoState * state = action->getState();
+  SoGLRenderQueue::clearChunk(&this->chunk);
+  this->chunk.nodeid = group->getNodeId();
+  this->chunk.numrecords++;
+
+  // the switch element is set outside the cache, so that children
+  // reading it make the cache depend on it, while the matrix of the
+  // copy is not
+  state->push();
+  SoSwitchElement::set(state, 0);
+  this->recorder.beginRecording(state, &this->chunk);
+  state->push();
+  SoModelMatrixElement::mult(state, group, this->matrices[0]);
+  const SbMatrix firstmatrix = SoModelMatrixElement::get(state);
+  group->SoGroup::doAction(action);
+  state->pop();
+  this->recorder.endRecording(state);
+  state->pop();
+
+  if (this->chunk.numrecords > SOINST_MAX_RECORDS) this->chunk.ok = FALSE;
+  // children which differ between the copies, or which invalidated
+  // the cache while recorded
+  if (this->chunk.ok && !this->isValid(state, 1)) this->chunk.ok = FALSE;
+  if (this->chunk.ok && std::fabs(firstmatrix.det4()) < 1.0e-12f) this->chunk.ok = FALSE;
+  if (this->chunk.ok &&
+      (SoComplexityTypeElement::get(state) == SoComplexityTypeElement::SCREEN_SPACE ||
+       soinst_uses_matrix(group))) {
+    this->chunk.ok = FALSE;
+  }
+
+  if (this->chunk.ok) {
+    // keep the matrices of the shapes relative to the copy
+    const SbMatrix inverse = firstmatrix.inverse();
+    for (int i = 0; i < this->chunk.items.getLength(); i++) {
+      this->chunk.items[i].matrix.multRight(inverse);
+    }
+  }
+  else {
+    SoGLRenderQueue::clearChunk(&this->chunk);
+  }
+}
+
+// Draws the recorded shapes for the copies from first and on.
+// Returns FALSE if nothing was drawn because the program could not
+// be created.
+SbBool
+SoGLInstancer::draw(SoState * state, const int first)
+{
+  const int count = this->matrices.getLength() - first;
+  if (count <= 0 || this->chunk.items.getLength() == 0) return TRUE;
+
+  const cc_glglue * glue = sogl_glue_instance(state);
+  const uint32_t contextid = SoGLCacheContextElement::get(state);
+  const soinst_program * prog = soinst_get_program(glue, contextid);
+  if (!prog) return FALSE;
+
+  SbMatrix modelview = SoModelMatrixElement::get(state);
+  modelview.multRight(SoViewingMatrixElement::get(state));
+  glPushAttrib(GL_ENABLE_BIT | GL_LIGHTING_BIT | GL_POLYGON_BIT | GL_CURRENT_BIT);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadMatrixf(modelview[0]);
+  glue->glUseProgramObjectARB(prog->program);
+  glue->glUniform1iARB(prog->numlights, SoGLLightIdElement::get(state) + 1);
+
+  // one matrix per copy, a column in each of four attributes
+  this->matrixvbo->bindBuffer(contextid);
+  const GLuint loc = static_cast<GLuint>(prog->instancematrix);
+  for (GLuint c = 0; c < 4; c++) {
+    const intptr_t offset = (first * 16 + c * 4) * sizeof(float);
+    glue->glEnableVertexAttribArrayARB(loc + c);
+    glue->glVertexAttribPointerARB(loc + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+                                   reinterpret_cast<const GLvoid *>(offset));
+    glue->glVertexAttribDivisor(loc + c, 1);
+  }
+  cc_glglue_glBindBuffer(glue, GL_ARRAY_BUFFER, 0);
+
+  const sorq_glstate * prev = NULL;
+  for (int i = 0; i < this->chunk.items.getLength(); i++) {
+    const sorq_item & item = this->chunk.items[i];
+    if (!prev || memcmp(prev, &item.glstate, sizeof(sorq_glstate))) {
+      SoGLRenderQueue::sendGLState(item.glstate, prev);
+      // the vertex shader does the lighting
+      if (!prev || prev->lighting != item.glstate.lighting) {
+        glue->glUniform1iARB(prog->lighting, item.glstate.lighting);
+      }
+      if (!prev || prev->twoside != item.glstate.twoside) {
+        if (item.glstate.twoside) glEnable(GL_VERTEX_PROGRAM_TWO_SIDE_ARB);
+        else glDisable(GL_VERTEX_PROGRAM_TWO_SIDE_ARB);
+      }
+      prev = &item.glstate;
+    }
+    glue->glUniformMatrix4fvARB(prog->itemmatrix, 1, GL_FALSE, item.matrix[0]);
+    item.pvcache->renderTrianglesInstanced(state, count, SoPrimitiveVertexCache::NORMAL |
+                                           SoPrimitiveVertexCache::COLOR);
+  }
+
+  for (GLuint c = 0; c < 4; c++) {
+    glue->glVertexAttribDivisor(loc + c, 0);
+    glue->glDisableVertexAttribArrayARB(loc + c);
+  }
+  glue->glUseProgramObjectARB(0);
+  glPopMatrix();
+  glPopAttrib();
+  return TRUE;
+}
+
+// Renders the children for one copy, the way SoMultipleCopy and
+// SoArray do without instancing.
+void
+SoGLInstancer::traverse(SoGLRenderAction * action, SoGroup * group, const int instance)
+{
+  SoState * state = action->getState();
+  state->push();
+  SoSwitchElement::set(state, instance);
+  SoModelMatrixElement::mult(state, group, this->matrices[instance]);
+  group->SoGroup::doAction(action);
+  state->pop();
+}
@@ -0,0 +1,81 @@
+#ifndef COIN_SOGLINSTANCER_H
+#define COIN_SOGLINSTANCER_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* !COIN_INTERNAL */
+
+#include <Inventor/SbMatrix.h>
+#include <Inventor/lists/SbList.h>
+
+#include "rendering/SoGLRenderQueue.h"
+#include "rendering/SoVBO.h"
+
+class SoGLRenderAction;
+class SoGroup;
+class SoNode;
+class SoState;
+
+class SoGLInstancer {
+public:
+  SoGLInstancer(void);
+  ~SoGLInstancer();
+
+  static void initClass(void);
+  static SoGLInstancer * acquire(SoGLRenderAction * action, const SoNode * node,
+                                 const int numinstances);
+  static void remove(const SoNode * node);
+  void release(void);
+
+  SbBool needsMatrices(const SoNode * node) const;
+  void setMatrices(const SbMatrix * matrices, const int num, const SbUniqueId id);
+  void render(SoGLRenderAction * action, SoGroup * group);
+
+private:
+  static void cleanup(void);
+  SbBool isValid(SoState * state, const int instance) const;
+  void record(SoGLRenderAction * action, SoGroup * group);
+  SbBool draw(SoState * state, const int first);
+  void traverse(SoGLRenderAction * action, SoGroup * group, const int instance);
+
+  SoGLRenderQueue recorder;
+  sorq_chunk chunk;
+  SbList<SbMatrix> matrices;
+  SbUniqueId matricesid;
+  SoVBO * matrixvbo;
+  SbBool busy;
+};
+
+#endif // !COIN_SOGLINSTANCER_H
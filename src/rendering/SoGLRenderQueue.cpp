@@ -0,0 +1,681 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+
+/*!
+  \class SoGLRenderQueue SoGLRenderQueue.h
+  \brief The SoGLRenderQueue class keeps the shapes below a separator as a state sorted list of draw items.
+
+  \ingroup coin_rendering
+
+  Used by SoSeparator when SoGLRenderAction::setRetainedRendering() is
+  enabled. The shapes below each child separator are recorded once,
+  as their primitive vertex cache, model matrix and material, while
+  the child is rendered normally. In later frames the child is not
+  traversed as long as it is unchanged, and its shapes are drawn
+  together with the shapes of the other unchanged children, sorted to
+  minimize the number of material and polygon state changes.
+
+  The pending shapes are drawn with flush() before anything else is
+  rendered, that is before a child is traversed normally and before
+  the state set by a node which is not a separator changes, so that
+  the shapes are drawn in the same order relative to transparent
+  shapes, cameras and nodes like SoDepthBuffer or SoPolygonOffset as
+  without the queue. They are also drawn at the end of the frame.
+
+  A recorded child is traversed and recorded again when its node id
+  changes, when it depends on elements that have changed (much like
+  a render cache), or when the material it inherits has changed. Only
+  the shapes of that child are rebuilt. Children with shapes that can
+  not be drawn from a vertex cache, like textured or transparent
+  shapes, lines and points, are traversed normally every frame. So
+  are children with lights, clip planes, SoDepthBuffer or
+  SoPolygonOffset nodes that affect their own shapes, since that
+  state is not active when the queue is drawn. Nothing is queued with
+  the SoGLRenderAction::SORTED_LAYERS_BLEND transparency type or with
+  smoothing, which need each shape to be set up by the action.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "rendering/SoGLRenderQueue.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <cstdlib>
+#include <cstring>
+
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/caches/SoCache.h>
+#include <Inventor/caches/SoPrimitiveVertexCache.h>
+#include <Inventor/elements/SoCacheElement.h>
+#include <Inventor/elements/SoClipPlaneElement.h>
+#include <Inventor/elements/SoCullElement.h>
+#include <Inventor/elements/SoDepthBufferElement.h>
+#include <Inventor/elements/SoDrawStyleElement.h>
+#include <Inventor/elements/SoGLCacheContextElement.h>
+#include <Inventor/elements/SoGLShaderProgramElement.h>
+#include <Inventor/elements/SoLightElement.h>
+#include <Inventor/elements/SoModelMatrixElement.h>
+#include <Inventor/elements/SoPolygonOffsetElement.h>
+#include <Inventor/elements/SoShapeStyleElement.h>
+#include <Inventor/elements/SoViewingMatrixElement.h>
+#include <Inventor/misc/SoState.h>
+#include <Inventor/nodes/SoImage.h>
+#include <Inventor/nodes/SoText2.h>
+#include <Inventor/system/gl.h>
+#include <Inventor/threads/SbStorage.h>
+
+#include "tidbitsp.h"
+#include "threads/threadsutilp.h"
+#include "SbBasicP.h"
+
+// *************************************************************************
+
+// The recording queue of a thread, and the state it records from.
+struct sorq_recording {
+  SoGLRenderQueue * queue;
+  const SoState * state;
+  int numlights;
+  int numclipplanes;
+  const SoElement * depthbuffer;
+  const SoElement * polygonoffset;
+};
+
+static SbStorage * sorq_storage = NULL;
+// The number of threads recording, changed with the global lock held.
+static int sorq_numrecording = 0;
+
+// A chunk which has been recorded this many times without its node
+// id changing depends on something that changes every frame, and is
+// traversed normally instead.
+static const int SORQ_MAX_RECORDS = 2;
+
+// Shape styles which need more state than the queue keeps.
+static const unsigned int SORQ_UNQUEUEABLE_FLAGS =
+  SoShapeStyleElement::TEXENABLED |
+  SoShapeStyleElement::TEXFUNC |
+  SoShapeStyleElement::TEX3ENABLED |
+  SoShapeStyleElement::BBOXCMPLX |
+  SoShapeStyleElement::ABORTCB |
+  SoShapeStyleElement::BIGIMAGE |
+  SoShapeStyleElement::BUMPMAP |
+  SoShapeStyleElement::TRANSP_TEXTURE |
+  SoShapeStyleElement::TRANSP_MATERIAL |
+  SoShapeStyleElement::TRANSP_SORTED_TRIANGLES |
+  SoShapeStyleElement::SHADOWMAP |
+  SoShapeStyleElement::SHADOWS;
+
+static void
+sorq_construct_recording(void * closure)
+{
+  sorq_recording * data = static_cast<sorq_recording *>(closure);
+  data->queue = NULL;
+  data->state = NULL;
+}
+
+static void
+sorq_destruct_recording(void * COIN_UNUSED_ARG(closure))
+{
+}
+
+static sorq_recording *
+sorq_get_recording(void)
+{
+  return static_cast<sorq_recording *>(sorq_storage->get());
+}
+
+static int
+sorq_compare_items(const void * a, const void * b)
+{
+  const sorq_item * ia = *static_cast<const sorq_item * const *>(a);
+  const sorq_item * ib = *static_cast<const sorq_item * const *>(b);
+  const int cmp = memcmp(&ia->glstate, &ib->glstate, sizeof(sorq_glstate));
+  if (cmp) return cmp;
+  if (ia->pvcache != ib->pvcache) return (ia->pvcache < ib->pvcache) ? -1 : 1;
+  return 0;
+}
+
+// Returns the current instance of an element without making the open
+// caches depend on it. It is only compared with another instance, to
+// find out if the element was set in between.
+static const SoElement *
+sorq_get_instance(const SoState * state, const int stackindex)
+{
+  return state->isElementEnabled(stackindex) ? state->getConstElement(stackindex) : NULL;
+}
+
+static void
+sorq_send_color(GLenum pname, const float * color)
+{
+  const GLfloat col[4] = { color[0], color[1], color[2], 1.0f };
+  glMaterialfv(GL_FRONT_AND_BACK, pname, col);
+}
+
+// Sends the parts of state that differ from prev, or all of it if
+// prev is NULL.
+static void
+sorq_send_glstate(const sorq_glstate & state, const sorq_glstate * prev)
+{
+#define SORQ_CHANGED(member) (!prev || memcmp(&state.member, &prev->member, sizeof(state.member)))
+  if (SORQ_CHANGED(diffuse)) {
+    glColor4ub(static_cast<GLubyte>((state.diffuse >> 24) & 0xff),
+               static_cast<GLubyte>((state.diffuse >> 16) & 0xff),
+               static_cast<GLubyte>((state.diffuse >> 8) & 0xff),
+               static_cast<GLubyte>(state.diffuse & 0xff));
+  }
+  if (SORQ_CHANGED(ambient)) sorq_send_color(GL_AMBIENT, state.ambient);
+  if (SORQ_CHANGED(emissive)) sorq_send_color(GL_EMISSION, state.emissive);
+  if (SORQ_CHANGED(specular)) sorq_send_color(GL_SPECULAR, state.specular);
+  if (SORQ_CHANGED(shininess)) {
+    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, state.shininess * 128.0f);
+  }
+  if (SORQ_CHANGED(lighting)) {
+    if (state.lighting) glEnable(GL_LIGHTING);
+    else glDisable(GL_LIGHTING);
+  }
+  if (SORQ_CHANGED(ccw)) glFrontFace(state.ccw ? GL_CCW : GL_CW);
+  if (SORQ_CHANGED(culling)) {
+    if (state.culling) glEnable(GL_CULL_FACE);
+    else glDisable(GL_CULL_FACE);
+  }
+  if (SORQ_CHANGED(twoside)) {
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, state.twoside ? GL_TRUE : GL_FALSE);
+  }
+  if (SORQ_CHANGED(flatshading)) glShadeModel(state.flatshading ? GL_FLAT : GL_SMOOTH);
+#undef SORQ_CHANGED
+}
+
+// *************************************************************************
+
+/*!
+  Constructor.
+*/
+SoGLRenderQueue::SoGLRenderQueue(void)
+  : sortdirty(FALSE), recording(NULL), frame(0)
+{
+}
+
+/*!
+  Destructor.
+*/
+SoGLRenderQueue::~SoGLRenderQueue()
+{
+  for (int i = 0; i < this->chunks.getLength(); i++) {
+    SoGLRenderQueue::clearChunk(this->chunks[i]);
+    delete this->chunks[i];
+  }
+}
+
+/*!
+  Sets up the per-thread recording data. Called from
+  SoGLRenderAction::initClass().
+*/
+void
+SoGLRenderQueue::initClass(void)
+{
+  sorq_storage = new SbStorage(sizeof(sorq_recording),
+                               sorq_construct_recording,
+                               sorq_destruct_recording);
+  coin_atexit(reinterpret_cast<coin_atexit_f *>(SoGLRenderQueue::cleanup), CC_ATEXIT_NORMAL);
+}
+
+void
+SoGLRenderQueue::cleanup(void)
+{
+  delete sorq_storage;
+  sorq_storage = NULL;
+}
+
+/*!
+  Returns the queue recording the shapes rendered with \a state in
+  this thread, or \c NULL if no queue is recording.
+*/
+SoGLRenderQueue *
+SoGLRenderQueue::getRecording(const SoState * state)
+{
+  // called for every shape, so the thread local data is only looked
+  // at when some thread is recording
+  if (sorq_numrecording == 0) return NULL;
+  const sorq_recording * data = sorq_get_recording();
+  return (data->state == state) ? data->queue : NULL;
+}
+
+/*!
+  Starts a new frame. Must be called before the children are
+  rendered with render().
+*/
+void
+SoGLRenderQueue::beginFrame(void)
+{
+  this->frame++;
+  this->pending.truncate(0);
+}
+
+/*!
+  Renders \a child, which must be a separator, for the current frame.
+  If its shapes have already been recorded and are still valid, the
+  child is not traversed, and its shapes will be drawn by flush() or
+  endFrame(). Otherwise the pending shapes are flushed, and the child
+  is traversed, and its shapes are recorded while they are rendered.
+*/
+void
+SoGLRenderQueue::render(SoGLRenderAction * action, SoNode * child)
+{
+  SoState * state = action->getState();
+  sorq_chunk * chunk = NULL;
+  if (!this->chunkdict.get(child, chunk)) {
+    chunk = new sorq_chunk;
+    chunk->node = child;
+    chunk->nodeid = 0;
+    chunk->contextid = 0;
+    chunk->cache = NULL;
+    chunk->ok = TRUE;
+    chunk->numrecords = 0;
+    chunk->visitframe = chunk->drawframe = -1;
+    this->chunks.append(chunk);
+    this->chunkdict.put(child, chunk);
+  }
+
+  // the same separator can occur more than once, with different state
+  if (chunk->visitframe == this->frame) {
+    this->flush(action);
+    child->GLRenderBelowPath(action);
+    return;
+  }
+  chunk->visitframe = this->frame;
+
+  const SbUniqueId nodeid = child->getNodeId();
+  if (nodeid != chunk->nodeid) {
+    chunk->ok = TRUE;
+    chunk->numrecords = 0;
+  }
+  if (!chunk->ok) {
+    this->flush(action);
+    child->GLRenderBelowPath(action);
+    return;
+  }
+
+  if (nodeid == chunk->nodeid &&
+      chunk->contextid == static_cast<uint32_t>(SoGLCacheContextElement::get(state)) &&
+      chunk->cache && chunk->cache->isValid(state) &&
+      SoGLLazyElement::preCacheCall(state, &chunk->prestate)) {
+    if (chunk->items.getLength() &&
+        !SoCullElement::cullTest(state, chunk->box, FALSE)) {
+      chunk->drawframe = this->frame;
+      this->pending.append(chunk);
+    }
+    return;
+  }
+  this->flush(action);
+  this->record(action, child, chunk);
+}
+
+void
+SoGLRenderQueue::record(SoGLRenderAction * action, SoNode * child, sorq_chunk * chunk)
+{
+  SoState * state = action->getState();
+  SoGLRenderQueue::clearChunk(chunk);
+  this->sortdirty = TRUE;
+  chunk->nodeid = child->getNodeId();
+  chunk->numrecords++;
+
+  this->beginRecording(state, chunk);
+  child->GLRenderBelowPath(action);
+  this->endRecording(state);
+
+  if (chunk->numrecords > SORQ_MAX_RECORDS) chunk->ok = FALSE;
+  if (!chunk->ok) SoGLRenderQueue::clearChunk(chunk);
+  // the shapes were rendered while recording
+  chunk->drawframe = -1;
+}
+
+/*!
+  Starts recording the shapes rendered with \a state in this thread
+  into \a chunk, which should be empty. Pushes the state and opens
+  the cache of \a chunk, so that it picks up the elements the shapes
+  depend on, like a render cache does. Recordings do not nest.
+*/
+void
+SoGLRenderQueue::beginRecording(SoState * state, sorq_chunk * chunk)
+{
+  assert(!this->recording);
+  chunk->contextid = SoGLCacheContextElement::get(state);
+  chunk->box.makeEmpty();
+
+  state->push();
+  chunk->cache = new SoCache(state);
+  chunk->cache->ref();
+  SoCacheElement::set(state, chunk->cache);
+  SoGLLazyElement::beginCaching(state, &chunk->prestate, &chunk->poststate);
+
+  sorq_recording * data = sorq_get_recording();
+  data->queue = this;
+  data->state = state;
+  data->numlights = SoLightElement::getLights(state).getLength();
+  data->numclipplanes = SoClipPlaneElement::getInstance(state)->getNum();
+  data->depthbuffer = sorq_get_instance(state, SoDepthBufferElement::getClassStackIndex());
+  data->polygonoffset = sorq_get_instance(state, SoPolygonOffsetElement::getClassStackIndex());
+  this->recording = chunk;
+
+  CC_GLOBAL_LOCK;
+  sorq_numrecording++;
+  CC_GLOBAL_UNLOCK;
+}
+
+/*!
+  Stops the recording started with beginRecording(), and pops the
+  state.
+*/
+void
+SoGLRenderQueue::endRecording(SoState * state)
+{
+  assert(this->recording);
+  CC_GLOBAL_LOCK;
+  sorq_numrecording--;
+  CC_GLOBAL_UNLOCK;
+
+  this->recording = NULL;
+  sorq_recording * data = sorq_get_recording();
+  data->queue = NULL;
+  data->state = NULL;
+  SoGLLazyElement::endCaching(state);
+  state->pop();
+}
+
+/*!
+  Draws the shapes of the unchanged children visited since the last
+  flush, sorted by their GL state. Must be called before anything
+  else is rendered or the GL state is changed during the frame.
+*/
+void
+SoGLRenderQueue::flush(SoGLRenderAction * action)
+{
+  if (this->pending.getLength() == 0) return;
+  int numitems = 0;
+  for (int i = 0; i < this->pending.getLength(); i++) {
+    numitems += this->pending[i]->items.getLength();
+  }
+
+  // the shapes of a few children are sorted on their own rather than
+  // picked out of the sorted shapes of all children
+  SbList<const sorq_item *> few;
+  const SbList<const sorq_item *> * items = &this->sorted;
+  if (this->sortdirty || 2 * numitems < this->sorted.getLength()) {
+    for (int i = 0; i < this->pending.getLength(); i++) {
+      sorq_chunk * chunk = this->pending[i];
+      for (int j = 0; j < chunk->items.getLength(); j++) {
+        few.append(&chunk->items[j]);
+      }
+    }
+    if (few.getLength() > 1) {
+      qsort(const_cast<const sorq_item **>(few.getArrayPtr()),
+            few.getLength(), sizeof(const sorq_item *),
+            sorq_compare_items);
+    }
+    items = &few;
+  }
+
+  SoState * state = action->getState();
+  const SbMatrix & viewing = SoViewingMatrixElement::get(state);
+  glPushAttrib(GL_ENABLE_BIT | GL_LIGHTING_BIT | GL_POLYGON_BIT | GL_CURRENT_BIT);
+  glEnable(GL_NORMALIZE);
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  const sorq_glstate * prev = NULL;
+  for (int i = 0; i < items->getLength(); i++) {
+    const sorq_item * item = (*items)[i];
+    if (item->chunk->drawframe != this->frame) continue;
+    if (!prev || memcmp(prev, &item->glstate, sizeof(sorq_glstate))) {
+      sorq_send_glstate(item->glstate, prev);
+      prev = &item->glstate;
+    }
+    SbMatrix matrix = item->matrix;
+    matrix.multRight(viewing);
+    glLoadMatrixf(matrix[0]);
+    item->pvcache->renderTriangles(state, SoPrimitiveVertexCache::NORMAL |
+                                   SoPrimitiveVertexCache::COLOR);
+  }
+  glPopMatrix();
+  glPopAttrib();
+
+  for (int i = 0; i < this->pending.getLength(); i++) {
+    this->pending[i]->drawframe = -1;
+  }
+  this->pending.truncate(0);
+}
+
+/*!
+  Draws the shapes which are still pending, and forgets the children
+  which were not visited since beginFrame().
+*/
+void
+SoGLRenderQueue::endFrame(SoGLRenderAction * action)
+{
+  int n = 0;
+  for (int i = 0; i < this->chunks.getLength(); i++) {
+    sorq_chunk * chunk = this->chunks[i];
+    if (chunk->visitframe != this->frame) {
+      if (chunk->items.getLength()) this->sortdirty = TRUE;
+      SoGLRenderQueue::clearChunk(chunk);
+      this->chunkdict.erase(chunk->node);
+      delete chunk;
+      continue;
+    }
+    this->chunks[n++] = chunk;
+  }
+  this->chunks.truncate(n);
+  if (this->sortdirty) this->sort();
+  this->flush(action);
+}
+
+/*!
+  Sends the material and polygon state \a glstate to OpenGL. Only the
+  parts which differ from \a prev are sent, or all of it if \a prev
+  is \c NULL.
+*/
+void
+SoGLRenderQueue::sendGLState(const sorq_glstate & glstate, const sorq_glstate * prev)
+{
+  sorq_send_glstate(glstate, prev);
+}
+
+/*!
+  Returns \c TRUE if \a shape can be drawn from its primitive vertex
+  cache with only the state the queue keeps.
+*/
+SbBool
+SoGLRenderQueue::canQueue(SoState * state, const SoShape * shape)
+{
+  if (SoShapeStyleElement::get(state)->getFlags() & SORQ_UNQUEUEABLE_FLAGS) return FALSE;
+  if (SoDrawStyleElement::get(state) != SoDrawStyleElement::FILLED) return FALSE;
+  if (SoGLShaderProgramElement::get(state) != NULL) return FALSE;
+  // the shape is queued before SoGLRenderAction::handleTransparency()
+  // is called, which renders to the sorted layers or sets up blending
+  // for smoothing
+  const SoGLRenderAction * action =
+    coin_assert_cast<const SoGLRenderAction *>(state->getAction());
+  if (action->getTransparencyType() == SoGLRenderAction::SORTED_LAYERS_BLEND ||
+      action->isSmoothing()) return FALSE;
+  // bitmaps generate primitives which differ from what is rendered
+  if (shape->isOfType(SoText2::getClassTypeId()) ||
+      shape->isOfType(SoImage::getClassTypeId())) return FALSE;
+
+  // lights, clip planes and depth buffer and polygon offset settings
+  // inside the child are not active when the queue is drawn
+  const sorq_recording * data = sorq_get_recording();
+  return
+    SoLightElement::getLights(state).getLength() == data->numlights &&
+    SoClipPlaneElement::getInstance(state)->getNum() == data->numclipplanes &&
+    sorq_get_instance(state, SoDepthBufferElement::getClassStackIndex()) == data->depthbuffer &&
+    sorq_get_instance(state, SoPolygonOffsetElement::getClassStackIndex()) == data->polygonoffset;
+}
+
+/*!
+  Adds a shape which is about to be rendered from \a pvcache, after
+  its material and shape hints have been sent to OpenGL. Returns \c
+  FALSE if \a pvcache has lines or points, which the queue does not
+  draw.
+*/
+SbBool
+SoGLRenderQueue::addShape(SoState * state, SoPrimitiveVertexCache * pvcache)
+{
+  assert(this->recording);
+  if (pvcache->getNumLineIndices() || pvcache->getNumPointIndices()) return FALSE;
+  if (pvcache->getNumTriangleIndices() == 0) return TRUE;
+
+  sorq_item item;
+  sorq_glstate & glstate = item.glstate;
+  memset(&glstate, 0, sizeof(sorq_glstate));
+  glstate.diffuse = SoLazyElement::getDiffuse(state, 0).getPackedValue(SoLazyElement::getTransparency(state, 0));
+  SoLazyElement::getAmbient(state).getValue(glstate.ambient[0], glstate.ambient[1], glstate.ambient[2]);
+  SoLazyElement::getEmissive(state).getValue(glstate.emissive[0], glstate.emissive[1], glstate.emissive[2]);
+  SoLazyElement::getSpecular(state).getValue(glstate.specular[0], glstate.specular[1], glstate.specular[2]);
+  glstate.shininess = SoLazyElement::getShininess(state);
+
+  // the polygon state is sent by the shape itself, so it is read back
+  // from OpenGL
+  GLint value;
+  glstate.lighting = glIsEnabled(GL_LIGHTING) ? 1 : 0;
+  glstate.culling = glIsEnabled(GL_CULL_FACE) ? 1 : 0;
+  glGetIntegerv(GL_FRONT_FACE, &value);
+  glstate.ccw = (value == GL_CCW) ? 1 : 0;
+  glGetIntegerv(GL_LIGHT_MODEL_TWO_SIDE, &value);
+  glstate.twoside = value ? 1 : 0;
+  glGetIntegerv(GL_SHADE_MODEL, &value);
+  glstate.flatshading = (value == GL_FLAT) ? 1 : 0;
+
+  item.matrix = SoModelMatrixElement::get(state);
+  item.pvcache = pvcache;
+  item.chunk = this->recording;
+  pvcache->ref();
+  this->recording->items.append(item);
+  this->recording->box.extendBy(pvcache->getVertexArray(), pvcache->getNumVertices(), item.matrix);
+  return TRUE;
+}
+
+/*!
+  Marks the child being recorded as having shapes which can not be
+  queued. It will be traversed normally until it changes.
+*/
+void
+SoGLRenderQueue::setUnqueueable(void)
+{
+  assert(this->recording);
+  this->recording->ok = FALSE;
+}
+
+/*!
+  Releases the shapes and the cache of \a chunk.
+*/
+void
+SoGLRenderQueue::clearChunk(sorq_chunk * chunk)
+{
+  for (int i = 0; i < chunk->items.getLength(); i++) {
+    chunk->items[i].pvcache->unref();
+  }
+  chunk->items.truncate(0);
+  if (chunk->cache) {
+    chunk->cache->unref();
+    chunk->cache = NULL;
+  }
+}
+
+// Sorts the items of all chunks by their GL state.
+void
+SoGLRenderQueue::sort(void)
+{
+  this->sorted.truncate(0);
+  for (int i = 0; i < this->chunks.getLength(); i++) {
+    sorq_chunk * chunk = this->chunks[i];
+    for (int j = 0; j < chunk->items.getLength(); j++) {
+      this->sorted.append(&chunk->items[j]);
+    }
+  }
+  if (this->sorted.getLength() > 1) {
+    qsort(const_cast<const sorq_item **>(this->sorted.getArrayPtr()),
+          this->sorted.getLength(), sizeof(const sorq_item *),
+          sorq_compare_items);
+  }
+  this->sortdirty = FALSE;
+}
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/caches/SoCache.h>
+#include <Inventor/nodes/SoCube.h>
+#include <rendering/SoGLRenderQueue.h>
+
+// Starts recording into a queue from the state of action, and
+// returns whether a cube could be queued.
+static SbBool
+sorq_test_can_queue(SoGLRenderAction & action)
+{
+  SoCube * cube = new SoCube;
+  cube->ref();
+  SoState * state = action.getState();
+  SoGLRenderQueue queue;
+  sorq_chunk chunk;
+  queue.beginRecording(state, &chunk);
+  BOOST_CHECK(SoGLRenderQueue::getRecording(state) == &queue);
+  const SbBool canqueue = SoGLRenderQueue::canQueue(state, cube);
+  queue.endRecording(state);
+  BOOST_CHECK(SoGLRenderQueue::getRecording(state) == NULL);
+  chunk.cache->unref();
+  cube->unref();
+  return canqueue;
+}
+
+BOOST_AUTO_TEST_CASE(canQueue)
+{
+  const SbViewportRegion vp(100, 100);
+  SoGLRenderAction plain(vp);
+  BOOST_CHECK_MESSAGE(sorq_test_can_queue(plain), "plain shape not queued");
+
+  SoGLRenderAction layers(vp);
+  layers.setTransparencyType(SoGLRenderAction::SORTED_LAYERS_BLEND);
+  BOOST_CHECK_MESSAGE(!sorq_test_can_queue(layers),
+                      "shape queued with sorted layers blending");
+
+  SoGLRenderAction smoothing(vp);
+  smoothing.setSmoothing(TRUE);
+  BOOST_CHECK_MESSAGE(!sorq_test_can_queue(smoothing),
+                      "shape queued with smoothing");
+}
+
+#endif // COIN_TEST_SUITE
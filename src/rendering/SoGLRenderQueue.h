@@ -0,0 +1,132 @@
+#ifndef COIN_SOGLRENDERQUEUE_H
+#define COIN_SOGLRENDERQUEUE_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* !COIN_INTERNAL */
+
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbMatrix.h>
+#include <Inventor/elements/SoGLLazyElement.h>
+#include <Inventor/lists/SbList.h>
+
+#include "misc/SbHash.h"
+
+class SoCache;
+class SoGLRenderAction;
+class SoNode;
+class SoPrimitiveVertexCache;
+class SoShape;
+class SoState;
+
+// The GL state a queued shape is drawn with. Compared with memcmp()
+// when sorting, so it must be cleared before it is filled in.
+struct sorq_glstate {
+  uint32_t diffuse;
+  float ambient[3];
+  float emissive[3];
+  float specular[3];
+  float shininess;
+  uint8_t lighting;
+  uint8_t ccw;
+  uint8_t culling;
+  uint8_t twoside;
+  uint8_t flatshading;
+};
+
+struct sorq_chunk;
+
+struct sorq_item {
+  sorq_glstate glstate;
+  SbMatrix matrix;
+  SoPrimitiveVertexCache * pvcache;
+  sorq_chunk * chunk;
+};
+
+// The queued shapes of one child separator, and what they depend on.
+struct sorq_chunk {
+  const SoNode * node; // only used as a key
+  SbUniqueId nodeid;
+  uint32_t contextid;
+  SoCache * cache;
+  SoGLLazyElement::GLState prestate;
+  SoGLLazyElement::GLState poststate;
+  SbList<sorq_item> items;
+  SbBox3f box;
+  SbBool ok;
+  int numrecords;
+  int visitframe;
+  int drawframe;
+};
+
+class SoGLRenderQueue {
+public:
+  SoGLRenderQueue(void);
+  ~SoGLRenderQueue();
+
+  static void initClass(void);
+  static SoGLRenderQueue * getRecording(const SoState * state);
+
+  void beginFrame(void);
+  void render(SoGLRenderAction * action, SoNode * child);
+  void flush(SoGLRenderAction * action);
+  void endFrame(SoGLRenderAction * action);
+
+  static SbBool canQueue(SoState * state, const SoShape * shape);
+  SbBool addShape(SoState * state, SoPrimitiveVertexCache * pvcache);
+  void setUnqueueable(void);
+
+  void beginRecording(SoState * state, sorq_chunk * chunk);
+  void endRecording(SoState * state);
+  static void clearChunk(sorq_chunk * chunk);
+  static void sendGLState(const sorq_glstate & glstate, const sorq_glstate * prev);
+
+  int getNumChunks(void) const { return this->chunks.getLength(); }
+
+private:
+  static void cleanup(void);
+  void record(SoGLRenderAction * action, SoNode * child, sorq_chunk * chunk);
+  void sort(void);
+
+  SbList<sorq_chunk *> chunks;
+  SbHash<const SoNode *, sorq_chunk *> chunkdict;
+  SbList<const sorq_item *> sorted;
+  SbBool sortdirty;
+  SbList<sorq_chunk *> pending; // drawn by the next flush()
+  sorq_chunk * recording;
+  int frame;
+};
+
+#endif // !COIN_SOGLRENDERQUEUE_H
@@ -0,0 +1,399 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SoGLWeightedBlend SoGLWeightedBlend.h
+  \brief The SoGLWeightedBlend class renders transparent shapes with weighted blended order independent transparency.
+
+  \ingroup coin_rendering
+
+  Used by SoGLRenderAction for SoGLRenderAction::WEIGHTED_BLEND. The
+  transparent shapes are rendered in one pass, after the opaque
+  shapes, into two floating point color buffers of a framebuffer
+  object. The first accumulates the premultiplied colors weighted by
+  depth and coverage, the second the logarithm of how much of the
+  background is left visible. Both are accumulated with additive
+  blending, so the order the shapes are rendered in does not matter.
+  The framebuffer object shares a copy of the depth buffer of the
+  opaque shapes. At the end, the averaged color is blended on top of
+  the opaque shapes.
+
+  The method is described in "Weighted Blended Order-Independent
+  Transparency" by Morgan McGuire and Louis Bavoil, Journal of
+  Computer Graphics Techniques, 2013.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "rendering/SoGLWeightedBlend.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <cstring>
+
+#include <Inventor/elements/SoGLCacheContextElement.h>
+#include <Inventor/elements/SoViewportRegionElement.h>
+#include <Inventor/errors/SoDebugError.h>
+#include <Inventor/misc/SoState.h>
+#include <Inventor/system/gl.h>
+
+#include "rendering/SoGL.h"
+
+// *************************************************************************
+
+// The lit color comes from the fixed function vertex processing. The
+// weight function is equation 10 of the paper. Coverage is clamped
+// below 1 so that the logarithm stays finite.
+static const char * sowb_accum_program =
+  "uniform sampler2D texture0;\n"
+  "uniform int textured;\n"
+  "void main(void)\n"
+  "{\n"
+  "  vec4 color = gl_Color;\n"
+  "  if (textured != 0) color *= texture2D(texture0, gl_TexCoord[0].st);\n"
+  "  float alpha = clamp(color.a, 0.0, 0.999);\n"
+  "  float z = gl_FragCoord.z;\n"
+  "  float weight = clamp(alpha * max(1.0e-2, 3.0e3 * pow(1.0 - z, 3.0)), 1.0e-2, 3.0e3);\n"
+  "  gl_FragData[0] = vec4(color.rgb * alpha, alpha) * weight;\n"
+  "  gl_FragData[1] = vec4(-log(1.0 - alpha));\n"
+  "}\n";
+
+static const char * sowb_composite_program =
+  "uniform sampler2D accumtexture;\n"
+  "uniform sampler2D revealtexture;\n"
+  "void main(void)\n"
+  "{\n"
+  "  float revealage = exp(-texture2D(revealtexture, gl_TexCoord[0].st).r);\n"
+  "  if (revealage >= 1.0) discard;\n"
+  "  vec4 accum = texture2D(accumtexture, gl_TexCoord[0].st);\n"
+  "  gl_FragColor = vec4(accum.rgb / max(accum.a, 1.0e-5), 1.0 - revealage);\n"
+  "}\n";
+
+static void
+sowb_delete_buffers(const cc_glglue * glue, sowb_resources * res)
+{
+  if (res->framebuffer) cc_glglue_glDeleteFramebuffers(glue, 1, &res->framebuffer);
+  if (res->depthtexture) glDeleteTextures(1, &res->depthtexture);
+  if (res->colortextures[0]) glDeleteTextures(2, res->colortextures);
+  res->framebuffer = 0;
+  res->depthtexture = 0;
+  res->colortextures[0] = res->colortextures[1] = 0;
+}
+
+static void
+sowb_delete_programs(const cc_glglue * glue, sowb_resources * res)
+{
+  if (res->accumprogram) glue->glDeleteObjectARB(res->accumprogram);
+  if (res->compositeprogram) glue->glDeleteObjectARB(res->compositeprogram);
+  res->accumprogram = 0;
+  res->compositeprogram = 0;
+}
+
+static void
+sowb_delete_cb(void * closure, uint32_t contextid)
+{
+  const cc_glglue * glue = cc_glglue_instance(contextid);
+  sowb_resources * res = static_cast<sowb_resources *>(closure);
+  sowb_delete_buffers(glue, res);
+  sowb_delete_programs(glue, res);
+  delete res;
+}
+
+// Compiles and links a program with only a fragment shader. Returns 0
+// on failure.
+static COIN_GLhandle
+sowb_create_program(const cc_glglue * glue, const char * source)
+{
+  GLint ok = 0;
+  COIN_GLhandle shader = glue->glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
+  if (!shader) return 0;
+  glue->glShaderSourceARB(shader, 1, (const COIN_GLchar **)&source, NULL);
+  glue->glCompileShaderARB(shader);
+  glue->glGetObjectParameterivARB(shader, GL_OBJECT_COMPILE_STATUS_ARB, &ok);
+  if (!ok) {
+    glue->glDeleteObjectARB(shader);
+    return 0;
+  }
+
+  COIN_GLhandle program = glue->glCreateProgramObjectARB();
+  glue->glAttachObjectARB(program, shader);
+  glue->glLinkProgramARB(program);
+  // the shader is deleted with the program it is attached to
+  glue->glDeleteObjectARB(shader);
+  glue->glGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &ok);
+  if (!ok) {
+    glue->glDeleteObjectARB(program);
+    return 0;
+  }
+  return program;
+}
+
+// *************************************************************************
+
+/*!
+  Constructor.
+*/
+SoGLWeightedBlend::SoGLWeightedBlend(void)
+  : contextid(0), size(0, 0), failed(FALSE), textured(FALSE), oldframebuffer(0)
+{
+  memset(&this->resources, 0, sizeof(sowb_resources));
+}
+
+/*!
+  Destructor. The GL objects are deleted the next time their context
+  is current.
+*/
+SoGLWeightedBlend::~SoGLWeightedBlend()
+{
+  this->freeResources(NULL, TRUE);
+}
+
+/*!
+  Binds the framebuffer object and program for rendering the
+  transparent shapes. The depth buffer must hold the opaque shapes.
+  Returns \c FALSE if the GL objects could not be created, and
+  nothing was changed.
+*/
+SbBool
+SoGLWeightedBlend::begin(SoState * state)
+{
+  const cc_glglue * glue = sogl_glue_instance(state);
+  const uint32_t context = SoGLCacheContextElement::get(state);
+  const SbVec2s winsize = SoViewportRegionElement::get(state).getWindowSize();
+
+  if (context != this->contextid) {
+    this->freeResources(state, TRUE);
+    this->contextid = context;
+    this->size.setValue(0, 0);
+    this->failed = !this->createPrograms(glue);
+  }
+  if (this->failed) return FALSE;
+  if (winsize != this->size) {
+    this->freeResources(state, FALSE);
+    this->size = winsize;
+    if (!this->createBuffers(glue)) this->freeResources(state, FALSE);
+  }
+  // creating the buffers is only tried again when the size changes
+  if (!this->resources.framebuffer) return FALSE;
+
+  const sowb_resources & res = this->resources;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &this->oldframebuffer);
+
+  // the transparent shapes are depth tested against the opaque shapes
+  glPushAttrib(GL_TEXTURE_BIT);
+  glBindTexture(GL_TEXTURE_2D, res.depthtexture);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, this->size[0], this->size[1]);
+  glPopAttrib();
+
+  cc_glglue_glBindFramebuffer(glue, GL_FRAMEBUFFER_EXT, res.framebuffer);
+  static const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0_EXT, GL_COLOR_ATTACHMENT1_EXT };
+  glue->glDrawBuffers(2, buffers);
+  glPushAttrib(GL_COLOR_BUFFER_BIT);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glPopAttrib();
+
+  glue->glUseProgramObjectARB(res.accumprogram);
+  this->textured = FALSE;
+  glue->glUniform1iARB(res.texturedlocation, 0);
+  return TRUE;
+}
+
+/*!
+  Sets whether the transparent shapes rendered next are modulated by
+  the 2D texture in texture unit 0.
+*/
+void
+SoGLWeightedBlend::setTextured(const SbBool onoff)
+{
+  if (onoff != this->textured) {
+    const cc_glglue * glue = cc_glglue_instance(this->contextid);
+    glue->glUniform1iARB(this->resources.texturedlocation, onoff ? 1 : 0);
+    this->textured = onoff;
+  }
+}
+
+/*!
+  Restores the framebuffer bound before begin(), and blends the
+  averaged color of the transparent shapes on top of it.
+*/
+void
+SoGLWeightedBlend::end(SoState * state)
+{
+  const cc_glglue * glue = sogl_glue_instance(state);
+  const sowb_resources & res = this->resources;
+  cc_glglue_glBindFramebuffer(glue, GL_FRAMEBUFFER_EXT, this->oldframebuffer);
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+               GL_TEXTURE_BIT | GL_VIEWPORT_BIT | GL_TRANSFORM_BIT | GL_CURRENT_BIT);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_ALPHA_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glViewport(0, 0, this->size[0], this->size[1]);
+
+  cc_glglue_glActiveTexture(glue, GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, res.colortextures[1]);
+  cc_glglue_glActiveTexture(glue, GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, res.colortextures[0]);
+  glue->glUseProgramObjectARB(res.compositeprogram);
+
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+  glBegin(GL_QUADS);
+  glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
+  glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, -1.0f);
+  glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, 1.0f);
+  glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, 1.0f);
+  glEnd();
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+
+  glue->glUseProgramObjectARB(0);
+  glPopAttrib();
+}
+
+SbBool
+SoGLWeightedBlend::createPrograms(const cc_glglue * glue)
+{
+  sowb_resources & res = this->resources;
+  res.accumprogram = sowb_create_program(glue, sowb_accum_program);
+  res.compositeprogram = sowb_create_program(glue, sowb_composite_program);
+  if (!res.accumprogram || !res.compositeprogram) {
+    SoDebugError::postWarning("SoGLWeightedBlend::createPrograms",
+                              "Could not compile the weighted blend shaders.");
+    return FALSE;
+  }
+
+  // the sampler uniforms never change
+  glue->glUseProgramObjectARB(res.accumprogram);
+  glue->glUniform1iARB(glue->glGetUniformLocationARB(res.accumprogram, "texture0"), 0);
+  res.texturedlocation = glue->glGetUniformLocationARB(res.accumprogram, "textured");
+  glue->glUseProgramObjectARB(res.compositeprogram);
+  glue->glUniform1iARB(glue->glGetUniformLocationARB(res.compositeprogram, "accumtexture"), 0);
+  glue->glUniform1iARB(glue->glGetUniformLocationARB(res.compositeprogram, "revealtexture"), 1);
+  glue->glUseProgramObjectARB(0);
+  return TRUE;
+}
+
+SbBool
+SoGLWeightedBlend::createBuffers(const cc_glglue * glue)
+{
+  sowb_resources & res = this->resources;
+  const GLsizei w = this->size[0];
+  const GLsizei h = this->size[1];
+  if (w <= 0 || h <= 0) return FALSE;
+
+  glPushAttrib(GL_TEXTURE_BIT);
+  glGenTextures(2, res.colortextures);
+  glGenTextures(1, &res.depthtexture);
+  for (int i = 0; i < 3; i++) {
+    const GLuint id = (i < 2) ? res.colortextures[i] : res.depthtexture;
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (i < 2) {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F_ARB, w, h, 0, GL_RGBA, GL_FLOAT, NULL);
+    }
+    else {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, w, h, 0,
+                   GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    }
+  }
+  glPopAttrib();
+
+  GLint oldfb = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &oldfb);
+  cc_glglue_glGenFramebuffers(glue, 1, &res.framebuffer);
+  cc_glglue_glBindFramebuffer(glue, GL_FRAMEBUFFER_EXT, res.framebuffer);
+  cc_glglue_glFramebufferTexture2D(glue, GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+                                   GL_TEXTURE_2D, res.colortextures[0], 0);
+  cc_glglue_glFramebufferTexture2D(glue, GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT1_EXT,
+                                   GL_TEXTURE_2D, res.colortextures[1], 0);
+  cc_glglue_glFramebufferTexture2D(glue, GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
+                                   GL_TEXTURE_2D, res.depthtexture, 0);
+  const GLenum status = cc_glglue_glCheckFramebufferStatus(glue, GL_FRAMEBUFFER_EXT);
+  cc_glglue_glBindFramebuffer(glue, GL_FRAMEBUFFER_EXT, oldfb);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE_EXT) {
+    SoDebugError::postWarning("SoGLWeightedBlend::createBuffers",
+                              "Framebuffer incomplete (status 0x%x).", status);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Frees the textures and framebuffer, and the programs if \a
+// programs is TRUE. They are freed at once if their context is the
+// current one, and later otherwise.
+void
+SoGLWeightedBlend::freeResources(SoState * state, const SbBool programs)
+{
+  sowb_resources & res = this->resources;
+  if (!res.framebuffer && !res.depthtexture && !res.colortextures[0] &&
+      !(programs && (res.accumprogram || res.compositeprogram))) {
+    return;
+  }
+
+  if (state && static_cast<uint32_t>(SoGLCacheContextElement::get(state)) == this->contextid) {
+    const cc_glglue * glue = sogl_glue_instance(state);
+    sowb_delete_buffers(glue, &res);
+    if (programs) sowb_delete_programs(glue, &res);
+    return;
+  }
+
+  sowb_resources * deleted = new sowb_resources(res);
+  if (!programs) {
+    deleted->accumprogram = 0;
+    deleted->compositeprogram = 0;
+  }
+  SoGLCacheContextElement::scheduleDeleteCallback(this->contextid, sowb_delete_cb, deleted);
+  res.framebuffer = 0;
+  res.depthtexture = 0;
+  res.colortextures[0] = res.colortextures[1] = 0;
+  if (programs) {
+    res.accumprogram = 0;
+    res.compositeprogram = 0;
+  }
+}
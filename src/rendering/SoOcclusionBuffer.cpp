@@ -0,0 +1,644 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class SoOcclusionBuffer SoOcclusionBuffer.h
+  \brief The SoOcclusionBuffer class is a small software depth buffer for occlusion culling.
+
+  \ingroup coin_rendering
+
+  Triangles of large occluders are rasterized into a low resolution
+  depth buffer on the CPU, and bounding boxes can then be tested
+  against it to find out if they are completely hidden. This is used
+  by SoGLRenderAction when occlusion culling is enabled.
+
+  An occluder only covers the pixels which are completely inside it,
+  and it writes the farthest depth it has within each of them. A box
+  is occluded if its nearest corner is behind the depth of every pixel
+  its projection touches, so a box is never hidden by a pixel that an
+  occluder only partly covers. Since the pixels along the edge shared
+  by two triangles would be covered by neither, consecutive triangles
+  forming a convex quad, like the two halves of a rectangle, are
+  rasterized as one quad. Occluders crossing the near plane are
+  skipped, and boxes crossing it are never occluded.
+
+  The pixels of a row are rasterized four at a time with SSE2 when
+  SbVec3fBatch has picked an SSE2 or AVX kernel. With more than one
+  thread, the buffer is split in horizontal bands that are rasterized
+  in parallel.
+
+  \internal
+*/
+
+// *************************************************************************
+
+#include "rendering/SoOcclusionBuffer.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <cmath>
+
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbVec3f.h>
+#include <Inventor/C/threads/wpool.h>
+
+#include "base/SbVec3fBatch.h"
+
+#if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SOOCCLUSIONBUFFER_X86 1
+#define SOOCCLUSIONBUFFER_TARGET(ext) __attribute__((target(ext)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SOOCCLUSIONBUFFER_X86 1
+#define SOOCCLUSIONBUFFER_TARGET(ext)
+#endif
+
+#ifdef SOOCCLUSIONBUFFER_X86
+#include <emmintrin.h>
+#endif // SOOCCLUSIONBUFFER_X86
+
+// *************************************************************************
+
+// A band of rows rasterized by one thread.
+struct sooccl_band {
+  SoOcclusionBuffer * buffer;
+  const sooccl_triangle * triangles;
+  int numtriangles;
+  float * depth;
+  int width;
+  int ymin, ymax;
+  SbBool sse2;
+};
+
+namespace {
+
+// Points closer to the eye than this, in clip space w, are treated as
+// crossing the near plane.
+const float NEAR_W = 1.0e-5f;
+
+// Transforms a point to clip space. Returns FALSE if it is not in
+// front of the near plane.
+SbBool
+to_screen(const float m[4][4], const float * p, const int width,
+          const int height, float * screen)
+{
+  const float x = p[0]*m[0][0] + p[1]*m[1][0] + p[2]*m[2][0] + m[3][0];
+  const float y = p[0]*m[0][1] + p[1]*m[1][1] + p[2]*m[2][1] + m[3][1];
+  const float z = p[0]*m[0][2] + p[1]*m[1][2] + p[2]*m[2][2] + m[3][2];
+  const float w = p[0]*m[0][3] + p[1]*m[1][3] + p[2]*m[2][3] + m[3][3];
+  if (w <= NEAR_W || z < -w) return FALSE;
+  screen[0] = (x / w + 1.0f) * 0.5f * float(width);
+  screen[1] = (y / w + 1.0f) * 0.5f * float(height);
+  screen[2] = (z / w + 1.0f) * 0.5f;
+  return TRUE;
+}
+
+// Returns twice the signed area of the screen space triangle, which
+// is positive for counterclockwise vertices.
+double
+signed_area(const float * v0, const float * v1, const float * v2)
+{
+  return
+    double(v1[0] - v0[0]) * double(v2[1] - v0[1]) -
+    double(v2[0] - v0[0]) * double(v1[1] - v0[1]);
+}
+
+// Sets up a counterclockwise convex polygon with n = 3 or 4 screen
+// space vertices. The depth plane is the one of the first three
+// vertices, with doubled area area, and zextra is added to it. Returns
+// FALSE if it can not cover any pixel.
+SbBool
+setup_polygon(const float * const * v, const int n, const double area,
+              const float zextra, const int width, const int height,
+              sooccl_triangle & t)
+{
+  const float * v0 = v[0];
+  t.origin[0] = v0[0];
+  t.origin[1] = v0[1];
+  for (int i = 0; i < n; i++) {
+    const double ax = v[i][0] - v0[0], ay = v[i][1] - v0[1];
+    const float * b = v[(i + 1) % n];
+    const double bx = b[0] - v0[0], by = b[1] - v0[1];
+    const double ea = ay - by, eb = bx - ax;
+    t.edge[i][0] = float(ea);
+    t.edge[i][1] = float(eb);
+    // moved inwards, so that the edge function is >= 0 at the pixel
+    // center only if it is >= 0 at all corners of the pixel
+    t.edge[i][2] = float(ax * by - ay * bx - 0.5 * (fabs(ea) + fabs(eb)));
+  }
+  if (n == 3) {
+    t.edge[3][0] = t.edge[3][1] = 0.0f;
+    t.edge[3][2] = 1.0f;
+  }
+
+  const float * v1 = v[1], * v2 = v[2];
+  const double dz1 = v1[2] - v0[2], dz2 = v2[2] - v0[2];
+  const double a =
+    (dz1 * double(v2[1] - v0[1]) - dz2 * double(v1[1] - v0[1])) / area;
+  const double b =
+    (double(v1[0] - v0[0]) * dz2 - double(v2[0] - v0[0]) * dz1) / area;
+  t.zplane[0] = float(a);
+  t.zplane[1] = float(b);
+  t.zplane[2] = v0[2];
+  // the farthest depth within a pixel, from its center
+  t.zoffset = 0.5f * float(fabs(a) + fabs(b)) + zextra + 1.0e-6f;
+
+  // pixels with the center inside the bounds, clamped before
+  // converting to int as vertices can be far outside the buffer
+  float xmin = v0[0], xmax = v0[0], ymin = v0[1], ymax = v0[1];
+  for (int i = 1; i < n; i++) {
+    xmin = SbMin(xmin, v[i][0]);
+    xmax = SbMax(xmax, v[i][0]);
+    ymin = SbMin(ymin, v[i][1]);
+    ymax = SbMax(ymax, v[i][1]);
+  }
+  const float w = float(width), h = float(height);
+  t.xmin = int(ceil(SbClamp(xmin - 0.5f, 0.0f, w)));
+  t.xmax = SbMin(int(floor(SbClamp(xmax - 0.5f, -1.0f, w))), width - 1);
+  t.ymin = int(ceil(SbClamp(ymin - 0.5f, 0.0f, h)));
+  t.ymax = SbMin(int(floor(SbClamp(ymax - 0.5f, -1.0f, h))), height - 1);
+  return t.xmin <= t.xmax && t.ymin <= t.ymax;
+}
+
+// Sets up a triangle from screen space vertices. Returns FALSE if it
+// can not cover any pixel.
+SbBool
+setup_triangle(const float * v0, const float * v1, const float * v2,
+               const int width, const int height, sooccl_triangle & t)
+{
+  double area = signed_area(v0, v1, v2);
+  // occluders are two-sided, so the vertex order does not matter
+  if (area < 0.0) {
+    const float * tmp = v1; v1 = v2; v2 = tmp;
+    area = -area;
+  }
+  if (area < 1.0e-6) return FALSE;
+  const float * v[3] = { v0, v1, v2 };
+  return setup_polygon(v, 3, area, 0.0f, width, height, t);
+}
+
+// Sets up the quad made of the triangle a and the triangle sharing
+// the edge q-r of a, with s as its third vertex. Returns FALSE if the
+// quad is not convex, or can not cover any pixel.
+SbBool
+setup_quad(const float * const * a, const int p, const float * s,
+           const int width, const int height, sooccl_triangle & t)
+{
+  // p is the vertex of a which is not shared
+  const float * v0 = a[p], * v1 = a[(p + 1) % 3], * v2 = a[(p + 2) % 3];
+  double area = signed_area(v0, v1, v2);
+  if (area < 0.0) {
+    const float * tmp = v1; v1 = v2; v2 = tmp;
+    area = -area;
+  }
+  if (area < 1.0e-6) return FALSE;
+
+  const float * v[4] = { v0, v1, s, v2 };
+  for (int i = 0; i < 4; i++) {
+    if (signed_area(v[i], v[(i + 1) % 4], v[(i + 2) % 4]) <= 0.0) return FALSE;
+  }
+  // the depth plane of the first triangle is used for both, moved
+  // back to be behind the second triangle, which has the same depth
+  // along the shared edge
+  const double x = s[0] - v0[0], y = s[1] - v0[1];
+  const double dz1 = v1[2] - v0[2], dz2 = v2[2] - v0[2];
+  const double za = v0[2] +
+    (x * (dz1 * double(v2[1] - v0[1]) - dz2 * double(v1[1] - v0[1])) +
+     y * (double(v1[0] - v0[0]) * dz2 - double(v2[0] - v0[0]) * dz1)) / area;
+  const float zextra = float(SbMax(double(s[2]) - za, 0.0));
+  return setup_polygon(v, 4, area, zextra, width, height, t);
+}
+
+// Returns the index of the vertex of triangle a which is not a vertex
+// of triangle b, or -1 if the triangles do not share exactly one edge.
+// The fourth vertex of the quad is returned in s.
+int
+shared_edge(const SbVec3f * a, const SbVec3f * b, int & s)
+{
+  int p = -1, numshared = 0;
+  SbBool inb[3] = { FALSE, FALSE, FALSE };
+  for (int i = 0; i < 3; i++) {
+    SbBool shared = FALSE;
+    for (int j = 0; j < 3; j++) {
+      if (a[i] == b[j]) { shared = TRUE; inb[j] = TRUE; }
+    }
+    if (shared) numshared++;
+    else p = i;
+  }
+  if (numshared != 2 || p < 0) return -1;
+  s = -1;
+  for (int j = 0; j < 3; j++) {
+    if (!inb[j]) s = j;
+  }
+  return (s >= 0) ? p : -1;
+}
+
+// Rasterizes pixels first to last of a row. The edge functions and
+// depth are given at the center of pixel x0, and each pixel is
+// computed from there so that all kernels get the same result.
+void
+row_scalar(float * row, const int x0, const int first, const int last,
+           const float * e, const sooccl_triangle & t, const float z)
+{
+  for (int x = first; x <= last; x++) {
+    const float i = float(x - x0);
+    if (e[0] + t.edge[0][0] * i >= 0.0f &&
+        e[1] + t.edge[1][0] * i >= 0.0f &&
+        e[2] + t.edge[2][0] * i >= 0.0f &&
+        e[3] + t.edge[3][0] * i >= 0.0f) {
+      const float d = z + t.zplane[0] * i;
+      if (d < row[x]) row[x] = d;
+    }
+  }
+}
+
+SbBool
+covered_scalar(const float * row, const int x0, const int x1, const float depth)
+{
+  for (int x = x0; x <= x1; x++) {
+    if (row[x] >= depth) return FALSE;
+  }
+  return TRUE;
+}
+
+#ifdef SOOCCLUSIONBUFFER_X86
+
+SOOCCLUSIONBUFFER_TARGET("sse2") void
+row_sse2(float * row, const int x0, const int x1,
+         const float * e, const sooccl_triangle & t, const float z)
+{
+  const __m128 step = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 e0 = _mm_set1_ps(e[0]), a0 = _mm_set1_ps(t.edge[0][0]);
+  const __m128 e1 = _mm_set1_ps(e[1]), a1 = _mm_set1_ps(t.edge[1][0]);
+  const __m128 e2 = _mm_set1_ps(e[2]), a2 = _mm_set1_ps(t.edge[2][0]);
+  const __m128 e3 = _mm_set1_ps(e[3]), a3 = _mm_set1_ps(t.edge[3][0]);
+  const __m128 zv = _mm_set1_ps(z), za = _mm_set1_ps(t.zplane[0]);
+
+  int x = x0;
+  for (; x + 3 <= x1; x += 4) {
+    const __m128 i = _mm_add_ps(_mm_set1_ps(float(x - x0)), step);
+    __m128 mask = _mm_cmpge_ps(_mm_add_ps(e0, _mm_mul_ps(a0, i)), zero);
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(e1, _mm_mul_ps(a1, i)), zero));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(e2, _mm_mul_ps(a2, i)), zero));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(e3, _mm_mul_ps(a3, i)), zero));
+    const __m128 d = _mm_add_ps(zv, _mm_mul_ps(za, i));
+    const __m128 old = _mm_loadu_ps(row + x);
+    mask = _mm_and_ps(mask, _mm_cmplt_ps(d, old));
+    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, d), _mm_andnot_ps(mask, old)));
+  }
+  row_scalar(row, x0, x, x1, e, t, z);
+}
+
+SOOCCLUSIONBUFFER_TARGET("sse2") SbBool
+covered_sse2(const float * row, const int x0, const int x1, const float depth)
+{
+  const __m128 dv = _mm_set1_ps(depth);
+  int x = x0;
+  for (; x + 3 <= x1; x += 4) {
+    if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), dv))) return FALSE;
+  }
+  return covered_scalar(row, x, x1, depth);
+}
+
+#endif // SOOCCLUSIONBUFFER_X86
+
+} // namespace
+
+// *************************************************************************
+
+/*!
+  Constructor. The buffer is empty until setSize() is called.
+*/
+SoOcclusionBuffer::SoOcclusionBuffer(void)
+  : width(0), height(0), depth(NULL), numthreads(1), pool(NULL)
+{
+  this->matrix.makeIdentity();
+}
+
+/*!
+  Destructor.
+*/
+SoOcclusionBuffer::~SoOcclusionBuffer()
+{
+  delete[] this->depth;
+#ifdef HAVE_THREADS
+  if (this->pool) { cc_wpool_destruct(this->pool); }
+#endif // HAVE_THREADS
+}
+
+/*!
+  Sets the resolution of the buffer, and clears it.
+*/
+void
+SoOcclusionBuffer::setSize(const int widtharg, const int heightarg)
+{
+  if (widtharg != this->width || heightarg != this->height) {
+    delete[] this->depth;
+    this->width = widtharg;
+    this->height = heightarg;
+    this->depth = new float[this->width * this->height];
+  }
+  this->clear();
+}
+
+/*!
+  Sets the number of threads used for rasterizing triangles. The
+  default is 1.
+*/
+void
+SoOcclusionBuffer::setNumThreads(const int num)
+{
+  this->numthreads = SbMax(num, 1);
+}
+
+/*!
+  Sets the matrix transforming world space points to clip space,
+  usually the viewing matrix multiplied with the projection matrix,
+  and clears the buffer.
+*/
+void
+SoOcclusionBuffer::setMatrix(const SbMatrix & matrixarg)
+{
+  this->matrix = matrixarg;
+  this->clear();
+}
+
+/*!
+  Resets all pixels to the far plane.
+*/
+void
+SoOcclusionBuffer::clear(void)
+{
+  const int n = this->width * this->height;
+  for (int i = 0; i < n; i++) this->depth[i] = 1.0f;
+}
+
+void
+SoOcclusionBuffer::rasterizeBand(void * closure)
+{
+  const sooccl_band * band = static_cast<const sooccl_band *>(closure);
+  for (int i = 0; i < band->numtriangles; i++) {
+    const sooccl_triangle & t = band->triangles[i];
+    const int y0 = SbMax(t.ymin, band->ymin);
+    const int y1 = SbMin(t.ymax, band->ymax);
+    const float cx = float(t.xmin) + 0.5f - t.origin[0];
+    for (int y = y0; y <= y1; y++) {
+      const float cy = float(y) + 0.5f - t.origin[1];
+      float e[4];
+      for (int j = 0; j < 4; j++) {
+        e[j] = t.edge[j][0] * cx + t.edge[j][1] * cy + t.edge[j][2];
+      }
+      const float z = t.zplane[0] * cx + t.zplane[1] * cy + t.zplane[2] + t.zoffset;
+      float * row = band->depth + y * band->width;
+#ifdef SOOCCLUSIONBUFFER_X86
+      if (band->sse2) {
+        row_sse2(row, t.xmin, t.xmax, e, t, z);
+        continue;
+      }
+#endif // SOOCCLUSIONBUFFER_X86
+      row_scalar(row, t.xmin, t.xmin, t.xmax, e, t, z);
+    }
+  }
+}
+
+/*!
+  Rasterizes \a numtriangles triangles, given as three world space
+  vertices each, into the buffer.
+*/
+void
+SoOcclusionBuffer::addTriangles(const SbVec3f * vertices, const int numtriangles)
+{
+  if (this->width == 0 || this->height == 0) return;
+
+  const float (*m)[4] = this->matrix.getValue();
+  this->triangles.truncate(0);
+  for (int i = 0; i < numtriangles; i++) {
+    float screen[3][3];
+    SbBool infront = TRUE;
+    for (int j = 0; j < 3 && infront; j++) {
+      infront = to_screen(m, vertices[i*3 + j].getValue(),
+                          this->width, this->height, screen[j]);
+    }
+    if (!infront) continue;
+
+    sooccl_triangle t;
+    // a triangle and the next one sharing an edge with it are tried
+    // as a quad first
+    int p, s;
+    float fourth[3];
+    if (i + 1 < numtriangles &&
+        (p = shared_edge(vertices + i*3, vertices + (i + 1)*3, s)) >= 0 &&
+        to_screen(m, vertices[(i + 1)*3 + s].getValue(),
+                  this->width, this->height, fourth)) {
+      const float * a[3] = { screen[0], screen[1], screen[2] };
+      if (setup_quad(a, p, fourth, this->width, this->height, t)) {
+        this->triangles.append(t);
+        i++;
+        continue;
+      }
+    }
+    if (setup_triangle(screen[0], screen[1], screen[2],
+                       this->width, this->height, t)) {
+      this->triangles.append(t);
+    }
+  }
+  if (this->triangles.getLength() == 0) return;
+
+  // bands of at least 16 rows, one per thread
+  const int numbands = SbMax(SbMin(this->numthreads, this->height / 16), 1);
+  SbList<sooccl_band> bands;
+  for (int i = 0; i < numbands; i++) {
+    sooccl_band band;
+    band.buffer = this;
+    band.triangles = this->triangles.getArrayPtr();
+    band.numtriangles = this->triangles.getLength();
+    band.depth = this->depth;
+    band.width = this->width;
+    band.ymin = this->height * i / numbands;
+    band.ymax = this->height * (i + 1) / numbands - 1;
+    band.sse2 = SbVec3fBatch::getKernel() != SbVec3fBatch::SCALAR;
+    bands.append(band);
+  }
+
+#ifdef HAVE_THREADS
+  if (numbands > 1) {
+    const int numworkers = numbands - 1;
+    if (!this->pool) {
+      this->pool = cc_wpool_construct(numworkers);
+    }
+    else if (cc_wpool_get_num_workers(this->pool) < numworkers) {
+      cc_wpool_set_num_workers(this->pool, numworkers);
+    }
+    cc_wpool_begin(this->pool, numworkers);
+    for (int i = 1; i < numbands; i++) {
+      cc_wpool_start_worker(this->pool, SoOcclusionBuffer::rasterizeBand,
+                            &bands[i]);
+    }
+    cc_wpool_end(this->pool);
+    SoOcclusionBuffer::rasterizeBand(&bands[0]);
+    cc_wpool_wait_all(this->pool);
+    return;
+  }
+#endif // HAVE_THREADS
+  for (int i = 0; i < numbands; i++) {
+    SoOcclusionBuffer::rasterizeBand(&bands[i]);
+  }
+}
+
+/*!
+  Returns \c TRUE if \a box, transformed by \a modelmatrix to world
+  space, is hidden behind the occluders in every pixel it covers.
+*/
+SbBool
+SoOcclusionBuffer::isOccluded(const SbBox3f & box, const SbMatrix & modelmatrix) const
+{
+  if (box.isEmpty() || this->width == 0 || this->height == 0) return FALSE;
+
+  SbMatrix m = modelmatrix;
+  m.multRight(this->matrix);
+
+  const SbVec3f & mn = box.getMin();
+  const SbVec3f & mx = box.getMax();
+  float xmin = 0.0f, xmax = 0.0f, ymin = 0.0f, ymax = 0.0f, zmin = 0.0f;
+  for (int i = 0; i < 8; i++) {
+    const float corner[3] = {
+      (i & 1) ? mx[0] : mn[0],
+      (i & 2) ? mx[1] : mn[1],
+      (i & 4) ? mx[2] : mn[2]
+    };
+    float screen[3];
+    if (!to_screen(m.getValue(), corner, this->width, this->height, screen)) {
+      return FALSE;
+    }
+    if (i == 0 || screen[0] < xmin) xmin = screen[0];
+    if (i == 0 || screen[0] > xmax) xmax = screen[0];
+    if (i == 0 || screen[1] < ymin) ymin = screen[1];
+    if (i == 0 || screen[1] > ymax) ymax = screen[1];
+    if (i == 0 || screen[2] < zmin) zmin = screen[2];
+  }
+
+  // boxes outside the buffer are left to view frustum culling
+  if (xmax < 0.0f || ymax < 0.0f ||
+      xmin >= float(this->width) || ymin >= float(this->height)) {
+    return FALSE;
+  }
+  const float w = float(this->width), h = float(this->height);
+  const int x0 = int(floor(SbMax(xmin, 0.0f)));
+  const int x1 = SbMin(int(floor(SbMin(xmax, w))), this->width - 1);
+  const int y0 = int(floor(SbMax(ymin, 0.0f)));
+  const int y1 = SbMin(int(floor(SbMin(ymax, h))), this->height - 1);
+
+#ifdef SOOCCLUSIONBUFFER_X86
+  const SbBool sse2 = SbVec3fBatch::getKernel() != SbVec3fBatch::SCALAR;
+#endif // SOOCCLUSIONBUFFER_X86
+  for (int y = y0; y <= y1; y++) {
+    const float * row = this->depth + y * this->width;
+#ifdef SOOCCLUSIONBUFFER_X86
+    if (sse2) {
+      if (!covered_sse2(row, x0, x1, zmin)) return FALSE;
+      continue;
+    }
+#endif // SOOCCLUSIONBUFFER_X86
+    if (!covered_scalar(row, x0, x1, zmin)) return FALSE;
+  }
+  return TRUE;
+}
+
+#undef SOOCCLUSIONBUFFER_X86
+#undef SOOCCLUSIONBUFFER_TARGET
+
+// *************************************************************************
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbViewVolume.h>
+#include <base/SbVec3fBatch.h>
+#include <rendering/SoOcclusionBuffer.h>
+
+BOOST_AUTO_TEST_CASE(culledSets)
+{
+  // camera at the origin looking down the negative z axis, with a
+  // wall covering the middle of the view at z = -10
+  SbViewVolume vv;
+  vv.perspective(float(M_PI) / 4.0f, 1.0f, 1.0f, 100.0f);
+  const SbVec3f wall[6] = {
+    SbVec3f(-2.0f, -2.0f, -10.0f), SbVec3f(2.0f, -2.0f, -10.0f), SbVec3f(2.0f, 2.0f, -10.0f),
+    SbVec3f(-2.0f, -2.0f, -10.0f), SbVec3f(2.0f, 2.0f, -10.0f), SbVec3f(-2.0f, 2.0f, -10.0f)
+  };
+
+  struct { SbVec3f min, max; SbVec3f translation; SbBool occluded; } boxes[] = {
+    { SbVec3f(-0.5f, -0.5f, -20.5f), SbVec3f(0.5f, 0.5f, -19.5f), SbVec3f(0, 0, 0), TRUE },
+    { SbVec3f(-3.5f, -3.5f, -20.5f), SbVec3f(3.5f, 3.5f, -19.5f), SbVec3f(0, 0, 0), TRUE },
+    { SbVec3f(-0.5f, -0.5f, -0.5f), SbVec3f(0.5f, 0.5f, 0.5f), SbVec3f(1, -1, -50), TRUE },
+    // beside, partly beside and bigger than the wall
+    { SbVec3f(9.5f, -0.5f, -20.5f), SbVec3f(10.5f, 0.5f, -19.5f), SbVec3f(0, 0, 0), FALSE },
+    { SbVec3f(3.5f, -0.5f, -20.5f), SbVec3f(4.5f, 0.5f, -19.5f), SbVec3f(0, 0, 0), FALSE },
+    { SbVec3f(-10.0f, -10.0f, -31.0f), SbVec3f(10.0f, 10.0f, -29.0f), SbVec3f(0, 0, 0), FALSE },
+    // in front of the wall, the wall itself, and crossing the near plane
+    { SbVec3f(-0.5f, -0.5f, -5.5f), SbVec3f(0.5f, 0.5f, -4.5f), SbVec3f(0, 0, 0), FALSE },
+    { SbVec3f(-2.0f, -2.0f, -10.0f), SbVec3f(2.0f, 2.0f, -10.0f), SbVec3f(0, 0, 0), FALSE },
+    { SbVec3f(-0.5f, -0.5f, -20.0f), SbVec3f(0.5f, 0.5f, 0.5f), SbVec3f(0, 0, 0), FALSE },
+    // outside the view volume
+    { SbVec3f(-0.5f, -0.5f, 19.5f), SbVec3f(0.5f, 0.5f, 20.5f), SbVec3f(0, 0, 0), FALSE },
+    // just past the edge of the wall, in a pixel it only partly covers
+    { SbVec3f(3.9f, -0.5f, -20.01f), SbVec3f(4.005f, 0.5f, -19.99f), SbVec3f(0, 0, 0), FALSE }
+  };
+  const int numboxes = sizeof(boxes) / sizeof(boxes[0]);
+
+  const SbVec3fBatch::Kernel kernel = SbVec3fBatch::getKernel();
+  for (int pass = 0; pass < 4; pass++) {
+    SbVec3fBatch::setKernel((pass & 1) ? kernel : SbVec3fBatch::SCALAR);
+    SoOcclusionBuffer buffer;
+    buffer.setSize(128, 96);
+    buffer.setNumThreads((pass & 2) ? 4 : 1);
+    buffer.setMatrix(vv.getMatrix());
+    buffer.addTriangles(wall, 2);
+
+    BOOST_CHECK_MESSAGE(buffer.getDepth(64, 48) < 1.0f && buffer.getDepth(0, 0) == 1.0f,
+                        "wall not rasterized into the middle of the buffer");
+    for (int i = 0; i < numboxes; i++) {
+      SbMatrix modelmatrix;
+      modelmatrix.setTranslate(boxes[i].translation);
+      const SbBool occluded =
+        buffer.isOccluded(SbBox3f(boxes[i].min, boxes[i].max), modelmatrix);
+      BOOST_CHECK_MESSAGE(occluded == boxes[i].occluded,
+                          "wrong occlusion result for box " << i << " in pass " << pass);
+    }
+  }
+  SbVec3fBatch::setKernel(kernel);
+}
+
+#endif // COIN_TEST_SUITE
@@ -0,0 +1,94 @@
+#ifndef COIN_SOOCCLUSIONBUFFER_H
+#define COIN_SOOCCLUSIONBUFFER_H
+
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef COIN_INTERNAL
+#error this is a private header file
+#endif /* !COIN_INTERNAL */
+
+#include <Inventor/SbMatrix.h>
+#include <Inventor/C/threads/common.h>
+#include <Inventor/lists/SbList.h>
+
+class SbBox3f;
+class SbVec3f;
+
+// A triangle, or a convex quad made of two triangles, set up for
+// rasterization. The edge functions are >= 0 for pixels completely
+// inside, and the depth is a plane in screen coordinates. Both are
+// relative to the first vertex, to keep the constant terms small.
+// Triangles have an edge function which is always 1 as the fourth.
+struct sooccl_triangle {
+  float origin[2];
+  float edge[4][3];
+  float zplane[3];
+  float zoffset;
+  int xmin, xmax, ymin, ymax;
+};
+
+class SoOcclusionBuffer {
+public:
+  SoOcclusionBuffer(void);
+  ~SoOcclusionBuffer();
+
+  void setSize(const int width, const int height);
+  int getWidth(void) const { return this->width; }
+  int getHeight(void) const { return this->height; }
+
+  void setNumThreads(const int num);
+  int getNumThreads(void) const { return this->numthreads; }
+
+  void setMatrix(const SbMatrix & matrix);
+  const SbMatrix & getMatrix(void) const { return this->matrix; }
+
+  void clear(void);
+  void addTriangles(const SbVec3f * vertices, const int numtriangles);
+  SbBool isOccluded(const SbBox3f & box, const SbMatrix & modelmatrix) const;
+
+  float getDepth(const int x, const int y) const {
+    return this->depth[y * this->width + x];
+  }
+
+private:
+  static void rasterizeBand(void * closure);
+
+  int width, height;
+  float * depth;
+  SbMatrix matrix;
+  int numthreads;
+  SbList<sooccl_triangle> triangles;
+  cc_wpool * pool;
+};
+
+#endif // !COIN_SOOCCLUSIONBUFFER_H
@@ -47,6 +47,7 @@
 #include <Inventor/misc/SoGLDriverDatabase.h>
 
 #include "tidbitsp.h"
+#include "glue/glp.h"
 #include "rendering/SoVBO.h"
 #include "coindefs.h"
 
@@ -241,10 +242,13 @@ SoVertexArrayIndexer::close(void)
 }
 
 /*!
-  Render all added targets/indices.
+  Render all added targets/indices. If \a numinstances is more than
+  one, they are drawn that many times with glDrawElementsInstanced(),
+  which must then be supported.
 */
 void
-SoVertexArrayIndexer::render(const cc_glglue * glue, const SbBool renderasvbo, const uint32_t contextid)
+SoVertexArrayIndexer::render(const cc_glglue * glue, const SbBool renderasvbo, const uint32_t contextid,
+                             const int numinstances)
 {
   switch (this->target) {
   case GL_TRIANGLES:
@@ -269,23 +273,42 @@ SoVertexArrayIndexer::render(const cc_glglue * glue, const SbBool renderasvbo, c
         }
       }
       this->vbo->bindBuffer(contextid);
-      cc_glglue_glDrawElements(glue,
-                               this->target,
-                               this->indexarray.getLength(),
-                               this->use_shorts ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, NULL);
+      const GLenum type = this->use_shorts ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+      if (numinstances > 1) {
+        glue->glDrawElementsInstanced(this->target, this->indexarray.getLength(),
+                                      type, NULL, numinstances);
+      }
+      else {
+        cc_glglue_glDrawElements(glue,
+                                 this->target,
+                                 this->indexarray.getLength(),
+                                 type, NULL);
+      }
       cc_glglue_glBindBuffer(glue, GL_ELEMENT_ARRAY_BUFFER, 0);
     }
     else {
       const GLint * idxptr = this->indexarray.getArrayPtr();
-      cc_glglue_glDrawElements(glue,
-                               this->target,
-                               this->indexarray.getLength(),
-                               GL_UNSIGNED_INT,
-                               idxptr);
+      if (numinstances > 1) {
+        glue->glDrawElementsInstanced(this->target, this->indexarray.getLength(),
+                                      GL_UNSIGNED_INT, idxptr, numinstances);
+      }
+      else {
+        cc_glglue_glDrawElements(glue,
+                                 this->target,
+                                 this->indexarray.getLength(),
+                                 GL_UNSIGNED_INT,
+                                 idxptr);
+      }
     }
     break;
   default:
-    if (SoGLDriverDatabase::isSupported(glue, SO_GL_MULTIDRAW_ELEMENTS)) {
+    if (numinstances > 1) {
+      for (int i = 0; i < this->countarray.getLength(); i++) {
+        glue->glDrawElementsInstanced(this->target, this->countarray[i], GL_UNSIGNED_INT,
+                                      (const GLvoid*) this->ciarray[i], numinstances);
+      }
+    }
+    else if (SoGLDriverDatabase::isSupported(glue, SO_GL_MULTIDRAW_ELEMENTS)) {
       cc_glglue_glMultiDrawElements(glue,
                                     this->target,
                                     (GLsizei*) this->countarray.getArrayPtr(),
@@ -307,7 +330,7 @@ SoVertexArrayIndexer::render(const cc_glglue * glue, const SbBool renderasvbo, c
     break;
   }
 
-  if (this->next) this->next->render(glue, renderasvbo, contextid);
+  if (this->next) this->next->render(glue, renderasvbo, contextid, numinstances);
 }
 
 /*!
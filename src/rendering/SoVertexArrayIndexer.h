@@ -67,7 +67,8 @@ public:
   void endTarget(GLenum target);
 
   void close(void);
-  void render(const cc_glglue * glue, const SbBool renderasvbo, const uint32_t vbocontextid);
+  void render(const cc_glglue * glue, const SbBool renderasvbo, const uint32_t vbocontextid,
+              const int numinstances = 1);
 
   int getNumVertices(void);
   int getNumIndices(void) const;
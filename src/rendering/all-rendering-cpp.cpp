@@ -31,12 +31,17 @@
 \**************************************************************************/
 
 #include "CoinOffscreenGLCanvas.cpp"
+#include "SoDepthSorter.cpp"
 #include "SoGL.cpp"
 #include "SoGLBigImage.cpp"
 #include "SoGLCubeMapImage.cpp"
 #include "SoGLDriverDatabase.cpp"
 #include "SoGLImage.cpp"
+#include "SoGLInstancer.cpp"
 #include "SoGLNurbs.cpp"
+#include "SoGLRenderQueue.cpp"
+#include "SoGLWeightedBlend.cpp"
+#include "SoOcclusionBuffer.cpp"
 #include "SoOffscreenCGData.cpp"
 #include "SoOffscreenGLXData.cpp"
 #include "SoOffscreenRenderer.cpp"
@@ -107,6 +107,8 @@
 #include <Inventor/threads/SbMutex.h>
 #endif // COIN_THREADSAFE
 
+#include <Inventor/C/base/heap.h>
+
 #include "misc/SbHash.h"
 #include "coindefs.h" // COIN_STUB()
 
@@ -134,6 +136,116 @@
 
 // *************************************************************************
 
+// A queue of sensors, ordered on a key given when the sensor is
+// inserted, and FIFO for sensors with equal keys. Insertion, removal
+// and extraction of the first sensor are all O(log n), so scheduling
+// and unscheduling stays cheap with tens of thousands of sensors.
+class SoSensorQueue {
+public:
+  SoSensorQueue(void);
+  ~SoSensorQueue();
+
+  void insert(SoSensor * sensor, double key);
+  SbBool remove(SoSensor * sensor);
+  SoSensor * getFirst(void) const;
+  SoSensor * extractFirst(void);
+  int getLength(void) const { return this->entries.getNumElements(); }
+
+private:
+  struct Entry {
+    SoSensor * sensor;
+    double key;
+    uint64_t seqno;
+  };
+  static int compare(void * e0, void * e1);
+  void freeEntry(Entry * entry);
+
+  cc_heap * heap;
+  SbHash<SoSensor *, Entry *> entries;
+  SbList<Entry *> freelist;
+  uint64_t seqno;
+};
+
+SoSensorQueue::SoSensorQueue(void)
+  : seqno(0)
+{
+  this->heap = cc_heap_construct(256, SoSensorQueue::compare, TRUE);
+}
+
+SoSensorQueue::~SoSensorQueue()
+{
+  for (SbHash<SoSensor *, Entry *>::const_iterator iter = this->entries.const_begin();
+       iter != this->entries.const_end(); ++iter) {
+    delete iter->obj;
+  }
+  for (int i = 0; i < this->freelist.getLength(); i++) {
+    delete this->freelist[i];
+  }
+  cc_heap_destruct(this->heap);
+}
+
+// min-heap order: smallest key first, then first inserted first
+int
+SoSensorQueue::compare(void * e0, void * e1)
+{
+  const Entry * a = static_cast<const Entry *>(e0);
+  const Entry * b = static_cast<const Entry *>(e1);
+  if (a->key != b->key) return a->key < b->key;
+  return a->seqno < b->seqno;
+}
+
+void
+SoSensorQueue::insert(SoSensor * sensor, double key)
+{
+  // a sensor is only in the queue once
+  (void) this->remove(sensor);
+
+  Entry * entry;
+  if (this->freelist.getLength()) { entry = this->freelist.pop(); }
+  else { entry = new Entry; }
+  entry->sensor = sensor;
+  entry->key = key;
+  entry->seqno = this->seqno++;
+  (void) this->entries.put(sensor, entry);
+  cc_heap_add(this->heap, entry);
+}
+
+SbBool
+SoSensorQueue::remove(SoSensor * sensor)
+{
+  Entry * entry;
+  if (!this->entries.get(sensor, entry)) return FALSE;
+  (void) cc_heap_remove(this->heap, entry);
+  this->freeEntry(entry);
+  return TRUE;
+}
+
+SoSensor *
+SoSensorQueue::getFirst(void) const
+{
+  const Entry * entry = static_cast<const Entry *>(cc_heap_get_top(this->heap));
+  return entry ? entry->sensor : NULL;
+}
+
+SoSensor *
+SoSensorQueue::extractFirst(void)
+{
+  Entry * entry = static_cast<Entry *>(cc_heap_extract_top(this->heap));
+  if (entry == NULL) return NULL;
+  SoSensor * sensor = entry->sensor;
+  this->freeEntry(entry);
+  return sensor;
+}
+
+void
+SoSensorQueue::freeEntry(Entry * entry)
+{
+  (void) this->entries.erase(entry->sensor);
+  this->freelist.push(entry);
+}
+
+// *************************************************************************
+
 class SoSensorManagerP {
 public:
   SoSensorManagerP(void) : alive(ALIVE_PATTERN) { }
@@ -143,12 +255,12 @@ public:
   SbBool processingimmediatequeue;
 
   // immediatequeue - stores SoDelayQueueSensors with priority 0. FIFO.
-  // delayqueue   - stores SoDelayQueueSensor's in sorted order.
-  // timerqueue - stores SoTimerSensors in sorted order.
+  // delayqueue   - stores SoDelayQueueSensor's ordered on priority.
+  // timerqueue - stores SoTimerSensors ordered on trigger time.
 
-  SbList <SoDelayQueueSensor *> immediatequeue;
-  SbList <SoDelayQueueSensor *> delayqueue;
-  SbList <SoTimerQueueSensor *> timerqueue;
+  SoSensorQueue immediatequeue;
+  SoSensorQueue delayqueue;
+  SoSensorQueue timerqueue;
   SbList <SoTimerSensor*> reschedulelist;
 
   // FIXME: from what I can see, the two dicts below are simply used
@@ -297,7 +409,7 @@ SoSensorManager::insertDelaySensor(SoDelayQueueSensor * newentry)
   // strategy.
   if (newentry->getPriority() == 0) {
     LOCK_IMMEDIATE_QUEUE(this);
-    PRIVATE(this)->immediatequeue.append(newentry);
+    PRIVATE(this)->immediatequeue.insert(newentry, 0.0);
     UNLOCK_IMMEDIATE_QUEUE(this);
   }
   else {
@@ -308,17 +420,8 @@ SoSensorManager::insertDelaySensor(SoDelayQueueSensor * newentry)
     }
 
     LOCK_DELAY_QUEUE(this);
-    SbList <SoDelayQueueSensor *> & delayqueue = PRIVATE(this)->delayqueue;
-
-    // <= in test since the sensors should be processed FIFO for
-    // sensors with equal priority
-    uint32_t newsensorpriority = newentry->getPriority();
-    int pos = 0;
-    while((pos < delayqueue.getLength()) &&
-          (delayqueue[pos]->getPriority() <= newsensorpriority)) {
-      pos++;
-    }
-    delayqueue.insert(newentry, pos);
+    // the queue keeps sensors with equal priority FIFO
+    PRIVATE(this)->delayqueue.insert(newentry, newentry->getPriority());
     UNLOCK_DELAY_QUEUE(this);
     this->notifyChanged();
   }
@@ -346,20 +449,9 @@ SoSensorManager::insertTimerSensor(SoTimerQueueSensor * newentry)
   SoSensorManagerP::assertAlive(PRIVATE(this));
   assert(newentry);
 
-  SbList <SoTimerQueueSensor *> & timerqueue = PRIVATE(this)->timerqueue;
-
   LOCK_TIMER_QUEUE(this);
-  int i = 0;
-
-  // <= in test since the sensors should be processed FIFO for sensors
-  // with the same trigger time
-  double newtime = newentry->getTriggerTime().getValue();
-  while ((i < timerqueue.getLength()) &&
-         (timerqueue[i]->getTriggerTime().getValue() <= newtime)) {
-    i++;
-  }
-  timerqueue.insert(newentry, i);
-
+  // the queue keeps sensors with the same trigger time FIFO
+  PRIVATE(this)->timerqueue.insert(newentry, newentry->getTriggerTime().getValue());
   UNLOCK_TIMER_QUEUE(this);
 
 #if DEBUG_TIMER_SENSORHANDLING || 0 // debug
@@ -390,28 +482,24 @@ SoSensorManager::removeDelaySensor(SoDelayQueueSensor * entry)
 
   LOCK_DELAY_QUEUE(this);
   // Check "real" queue first..
-  int idx = PRIVATE(this)->delayqueue.find(entry);
-  if (idx != -1) PRIVATE(this)->delayqueue.remove(idx);
+  SbBool found = PRIVATE(this)->delayqueue.remove(entry);
   UNLOCK_DELAY_QUEUE(this);
 
   // ..then the immediate queue.
-  if (idx == -1) {
+  if (!found) {
     LOCK_IMMEDIATE_QUEUE(this);
-    idx = PRIVATE(this)->immediatequeue.find(entry);
-    if (idx != -1) PRIVATE(this)->immediatequeue.remove(idx);
+    found = PRIVATE(this)->immediatequeue.remove(entry);
     UNLOCK_IMMEDIATE_QUEUE(this);
   }
   // ..then the reinsert list
-  if (idx == -1) {
-    if (PRIVATE(this)->reinsertdict.erase(entry)) {
-      idx = 0; // make sure notifyChanged() is called.
-    }
+  if (!found) {
+    found = PRIVATE(this)->reinsertdict.erase(entry) != 0;
   }
 
-  if (idx != -1) this->notifyChanged();
+  if (found) this->notifyChanged();
 
 #if COIN_DEBUG
-  if (idx == -1) {
+  if (!found) {
     SoDebugError::postWarning("SoSensorManager::removeDelaySensor",
                               "trying to remove element not in list");
   }
@@ -427,9 +515,7 @@ SoSensorManager::removeTimerSensor(SoTimerQueueSensor * entry)
   SoSensorManagerP::assertAlive(PRIVATE(this));
 
   LOCK_TIMER_QUEUE(this);
-  int idx = PRIVATE(this)->timerqueue.find(entry);
-  if (idx != -1) {
-    PRIVATE(this)->timerqueue.remove(idx);
+  if (PRIVATE(this)->timerqueue.remove(entry)) {
     UNLOCK_TIMER_QUEUE(this);
     this->notifyChanged();
   }
@@ -482,14 +568,13 @@ SoSensorManager::processTimerQueue(void)
 
   SbTime currenttime = SbTime::getTimeOfDay();
   while (PRIVATE(this)->timerqueue.getLength() > 0 &&
-         PRIVATE(this)->timerqueue[0]->getTriggerTime() <= currenttime) {
+         static_cast<SoTimerQueueSensor *>(PRIVATE(this)->timerqueue.getFirst())->getTriggerTime() <= currenttime) {
 #if DEBUG_TIMER_SENSORHANDLING // debug
     SoDebugError::postInfo("SoSensorManager::processTimerQueue",
                            "process element with triggertime %s",
-                           PRIVATE(this)->timerqueue[0]->getTriggerTime().format().getString());
+                           static_cast<SoTimerQueueSensor *>(PRIVATE(this)->timerqueue.getFirst())->getTriggerTime().format().getString());
 #endif // debug
-    SoSensor * sensor = PRIVATE(this)->timerqueue[0];
-    PRIVATE(this)->timerqueue.remove(0);
+    SoSensor * sensor = PRIVATE(this)->timerqueue.extractFirst();
     UNLOCK_TIMER_QUEUE(this);
     sensor->trigger();
     LOCK_TIMER_QUEUE(this);
@@ -591,11 +676,11 @@ SoSensorManager::processDelayQueue(SbBool isidle)
 #if DEBUG_DELAY_SENSORHANDLING // debug
     SoDebugError::postInfo("SoSensorManager::processDelayQueue",
                            "treat element with pri %d",
-                           PRIVATE(this)->delayqueue[0]->getPriority());
+                           static_cast<SoDelayQueueSensor *>(PRIVATE(this)->delayqueue.getFirst())->getPriority());
 #endif // debug
 
-    SoDelayQueueSensor * sensor = PRIVATE(this)->delayqueue[0];
-    PRIVATE(this)->delayqueue.remove(0);
+    SoDelayQueueSensor * sensor =
+      static_cast<SoDelayQueueSensor *>(PRIVATE(this)->delayqueue.extractFirst());
     UNLOCK_DELAY_QUEUE(this);
 
     if (!isidle && sensor->isIdleOnly()) {
@@ -695,8 +780,7 @@ SoSensorManager::processImmediateQueue(void)
     SoDebugError::postInfo("SoSensorManager::processImmediateQueue",
                            "trigger element");
 #endif // debug
-    SoSensor * sensor = PRIVATE(this)->immediatequeue[0];
-    PRIVATE(this)->immediatequeue.remove(0);
+    SoSensor * sensor = PRIVATE(this)->immediatequeue.extractFirst();
     UNLOCK_IMMEDIATE_QUEUE(this);
 
     sensor->trigger();
@@ -776,7 +860,7 @@ SoSensorManager::isTimerSensorPending(SbTime & tm)
 
   LOCK_TIMER_QUEUE(this);
   if (PRIVATE(this)->timerqueue.getLength() > 0) {
-    tm = PRIVATE(this)->timerqueue[0]->getTriggerTime();
+    tm = static_cast<SoTimerQueueSensor *>(PRIVATE(this)->timerqueue.getFirst())->getTriggerTime();
     UNLOCK_TIMER_QUEUE(this);
     return TRUE;
   }
@@ -902,6 +986,68 @@ SoSensorManager::mergeDelayQueues(void)
   return 0;
 }
 
+#ifdef COIN_TEST_SUITE
+#include <Inventor/SoDB.h>
+#include <Inventor/SbString.h>
+#include <Inventor/sensors/SoOneShotSensor.h>
+#include <Inventor/sensors/SoAlarmSensor.h>
+
+namespace {
+struct sensor_record {
+  SbString * order;
+  int id;
+};
+}
+
+static void
+record_sensor_cb(void * data, SoSensor *)
+{
+  sensor_record * record = static_cast<sensor_record *>(data);
+  SbString id;
+  id.sprintf("%d ", record->id);
+  *record->order += id;
+}
+
+BOOST_AUTO_TEST_CASE(fifoWithinPriority)
+{
+  SoSensorManager * sm = SoDB::getSensorManager();
+  SbString order;
+  sensor_record records[6];
+  SoOneShotSensor * sensors[6];
+  const uint32_t priorities[6] = { 30, 10, 20, 10, 30, 10 };
+  for (int i = 0; i < 6; i++) {
+    records[i].order = &order;
+    records[i].id = i;
+    sensors[i] = new SoOneShotSensor(record_sensor_cb, &records[i]);
+    sensors[i]->setPriority(priorities[i]);
+    sensors[i]->schedule();
+  }
+  // removal from the middle of the queue
+  sensors[3]->unschedule();
+  sm->processDelayQueue(TRUE);
+  BOOST_CHECK_MESSAGE(order == "1 5 2 0 4 ",
+                      std::string("unexpected delay queue order: ") + order.getString());
+
+  order = "";
+  const SbTime now = SbTime::getTimeOfDay();
+  SoAlarmSensor * alarms[6];
+  for (int i = 0; i < 6; i++) {
+    alarms[i] = new SoAlarmSensor(record_sensor_cb, &records[i]);
+    alarms[i]->setTime(now - SbTime(1.0 + (i % 2)));
+    alarms[i]->schedule();
+  }
+  alarms[2]->unschedule();
+  sm->processTimerQueue();
+  BOOST_CHECK_MESSAGE(order == "1 3 5 0 4 ",
+                      std::string("unexpected timer queue order: ") + order.getString());
+
+  for (int i = 0; i < 6; i++) {
+    delete sensors[i];
+    delete alarms[i];
+  }
+}
+
+#endif // COIN_TEST_SUITE
 
 #undef DEBUG_DELAY_SENSORHANDLING
 #undef DEBUG_TIMER_SENSORHANDLING
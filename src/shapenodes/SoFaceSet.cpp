@@ -91,6 +91,7 @@
 #include <Inventor/bundles/SoTextureCoordinateBundle.h>
 #include <Inventor/details/SoFaceDetail.h>
 #include <Inventor/actions/SoGetPrimitiveCountAction.h>
+#include <Inventor/actions/SoRayPickAction.h>
 #include <Inventor/caches/SoConvexDataCache.h>
 #include <Inventor/elements/SoCacheElement.h>
 #include <Inventor/elements/SoModelMatrixElement.h>
@@ -104,6 +105,7 @@
 #include "nodes/SoSubNodeP.h"
 #include "rendering/SoVBO.h"
 #include "rendering/SoGL.h"
+#include "shapenodes/soshape_bvhpick.h"
 
 // *************************************************************************
 
@@ -748,6 +750,14 @@ SoFaceSet::generateDefaultNormals(SoState * /* state */,
   return FALSE;
 }
 
+// doc from parent
+void
+SoFaceSet::rayPick(SoRayPickAction * action)
+{
+  // large meshes are picked using a hierarchy of the triangles
+  this->rayPickBVH(action);
+}
+
 // doc from parent
 void
 SoFaceSet::getPrimitiveCount(SoGetPrimitiveCountAction *action)
@@ -835,7 +845,28 @@ SoFaceSet::generatePrimitives(SoAction *action)
   vertex.setDetail(&pointDetail);
   vertex.setNormal(*currnormal);
 
+  // support for generating only the face hit by a ray (see
+  // SoShape::rayPickBVH())
+  const int32_t * start = ptr;
+  const SbBool addrestartpoints = soshape_bvhpick::isRecording();
+  const int32_t * restart = soshape_bvhpick::getRestartPoint();
+  if (restart) {
+    ptr = start + restart[0];
+    idx = restart[1];
+    matnr = restart[2];
+    texnr = restart[3];
+    normnr = restart[4];
+    faceDetail.setFaceIndex(restart[5]);
+  }
+
   while (ptr < end) {
+    if (addrestartpoints) {
+      const int32_t data[] = {
+        (int32_t) (ptr - start), idx, matnr, texnr, normnr,
+        faceDetail.getFaceIndex()
+      };
+      soshape_bvhpick::addRestartPoint(data, sizeof(data) / sizeof(data[0]));
+    }
     n = *ptr++;
     if (n == 3) newmode = TRIANGLES;
     else if (n == 4) newmode = QUADS;
@@ -895,6 +926,7 @@ SoFaceSet::generatePrimitives(SoAction *action)
     }
     if (mode == POLYGON) this->endShape();
     faceDetail.incFaceIndex();
+    if (restart) break;
   }
   if (mode != POLYGON) this->endShape();
 
@@ -229,6 +229,7 @@
 #include "rendering/SoVertexArrayIndexer.h"
 #include "rendering/SoVBO.h"
 #include "rendering/SoGL.h"
+#include "shapenodes/soshape_bvhpick.h"
 
 // *************************************************************************
 
@@ -815,7 +816,37 @@ SoIndexedFaceSet::generatePrimitives(SoAction *action)
   int matnr = 0;
   int normnr = 0;
 
+  // support for generating only the face hit by a ray (see
+  // SoShape::rayPickBVH())
+  const int32_t * mstart = mindices;
+  const int32_t * nstart = nindices;
+  const int32_t * tstart = tindices;
+  const SbBool addrestartpoints = soshape_bvhpick::isRecording();
+  const int32_t * restart = soshape_bvhpick::getRestartPoint();
+  if (restart) {
+    viptr = cindices + restart[0];
+    if (mindices) mindices += restart[1];
+    if (nindices) nindices += restart[2];
+    if (tindices) tindices += restart[3];
+    matnr = restart[4];
+    normnr = restart[5];
+    texidx = restart[6];
+    faceDetail.setFaceIndex(restart[7]);
+    faceDetail.setPartIndex(restart[8]);
+  }
+
   while (viptr + 2 < viendptr) {
+    if (addrestartpoints) {
+      const int32_t data[] = {
+        (int32_t) (viptr - cindices),
+        (int32_t) (mindices ? mindices - mstart : 0),
+        (int32_t) (nindices ? nindices - nstart : 0),
+        (int32_t) (tindices ? tindices - tstart : 0),
+        matnr, normnr, texidx,
+        faceDetail.getFaceIndex(), faceDetail.getPartIndex()
+      };
+      soshape_bvhpick::addRestartPoint(data, sizeof(data) / sizeof(data[0]));
+    }
     v1 = *viptr++;
     v2 = *viptr++;
     v3 = *viptr++;
@@ -898,6 +929,7 @@ SoIndexedFaceSet::generatePrimitives(SoAction *action)
       nindices++;
     }
     if (tindices) tindices++;
+    if (restart) break;
   }
   if (mode != POLYGON) this->endShape();
 
@@ -915,6 +947,14 @@ SoIndexedFaceSet::generatePrimitives(SoAction *action)
 
 #undef DO_VERTEX
 
+// doc from parent
+void
+SoIndexedFaceSet::rayPick(SoRayPickAction * action)
+{
+  // large meshes are picked using a hierarchy of the triangles
+  this->rayPickBVH(action);
+}
+
 // doc from parent
 void
 SoIndexedFaceSet::getPrimitiveCount(SoGetPrimitiveCountAction *action)
@@ -1137,3 +1177,90 @@ SoIndexedFaceSet::generateDefaultNormals(SoState * state,
 #undef STATUS_CONCAVE
 #undef LOCK_VAINDEXER
 #undef UNLOCK_VAINDEXER
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoPickedPoint.h>
+#include <Inventor/actions/SoRayPickAction.h>
+#include <Inventor/details/SoFaceDetail.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+// a grid of quads in the z=0 plane, large enough to get a triangle
+// hierarchy when picked
+static SoSeparator *
+ifs_create_grid(SoCoordinate3 *& coords, const int size)
+{
+  SoSeparator * root = new SoSeparator;
+  coords = new SoCoordinate3;
+  SoIndexedFaceSet * ifs = new SoIndexedFaceSet;
+  root->addChild(coords);
+  root->addChild(ifs);
+
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      coords->point.set1Value(y*(size+1)+x, SbVec3f(float(x), float(y), 0.0f));
+    }
+  }
+  int idx = 0;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v = y*(size+1)+x;
+      ifs->coordIndex.set1Value(idx++, v);
+      ifs->coordIndex.set1Value(idx++, v+1);
+      ifs->coordIndex.set1Value(idx++, v+size+2);
+      ifs->coordIndex.set1Value(idx++, v+size+1);
+      ifs->coordIndex.set1Value(idx++, -1);
+    }
+  }
+  return root;
+}
+
+static SbBool
+ifs_pick(SoNode * root, const SbVec3f & start, SbVec3f & point, int & face)
+{
+  SoRayPickAction rp(SbViewportRegion(100, 100));
+  rp.setRay(start, SbVec3f(0.0f, 0.0f, -1.0f));
+  rp.apply(root);
+  const SoPickedPoint * pp = rp.getPickedPoint();
+  if (!pp) return FALSE;
+  point = pp->getPoint();
+  const SoFaceDetail * detail = (const SoFaceDetail *) pp->getDetail();
+  face = detail ? detail->getFaceIndex() : -1;
+  return TRUE;
+}
+
+BOOST_AUTO_TEST_CASE(rayPickBVH)
+{
+  SoCoordinate3 * coords;
+  SoSeparator * root = ifs_create_grid(coords, 40);
+  root->ref();
+
+  const SbVec3f start(12.25f, 30.5f, 10.0f);
+  SbVec3f p0, p1;
+  int f0, f1;
+
+  // the first pick creates the hierarchy, the second one uses it
+  BOOST_CHECK(ifs_pick(root, start, p0, f0));
+  BOOST_CHECK(ifs_pick(root, start, p1, f1));
+  BOOST_CHECK_EQUAL(f0, 30*40+12);
+  BOOST_CHECK_EQUAL(f0, f1);
+  BOOST_CHECK(p0 == p1);
+
+  BOOST_CHECK(!ifs_pick(root, SbVec3f(50.0f, 50.0f, 10.0f), p1, f1));
+
+  // the hierarchy must be rebuilt when the coordinates change
+  coords->point.set1Value(30*41+12, SbVec3f(12.0f, 30.0f, 1.0f));
+  coords->point.set1Value(30*41+13, SbVec3f(13.0f, 30.0f, 1.0f));
+  coords->point.set1Value(31*41+12, SbVec3f(12.0f, 31.0f, 1.0f));
+  coords->point.set1Value(31*41+13, SbVec3f(13.0f, 31.0f, 1.0f));
+  BOOST_CHECK(ifs_pick(root, start, p0, f0));
+  BOOST_CHECK(ifs_pick(root, start, p1, f1));
+  BOOST_CHECK_EQUAL(f1, 30*40+12);
+  BOOST_CHECK(p1 == SbVec3f(12.25f, 30.5f, 1.0f));
+
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
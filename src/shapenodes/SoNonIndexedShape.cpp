@@ -47,6 +47,7 @@
 #include <Inventor/elements/SoCoordinateElement.h>
 
 #include "nodes/SoSubNodeP.h"
+#include "base/SbVec3fBatch.h"
 
 /*!  
   \var SoSFInt32 SoNonIndexedShape::startIndex 
@@ -131,9 +132,12 @@ SoNonIndexedShape::computeCoordBBox(SoAction * action, int numVertices,
       vp->vertex.getValues(0) :
       coordelem->getArrayPtr3();
     
-    for (int i = startidx; i <= lastidx; i++) {
-      box.extendBy(coords[i]);
-      center += coords[i];
+    // getBounds() leaves min and max untouched for zero vertices
+    if (lastidx >= startidx) {
+      SbVec3f min, max;
+      SbVec3fBatch::getBounds(coords + startidx, lastidx + 1 - startidx,
+                              min, max, &center);
+      box.extendBy(SbBox3f(min, max));
     }
   }
   else { // 4D
@@ -182,3 +186,40 @@ SoNonIndexedShape::fixNumVerticesPointers(SoState *state, const int32_t *&start,
     end = numCoords > 1 ? start + 1 : start;
   }
 }
+
+#ifdef COIN_TEST_SUITE
+
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoPointSet.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+BOOST_AUTO_TEST_CASE(noVerticesBBox)
+{
+  const SbVec3f points[3] = {
+    SbVec3f(1.0f, 2.0f, 3.0f), SbVec3f(4.0f, 5.0f, 6.0f), SbVec3f(7.0f, 8.0f, 9.0f)
+  };
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoCoordinate3 * coords = new SoCoordinate3;
+  coords->point.setValues(0, 3, points);
+  SoPointSet * pointset = new SoPointSet;
+  pointset->numPoints = 0;
+  root->addChild(coords);
+  root->addChild(pointset);
+
+  SoGetBoundingBoxAction action(SbViewportRegion(100, 100));
+  action.apply(root);
+  BOOST_CHECK_MESSAGE(action.getBoundingBox().isEmpty(),
+                      "a shape with no vertices should have an empty bounding box");
+
+  pointset->numPoints = 2;
+  action.apply(root);
+  BOOST_CHECK_MESSAGE(action.getBoundingBox().getMin() == points[0] &&
+                      action.getBoundingBox().getMax() == points[1],
+                      "wrong bounding box for two points");
+  root->unref();
+}
+
+#endif // COIN_TEST_SUITE
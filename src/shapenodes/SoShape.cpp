@@ -120,6 +120,8 @@
 #include "threads/threadsutilp.h"
 #include "tidbitsp.h"
 #include "rendering/SoVBO.h"
+#include "rendering/SoGLRenderQueue.h"
+#include "caches/SoTriangleBVHCache.h"
 #include "coindefs.h" // COIN_OBSOLETED()
 
 // SoShape.cpp grew too big, so I had to move some code into new
@@ -128,6 +130,7 @@
 #include "soshape_trianglesort.h"
 #include "soshape_bigtexture.h"
 #include "soshape_bumprender.h"
+#include "soshape_bvhpick.h"
 
 // *************************************************************************
 
@@ -175,6 +178,7 @@ public:
   SoShapeP() {
     this->bboxcache = NULL;
     this->pvcache = NULL;
+    this->bvhcache = NULL;
     this->bumprender = NULL;
     this->rendercnt = 0;
     this->flags = 0;
@@ -182,6 +186,7 @@ public:
   ~SoShapeP() {
     if (this->bboxcache) { this->bboxcache->unref(); }
     if (this->pvcache) { this->pvcache->unref(); }
+    if (this->bvhcache) { this->bvhcache->unref(); }
     delete this->bumprender;
   }
   enum {
@@ -198,6 +203,7 @@ public:
   static double bboxcachetimelimit;
   SoBoundingBoxCache * bboxcache;
   SoPrimitiveVertexCache * pvcache;
+  SoTriangleBVHCache * bvhcache;
   soshape_bumprender * bumprender;
   uint32_t flags : FLAG_BITS;
   // stores the number of frames rendered with no node changes
@@ -278,6 +284,17 @@ typedef struct {
   SoMaterialBundle * currentbundle;
 
   int rendermode;
+
+  // used in generatePrimitives() callbacks when ray picking with a
+  // triangle hierarchy. While creating the cache, all triangles are
+  // added to bvhcache. When the cache is valid, only the triangles
+  // in pickfilter (sorted indices) are tested. restartpoint is set
+  // when only the face starting at the restart point is needed.
+  SoTriangleBVHCache * bvhcache;
+  const SbList <int> * pickfilter;
+  int pickfilterpos;
+  int pickcounter;
+  const int32_t * restartpoint;
 } soshape_staticdata;
 
 static soshape_bigtexture *
@@ -304,6 +321,11 @@ soshape_construct_staticdata(void * closure)
   data->primdata = new soshape_primdata();
   data->trianglesort = new soshape_trianglesort();
   data->rendermode = NORMAL;
+  data->bvhcache = NULL;
+  data->pickfilter = NULL;
+  data->pickfilterpos = 0;
+  data->pickcounter = 0;
+  data->restartpoint = NULL;
 }
 
 static void
@@ -438,6 +460,22 @@ SoShape::callback(SoCallbackAction * action)
 }
 
 // test bbox intersection
+// Returns TRUE if OpenGL generates the texture coordinates for any
+// of the enabled texture units.
+static SbBool
+soshape_has_texgen(SoState * state)
+{
+  int lastenabled = -1;
+  const SbBool * enabled =
+    SoMultiTextureEnabledElement::getEnabledUnits(state, lastenabled);
+  for (int i = 0; i <= lastenabled; i++) {
+    if (enabled[i] &&
+        SoMultiTextureCoordinateElement::getType(state, i) ==
+        SoMultiTextureCoordinateElement::TEXGEN) return TRUE;
+  }
+  return FALSE;
+}
+
 static SbBool
 soshape_ray_intersect(SoRayPickAction * action, const SbBox3f & box)
 {
@@ -463,6 +501,146 @@ SoShape::rayPick(SoRayPickAction * action)
   }
 }
 
+namespace {
+
+typedef struct {
+  SoRayPickAction * action;
+  const SbTriangleBVH * bvh;
+  SbList <int> * hits;
+} soshape_bvhpick_data;
+
+} // anonymous namespace
+
+static void
+soshape_bvhpick_cb(void * closure, const int triangle)
+{
+  soshape_bvhpick_data * data = (soshape_bvhpick_data*) closure;
+  SbVec3f v0, v1, v2, intersection, barycentric;
+  SbBool front;
+  data->bvh->getTriangle(triangle, v0, v1, v2);
+  if (data->action->intersect(v0, v1, v2, intersection, barycentric, front) &&
+      data->action->isBetweenPlanes(intersection)) {
+    data->hits->append(triangle);
+  }
+}
+
+static int
+soshape_int_compare(const void * a, const void * b)
+{
+  return *((const int*) a) - *((const int*) b);
+}
+
+/*!
+  Calculates picked point based on primitives generated by
+  subclasses, like rayPick(), but uses a bounding volume hierarchy
+  of the shape's triangles to find the triangles hit by the ray.
+
+  The hierarchy is created the first time the shape is picked, and
+  is invalidated when the shape or any state it depends on
+  changes. When the ray hits the shape, generatePrimitives() is
+  called to create the picked points, but only the triangles found to
+  be intersected are tested. The picked points will therefore be
+  identical to the ones found by rayPick(). Coin's built-in face set
+  nodes store where each face starts when the hierarchy is created,
+  and will only generate the faces that were hit.
+
+  Shapes that only generate triangles can call this method from
+  rayPick() to make picking on large shapes faster. The hierarchy is
+  not used for shapes with few triangles (see the
+  COIN_RAYPICK_BVH_MIN_TRIANGLES environment variable).
+
+  \COIN_FUNCTION_EXTENSION
+
+  \since Coin 4.1
+*/
+void
+SoShape::rayPickBVH(SoRayPickAction * action)
+{
+  if (!this->shouldRayPick(action)) return;
+  this->computeObjectSpaceRay(action);
+
+  SoState * state = action->getState();
+  if (PRIVATE(this)->bboxcache &&
+      PRIVATE(this)->bboxcache->isValid(state) &&
+      !soshape_ray_intersect(action, PRIVATE(this)->bboxcache->getProjectedBox())) {
+    return;
+  }
+
+  soshape_staticdata * shapedata = soshape_get_staticdata();
+
+  PRIVATE(this)->lock();
+  SoTriangleBVHCache * cache = PRIVATE(this)->bvhcache;
+  if (cache && cache->isValid(state)) {
+    cache->ref();
+  }
+  else {
+    cache = NULL;
+  }
+  PRIVATE(this)->unlock();
+
+  if (cache == NULL) {
+    // pick the normal way, and record the triangles while doing it
+    state->push();
+    SbBool storedinvalid = SoCacheElement::setInvalid(FALSE);
+    cache = new SoTriangleBVHCache(state);
+    cache->ref();
+    SoCacheElement::set(state, cache);
+    shapedata->bvhcache = cache;
+    this->generatePrimitives(action);
+    shapedata->bvhcache = NULL;
+    state->pop();
+    SoCacheElement::setInvalid(storedinvalid);
+    cache->close();
+
+    PRIVATE(this)->lock();
+    if (PRIVATE(this)->bvhcache) PRIVATE(this)->bvhcache->unref();
+    PRIVATE(this)->bvhcache = cache;
+    PRIVATE(this)->unlock();
+    return;
+  }
+
+  if (!cache->hasHierarchy()) {
+    this->generatePrimitives(action);
+  }
+  else {
+    SbList <int> hits;
+    soshape_bvhpick_data data;
+    data.action = action;
+    data.bvh = &cache->getHierarchy();
+    data.hits = &hits;
+    data.bvh->findTriangles(action->getLine(), soshape_bvhpick_cb, &data);
+
+    if (hits.getLength()) {
+      // the hierarchy is searched in node order, the filter needs
+      // the triangles in the order they are generated
+      qsort((void*) hits.getArrayPtr(), hits.getLength(), sizeof(int),
+            soshape_int_compare);
+      shapedata->pickfilter = &hits;
+      shapedata->pickfilterpos = 0;
+      shapedata->pickcounter = 0;
+
+      SbBool generated = FALSE;
+      if (cache->getNumRestartPoints() &&
+          cache->findRestartPoint(hits[0]) >= 0) {
+        int prev = -1;
+        for (int i = 0; i < hits.getLength(); i++) {
+          const int rp = cache->findRestartPoint(hits[i]);
+          if (rp == prev) continue;
+          prev = rp;
+          shapedata->pickcounter = cache->getRestartPointTriangle(rp);
+          shapedata->restartpoint = cache->getRestartPointData(rp);
+          this->generatePrimitives(action);
+        }
+        shapedata->restartpoint = NULL;
+        generated = TRUE;
+      }
+      if (!generated) this->generatePrimitives(action);
+      shapedata->pickfilter = NULL;
+    }
+  }
+  cache->unref();
+}
+
 /*!
   A convenience function that returns the size of a \a boundingbox
   projected onto the screen. Useful for \c SCREEN_SPACE complexity
@@ -567,6 +745,30 @@ SoShape::shouldGLRender(SoGLRenderAction * action)
   if (shapestyleflags & SoShapeStyleElement::INVISIBLE)
     return FALSE;
 
+  // in retained mode, or below an instanced SoMultipleCopy or SoArray,
+  // record the shape for drawing it in later frames
+  SoGLRenderQueue * renderqueue = SoGLRenderQueue::getRecording(state);
+  if (renderqueue) {
+    if (SoGLRenderQueue::canQueue(state, this)) {
+      PRIVATE(this)->lock();
+      this->validatePVCache(action);
+      SoPrimitiveVertexCache * pvcache = PRIVATE(this)->pvcache;
+      pvcache->ref();
+      PRIVATE(this)->unlock();
+
+      SoMaterialBundle mb(action);
+      mb.sendFirst();
+      PRIVATE(this)->setupShapeHints(this, state);
+      const SbBool queued = renderqueue->addShape(state, pvcache);
+      if (queued) {
+        pvcache->renderTriangles(state, SoPrimitiveVertexCache::NORMAL|SoPrimitiveVertexCache::COLOR);
+      }
+      pvcache->unref();
+      if (queued) return FALSE;
+    }
+    renderqueue->setUnqueueable();
+  }
+
   if (PRIVATE(this)->bboxcache && !state->isCacheOpen() && !SoCullElement::completelyInside(state)) {
     if (PRIVATE(this)->bboxcache->isValid(state)) {
       if (SoCullElement::cullTest(state, PRIVATE(this)->bboxcache->getProjectedBox())) {
@@ -994,6 +1196,24 @@ SoShape::invokeTriangleCallbacks(SoAction * const action,
   if (action->getTypeId().isDerivedFrom(SoRayPickAction::getClassTypeId())) {
     SoRayPickAction * ra = (SoRayPickAction *) action;
 
+    soshape_staticdata * shapedata = soshape_get_staticdata();
+    if (shapedata->bvhcache) {
+      shapedata->bvhcache->addTriangle(v1->getPoint(), v2->getPoint(), v3->getPoint());
+    }
+    else if (shapedata->pickfilter) {
+      // skip triangles which the hierarchy search found not to be hit
+      const SbList <int> & filter = *shapedata->pickfilter;
+      const int idx = shapedata->pickcounter++;
+      const int len = filter.getLength();
+      while (shapedata->pickfilterpos < len &&
+             filter[shapedata->pickfilterpos] < idx) {
+        shapedata->pickfilterpos++;
+      }
+      if (shapedata->pickfilterpos >= len ||
+          filter[shapedata->pickfilterpos] != idx) return;
+      shapedata->pickfilterpos++;
+    }
+
     SbVec3f intersection;
     SbVec3f barycentric;
     SbBool front;
@@ -1433,6 +1653,9 @@ SoShape::notify(SoNotList * nl)
   if (PRIVATE(this)->pvcache) {
     PRIVATE(this)->pvcache->invalidate();
   }
+  if (PRIVATE(this)->bvhcache) {
+    PRIVATE(this)->bvhcache->invalidate();
+  }
   PRIVATE(this)->flags &= ~SoShapeP::SHOULD_BBOX_CACHE;
   PRIVATE(this)->rendercnt = 0;
   PRIVATE(this)->unlock();
@@ -1775,6 +1998,12 @@ SoShape::validatePVCache(SoGLRenderAction * action)
     PRIVATE(this)->pvcache = new SoPrimitiveVertexCache(state);
     PRIVATE(this)->pvcache->ref();
     SoCacheElement::set(state, PRIVATE(this)->pvcache);
+    // bump mapping works on the full precision arrays, and texture
+    // coordinates generated by OpenGL from the object coordinates
+    // would come out wrong from the scaled compact coordinates
+    if (PRIVATE(this)->bumprender || soshape_has_texgen(state)) {
+      PRIVATE(this)->pvcache->setLayout(SoPrimitiveVertexCache::FULL_PRECISION);
+    }
     shapedata->rendermode = PVCACHE;
     this->generatePrimitives(action);
     shapedata->rendermode = NORMAL;
@@ -1793,4 +2022,48 @@ SoShape::validatePVCache(SoGLRenderAction * action)
 }
 
 
+// *************************************************************************
+
+/*!
+  \class soshape_bvhpick soshape_bvhpick.h
+  \brief The soshape_bvhpick class lets shapes generate single faces when ray picking.
+
+  See SoShape::rayPickBVH().
+
+  \internal
+*/
+
+/*!
+  Returns \c TRUE if the triangle hierarchy is being created, and
+  restart points should be added.
+*/
+SbBool
+soshape_bvhpick::isRecording(void)
+{
+  return soshape_get_staticdata()->bvhcache != NULL;
+}
+
+/*!
+  Adds a restart point. Should be called before generating the
+  first vertex of a face. \a data should contain everything needed
+  to continue generating primitives from this face.
+*/
+void
+soshape_bvhpick::addRestartPoint(const int32_t * data, const int num)
+{
+  soshape_staticdata * shapedata = soshape_get_staticdata();
+  assert(shapedata->bvhcache);
+  shapedata->bvhcache->addRestartPoint(data, num);
+}
+
+/*!
+  Returns the restart point data if only the face starting at this
+  restart point should be generated, \c NULL otherwise.
+*/
+const int32_t *
+soshape_bvhpick::getRestartPoint(void)
+{
+  return soshape_get_staticdata()->restartpoint;
+}
+
 #undef PRIVATE
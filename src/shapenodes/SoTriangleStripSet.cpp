@@ -123,6 +123,7 @@
 #include <Inventor/actions/SoGLRenderAction.h>
 #include <Inventor/system/gl.h>
 #include <Inventor/actions/SoGetPrimitiveCountAction.h>
+#include <Inventor/actions/SoRayPickAction.h>
 #include <Inventor/elements/SoGLLazyElement.h>
 #include <Inventor/elements/SoGLCoordinateElement.h>
 #include <Inventor/elements/SoNormalBindingElement.h>
@@ -138,6 +139,7 @@
 
 #include "nodes/SoSubNodeP.h"
 #include "rendering/SoGL.h"
+#include "shapenodes/soshape_bvhpick.h"
 
 /*!
   \var SoMFInt32 SoTriangleStripSet::numVertices
@@ -593,6 +595,14 @@ SoTriangleStripSet::generateDefaultNormals(SoState * state, SoNormalCache * nc)
   return TRUE;
 }
 
+// doc from parent
+void
+SoTriangleStripSet::rayPick(SoRayPickAction * action)
+{
+  // large meshes are picked using a hierarchy of the triangles
+  this->rayPickBVH(action);
+}
+
 // doc from parent
 void
 SoTriangleStripSet::getPrimitiveCount(SoGetPrimitiveCountAction *action)
@@ -686,7 +696,28 @@ SoTriangleStripSet::generatePrimitives(SoAction *action)
   vertex.setNormal(*currnormal);
   vertex.setDetail(&pointDetail);
 
+  // support for generating only the strip hit by a ray (see
+  // SoShape::rayPickBVH())
+  const int32_t * start = ptr;
+  const SbBool addrestartpoints = soshape_bvhpick::isRecording();
+  const int32_t * restart = soshape_bvhpick::getRestartPoint();
+  if (restart) {
+    ptr = start + restart[0];
+    idx = restart[1];
+    matnr = restart[2];
+    texnr = restart[3];
+    normnr = restart[4];
+    faceDetail.setPartIndex(restart[5]);
+  }
+
   while (ptr < end) {
+    if (addrestartpoints) {
+      const int32_t data[] = {
+        (int32_t) (ptr - start), idx, matnr, texnr, normnr,
+        faceDetail.getPartIndex()
+      };
+      soshape_bvhpick::addRestartPoint(data, sizeof(data) / sizeof(data[0]));
+    }
     n = *ptr++ - 3;
     if (n < 0) continue; // triangle with < 3 vertices, try next one
 
@@ -793,6 +824,7 @@ SoTriangleStripSet::generatePrimitives(SoAction *action)
     }
     this->endShape();
     faceDetail.incPartIndex();
+    if (restart) break;
   }
 
   if (nc) {
@@ -41,6 +41,50 @@
 #include <config.h>
 #endif /* HAVE_CONFIG_H */
 
+/* Atomic compare-and-swap of an int32_t. If *_ptr_ equals
+   _expected_, it is replaced with _desired_ and TRUE is returned.
+   Otherwise _expected_ is set to the value of *_ptr_ and FALSE is
+   returned. All accesses before a successful swap are done before it,
+   and all accesses after it are done after it. */
+
+#ifdef _MSC_VER
+#include <intrin.h>
+inline SbBool
+cc_atomic_compare_exchange(int32_t * ptr, int32_t & expected, const int32_t desired)
+{
+  const long old = _InterlockedCompareExchange(reinterpret_cast<volatile long *>(ptr),
+                                               desired, expected);
+  if (old == expected) return TRUE;
+  expected = old;
+  return FALSE;
+}
+#define CC_ATOMIC_COMPARE_EXCHANGE(_ptr_, _expected_, _desired_) \
+  cc_atomic_compare_exchange(_ptr_, _expected_, _desired_)
+#else /* ! _MSC_VER */
+#define CC_ATOMIC_COMPARE_EXCHANGE(_ptr_, _expected_, _desired_) \
+  (__atomic_compare_exchange_n(_ptr_, &(_expected_), _desired_, false, \
+                               __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ? TRUE : FALSE)
+#endif /* ! _MSC_VER */
+
+/* Loads and stores of a pointer variable shared between threads
+   without a lock. A thread which loads a pointer with
+   CC_ATOMIC_LOAD_ACQUIRE() sees everything written by the thread
+   which stored it with CC_ATOMIC_STORE_RELEASE() before the store. */
+
+#ifdef _MSC_VER
+/* volatile accesses have acquire and release semantics with MSVC's
+   default /volatile:ms on x86 and x64 */
+#define CC_ATOMIC_LOAD_ACQUIRE(_ptr_) \
+  (*static_cast<volatile const decltype(+*(_ptr_)) *>(_ptr_))
+#define CC_ATOMIC_STORE_RELEASE(_ptr_, _val_) \
+  (void)(*static_cast<volatile decltype(+*(_ptr_)) *>(_ptr_) = (_val_))
+#else /* ! _MSC_VER */
+#define CC_ATOMIC_LOAD_ACQUIRE(_ptr_) \
+  __atomic_load_n(_ptr_, __ATOMIC_ACQUIRE)
+#define CC_ATOMIC_STORE_RELEASE(_ptr_, _val_) \
+  __atomic_store_n(_ptr_, _val_, __ATOMIC_RELEASE)
+#endif /* ! _MSC_VER */
+
 #ifdef HAVE_THREADS
 
 #include <Inventor/C/threads/mutex.h>
@@ -876,6 +876,104 @@ coin_ntoh_double_bytes(const char * value)
   return val.d64;
 }
 
+/*
+  The array versions are used when reading and writing binary files,
+  where large arrays are common. On little-endian x86 CPUs, four
+  32-bit values are swapped at a time with SSE2, which is always
+  available on x86-64.
+*/
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define COIN_BSWAP_SSE2 1
+#include <emmintrin.h>
+
+/* swaps the bytes of each 32-bit value */
+static __m128i
+coin_bswap32_sse2(__m128i v)
+{
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+#endif /* __SSE2__ || _M_X64 */
+
+void
+coin_hton_uint32_array(const void * from, void * to, size_t num)
+{
+  const unsigned char * src = (const unsigned char *) from;
+  unsigned char * dst = (unsigned char *) to;
+  size_t i = 0;
+
+  switch (coin_host_get_endianness()) {
+  case COIN_HOST_IS_BIGENDIAN:
+    if (from != to) { memmove(to, from, num * sizeof(uint32_t)); }
+    return;
+  case COIN_HOST_IS_LITTLEENDIAN:
+    break;
+  default:
+    assert(0 && "system has unknown endianness");
+    return;
+  }
+
+#ifdef COIN_BSWAP_SSE2
+  for (; i + 4 <= num; i += 4) {
+    const __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 4));
+    _mm_storeu_si128((__m128i *) (dst + i * 4), coin_bswap32_sse2(v));
+  }
+#endif /* COIN_BSWAP_SSE2 */
+  for (; i < num; i++) {
+    uint32_t value;
+    memcpy(&value, src + i * 4, sizeof(uint32_t));
+    value = COIN_BSWAP_32(value);
+    memcpy(dst + i * 4, &value, sizeof(uint32_t));
+  }
+}
+
+void
+coin_ntoh_uint32_array(const void * from, void * to, size_t num)
+{
+  coin_hton_uint32_array(from, to, num);
+}
+
+void
+coin_hton_uint64_array(const void * from, void * to, size_t num)
+{
+  const unsigned char * src = (const unsigned char *) from;
+  unsigned char * dst = (unsigned char *) to;
+  size_t i = 0;
+
+  switch (coin_host_get_endianness()) {
+  case COIN_HOST_IS_BIGENDIAN:
+    if (from != to) { memmove(to, from, num * sizeof(uint64_t)); }
+    return;
+  case COIN_HOST_IS_LITTLEENDIAN:
+    break;
+  default:
+    assert(0 && "system has unknown endianness");
+    return;
+  }
+
+#ifdef COIN_BSWAP_SSE2
+  for (; i + 2 <= num; i += 2) {
+    const __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 8));
+    _mm_storeu_si128((__m128i *) (dst + i * 8),
+                     _mm_shuffle_epi32(coin_bswap32_sse2(v), _MM_SHUFFLE(2, 3, 0, 1)));
+  }
+#endif /* COIN_BSWAP_SSE2 */
+  for (; i < num; i++) {
+    uint64_t value;
+    memcpy(&value, src + i * 8, sizeof(uint64_t));
+    value = COIN_BSWAP_64(value);
+    memcpy(dst + i * 8, &value, sizeof(uint64_t));
+  }
+}
+
+void
+coin_ntoh_uint64_array(const void * from, void * to, size_t num)
+{
+  coin_hton_uint64_array(from, to, num);
+}
+
 /**************************************************************************/
 
 /*
@@ -1767,6 +1865,22 @@ coin_runtime_os(void)
 
 /**************************************************************************/
 
+int
+coin_num_processors(void)
+{
+  int num = 1;
+#if defined(HAVE_WINDOWS_H)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  num = (int) info.dwNumberOfProcessors;
+#elif defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  num = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return (num > 0) ? num : 1;
+}
+
+/**************************************************************************/
+
 /*
  * Will return TRUE if extra debugging information is enabled. These
  * are typically debugging messages extra for Coin and not found in
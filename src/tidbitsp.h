@@ -257,6 +257,16 @@ enum CoinOSType {
 
 int coin_runtime_os(void);
 
+/* number of processors available to the process, at least 1 */
+int coin_num_processors(void);
+
+/* convert arrays of num 32-bit or 64-bit values between host and
+   network byte order. from and to can be the same array. */
+void coin_hton_uint32_array(const void * from, void * to, size_t num);
+void coin_ntoh_uint32_array(const void * from, void * to, size_t num);
+void coin_hton_uint64_array(const void * from, void * to, size_t num);
+void coin_ntoh_uint64_array(const void * from, void * to, size_t num);
+
 #define COIN_MAC_FRAMEWORK_IDENTIFIER_CSTRING ("org.coin3d.Coin.framework")
 
 /* ********************************************************************** */
@@ -0,0 +1,130 @@
+/************************************************************************
+ *
+ * Compares transforming and bounding large arrays of points with the
+ * array versions of SbMatrix::multVecMatrix(), multDirMatrix() and
+ * SbBox3f::extendBy() against calling the single point versions in a
+ * loop.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o batch-benchmark batch-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: batch-benchmark [NUMPOINTS [NUMLOOPS]]
+ *
+ * Run with COIN_SIMD_KERNEL set to "sse2" or "scalar" to compare the
+ * different array kernels.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbBox3f.h>
+#include <Inventor/SbMatrix.h>
+#include <Inventor/SbRotation.h>
+#include <Inventor/SbTime.h>
+
+static void
+report(const char * what, const double single, const double array,
+       const int numpoints, const int numloops)
+{
+  const double n = double(numpoints) * numloops;
+  (void)fprintf(stdout, "%-14s single: %7.2f ns/point  array: %7.2f ns/point  (%.2fx)\n",
+                what, single * 1.0e9 / n, array * 1.0e9 / n, single / array);
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numpoints = argc > 1 ? atoi(argv[1]) : 1000000;
+  const int numloops = argc > 2 ? atoi(argv[2]) : 20;
+
+  SoDB::init();
+
+  std::vector<SbVec3f> points(numpoints), single(numpoints), array(numpoints);
+  srand(1);
+  for (int i = 0; i < numpoints; i++) {
+    points[i].setValue(float(rand() % 10000) * 0.01f,
+                       float(rand() % 10000) * 0.01f,
+                       float(rand() % 10000) * 0.01f);
+  }
+  SbMatrix matrix;
+  matrix.setTransform(SbVec3f(1.0f, 2.0f, 3.0f),
+                      SbRotation(SbVec3f(1.0f, 0.0f, 1.0f), 0.3f),
+                      SbVec3f(1.0f, 2.0f, 0.5f));
+
+  (void)fprintf(stdout, "%d points, %d loops\n", numpoints, numloops);
+  int errors = 0;
+  SbTime start;
+  double t1, t2;
+
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    for (int i = 0; i < numpoints; i++) { matrix.multVecMatrix(points[i], single[i]); }
+  }
+  t1 = (SbTime::getTimeOfDay() - start).getValue();
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    matrix.multVecMatrix(&points[0], &array[0], numpoints);
+  }
+  t2 = (SbTime::getTimeOfDay() - start).getValue();
+  report("multVecMatrix", t1, t2, numpoints, numloops);
+  if (single != array) errors++;
+
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    for (int i = 0; i < numpoints; i++) { matrix.multDirMatrix(points[i], single[i]); }
+  }
+  t1 = (SbTime::getTimeOfDay() - start).getValue();
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    matrix.multDirMatrix(&points[0], &array[0], numpoints);
+  }
+  t2 = (SbTime::getTimeOfDay() - start).getValue();
+  report("multDirMatrix", t1, t2, numpoints, numloops);
+  if (single != array) errors++;
+
+  SbBox3f singlebox, arraybox;
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    singlebox.makeEmpty();
+    for (int i = 0; i < numpoints; i++) { singlebox.extendBy(points[i]); }
+  }
+  t1 = (SbTime::getTimeOfDay() - start).getValue();
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    arraybox.makeEmpty();
+    arraybox.extendBy(&points[0], numpoints);
+  }
+  t2 = (SbTime::getTimeOfDay() - start).getValue();
+  report("extendBy", t1, t2, numpoints, numloops);
+  if (singlebox.getMin() != arraybox.getMin() ||
+      singlebox.getMax() != arraybox.getMax()) errors++;
+
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    singlebox.makeEmpty();
+    for (int i = 0; i < numpoints; i++) {
+      SbVec3f pt;
+      matrix.multVecMatrix(points[i], pt);
+      singlebox.extendBy(pt);
+    }
+  }
+  t1 = (SbTime::getTimeOfDay() - start).getValue();
+  start = SbTime::getTimeOfDay();
+  for (int l = 0; l < numloops; l++) {
+    arraybox.makeEmpty();
+    arraybox.extendBy(&points[0], numpoints, matrix);
+  }
+  t2 = (SbTime::getTimeOfDay() - start).getValue();
+  report("xf extendBy", t1, t2, numpoints, numloops);
+  if (singlebox.getMin() != arraybox.getMin() ||
+      singlebox.getMax() != arraybox.getMax()) errors++;
+
+  if (errors) {
+    (void)fprintf(stderr, "array results differ\n");
+    return 1;
+  }
+  return 0;
+}
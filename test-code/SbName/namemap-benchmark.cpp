@@ -0,0 +1,127 @@
+/************************************************************************
+ *
+ * Measures the SbName string table. Interns NUMNAMES unique names,
+ * like the DEF names of a huge scene, then looks all of them up
+ * again, first from a single thread and then from NUMTHREADS threads
+ * at the same time. The table statistics are printed when the
+ * library is cleaned up.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o namemap-benchmark namemap-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: namemap-benchmark [NUMNAMES [NUMTHREADS]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbName.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/C/tidbits.h>
+#include <Inventor/C/threads/thread.h>
+
+#define MAXTHREADS 256
+
+static int numnames = 0;
+
+/* Writes a name like "Node_1234_Transform" for index i into buf,
+   without going through printf, so the benchmark measures the name
+   table and not the formatting. */
+static void
+make_name(char * buf, int i)
+{
+  static const char * kinds[] = { "Transform", "Material", "Shape", "Group" };
+  char digits[16];
+  int n = 0;
+  int v = i;
+  do { digits[n++] = static_cast<char>('0' + v % 10); v /= 10; } while (v);
+  const char * p = "Node_";
+  while (*p) { *buf++ = *p++; }
+  while (n) { *buf++ = digits[--n]; }
+  *buf++ = '_';
+  p = kinds[i & 3];
+  while (*p) { *buf++ = *p++; }
+  *buf = '\0';
+}
+
+static int
+lookup_names(int first, int step)
+{
+  char buf[64];
+  int found = 0;
+  for (int i = first; i < numnames; i += step) {
+    make_name(buf, i);
+    SbName name(buf);
+    if (name.getLength() > 0) found++;
+  }
+  return found;
+}
+
+struct worker {
+  cc_thread * thread;
+  int index;
+  int numthreads;
+  int found;
+};
+
+static void *
+worker_cb(void * closure)
+{
+  worker * w = static_cast<worker *>(closure);
+  w->found = 0;
+  // every thread looks up all the names, starting at different places
+  for (int i = 0; i < w->numthreads; i++) {
+    w->found += lookup_names((w->index + i) % w->numthreads, w->numthreads);
+  }
+  return NULL;
+}
+
+int
+main(int argc, char ** argv)
+{
+  numnames = argc > 1 ? atoi(argv[1]) : 10000000;
+  int numthreads = argc > 2 ? atoi(argv[2]) : 8;
+  if (numthreads > MAXTHREADS) numthreads = MAXTHREADS;
+
+  (void)coin_setenv("COIN_DEBUG_NAMEMAP", "1", 0);
+  SoDB::init();
+
+  char buf[64];
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < numnames; i++) {
+    make_name(buf, i);
+    SbName name(buf);
+  }
+  double t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "interned %d names in %.2f s: %.1f ns/name\n",
+                numnames, t, t * 1.0e9 / numnames);
+
+  start = SbTime::getTimeOfDay();
+  int found = lookup_names(0, 1);
+  t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "looked up %d names in %.2f s: %.1f ns/name\n",
+                found, t, t * 1.0e9 / numnames);
+
+  static worker workers[MAXTHREADS];
+  start = SbTime::getTimeOfDay();
+  for (int i = 0; i < numthreads; i++) {
+    workers[i].index = i;
+    workers[i].numthreads = numthreads;
+    workers[i].thread = cc_thread_construct(worker_cb, &workers[i]);
+  }
+  found = 0;
+  for (int i = 0; i < numthreads; i++) {
+    (void)cc_thread_join(workers[i].thread, NULL);
+    cc_thread_destruct(workers[i].thread);
+    found += workers[i].found;
+  }
+  t = (SbTime::getTimeOfDay() - start).getValue();
+  const double lookups = static_cast<double>(numnames) * numthreads;
+  (void)fprintf(stdout, "%d threads looked up %d names in %.2f s: %.1f Mlookups/s\n",
+                numthreads, found, t, lookups / t / 1.0e6);
+
+  SoDB::finish();
+  return found == lookups ? 0 : 1;
+}
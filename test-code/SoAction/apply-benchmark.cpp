@@ -0,0 +1,80 @@
+/************************************************************************
+ *
+ * Measures the fixed cost of applying actions to tiny scene graphs,
+ * like the many short-lived pick and bounding box actions an
+ * application typically applies per frame. Each round constructs a
+ * fresh SoRayPickAction and SoGetBoundingBoxAction and applies them
+ * to a separator holding a transform and a cube, and then does the
+ * same with a single pair of actions that is applied over and over.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o apply-benchmark apply-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: apply-benchmark [ROUNDS]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/actions/SoRayPickAction.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTransform.h>
+
+static int
+apply_actions(SoGetBoundingBoxAction & bboxaction, SoRayPickAction & pickaction,
+              SoNode * root)
+{
+  int hits = 0;
+  bboxaction.apply(root);
+  if (!bboxaction.getBoundingBox().isEmpty()) hits++;
+  pickaction.apply(root);
+  if (pickaction.getPickedPoint()) hits++;
+  return hits;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int rounds = argc > 1 ? atoi(argv[1]) : 100000;
+
+  SoDB::init();
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoTransform * transform = new SoTransform;
+  transform->translation.setValue(0.0f, 0.0f, -5.0f);
+  root->addChild(transform);
+  root->addChild(new SoCube);
+
+  SbViewportRegion vp(100, 100);
+  int hits = 0;
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    SoGetBoundingBoxAction bboxaction(vp);
+    SoRayPickAction pickaction(vp);
+    pickaction.setRay(SbVec3f(0.0f, 0.0f, 0.0f), SbVec3f(0.0f, 0.0f, -1.0f));
+    hits += apply_actions(bboxaction, pickaction, root);
+  }
+  double t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "new actions:    %.2f us/round\n", t * 1.0e6 / rounds);
+
+  SoGetBoundingBoxAction bboxaction(vp);
+  SoRayPickAction pickaction(vp);
+  pickaction.setRay(SbVec3f(0.0f, 0.0f, 0.0f), SbVec3f(0.0f, 0.0f, -1.0f));
+  start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    hits += apply_actions(bboxaction, pickaction, root);
+  }
+  t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "reused actions: %.2f us/round\n", t * 1.0e6 / rounds);
+
+  root->unref();
+  return hits == 4 * rounds ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/************************************************************************
+ *
+ * Measures the per-node cost of traversing scene graphs. Builds a
+ * deep graph, a chain of groups nested DEPTH levels deep, and a wide
+ * graph, a separator with WIDTH children, both made from cheap nodes
+ * like SoInfo and SoTranslation so that the time is dominated by
+ * looking up and calling the action methods. Each graph is traversed
+ * ROUNDS times with SoCallbackAction and SoGLRenderAction, and the
+ * time per visited node is printed. SoGLRenderAction is skipped when
+ * DISPLAY is not set, as no offscreen context can be created then.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o dispatch-benchmark dispatch-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: dispatch-benchmark [DEPTH [WIDTH [ROUNDS]]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoOffscreenRenderer.h>
+#include <Inventor/actions/SoCallbackAction.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/nodes/SoGroup.h>
+#include <Inventor/nodes/SoInfo.h>
+#include <Inventor/nodes/SoLabel.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static SoNode *
+cheap_node(int i)
+{
+  switch (i % 3) {
+  case 0: return new SoInfo;
+  case 1: return new SoLabel;
+  default: return new SoTranslation;
+  }
+}
+
+// each level holds two cheap nodes and the next level
+static SoSeparator *
+build_deep(int depth)
+{
+  SoSeparator * root = new SoSeparator;
+  SoGroup * group = root;
+  for (int i = 0; i < depth; i++) {
+    SoGroup * child = new SoGroup;
+    group->addChild(cheap_node(i));
+    group->addChild(cheap_node(i + 1));
+    group->addChild(child);
+    group = child;
+  }
+  return root;
+}
+
+static SoSeparator *
+build_wide(int width)
+{
+  SoSeparator * root = new SoSeparator;
+  for (int i = 0; i < width; i++) {
+    root->addChild(cheap_node(i));
+  }
+  return root;
+}
+
+static int
+count_nodes(SoNode * node)
+{
+  int n = 1;
+  if (node->isOfType(SoGroup::getClassTypeId())) {
+    SoGroup * group = static_cast<SoGroup *>(node);
+    for (int i = 0; i < group->getNumChildren(); i++) {
+      n += count_nodes(group->getChild(i));
+    }
+  }
+  return n;
+}
+
+static void
+measure(const char * name, SoAction * action, SoNode * root, int rounds)
+{
+  action->apply(root); // warm up
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    action->apply(root);
+  }
+  const double t = (SbTime::getTimeOfDay() - start).getValue();
+  const double visited = static_cast<double>(count_nodes(root)) * rounds;
+  (void)fprintf(stdout, "  %-20s %10.2f ms %10.2f ns/node\n",
+                name, t * 1000.0 / rounds, t * 1.0e9 / visited);
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int depth = argc > 1 ? atoi(argv[1]) : 2000;
+  const int width = argc > 2 ? atoi(argv[2]) : 100000;
+  const int rounds = argc > 3 ? atoi(argv[3]) : 50;
+
+  SoDB::init();
+
+  SoSeparator * graphs[2];
+  graphs[0] = build_deep(depth);
+  graphs[1] = build_wide(width);
+  // render caches would skip the traversal
+  graphs[0]->renderCaching = SoSeparator::OFF;
+  graphs[1]->renderCaching = SoSeparator::OFF;
+  const char * names[2] = { "deep", "wide" };
+
+  SbViewportRegion viewport(64, 64);
+  SoOffscreenRenderer * renderer = new SoOffscreenRenderer(viewport);
+  SbBool havegl = getenv("DISPLAY") != NULL;
+  if (havegl) {
+    // renders an empty graph to find out if there is a context
+    SoSeparator * empty = new SoSeparator;
+    empty->ref();
+    havegl = renderer->render(empty);
+    empty->unref();
+  }
+
+  for (int i = 0; i < 2; i++) {
+    graphs[i]->ref();
+    (void)fprintf(stdout, "%s graph, %d nodes:\n", names[i], count_nodes(graphs[i]));
+
+    SoCallbackAction cbaction(viewport);
+    measure("SoCallbackAction", &cbaction, graphs[i], rounds);
+
+    if (havegl) {
+      SoGLRenderAction * glaction = renderer->getGLRenderAction();
+      SbTime start = SbTime::getTimeOfDay();
+      for (int j = 0; j < rounds; j++) {
+        (void)renderer->render(graphs[i]);
+      }
+      const double t = (SbTime::getTimeOfDay() - start).getValue();
+      (void)fprintf(stdout, "  %-20s %10.2f ms %10.2f ns/node\n",
+                    glaction->getTypeId().getName().getString(),
+                    t * 1000.0 / rounds,
+                    t * 1.0e9 / (static_cast<double>(count_nodes(graphs[i])) * rounds));
+    }
+    else {
+      (void)fprintf(stdout, "  %-20s skipped, no offscreen context\n",
+                    "SoGLRenderAction");
+    }
+    graphs[i]->unref();
+  }
+
+  delete renderer;
+  SoDB::finish();
+  return 0;
+}
@@ -0,0 +1,134 @@
+/************************************************************************
+ *
+ * Measures SoCalculator on large input arrays. Evaluates a few
+ * typical expressions on NUMVALUES input values, first with the
+ * expressions interpreted for each field index and then compiled into
+ * a register program, and checks that both give identical results.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o calculator-benchmark calculator-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: calculator-benchmark [NUMVALUES [ITERATIONS]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/C/tidbits.h>
+#include <Inventor/engines/SoCalculator.h>
+
+static const char * expressions[] = {
+  "oa = a * b + c",
+  "oA = A * a + B; ob = length(A - B)",
+  "oA = normalize(cross(A, B)); oa = a > 0 ? sqrt(a) : -pow(-a, 2)",
+  "ta = a * 0.5; tA = vec3f(cos(ta), sin(ta), 0); oA = tA * b + A",
+  NULL
+};
+
+static SoCalculator *
+create_calculator(const char * expression, int numvalues)
+{
+  SoCalculator * calc = new SoCalculator;
+  calc->ref();
+  calc->a.setNum(numvalues);
+  calc->b.setNum(numvalues);
+  calc->c.setNum(numvalues);
+  calc->A.setNum(numvalues);
+  calc->B.setNum(numvalues);
+  float * af = calc->a.startEditing();
+  float * bf = calc->b.startEditing();
+  float * cf = calc->c.startEditing();
+  SbVec3f * av = calc->A.startEditing();
+  SbVec3f * bv = calc->B.startEditing();
+  for (int i = 0; i < numvalues; i++) {
+    const float x = (i % 1000) * 0.01f - 5.0f;
+    af[i] = x;
+    bf[i] = 1.0f - x * 0.5f;
+    cf[i] = static_cast<float>(i % 17);
+    av[i].setValue(x, 1.0f, -x);
+    bv[i].setValue(0.5f, x * x, 2.0f);
+  }
+  calc->a.finishEditing();
+  calc->b.finishEditing();
+  calc->c.finishEditing();
+  calc->A.finishEditing();
+  calc->B.finishEditing();
+  calc->expression = expression;
+  return calc;
+}
+
+/* Evaluates the expression ITERATIONS times, and returns the time
+   per evaluation. The results are left in the inputs of the returned
+   reader engine. */
+static double
+run(const char * expression, int numvalues, int iterations,
+    SbBool interpret, SoCalculator ** reader)
+{
+  if (interpret) (void)coin_setenv("COIN_CALCULATOR_INTERPRET", "1", 1);
+  else coin_unsetenv("COIN_CALCULATOR_INTERPRET");
+
+  SoCalculator * calc = create_calculator(expression, numvalues);
+  *reader = new SoCalculator;
+  (*reader)->ref();
+  (*reader)->a.connectFrom(&calc->oa);
+  (*reader)->b.connectFrom(&calc->ob);
+  (*reader)->A.connectFrom(&calc->oA);
+
+  // parse (and compile) the expression before timing
+  (void)(*reader)->a.getNum();
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < iterations; i++) {
+    calc->c.touch();
+    (void)(*reader)->a.getNum();
+    (void)(*reader)->A.getNum();
+  }
+  const double t = (SbTime::getTimeOfDay() - start).getValue() / iterations;
+
+  calc->unref();
+  return t;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numvalues = argc > 1 ? atoi(argv[1]) : 500000;
+  const int iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+  SoDB::init();
+
+  (void)fprintf(stdout, "%d values, %d iterations\n", numvalues, iterations);
+  (void)fprintf(stdout, "%14s %14s %8s  %s\n",
+                "interpreted", "compiled", "speedup", "expression");
+  int errors = 0;
+  for (int i = 0; expressions[i]; i++) {
+    SoCalculator * interpreted, * compiled;
+    const double ti = run(expressions[i], numvalues, iterations, TRUE, &interpreted);
+    const double tc = run(expressions[i], numvalues, iterations, FALSE, &compiled);
+    (void)fprintf(stdout, "%11.2f ms %11.2f ms %7.1fx  %s\n",
+                  ti * 1000.0, tc * 1000.0, ti / tc, expressions[i]);
+
+    if (interpreted->a.getNum() != compiled->a.getNum() ||
+        interpreted->b.getNum() != compiled->b.getNum() ||
+        interpreted->A.getNum() != compiled->A.getNum() ||
+        memcmp(interpreted->a.getValues(0), compiled->a.getValues(0),
+               compiled->a.getNum() * sizeof(float)) != 0 ||
+        memcmp(interpreted->b.getValues(0), compiled->b.getValues(0),
+               compiled->b.getNum() * sizeof(float)) != 0 ||
+        memcmp(interpreted->A.getValues(0), compiled->A.getValues(0),
+               compiled->A.getNum() * sizeof(SbVec3f)) != 0) {
+      (void)fprintf(stderr, "results differ for \"%s\"\n", expressions[i]);
+      errors++;
+    }
+    interpreted->unref();
+    compiled->unref();
+  }
+
+  coin_unsetenv("COIN_CALCULATOR_INTERPRET");
+  SoDB::finish();
+  return errors ? 1 : 0;
+}
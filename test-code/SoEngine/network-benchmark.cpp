@@ -0,0 +1,134 @@
+/************************************************************************
+ *
+ * Measures evaluation of a large engine network. Builds NUMCHAINS
+ * chains of SoCalculator engines, NUMENGINES engines in all, where
+ * each engine adds one to the output of the engine before it, and
+ * SoInterpolateFloat engines blend the ends of neighbouring chains. Each frame changes the input of the first engine in every
+ * chain and reads all outputs, first with the ordinary lazy
+ * evaluation, then with SoEngine::evaluateScheduled() run before the
+ * reads, for 1 and for NUMTHREADS threads.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o network-benchmark network-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: network-benchmark [NUMENGINES [NUMCHAINS [FRAMES [NUMTHREADS]]]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/engines/SoCalculator.h>
+#include <Inventor/engines/SoInterpolateFloat.h>
+#include <Inventor/lists/SbList.h>
+
+static SbList<SoCalculator *> heads;
+static SbList<SoCalculator *> engines;
+static SbList<SoInterpolateFloat *> blends;
+static SbList<SoCalculator *> sinks;
+
+/* Reads the output of every engine, like the fields of a scene
+   graph connected to the network would be read by a traversal. */
+static double
+read_outputs(void)
+{
+  double sum = 0.0;
+  for (int i = 0; i < engines.getLength(); i++) { sum += engines[i]->a[0]; }
+  for (int i = 0; i < sinks.getLength(); i++) { sum += sinks[i]->a[0]; }
+  return sum;
+}
+
+static double
+run_frames(int frames, SbBool scheduled, int * evaluated)
+{
+  double sum = 0.0;
+  *evaluated = 0;
+  for (int f = 0; f < frames; f++) {
+    for (int i = 0; i < heads.getLength(); i++) {
+      heads[i]->a = static_cast<float>(f + i);
+    }
+    if (scheduled) { *evaluated += SoEngine::evaluateScheduled(); }
+    sum += read_outputs();
+  }
+  return sum;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numengines = argc > 1 ? atoi(argv[1]) : 10000;
+  int numchains = argc > 2 ? atoi(argv[2]) : 100;
+  const int frames = argc > 3 ? atoi(argv[3]) : 100;
+  const int numthreads = argc > 4 ? atoi(argv[4]) : 4;
+  if (numchains < 1) numchains = 1;
+  const int length = numengines / numchains;
+
+  SoDB::init();
+
+  SbList<SoCalculator *> tails;
+  for (int c = 0; c < numchains; c++) {
+    SoCalculator * prev = NULL;
+    for (int i = 0; i < length; i++) {
+      SoCalculator * calc = new SoCalculator;
+      calc->ref();
+      calc->expression = "oa = a + 1";
+      if (prev) { calc->a.connectFrom(&prev->oa); }
+      else { heads.append(calc); }
+      engines.append(calc);
+      prev = calc;
+    }
+    if (prev) { tails.append(prev); }
+  }
+  for (int c = 0; c + 1 < tails.getLength(); c += 2) {
+    SoInterpolateFloat * blend = new SoInterpolateFloat;
+    blend->ref();
+    blend->input0.connectFrom(&tails[c]->oa);
+    blend->input1.connectFrom(&tails[c+1]->oa);
+    blend->alpha = 0.5f;
+    blends.append(blend);
+    SoCalculator * sink = new SoCalculator;
+    sink->ref();
+    sink->a.connectFrom(&blend->output);
+    sinks.append(sink);
+  }
+  (void)fprintf(stdout, "%d chains of %d engines, %d frames\n",
+                numchains, length, frames);
+
+  // warm up, and make all engines clean
+  int evaluated = 0;
+  (void)run_frames(1, FALSE, &evaluated);
+
+  SbTime start = SbTime::getTimeOfDay();
+  const double lazysum = run_frames(frames, FALSE, &evaluated);
+  double t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "%-24s %10.3f ms/frame\n", "lazy evaluation",
+                t * 1.0e3 / frames);
+
+  SoEngine::enableScheduling(TRUE);
+  double scheduledsum = 0.0;
+  for (int threads = 1; threads <= numthreads; threads *= 2) {
+    SoEngine::setNumSchedulingThreads(threads);
+    (void)run_frames(1, TRUE, &evaluated);
+    start = SbTime::getTimeOfDay();
+    scheduledsum = run_frames(frames, TRUE, &evaluated);
+    t = (SbTime::getTimeOfDay() - start).getValue();
+    char label[64];
+    (void)sprintf(label, "scheduled, %d thread%s", threads, threads > 1 ? "s" : "");
+    (void)fprintf(stdout, "%-24s %10.3f ms/frame (%d engines/frame)\n", label,
+                  t * 1.0e3 / frames, evaluated / frames);
+  }
+  SoEngine::enableScheduling(FALSE);
+
+  for (int i = 0; i < sinks.getLength(); i++) { sinks[i]->unref(); }
+  for (int i = 0; i < blends.getLength(); i++) { blends[i]->unref(); }
+  for (int i = 0; i < engines.getLength(); i++) { engines[i]->unref(); }
+  SoDB::finish();
+
+  if (lazysum != scheduledsum) {
+    (void)fprintf(stderr, "results differ: %g != %g\n", lazysum, scheduledsum);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+/************************************************************************
+ *
+ * Measures SoGLRenderAction with and without retained rendering. Builds
+ * a separator with NUMCHILDREN child separators, each holding a
+ * translation, a material and a cube, and renders it ROUNDS times
+ * offscreen, first unchanged and then with one translation moved
+ * before every frame. The images from both modes are checked to be
+ * the same. Nothing is measured when DISPLAY is not set, as no
+ * offscreen context can be created then.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o renderqueue-benchmark renderqueue-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: renderqueue-benchmark [NUMCHILDREN [ROUNDS]]
+ *
+ ************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoOffscreenRenderer.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoDirectionalLight.h>
+#include <Inventor/nodes/SoMaterial.h>
+#include <Inventor/nodes/SoPerspectiveCamera.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static const int WIDTH = 256;
+static const int HEIGHT = 256;
+
+static void
+measure(const char * name, SoOffscreenRenderer * renderer, SoNode * root,
+        SoTranslation ** translations, int numchildren, int rounds,
+        unsigned char * image)
+{
+  (void)renderer->render(root); // warm up, and record the render queue
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    (void)renderer->render(root);
+  }
+  const double tstatic = (SbTime::getTimeOfDay() - start).getValue();
+
+  start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    const int idx = (i * 7919) % numchildren;
+    const SbVec3f t = translations[idx]->translation.getValue();
+    translations[idx]->translation = SbVec3f(t[0], t[1], float(i % 2) * 0.1f);
+    (void)renderer->render(root);
+  }
+  const double tedit = (SbTime::getTimeOfDay() - start).getValue();
+
+  // restore the scene, and keep the last image for comparison
+  for (int i = 0; i < numchildren; i++) {
+    const SbVec3f t = translations[i]->translation.getValue();
+    translations[i]->translation = SbVec3f(t[0], t[1], 0.0f);
+  }
+  (void)renderer->render(root);
+  (void)memcpy(image, renderer->getBuffer(), WIDTH * HEIGHT * 3);
+
+  (void)fprintf(stdout, "  %-10s %10.2f ms per frame, %10.2f ms per frame with edits\n",
+                name, tstatic * 1000.0 / rounds, tedit * 1000.0 / rounds);
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numchildren = argc > 1 ? atoi(argv[1]) : 25000;
+  const int rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+  SoDB::init();
+
+  SoOffscreenRenderer * renderer =
+    new SoOffscreenRenderer(SbViewportRegion(WIDTH, HEIGHT));
+  SbBool havegl = getenv("DISPLAY") != NULL;
+  if (havegl) {
+    // renders an empty graph to find out if there is a context
+    SoSeparator * empty = new SoSeparator;
+    empty->ref();
+    havegl = renderer->render(empty);
+    empty->unref();
+  }
+  if (!havegl) {
+    (void)fprintf(stdout, "skipped, no offscreen context\n");
+    delete renderer;
+    SoDB::finish();
+    return 0;
+  }
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  root->addChild(new SoPerspectiveCamera);
+  root->addChild(new SoDirectionalLight);
+  SoSeparator * scene = new SoSeparator;
+  root->addChild(scene);
+
+  SoTranslation ** translations = new SoTranslation*[numchildren];
+  SoCube * cube = new SoCube;
+  const int side = 1 + static_cast<int>(sqrt(static_cast<double>(numchildren)));
+  for (int i = 0; i < numchildren; i++) {
+    SoSeparator * child = new SoSeparator;
+    translations[i] = new SoTranslation;
+    translations[i]->translation = SbVec3f(float(i % side) * 3.0f, float(i / side) * 3.0f, 0.0f);
+    SoMaterial * material = new SoMaterial;
+    material->diffuseColor = SbColor(float(i % 4) / 3.0f, float(i % 3) / 2.0f, 0.5f);
+    child->addChild(translations[i]);
+    child->addChild(material);
+    child->addChild(cube);
+    scene->addChild(child);
+  }
+  SoPerspectiveCamera * camera = static_cast<SoPerspectiveCamera *>(root->getChild(0));
+  camera->viewAll(root, SbViewportRegion(WIDTH, HEIGHT));
+
+  unsigned char * images[2];
+  images[0] = new unsigned char[WIDTH * HEIGHT * 3];
+  images[1] = new unsigned char[WIDTH * HEIGHT * 3];
+
+  (void)fprintf(stdout, "%d children, %d frames:\n", numchildren, rounds);
+  SoGLRenderAction * action = renderer->getGLRenderAction();
+  action->setRetainedRendering(FALSE);
+  measure("immediate", renderer, root, translations, numchildren, rounds, images[0]);
+  action->setRetainedRendering(TRUE);
+  measure("retained", renderer, root, translations, numchildren, rounds, images[1]);
+
+  const int ok = memcmp(images[0], images[1], WIDTH * HEIGHT * 3) == 0;
+  if (!ok) (void)fprintf(stderr, "images differ\n");
+
+  delete[] images[0];
+  delete[] images[1];
+  delete[] translations;
+  root->unref();
+  delete renderer;
+  SoDB::finish();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/************************************************************************
+ *
+ * Measures the sorting of transparent objects in SoGLRenderAction.
+ * Builds a separator with NUMCHILDREN child separators, each holding
+ * a translation, a transparent material and a cube, and renders it
+ * ROUNDS times offscreen with SORTED_OBJECT_BLEND: with a still
+ * camera, with a camera turning a little between frames, and with a
+ * camera turning half a round between frames. The first two keep the
+ * order of the previous frame nearly right, the last one reverses it.
+ * Nothing is measured when DISPLAY is not set, as no offscreen
+ * context can be created then.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o transparency-sort-benchmark transparency-sort-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: transparency-sort-benchmark [NUMCHILDREN [ROUNDS]]
+ *
+ ************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoOffscreenRenderer.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoDirectionalLight.h>
+#include <Inventor/nodes/SoMaterial.h>
+#include <Inventor/nodes/SoPerspectiveCamera.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static const int SIZE = 256;
+
+static SbVec3f
+look_direction(const SbRotation & orientation)
+{
+  SbVec3f dir;
+  orientation.multVec(SbVec3f(0.0f, 0.0f, -1.0f), dir);
+  return dir;
+}
+
+static void
+measure(const char * name, SoOffscreenRenderer * renderer, SoNode * root,
+        SoPerspectiveCamera * camera, float angle, int rounds)
+{
+  const SbRotation start = camera->orientation.getValue();
+  const float focal = camera->focalDistance.getValue();
+  const SbVec3f center = camera->position.getValue() + look_direction(start) * focal;
+  const SbRotation step(SbVec3f(0.0f, 1.0f, 0.0f), angle);
+
+  (void)renderer->render(root); // warm up
+  SbTime begin = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    // orbit around the focal point
+    const SbRotation r = camera->orientation.getValue() * step;
+    camera->orientation = r;
+    camera->position = center - look_direction(r) * focal;
+    (void)renderer->render(root);
+  }
+  const double t = (SbTime::getTimeOfDay() - begin).getValue();
+  (void)fprintf(stdout, "  %-12s %10.2f ms per frame\n", name, t * 1000.0 / rounds);
+  camera->orientation = start;
+  camera->position = center - look_direction(start) * focal;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numchildren = argc > 1 ? atoi(argv[1]) : 20000;
+  const int rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+  SoDB::init();
+
+  SoOffscreenRenderer * renderer = new SoOffscreenRenderer(SbViewportRegion(SIZE, SIZE));
+  SbBool havegl = getenv("DISPLAY") != NULL;
+  if (havegl) {
+    // renders an empty graph to find out if there is a context
+    SoSeparator * empty = new SoSeparator;
+    empty->ref();
+    havegl = renderer->render(empty);
+    empty->unref();
+  }
+  if (!havegl) {
+    (void)fprintf(stdout, "skipped, no offscreen context\n");
+    delete renderer;
+    SoDB::finish();
+    return 0;
+  }
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoPerspectiveCamera * camera = new SoPerspectiveCamera;
+  root->addChild(camera);
+  root->addChild(new SoDirectionalLight);
+
+  SoCube * cube = new SoCube;
+  const int side = 1 + static_cast<int>(pow(static_cast<double>(numchildren), 1.0 / 3.0));
+  for (int i = 0; i < numchildren; i++) {
+    SoSeparator * child = new SoSeparator;
+    SoTranslation * translation = new SoTranslation;
+    translation->translation = SbVec3f(float(i % side) * 3.0f,
+                                       float((i / side) % side) * 3.0f,
+                                       float(i / (side * side)) * 3.0f);
+    SoMaterial * material = new SoMaterial;
+    material->diffuseColor = SbColor(float(i % 4) / 3.0f, float(i % 3) / 2.0f, 0.5f);
+    material->transparency = 0.5f;
+    child->addChild(translation);
+    child->addChild(material);
+    child->addChild(cube);
+    root->addChild(child);
+  }
+  camera->viewAll(root, SbViewportRegion(SIZE, SIZE));
+
+  renderer->getGLRenderAction()->setTransparencyType(SoGLRenderAction::SORTED_OBJECT_BLEND);
+  (void)fprintf(stdout, "%d transparent objects, %d frames:\n", numchildren, rounds);
+  measure("still", renderer, root, camera, 0.0f, rounds);
+  measure("turning", renderer, root, camera, 0.01f, rounds);
+  measure("jumping", renderer, root, camera, float(M_PI), rounds);
+
+  root->unref();
+  delete renderer;
+  SoDB::finish();
+  return 0;
+}
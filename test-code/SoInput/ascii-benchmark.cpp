@@ -0,0 +1,75 @@
+/************************************************************************
+ *
+ * Measures how long it takes to read a large ASCII Inventor file,
+ * which is dominated by parsing the numbers in the multiple-value
+ * fields. Writes a file with a Coordinate3 node with NUMCOORDS
+ * points, and an IndexedFaceSet with matching coordinate indices, and
+ * reads it back with SoDB::readAll().
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o ascii-benchmark ascii-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: ascii-benchmark [NUMCOORDS [FILENAME]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SoInput.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/actions/SoSearchAction.h>
+
+int
+main(int argc, char ** argv)
+{
+  const int numcoords = argc > 1 ? atoi(argv[1]) : 10000000;
+  const char * filename = argc > 2 ? argv[2] : "ascii-benchmark.iv";
+
+  SoDB::init();
+
+  FILE * fp = fopen(filename, "wb");
+  if (!fp) {
+    (void)fprintf(stderr, "couldn't write %s\n", filename);
+    return 1;
+  }
+  (void)fprintf(fp, "#Inventor V2.1 ascii\n\nSeparator {\n  Coordinate3 {\n    point [\n");
+  srand(1);
+  for (int i = 0; i < numcoords; i++) {
+    (void)fprintf(fp, "      %.8g %.8g %.8g,\n",
+                  (rand() - RAND_MAX / 2) * 1.0e-4,
+                  (rand() - RAND_MAX / 2) * 1.0e-4,
+                  (rand() - RAND_MAX / 2) * 1.0e-4);
+  }
+  (void)fprintf(fp, "    ]\n  }\n  IndexedFaceSet {\n    coordIndex [\n");
+  for (int i = 0; i + 2 < numcoords; i += 3) {
+    (void)fprintf(fp, "      %d, %d, %d, -1,\n", i, i + 1, i + 2);
+  }
+  (void)fprintf(fp, "    ]\n  }\n}\n");
+  const long size = ftell(fp);
+  (void)fclose(fp);
+
+  SoInput in;
+  if (!in.openFile(filename)) { return 1; }
+  SbTime start = SbTime::getTimeOfDay();
+  SoSeparator * root = SoDB::readAll(&in);
+  const double t = (SbTime::getTimeOfDay() - start).getValue();
+  if (!root) { return 1; }
+  root->ref();
+
+  SoSearchAction sa;
+  sa.setType(SoCoordinate3::getClassTypeId());
+  sa.apply(root);
+  const int numread = sa.getPath() ?
+    ((SoCoordinate3 *) sa.getPath()->getTail())->point.getNum() : 0;
+
+  (void)fprintf(stdout, "%d coordinates (%.1f MB) read in %.2f s: %.1f MB/s, %.1f ns/coordinate\n",
+                numread, size / 1.0e6, t, size / 1.0e6 / t, t * 1.0e9 / numcoords);
+  root->unref();
+  (void)remove(filename);
+  return numread == numcoords ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/************************************************************************
+ *
+ * Measures SoMultipleCopy with and without instanced rendering. Builds
+ * an SoMultipleCopy with NUMCOPIES matrices on a grid, holding a
+ * material and a sphere, and renders it ROUNDS times offscreen, first
+ * unchanged and then with the matrices changed before every frame.
+ * The largest difference between the images from both modes is
+ * printed, as the lighting done by the vertex shader of instanced
+ * rendering may differ slightly from the fixed function pipeline.
+ * Nothing is measured when DISPLAY is not set, as no offscreen
+ * context can be created then.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o instancing-benchmark instancing-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: instancing-benchmark [NUMCOPIES [ROUNDS]]
+ *
+ ************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoOffscreenRenderer.h>
+#include <Inventor/actions/SoGLRenderAction.h>
+#include <Inventor/nodes/SoComplexity.h>
+#include <Inventor/nodes/SoDirectionalLight.h>
+#include <Inventor/nodes/SoMaterial.h>
+#include <Inventor/nodes/SoMultipleCopy.h>
+#include <Inventor/nodes/SoPerspectiveCamera.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoSphere.h>
+
+static const int WIDTH = 256;
+static const int HEIGHT = 256;
+
+static void
+set_matrices(SoMultipleCopy * copy, int numcopies, float offset)
+{
+  const int side = 1 + static_cast<int>(sqrt(static_cast<double>(numcopies)));
+  SbMatrix * matrices = new SbMatrix[numcopies];
+  for (int i = 0; i < numcopies; i++) {
+    matrices[i].setTranslate(SbVec3f(float(i % side) * 3.0f, float(i / side) * 3.0f, offset));
+  }
+  copy->matrix.setValues(0, numcopies, matrices);
+  delete[] matrices;
+}
+
+static void
+measure(const char * name, SoOffscreenRenderer * renderer, SoNode * root,
+        SoMultipleCopy * copy, int numcopies, int rounds, unsigned char * image)
+{
+  (void)renderer->render(root); // warm up, and record the shapes
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    (void)renderer->render(root);
+  }
+  const double tstatic = (SbTime::getTimeOfDay() - start).getValue();
+
+  start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    set_matrices(copy, numcopies, float(i % 2) * 0.1f);
+    (void)renderer->render(root);
+  }
+  const double tedit = (SbTime::getTimeOfDay() - start).getValue();
+
+  set_matrices(copy, numcopies, 0.0f);
+  (void)renderer->render(root);
+  (void)memcpy(image, renderer->getBuffer(), WIDTH * HEIGHT * 3);
+
+  (void)fprintf(stdout, "  %-10s %10.2f ms per frame, %10.2f ms per frame with new matrices\n",
+                name, tstatic * 1000.0 / rounds, tedit * 1000.0 / rounds);
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numcopies = argc > 1 ? atoi(argv[1]) : 10000;
+  const int rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+  SoDB::init();
+
+  SoOffscreenRenderer * renderer =
+    new SoOffscreenRenderer(SbViewportRegion(WIDTH, HEIGHT));
+  SbBool havegl = getenv("DISPLAY") != NULL;
+  if (havegl) {
+    // renders an empty graph to find out if there is a context
+    SoSeparator * empty = new SoSeparator;
+    empty->ref();
+    havegl = renderer->render(empty);
+    empty->unref();
+  }
+  if (!havegl) {
+    (void)fprintf(stdout, "skipped, no offscreen context\n");
+    delete renderer;
+    SoDB::finish();
+    return 0;
+  }
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoPerspectiveCamera * camera = new SoPerspectiveCamera;
+  root->addChild(camera);
+  root->addChild(new SoDirectionalLight);
+
+  SoMultipleCopy * copy = new SoMultipleCopy;
+  set_matrices(copy, numcopies, 0.0f);
+  SoMaterial * material = new SoMaterial;
+  material->diffuseColor = SbColor(0.8f, 0.4f, 0.2f);
+  SoComplexity * complexity = new SoComplexity;
+  complexity->value = 0.3f;
+  copy->addChild(material);
+  copy->addChild(complexity);
+  copy->addChild(new SoSphere);
+  root->addChild(copy);
+  camera->viewAll(root, SbViewportRegion(WIDTH, HEIGHT));
+
+  unsigned char * images[2];
+  images[0] = new unsigned char[WIDTH * HEIGHT * 3];
+  images[1] = new unsigned char[WIDTH * HEIGHT * 3];
+
+  (void)fprintf(stdout, "%d copies, %d frames:\n", numcopies, rounds);
+  SoGLRenderAction * action = renderer->getGLRenderAction();
+  action->setInstancedRendering(FALSE);
+  measure("traversed", renderer, root, copy, numcopies, rounds, images[0]);
+  action->setInstancedRendering(TRUE);
+  measure("instanced", renderer, root, copy, numcopies, rounds, images[1]);
+
+  int maxdiff = 0;
+  for (int i = 0; i < WIDTH * HEIGHT * 3; i++) {
+    const int diff = abs(int(images[0][i]) - int(images[1][i]));
+    if (diff > maxdiff) maxdiff = diff;
+  }
+  (void)fprintf(stdout, "largest difference between the images: %d\n", maxdiff);
+
+  delete[] images[0];
+  delete[] images[1];
+  root->unref();
+  delete renderer;
+  SoDB::finish();
+  return 0;
+}
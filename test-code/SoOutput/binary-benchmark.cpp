@@ -0,0 +1,92 @@
+/************************************************************************
+ *
+ * Measures how long it takes to write a large binary Inventor file,
+ * which is dominated by the multiple-value fields. Builds a scene
+ * with a Coordinate3 node with NUMCOORDS points and an IndexedFaceSet
+ * with matching coordinate indices, and writes it with SoWriteAction,
+ * optionally compressed.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o binary-benchmark binary-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: binary-benchmark [NUMCOORDS [none|GZIP|BZIP2 [FILENAME]]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SoOutput.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/actions/SoWriteAction.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+int
+main(int argc, char ** argv)
+{
+  const int numcoords = argc > 1 ? atoi(argv[1]) : 10000000;
+  const char * compression = argc > 2 ? argv[2] : "none";
+  const char * filename = argc > 3 ? argv[3] : "binary-benchmark.iv";
+
+  SoDB::init();
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  SoCoordinate3 * coords = new SoCoordinate3;
+  SoIndexedFaceSet * faceset = new SoIndexedFaceSet;
+  root->addChild(coords);
+  root->addChild(faceset);
+
+  coords->point.setNum(numcoords);
+  SbVec3f * pts = coords->point.startEditing();
+  srand(1);
+  for (int i = 0; i < numcoords; i++) {
+    pts[i].setValue((rand() - RAND_MAX / 2) * 1.0e-4f,
+                    (rand() - RAND_MAX / 2) * 1.0e-4f,
+                    (rand() - RAND_MAX / 2) * 1.0e-4f);
+  }
+  coords->point.finishEditing();
+
+  const int numtriangles = numcoords / 3;
+  faceset->coordIndex.setNum(numtriangles * 4);
+  int32_t * idx = faceset->coordIndex.startEditing();
+  for (int i = 0; i < numtriangles; i++) {
+    idx[i * 4 + 0] = i * 3;
+    idx[i * 4 + 1] = i * 3 + 1;
+    idx[i * 4 + 2] = i * 3 + 2;
+    idx[i * 4 + 3] = -1;
+  }
+  faceset->coordIndex.finishEditing();
+
+  SoOutput out;
+  out.setBinary(TRUE);
+  if (strcmp(compression, "none") != 0 &&
+      !out.setCompression(compression, 0.1f)) {
+    (void)fprintf(stderr, "%s compression not available\n", compression);
+    return 1;
+  }
+  if (!out.openFile(filename)) { return 1; }
+
+  SbTime start = SbTime::getTimeOfDay();
+  SoWriteAction wa(&out);
+  wa.apply(root);
+  out.closeFile();
+  const double t = (SbTime::getTimeOfDay() - start).getValue();
+
+  FILE * fp = fopen(filename, "rb");
+  if (!fp) { return 1; }
+  (void)fseek(fp, 0, SEEK_END);
+  const long size = ftell(fp);
+  (void)fclose(fp);
+
+  const double values = numcoords * 3.0 + numtriangles * 4.0;
+  (void)fprintf(stdout, "%d coordinates (%.1f MB on disk) written in %.2f s: %.1f ns/value\n",
+                numcoords, size / 1.0e6, t, t * 1.0e9 / values);
+  root->unref();
+  (void)remove(filename);
+  return 0;
+}
@@ -0,0 +1,136 @@
+/************************************************************************
+ *
+ * Compares ray picking on a large SoIndexedFaceSet using the triangle
+ * hierarchy (SoShape::rayPickBVH()) against the old way of testing
+ * every triangle from generatePrimitives().
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o bvh-benchmark bvh-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: bvh-benchmark [GRIDSIZE [NUMPICKS]]
+ *
+ * A GRIDSIZE of 2000 gives 8M triangles.
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/SoPickedPoint.h>
+#include <Inventor/actions/SoRayPickAction.h>
+#include <Inventor/details/SoFaceDetail.h>
+#include <Inventor/nodes/SoCoordinate3.h>
+#include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+// picks the way SoShape did before SoIndexedFaceSet got a triangle
+// hierarchy
+class OldPickFaceSet : public SoIndexedFaceSet {
+public:
+  virtual void rayPick(SoRayPickAction * action) {
+    SoShape::rayPick(action);
+  }
+};
+
+static SoSeparator *
+create_grid(SoIndexedFaceSet * ifs, const int size)
+{
+  SoSeparator * root = new SoSeparator;
+  SoCoordinate3 * coords = new SoCoordinate3;
+  root->addChild(coords);
+  root->addChild(ifs);
+
+  coords->point.setNum((size+1)*(size+1));
+  SbVec3f * pts = coords->point.startEditing();
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      // some noise in z to get a less regular tree
+      pts[y*(size+1)+x].setValue(float(x), float(y), float(rand() % 100) * 0.01f);
+    }
+  }
+  coords->point.finishEditing();
+
+  ifs->coordIndex.setNum(size*size*5);
+  int32_t * idx = ifs->coordIndex.startEditing();
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v = y*(size+1)+x;
+      *idx++ = v;
+      *idx++ = v+1;
+      *idx++ = v+size+2;
+      *idx++ = v+size+1;
+      *idx++ = -1;
+    }
+  }
+  ifs->coordIndex.finishEditing();
+  return root;
+}
+
+// returns the time used. numhits and checksum are used to check
+// that both methods find the same points.
+static double
+run_picks(SoNode * root, const int size, const int numpicks,
+          int & numhits, double & checksum)
+{
+  SoRayPickAction rp(SbViewportRegion(100, 100));
+  srand(19720408);
+  numhits = 0;
+  checksum = 0.0;
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < numpicks; i++) {
+    const float x = float(rand() % (size*100)) * 0.01f;
+    const float y = float(rand() % (size*100)) * 0.01f;
+    rp.setRay(SbVec3f(x, y, 10.0f), SbVec3f(0.0f, 0.0f, -1.0f));
+    rp.apply(root);
+    const SoPickedPoint * pp = rp.getPickedPoint();
+    if (pp) {
+      const SoFaceDetail * detail = (const SoFaceDetail *) pp->getDetail();
+      numhits++;
+      checksum += pp->getPoint()[2] + pp->getNormal()[2] + detail->getFaceIndex();
+    }
+  }
+  return (SbTime::getTimeOfDay() - start).getValue();
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int size = argc > 1 ? atoi(argv[1]) : 1000;
+  const int numpicks = argc > 2 ? atoi(argv[2]) : 100;
+
+  SoDB::init();
+
+  srand(1);
+  SoSeparator * oldroot = create_grid(new OldPickFaceSet, size);
+  oldroot->ref();
+  srand(1);
+  SoSeparator * newroot = create_grid(new SoIndexedFaceSet, size);
+  newroot->ref();
+
+  int oldhits, newhits;
+  double oldsum, newsum;
+  (void)fprintf(stdout, "%d triangles, %d picks\n", size*size*2, numpicks);
+
+  double t = run_picks(oldroot, size, numpicks, oldhits, oldsum);
+  (void)fprintf(stdout, "generatePrimitives: %8.3f ms/pick (%d hits)\n",
+                t * 1000.0 / numpicks, oldhits);
+
+  // the first pick builds the hierarchy
+  t = run_picks(newroot, size, 1, newhits, newsum);
+  (void)fprintf(stdout, "hierarchy build:    %8.3f ms\n", t * 1000.0);
+
+  t = run_picks(newroot, size, numpicks, newhits, newsum);
+  (void)fprintf(stdout, "hierarchy:          %8.3f ms/pick (%d hits)\n",
+                t * 1000.0 / numpicks, newhits);
+
+  oldroot->unref();
+  newroot->unref();
+  if (oldhits != newhits || oldsum != newsum) {
+    (void)fprintf(stderr, "picked points differ\n");
+    return 1;
+  }
+  return 0;
+}
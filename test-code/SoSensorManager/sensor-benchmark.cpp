@@ -0,0 +1,99 @@
+/************************************************************************
+ *
+ * Measures the sensor queues of SoSensorManager. Attaches NUMSENSORS
+ * field sensors with a handful of different priorities to the fields
+ * of as many nodes, and sets up as many alarm sensors with trigger
+ * times in the recent past. Then times scheduling all of them,
+ * unscheduling and rescheduling every other one, and processing the
+ * queues, which fires all of them.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o sensor-benchmark sensor-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: sensor-benchmark [NUMSENSORS]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/nodes/SoTranslation.h>
+#include <Inventor/sensors/SoFieldSensor.h>
+#include <Inventor/sensors/SoAlarmSensor.h>
+#include <Inventor/sensors/SoSensorManager.h>
+
+static int numfired = 0;
+
+static void
+sensor_cb(void *, SoSensor *)
+{
+  numfired++;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numsensors = argc > 1 ? atoi(argv[1]) : 100000;
+
+  SoDB::init();
+  SoSensorManager * sm = SoDB::getSensorManager();
+
+  SoTranslation ** nodes = new SoTranslation *[numsensors];
+  SoFieldSensor ** fieldsensors = new SoFieldSensor *[numsensors];
+  SoAlarmSensor ** alarms = new SoAlarmSensor *[numsensors];
+  const SbTime now = SbTime::getTimeOfDay();
+  for (int i = 0; i < numsensors; i++) {
+    nodes[i] = new SoTranslation;
+    nodes[i]->ref();
+    fieldsensors[i] = new SoFieldSensor(sensor_cb, NULL);
+    fieldsensors[i]->setPriority(50 + (i % 7) * 10);
+    fieldsensors[i]->attach(&nodes[i]->translation);
+    alarms[i] = new SoAlarmSensor(sensor_cb, NULL);
+    // times in the past, so all of them fire when the queue is processed
+    alarms[i]->setTime(now - SbTime((i * 7919 % numsensors) * 1.0e-6 + 1.0));
+  }
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < numsensors; i++) {
+    // schedules the field sensor
+    nodes[i]->translation.setValue(float(i), 0.0f, 0.0f);
+    alarms[i]->schedule();
+  }
+  const double tschedule = (SbTime::getTimeOfDay() - start).getValue();
+
+  start = SbTime::getTimeOfDay();
+  for (int i = 0; i < numsensors; i += 2) {
+    fieldsensors[i]->unschedule();
+    alarms[i]->unschedule();
+  }
+  for (int i = 0; i < numsensors; i += 2) {
+    fieldsensors[i]->schedule();
+    alarms[i]->schedule();
+  }
+  const double treschedule = (SbTime::getTimeOfDay() - start).getValue();
+
+  start = SbTime::getTimeOfDay();
+  sm->processTimerQueue();
+  sm->processDelayQueue(TRUE);
+  const double tprocess = (SbTime::getTimeOfDay() - start).getValue();
+
+  const int numscheduled = 2 * numsensors;
+  (void)fprintf(stdout, "schedule %d sensors:     %8.3f s (%.2f us/sensor)\n",
+                numscheduled, tschedule, tschedule * 1.0e6 / numscheduled);
+  (void)fprintf(stdout, "reschedule %d sensors:   %8.3f s (%.2f us/sensor)\n",
+                numsensors, treschedule, treschedule * 1.0e6 / numsensors);
+  (void)fprintf(stdout, "fire %d sensors:         %8.3f s (%.2f us/sensor)\n",
+                numfired, tprocess, tprocess * 1.0e6 / numscheduled);
+
+  for (int i = 0; i < numsensors; i++) {
+    delete fieldsensors[i];
+    delete alarms[i];
+    nodes[i]->unref();
+  }
+  delete[] nodes;
+  delete[] fieldsensors;
+  delete[] alarms;
+  return numfired == numscheduled ? 0 : 1;
+}
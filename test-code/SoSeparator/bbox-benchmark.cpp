@@ -0,0 +1,88 @@
+/************************************************************************
+ *
+ * Measures SoGetBoundingBoxAction after a local edit. Builds a
+ * separator with NUMCHILDREN child separators, each holding a
+ * translation and a cube, then moves one child at a time and applies
+ * the action ROUNDS times. The same children are also measured below
+ * an SoGroup, where the separator can not keep the box of each child
+ * and has to visit all of them after every edit. The resulting boxes
+ * are checked to be the same.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o bbox-benchmark bbox-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: bbox-benchmark [NUMCHILDREN [ROUNDS]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/SbViewportRegion.h>
+#include <Inventor/actions/SoGetBoundingBoxAction.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoGroup.h>
+#include <Inventor/nodes/SoSeparator.h>
+#include <Inventor/nodes/SoTranslation.h>
+
+static SbBox3f
+measure(const char * name, SoNode * root, SoTranslation ** translations,
+        int numchildren, int rounds)
+{
+  SoGetBoundingBoxAction action(SbViewportRegion(640, 480));
+  action.apply(root); // fill the caches
+
+  SbTime start = SbTime::getTimeOfDay();
+  for (int i = 0; i < rounds; i++) {
+    const int idx = (i * 7919) % numchildren;
+    translations[idx]->translation = SbVec3f(float(idx), float(i % 10), 0.0f);
+    action.apply(root);
+  }
+  const double t = (SbTime::getTimeOfDay() - start).getValue();
+  (void)fprintf(stdout, "  %-12s %10.3f ms per edit\n", name, t * 1000.0 / rounds);
+  return action.getBoundingBox();
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int numchildren = argc > 1 ? atoi(argv[1]) : 100000;
+  const int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+  SoDB::init();
+
+  SoTranslation ** translations = new SoTranslation*[numchildren];
+  SoSeparator * wide = new SoSeparator;
+  wide->ref();
+  SoSeparator * grouped = new SoSeparator;
+  grouped->ref();
+  SoGroup * group = new SoGroup;
+  grouped->addChild(group);
+
+  SoCube * cube = new SoCube;
+  for (int i = 0; i < numchildren; i++) {
+    SoSeparator * child = new SoSeparator;
+    translations[i] = new SoTranslation;
+    translations[i]->translation = SbVec3f(float(i), 0.0f, 0.0f);
+    child->addChild(translations[i]);
+    child->addChild(cube);
+    wide->addChild(child);
+    group->addChild(child);
+  }
+
+  (void)fprintf(stdout, "%d children, %d edits:\n", numchildren, rounds);
+  const SbBox3f box = measure("separator", wide, translations, numchildren, rounds);
+  const SbBox3f refbox = measure("group", grouped, translations, numchildren, rounds);
+
+  const int ok = box.getMin().equals(refbox.getMin(), 1.0e-3f) &&
+    box.getMax().equals(refbox.getMax(), 1.0e-3f);
+  if (!ok) (void)fprintf(stderr, "bounding boxes differ\n");
+
+  grouped->unref();
+  wide->unref();
+  delete[] translations;
+  SoDB::finish();
+  return ok ? 0 : 1;
+}
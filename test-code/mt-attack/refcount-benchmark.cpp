@@ -0,0 +1,116 @@
+/************************************************************************
+ *
+ * Stress test for SoBase reference counting from several threads.
+ * Each thread repeatedly ref()s and unref()s a set of nodes shared by
+ * all threads, and a set of nodes private to the thread, for 1, 2, 4,
+ * ..., MAXTHREADS threads. Prints the time per ref()/unref() pair and
+ * the total throughput, and checks that all reference counts are back
+ * to their initial values afterwards.
+ *
+ * Build with something like:
+ *
+ *   c++ -O2 -o refcount-benchmark refcount-benchmark.cpp `coin-config --cppflags --ldflags --libs`
+ *
+ * Usage: refcount-benchmark [ITERATIONS [MAXTHREADS]]
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Inventor/SoDB.h>
+#include <Inventor/SbTime.h>
+#include <Inventor/C/threads/thread.h>
+#include <Inventor/nodes/SoCube.h>
+#include <Inventor/nodes/SoSeparator.h>
+
+#define NUMSHARED 8
+#define NUMPRIVATE 8
+#define MAXTHREADSLIMIT 256
+
+static SoNode * shared[NUMSHARED];
+
+struct worker {
+  cc_thread * thread;
+  SoNode * nodes[NUMPRIVATE];
+  int iterations;
+};
+
+static void *
+worker_cb(void * closure)
+{
+  worker * w = static_cast<worker *>(closure);
+  for (int i = 0; i < w->iterations; i++) {
+    SoNode * s = shared[i % NUMSHARED];
+    SoNode * p = w->nodes[i % NUMPRIVATE];
+    s->ref();
+    p->ref();
+    p->unref();
+    s->unref();
+  }
+  return NULL;
+}
+
+int
+main(int argc, char ** argv)
+{
+  const int iterations = argc > 1 ? atoi(argv[1]) : 2000000;
+  int maxthreads = argc > 2 ? atoi(argv[2]) : 32;
+  if (maxthreads > MAXTHREADSLIMIT) maxthreads = MAXTHREADSLIMIT;
+
+  SoDB::init();
+
+  SoSeparator * root = new SoSeparator;
+  root->ref();
+  for (int i = 0; i < NUMSHARED; i++) {
+    shared[i] = new SoCube;
+    root->addChild(shared[i]);
+  }
+
+  static worker workers[MAXTHREADSLIMIT];
+  for (int i = 0; i < maxthreads; i++) {
+    for (int j = 0; j < NUMPRIVATE; j++) {
+      workers[i].nodes[j] = new SoCube;
+      workers[i].nodes[j]->ref();
+    }
+  }
+
+  (void)fprintf(stdout, "%8s %12s %14s\n", "threads", "ns/pair", "Mpairs/s");
+  double single = 0.0;
+  for (int numthreads = 1; numthreads <= maxthreads; numthreads *= 2) {
+    SbTime start = SbTime::getTimeOfDay();
+    for (int i = 0; i < numthreads; i++) {
+      workers[i].iterations = iterations;
+      workers[i].thread = cc_thread_construct(worker_cb, &workers[i]);
+    }
+    for (int i = 0; i < numthreads; i++) {
+      (void)cc_thread_join(workers[i].thread, NULL);
+      cc_thread_destruct(workers[i].thread);
+    }
+    const double t = (SbTime::getTimeOfDay() - start).getValue();
+
+    // two ref()/unref() pairs per iteration
+    const double pairs = 2.0 * iterations * numthreads;
+    const double throughput = pairs / t / 1.0e6;
+    if (numthreads == 1) single = throughput;
+    (void)fprintf(stdout, "%8d %12.2f %14.2f (x%.2f)\n", numthreads,
+                  t * 1.0e9 / pairs, throughput, throughput / single);
+  }
+
+  int errors = 0;
+  for (int i = 0; i < NUMSHARED; i++) {
+    if (shared[i]->getRefCount() != 1) errors++;
+  }
+  for (int i = 0; i < maxthreads; i++) {
+    for (int j = 0; j < NUMPRIVATE; j++) {
+      if (workers[i].nodes[j]->getRefCount() != 1) errors++;
+      workers[i].nodes[j]->unref();
+    }
+  }
+  root->unref();
+
+  if (errors) {
+    (void)fprintf(stderr, "%d nodes with wrong reference count\n", errors);
+    return 1;
+  }
+  return 0;
+}